@@ -0,0 +1,73 @@
+/*
+ *  AABBArray.h
+ *  Base
+ *
+ *  Created by loch on 4/10/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _AABBARRAY_H_
+#define _AABBARRAY_H_
+#include "AABB.h"
+
+/*! AABBArray holds a set of AABB3s in structure of arrays form. Each component of the
+ *  center and extent (radius) of every box is kept in its own contiguous array, which is
+ *  the layout needed to test several boxes at once with vector instructions.
+ * \brief A list of AABB3s, stored as separate component arrays.
+ * \seealso Frustum::checkAABBs */
+class AABBArray {
+public:
+    AABBArray() {}
+    ~AABBArray() {}
+
+    /*! Gets the number of boxes in the array. */
+    unsigned int size() const { return _centers[0].size(); }
+
+    /*! Resizes the array. New boxes are empty and centered on the origin. */
+    void resize(unsigned int count) {
+        for (int i = 0; i < 3; i++) {
+            _centers[i].resize(count, 0);
+            _extents[i].resize(count, 0);
+        }
+    }
+
+    /*! Removes every box from the array. */
+    void clear() { resize(0); }
+
+    /*! Adds a box to the end of the array. */
+    void add(const AABB3 &box) {
+        for (int i = 0; i < 3; i++) {
+            _centers[i].push_back(box.getCenter()[i]);
+            _extents[i].push_back(box.getRadius()[i]);
+        }
+    }
+
+    /*! Replaces the box at the given index. */
+    void set(unsigned int index, const AABB3 &box) {
+        for (int i = 0; i < 3; i++) {
+            _centers[i][index] = box.getCenter()[i];
+            _extents[i][index] = box.getRadius()[i];
+        }
+    }
+
+    /*! Gets the box at the given index. */
+    AABB3 get(unsigned int index) const {
+        return AABB3(
+            Vector3(_centers[0][index], _centers[1][index], _centers[2][index]),
+            Vector3(_extents[0][index], _extents[1][index], _extents[2][index]));
+    }
+
+    /*! Gets the given component (0 for x, 1 for y, 2 for z) of every box's center. */
+    const Real *getCenters(int axis) const { return size() ? &_centers[axis][0] : NULL; }
+
+    /*! Gets the given component (0 for x, 1 for y, 2 for z) of every box's extent. */
+    const Real *getExtents(int axis) const { return size() ? &_extents[axis][0] : NULL; }
+
+protected:
+    std::vector<Real> _centers[3];
+    std::vector<Real> _extents[3];
+
+};
+
+#endif
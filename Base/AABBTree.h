@@ -0,0 +1,128 @@
+/*
+ *  AABBTree.h
+ *  Base
+ *
+ *  Created by loch on 4/9/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _AABBTREE_H_
+#define _AABBTREE_H_
+#include "AABB.h"
+#include "Frustum.h"
+
+/*! The AABBTree is a dynamic bounding volume hierarchy over a set of AABB3s. Each item
+ *  inserted into the tree is given a leaf, and every internal node in the tree holds an
+ *  AABB that encompasses both of its children. Insertion picks the sibling that causes
+ *  the smallest increase in surface area, and tree rotations keep the tree balanced so
+ *  queries remain logarithmic as items are added, moved and removed.
+ *
+ *  The leaves are loose. The AABB stored in a leaf is the item's AABB expanded by a
+ *  margin, so small movements can be handled with a simple containment check rather than
+ *  by removing and reinserting the leaf.
+ *
+ *  Frustum queries make use of the hierarchy in both directions. A node that is
+ *  completely outside of the frustum culls everything under it, while a node that is
+ *  completely inside of the frustum accepts everything under it without any further
+ *  tests.
+ * \brief A dynamic, loose bounding volume hierarchy.
+ * \seealso AABB */
+template <typename T>
+class AABBTree {
+public:
+#pragma mark Initialization and destruction
+    /*! Creates an empty tree. The margin is the amount each item's AABB is expanded by
+     *  (in every direction) when it is placed in a leaf. */
+    AABBTree(Real margin = 1.0);
+
+    /*! Destructor */
+    ~AABBTree();
+
+    /*! Removes everything from the tree. */
+    void clear();
+
+#pragma mark Item management
+    /*! Adds an item to the tree and returns the proxy that identifies it. */
+    int insert(const AABB3 &box, const T &data);
+
+    /*! Removes the item with the given proxy from the tree. */
+    void remove(int proxy);
+
+    /*! Updates the bounds of the item with the given proxy. If the new bounds still fit
+     *  in the item's loose AABB, nothing happens and false is returned. Otherwise, the
+     *  item is moved and true is returned. */
+    bool update(int proxy, const AABB3 &box);
+
+    /*! Returns the data associated with the given proxy. */
+    const T& getData(int proxy) const;
+
+    /*! Returns the loose AABB stored for the given proxy. */
+    const AABB3& getLooseAABB(int proxy) const;
+
+#pragma mark Queries
+    /*! Finds every item that may be in the given frustum. Items whose loose AABB is
+     *  completely inside of the frustum are added to 'contained'. Everything else whose
+     *  loose AABB touches the frustum is added to 'intersecting', and should be tested
+     *  individually. Results are appended to the given vectors. */
+    void query(const Frustum &frustum, std::vector<T> &intersecting, std::vector<T> &contained) const;
+
+    /*! Returns the number of items in the tree. */
+    int getItemCount() const;
+
+    /*! Returns the height of the tree. A tree with a single leaf has a height of 0 and
+     *  an empty tree has a height of -1. */
+    int getHeight() const;
+
+    /*! Checks the structure of the tree, making sure every node encompasses its children
+     *  and all parent and height values are correct. Used for testing. */
+    bool validate() const;
+
+protected:
+    struct Node {
+        AABB3 box;  //!< The loose AABB of the node.
+        T data;     //!< The item, if this is a leaf.
+        int parent; //!< The parent of this node, or the next free node if this is unused.
+        int left;   //!< The left child, or -1 if this is a leaf.
+        int right;  //!< The right child, or -1 if this is a leaf.
+        int height; //!< The height of this node. Leaves are 0, and unused nodes are -1.
+
+        bool isLeaf() const { return left == -1; }
+    };
+
+    int allocateNode();
+    void freeNode(int index);
+
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+
+    /*! Performs a left or right rotation if the given node is imbalanced. Returns the
+     *  index of the new root of the subtree. */
+    int balance(int index);
+
+    /*! Walks from the given node to the root, refitting AABBs and rebalancing. */
+    void refit(int index);
+
+    /*! Adds the data of every leaf under the given node to the given vector. */
+    void collectLeaves(int index, std::vector<T> &result) const;
+
+    bool validateNode(int index) const;
+
+    static AABB3 Combine(const AABB3 &lhs, const AABB3 &rhs);
+    static bool Contains(const AABB3 &outer, const AABB3 &inner);
+    static Real SurfaceArea(const AABB3 &box);
+
+protected:
+    std::vector<Node> _nodes;
+    int _root;
+    int _freeList;
+    int _itemCount;
+    Real _margin;
+
+    mutable std::vector<int> _stack; //!< Scratch space for queries.
+
+};
+
+#include "AABBTree.hpp"
+
+#endif
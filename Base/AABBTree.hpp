@@ -0,0 +1,404 @@
+/*
+ *  AABBTree.hpp
+ *  Base
+ *
+ *  Created by loch on 4/9/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _AABBTREE_HPP_
+#define _AABBTREE_HPP_
+#include "Assertion.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Initialization and destruction
+//////////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+AABBTree<T>::AABBTree(Real margin): _root(-1), _freeList(-1), _itemCount(0), _margin(margin) {}
+
+template <typename T>
+AABBTree<T>::~AABBTree() {}
+
+template <typename T>
+void AABBTree<T>::clear() {
+    _nodes.clear();
+    _root = -1;
+    _freeList = -1;
+    _itemCount = 0;
+}
+
+template <typename T>
+int AABBTree<T>::allocateNode() {
+    int index;
+    if (_freeList == -1) {
+        index = _nodes.size();
+        _nodes.push_back(Node());
+    } else {
+        index = _freeList;
+        _freeList = _nodes[index].parent;
+    }
+
+    Node &node = _nodes[index];
+    node.parent = -1;
+    node.left = -1;
+    node.right = -1;
+    node.height = 0;
+    return index;
+}
+
+template <typename T>
+void AABBTree<T>::freeNode(int index) {
+    _nodes[index].data = T();
+    _nodes[index].parent = _freeList;
+    _nodes[index].height = -1;
+    _freeList = index;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Item management
+//////////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+int AABBTree<T>::insert(const AABB3 &box, const T &data) {
+    int leaf = allocateNode();
+    _nodes[leaf].box = AABB3(box.getCenter(), box.getRadius() + Vector3(_margin));
+    _nodes[leaf].data = data;
+    insertLeaf(leaf);
+    _itemCount++;
+    return leaf;
+}
+
+template <typename T>
+void AABBTree<T>::remove(int proxy) {
+    ASSERT(proxy >= 0 && proxy < _nodes.size() && _nodes[proxy].isLeaf());
+    removeLeaf(proxy);
+    freeNode(proxy);
+    _itemCount--;
+}
+
+template <typename T>
+bool AABBTree<T>::update(int proxy, const AABB3 &box) {
+    ASSERT(proxy >= 0 && proxy < _nodes.size() && _nodes[proxy].isLeaf());
+    if (Contains(_nodes[proxy].box, box)) {
+        return false;
+    }
+
+    removeLeaf(proxy);
+    _nodes[proxy].box = AABB3(box.getCenter(), box.getRadius() + Vector3(_margin));
+    insertLeaf(proxy);
+    return true;
+}
+
+template <typename T>
+const T& AABBTree<T>::getData(int proxy) const {
+    return _nodes[proxy].data;
+}
+
+template <typename T>
+const AABB3& AABBTree<T>::getLooseAABB(int proxy) const {
+    return _nodes[proxy].box;
+}
+
+template <typename T>
+void AABBTree<T>::insertLeaf(int leaf) {
+    if (_root == -1) {
+        _root = leaf;
+        _nodes[leaf].parent = -1;
+        return;
+    }
+
+    // Walk down the tree, picking the child that results in the smallest increase in
+    // surface area, until it's cheaper to just pair up with the current node.
+    AABB3 leafBox = _nodes[leaf].box;
+    int index = _root;
+    while (!_nodes[index].isLeaf()) {
+        int left = _nodes[index].left;
+        int right = _nodes[index].right;
+
+        Real area = SurfaceArea(_nodes[index].box);
+        Real combinedArea = SurfaceArea(Combine(_nodes[index].box, leafBox));
+
+        // The cost of creating a new parent for this node and the new leaf, and the cost
+        // of pushing the leaf further down the tree.
+        Real cost = 2.0 * combinedArea;
+        Real inheritanceCost = 2.0 * (combinedArea - area);
+
+        Real leftCost = SurfaceArea(Combine(leafBox, _nodes[left].box)) + inheritanceCost;
+        if (!_nodes[left].isLeaf()) { leftCost -= SurfaceArea(_nodes[left].box); }
+
+        Real rightCost = SurfaceArea(Combine(leafBox, _nodes[right].box)) + inheritanceCost;
+        if (!_nodes[right].isLeaf()) { rightCost -= SurfaceArea(_nodes[right].box); }
+
+        if (cost < leftCost && cost < rightCost) { break; }
+        index = leftCost < rightCost ? left : right;
+    }
+
+    // Create a new parent for the chosen sibling and the new leaf.
+    int sibling = index;
+    int oldParent = _nodes[sibling].parent;
+    int newParent = allocateNode();
+
+    _nodes[newParent].parent = oldParent;
+    _nodes[newParent].box = Combine(leafBox, _nodes[sibling].box);
+    _nodes[newParent].height = _nodes[sibling].height + 1;
+    _nodes[newParent].left = sibling;
+    _nodes[newParent].right = leaf;
+    _nodes[sibling].parent = newParent;
+    _nodes[leaf].parent = newParent;
+
+    if (oldParent == -1) {
+        _root = newParent;
+    } else if (_nodes[oldParent].left == sibling) {
+        _nodes[oldParent].left = newParent;
+    } else {
+        _nodes[oldParent].right = newParent;
+    }
+
+    refit(_nodes[leaf].parent);
+}
+
+template <typename T>
+void AABBTree<T>::removeLeaf(int leaf) {
+    if (leaf == _root) {
+        _root = -1;
+        return;
+    }
+
+    int parent = _nodes[leaf].parent;
+    int grandParent = _nodes[parent].parent;
+    int sibling = _nodes[parent].left == leaf ? _nodes[parent].right : _nodes[parent].left;
+
+    // The sibling takes the place of the parent.
+    _nodes[sibling].parent = grandParent;
+    if (grandParent == -1) {
+        _root = sibling;
+    } else if (_nodes[grandParent].left == parent) {
+        _nodes[grandParent].left = sibling;
+    } else {
+        _nodes[grandParent].right = sibling;
+    }
+
+    freeNode(parent);
+    _nodes[leaf].parent = -1;
+
+    if (grandParent != -1) { refit(grandParent); }
+}
+
+template <typename T>
+void AABBTree<T>::refit(int index) {
+    while (index != -1) {
+        index = balance(index);
+
+        Node &node = _nodes[index];
+        node.height = 1 + std::max(_nodes[node.left].height, _nodes[node.right].height);
+        node.box = Combine(_nodes[node.left].box, _nodes[node.right].box);
+
+        index = node.parent;
+    }
+}
+
+template <typename T>
+int AABBTree<T>::balance(int iA) {
+    Node &a = _nodes[iA];
+    if (a.isLeaf() || a.height < 2) {
+        return iA;
+    }
+
+    int iB = a.left;
+    int iC = a.right;
+    Node &b = _nodes[iB];
+    Node &c = _nodes[iC];
+
+    int skew = c.height - b.height;
+
+    // The right side is too tall. Rotate C up.
+    if (skew > 1) {
+        int iF = c.left;
+        int iG = c.right;
+        Node &f = _nodes[iF];
+        Node &g = _nodes[iG];
+
+        c.left = iA;
+        c.parent = a.parent;
+        a.parent = iC;
+
+        if (c.parent == -1) {
+            _root = iC;
+        } else if (_nodes[c.parent].left == iA) {
+            _nodes[c.parent].left = iC;
+        } else {
+            _nodes[c.parent].right = iC;
+        }
+
+        // Keep the taller of C's children, and give the other to A.
+        if (f.height > g.height) {
+            c.right = iF;
+            a.right = iG;
+            g.parent = iA;
+            a.box = Combine(b.box, g.box);
+            c.box = Combine(a.box, f.box);
+            a.height = 1 + std::max(b.height, g.height);
+            c.height = 1 + std::max(a.height, f.height);
+        } else {
+            c.right = iG;
+            a.right = iF;
+            f.parent = iA;
+            a.box = Combine(b.box, f.box);
+            c.box = Combine(a.box, g.box);
+            a.height = 1 + std::max(b.height, f.height);
+            c.height = 1 + std::max(a.height, g.height);
+        }
+
+        return iC;
+    }
+
+    // The left side is too tall. Rotate B up.
+    if (skew < -1) {
+        int iD = b.left;
+        int iE = b.right;
+        Node &d = _nodes[iD];
+        Node &e = _nodes[iE];
+
+        b.left = iA;
+        b.parent = a.parent;
+        a.parent = iB;
+
+        if (b.parent == -1) {
+            _root = iB;
+        } else if (_nodes[b.parent].left == iA) {
+            _nodes[b.parent].left = iB;
+        } else {
+            _nodes[b.parent].right = iB;
+        }
+
+        // Keep the taller of B's children, and give the other to A.
+        if (d.height > e.height) {
+            b.right = iD;
+            a.left = iE;
+            e.parent = iA;
+            a.box = Combine(c.box, e.box);
+            b.box = Combine(a.box, d.box);
+            a.height = 1 + std::max(c.height, e.height);
+            b.height = 1 + std::max(a.height, d.height);
+        } else {
+            b.right = iE;
+            a.left = iD;
+            d.parent = iA;
+            a.box = Combine(c.box, d.box);
+            b.box = Combine(a.box, e.box);
+            a.height = 1 + std::max(c.height, d.height);
+            b.height = 1 + std::max(a.height, e.height);
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Queries
+//////////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+void AABBTree<T>::query(const Frustum &frustum, std::vector<T> &intersecting, std::vector<T> &contained) const {
+    if (_root == -1) { return; }
+
+    _stack.clear();
+    _stack.push_back(_root);
+    while (!_stack.empty()) {
+        int index = _stack.back();
+        _stack.pop_back();
+
+        const Node &node = _nodes[index];
+        switch (frustum.checkAABB(node.box)) {
+        case Frustum::COMPLETE_OUT:
+            break;
+        case Frustum::COMPLETE_IN:
+            collectLeaves(index, contained);
+            break;
+        case Frustum::INTERSECT:
+            if (node.isLeaf()) {
+                intersecting.push_back(node.data);
+            } else {
+                _stack.push_back(node.left);
+                _stack.push_back(node.right);
+            }
+            break;
+        }
+    }
+}
+
+template <typename T>
+void AABBTree<T>::collectLeaves(int index, std::vector<T> &result) const {
+    const Node &node = _nodes[index];
+    if (node.isLeaf()) {
+        result.push_back(node.data);
+    } else {
+        collectLeaves(node.left, result);
+        collectLeaves(node.right, result);
+    }
+}
+
+template <typename T>
+int AABBTree<T>::getItemCount() const {
+    return _itemCount;
+}
+
+template <typename T>
+int AABBTree<T>::getHeight() const {
+    return _root == -1 ? -1 : _nodes[_root].height;
+}
+
+template <typename T>
+bool AABBTree<T>::validate() const {
+    if (_root == -1) { return _itemCount == 0; }
+    if (_nodes[_root].parent != -1) { return false; }
+    return validateNode(_root);
+}
+
+template <typename T>
+bool AABBTree<T>::validateNode(int index) const {
+    const Node &node = _nodes[index];
+    if (node.isLeaf()) {
+        return node.height == 0;
+    }
+
+    const Node &left = _nodes[node.left];
+    const Node &right = _nodes[node.right];
+    if (left.parent != index || right.parent != index) { return false; }
+    if (node.height != 1 + std::max(left.height, right.height)) { return false; }
+    if (!Contains(node.box, left.box) || !Contains(node.box, right.box)) { return false; }
+
+    return validateNode(node.left) && validateNode(node.right);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Helpers
+//////////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+AABB3 AABBTree<T>::Combine(const AABB3 &lhs, const AABB3 &rhs) {
+    AABB3 result(lhs);
+    result.encompass(rhs);
+    return result;
+}
+
+template <typename T>
+bool AABBTree<T>::Contains(const AABB3 &outer, const AABB3 &inner) {
+    Vector3 outerMin = outer.getMin(), outerMax = outer.getMax();
+    Vector3 innerMin = inner.getMin(), innerMax = inner.getMax();
+
+    // AABBs are stored as a center and radius, so combining them isn't exact.
+    for (int i = 0; i < 3; i++) {
+        if (Math::lt(innerMin[i], outerMin[i]) || Math::gt(innerMax[i], outerMax[i])) { return false; }
+    }
+
+    return true;
+}
+
+template <typename T>
+Real AABBTree<T>::SurfaceArea(const AABB3 &box) {
+    const Vector3 &r = box.getRadius();
+    return 8.0 * (r[0] * r[1] + r[1] * r[2] + r[2] * r[0]);
+}
+
+#endif
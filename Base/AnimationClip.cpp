@@ -0,0 +1,224 @@
+/*
+ *  AnimationClip.cpp
+ *  Base
+ *
+ *  Created by loch on 5/9/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "AnimationClip.h"
+#include "Assertion.h"
+#include "Math3D.h"
+#include <algorithm>
+#include <cstring>
+
+const Real AnimationClip::DefaultTolerance = .001;
+
+// Everything but the largest component of a unit quaternion is within this of zero.
+static const Real QuantizeRange = 0.70710678118654752;
+static const Real QuantizeSteps = 32767;
+
+#pragma mark Quantization
+
+void AnimationClip::QuantizeRotation(const Quaternion &rotation, unsigned short *result) {
+    int largest = 0;
+    for (int i = 1; i < 4; i++) {
+        if (fabs(rotation.val[i]) > fabs(rotation.val[largest])) { largest = i; }
+    }
+
+    // q and -q are the same rotation, so flip things so the dropped component is positive.
+    Real sign = rotation.val[largest] < 0 ? -1 : 1;
+    for (int i = 0, j = 0; i < 4; i++) {
+        if (i == largest) { continue; }
+        Real normalized = (rotation.val[i] * sign / QuantizeRange + 1) * .5;
+        int value = (int)(normalized * QuantizeSteps + .5);
+        result[j++] = std::min(std::max(value, 0), (int)QuantizeSteps);
+    }
+
+    // The index of the dropped component goes in the spare top bits.
+    result[0] |= (largest & 2) << 14;
+    result[1] |= (largest & 1) << 15;
+}
+
+void AnimationClip::DequantizeRotation(const unsigned short *packed, Quaternion &result) {
+    int largest = ((packed[0] >> 14) & 2) | (packed[1] >> 15);
+    Real sum = 0;
+    for (int i = 0, j = 0; i < 4; i++) {
+        if (i == largest) { continue; }
+        Real value = ((packed[j++] & 0x7FFF) / QuantizeSteps * 2 - 1) * QuantizeRange;
+        result.val[i] = value;
+        sum += value * value;
+    }
+
+    result.val[largest] = Math::Sqrt(std::max<Real>(1 - sum, 0));
+}
+
+#pragma mark AnimationClip definitions
+
+AnimationClip::AnimationClip(const std::string &name, Real frameRate,
+const std::vector<Pose> &frames, Real tolerance): _name(name), _frameRate(frameRate),
+_frameCount(frames.size()), _boneCount(0) {
+    ASSERT(frames.size() > 0 && frames.size() <= 65536);
+    _boneCount = frames[0].getBoneCount();
+    for (int i = 1; i < _frameCount; i++) {
+        ASSERT_EQ(frames[i].getBoneCount(), _boneCount);
+    }
+
+    // A rotation that quantizes the same way in every frame is only stored once.
+    _constantRotations = frames[0].rotations;
+    std::vector<unsigned short> packed(_frameCount * _boneCount * 3);
+    for (int bone = 0; bone < _boneCount; bone++) {
+        bool constant = true;
+        for (int i = 0; i < _frameCount; i++) {
+            unsigned short *current = &packed[(i * _boneCount + bone) * 3];
+            QuantizeRotation(frames[i].rotations[bone], current);
+            if (i > 0 && memcmp(current, &packed[bone * 3], 3 * sizeof(unsigned short))) {
+                constant = false;
+            }
+        }
+
+        if (!constant) { _animatedBones.push_back(bone); }
+    }
+
+    _rotations.reserve(_frameCount * _animatedBones.size() * 3);
+    for (int i = 0; i < _frameCount; i++) {
+        for (int j = 0; j < _animatedBones.size(); j++) {
+            const unsigned short *source = &packed[(i * _boneCount + _animatedBones[j]) * 3];
+            _rotations.insert(_rotations.end(), source, source + 3);
+        }
+    }
+
+    for (int bone = 0; bone < _boneCount; bone++) {
+        _translationCurves.push_back(fitCurve(frames, &Pose::translations, bone, tolerance));
+        _scaleCurves.push_back(fitCurve(frames, &Pose::scales, bone, tolerance));
+    }
+}
+
+AnimationClip::~AnimationClip() {}
+
+const std::string &AnimationClip::getName() const {
+    return _name;
+}
+
+int AnimationClip::getBoneCount() const {
+    return _boneCount;
+}
+
+int AnimationClip::getFrameCount() const {
+    return _frameCount;
+}
+
+Real AnimationClip::getFrameRate() const {
+    return _frameRate;
+}
+
+Real AnimationClip::getDuration() const {
+    return (_frameCount - 1) / _frameRate;
+}
+
+int AnimationClip::getKeyCount() const {
+    return _keyFrames.size();
+}
+
+long long AnimationClip::getByteCount() const {
+    return sizeof(AnimationClip) +
+        _constantRotations.size() * sizeof(Quaternion) +
+        _animatedBones.size() * sizeof(int) +
+        _rotations.size() * sizeof(unsigned short) +
+        (_translationCurves.size() + _scaleCurves.size()) * sizeof(Curve) +
+        _keyFrames.size() * sizeof(unsigned short) +
+        _keyValues.size() * sizeof(Vector3);
+}
+
+void AnimationClip::sample(Real time, Pose &pose, bool loop) const {
+    Real last = _frameCount - 1;
+    Real frame = time * _frameRate;
+    if (loop && last > 0) {
+        frame = fmod(frame, last);
+        if (frame < 0) { frame += last; }
+    } else {
+        frame = std::min(std::max<Real>(frame, 0), last);
+    }
+
+    int first = std::min((int)frame, _frameCount - 1);
+    int second = std::min(first + 1, _frameCount - 1);
+    Real percent = frame - first;
+
+    pose.resize(_boneCount);
+    std::copy(_constantRotations.begin(), _constantRotations.end(), pose.rotations.begin());
+
+    int animated = _animatedBones.size();
+    const unsigned short *from = animated ? &_rotations[first * animated * 3] : NULL;
+    const unsigned short *to = animated ? &_rotations[second * animated * 3] : NULL;
+    for (int i = 0; i < animated; i++) {
+        Quaternion &rotation = pose.rotations[_animatedBones[i]];
+        DequantizeRotation(from + i * 3, rotation);
+        if (percent > 0) {
+            Quaternion next;
+            DequantizeRotation(to + i * 3, next);
+            rotation.nlerp(next, percent);
+        }
+    }
+
+    for (int bone = 0; bone < _boneCount; bone++) {
+        pose.translations[bone] = sampleCurve(_translationCurves[bone], frame);
+        pose.scales[bone] = sampleCurve(_scaleCurves[bone], frame);
+    }
+}
+
+#pragma mark Curves
+
+AnimationClip::Curve AnimationClip::fitCurve(const std::vector<Pose> &frames,
+std::vector<Vector3> Pose::*component, int bone, Real tolerance) {
+    Curve curve;
+    curve.offset = _keyFrames.size();
+
+    const Vector3 &initial = (frames[0].*component)[bone];
+    bool constant = true;
+    for (int i = 1; i < _frameCount && constant; i++) {
+        constant = (frames[i].*component)[bone].distanceTo(initial) <= tolerance;
+    }
+
+    _keyFrames.push_back(0);
+    _keyValues.push_back(initial);
+    if (!constant) {
+        // Grow each segment until some frame in the middle of it is too far off of the
+        // line between its ends, then start a new segment at the last frame that fit.
+        int start = 0;
+        for (int end = start + 2; end < _frameCount; end++) {
+            const Vector3 &a = (frames[start].*component)[bone];
+            const Vector3 &b = (frames[end].*component)[bone];
+            bool fits = true;
+            for (int i = start + 1; i < end && fits; i++) {
+                Vector3 expected = a + (b - a) * ((Real)(i - start) / (end - start));
+                fits = (frames[i].*component)[bone].distanceTo(expected) <= tolerance;
+            }
+
+            if (!fits) {
+                start = end - 1;
+                _keyFrames.push_back(start);
+                _keyValues.push_back((frames[start].*component)[bone]);
+            }
+        }
+
+        _keyFrames.push_back(_frameCount - 1);
+        _keyValues.push_back((frames[_frameCount - 1].*component)[bone]);
+    }
+
+    curve.count = _keyFrames.size() - curve.offset;
+    return curve;
+}
+
+Vector3 AnimationClip::sampleCurve(const Curve &curve, Real frame) const {
+    if (curve.count == 1) { return _keyValues[curve.offset]; }
+
+    const unsigned short *begin = &_keyFrames[curve.offset];
+    int next = std::upper_bound(begin, begin + curve.count, frame) - begin;
+    if (next == curve.count) { return _keyValues[curve.offset + curve.count - 1]; }
+
+    const Vector3 &a = _keyValues[curve.offset + next - 1];
+    const Vector3 &b = _keyValues[curve.offset + next];
+    Real percent = (frame - begin[next - 1]) / (begin[next] - begin[next - 1]);
+    return a + (b - a) * percent;
+}
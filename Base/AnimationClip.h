@@ -0,0 +1,102 @@
+/*
+ *  AnimationClip.h
+ *  Base
+ *
+ *  Created by loch on 5/9/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _ANIMATIONCLIP_H_
+#define _ANIMATIONCLIP_H_
+#include "Skeleton.h"
+
+/*! AnimationClip stores a single compressed animation for a skeleton and samples it into
+ *  Poses. Clips are built from the raw animation: one Pose for every frame, at a fixed
+ *  frame rate. The raw frames are compressed in two different ways:
+ *
+ *  Rotations are quantized to 48 bits each, using the "smallest three" encoding: the
+ *  largest component is dropped, since it can be rebuilt from the other three, and the
+ *  remaining three are stored in 15 bits each. That's good to about 5e-5 per component,
+ *  at three eighths of the size of a Quaternion. Rotations are kept for every frame, with
+ *  all of the bones for a single frame stored together, so sampling reads two short,
+ *  contiguous runs of memory. Bones whose rotation never changes are stored only once.
+ *
+ *  Translations and scales are reduced to the fewest keys that still reproduce every raw
+ *  frame to within the given tolerance when interpolated linearly. Most bones only ever
+ *  rotate, so these usually shrink to a single key.
+ * \brief A compressed skeletal animation.
+ * \seealso Skeleton, Animator */
+class AnimationClip {
+public:
+    /*! The default distance translations and scales may drift from the raw frames. */
+    static const Real DefaultTolerance;
+
+    /*! Packs a unit quaternion into 48 bits. */
+    static void QuantizeRotation(const Quaternion &rotation, unsigned short *result);
+
+    /*! Unpacks a quaternion packed by QuantizeRotation. */
+    static void DequantizeRotation(const unsigned short *packed, Quaternion &result);
+
+public:
+    /*! Compresses the given frames, which must all have the same number of bones. There
+     *  must be at least one frame, and no more than 65536. */
+    AnimationClip(const std::string &name, Real frameRate, const std::vector<Pose> &frames,
+                  Real tolerance = DefaultTolerance);
+
+    ~AnimationClip();
+
+    const std::string &getName() const;
+
+    int getBoneCount() const;
+
+    int getFrameCount() const;
+
+    Real getFrameRate() const;
+
+    /*! Gets the length of the clip in seconds, from the first frame to the last. */
+    Real getDuration() const;
+
+    /*! Gets the number of translation and scale keys kept after compression. */
+    int getKeyCount() const;
+
+    /*! Gets the number of bytes used by the compressed animation. */
+    long long getByteCount() const;
+
+    /*! Fills in the given pose at the given time, in seconds. Looping clips wrap around,
+     *  and others hold their first and last frames outside of the clip. */
+    void sample(Real time, Pose &pose, bool loop = true) const;
+
+protected:
+    /*! The keys for a single bone's translation or scale. */
+    struct Curve {
+        unsigned int offset;          //!< The index of the curve's first key.
+        unsigned int count;
+    };
+
+    /*! Builds a curve from a single component of every raw frame. */
+    Curve fitCurve(const std::vector<Pose> &frames, std::vector<Vector3> Pose::*component,
+                   int bone, Real tolerance);
+
+    /*! Finds the value of the given curve at the given frame. */
+    Vector3 sampleCurve(const Curve &curve, Real frame) const;
+
+protected:
+    std::string _name;
+    Real _frameRate;
+    int _frameCount;
+    int _boneCount;
+
+    std::vector<Quaternion> _constantRotations; //!< Used for bones not in _animatedBones.
+    std::vector<int> _animatedBones;            //!< The bones with a rotation every frame.
+    std::vector<unsigned short> _rotations;     //!< Three shorts for each animated bone in
+                                                //!< each frame, frame by frame.
+
+    std::vector<Curve> _translationCurves;
+    std::vector<Curve> _scaleCurves;
+    std::vector<unsigned short> _keyFrames;     //!< The frame of each key, for all curves.
+    std::vector<Vector3> _keyValues;            //!< The value of each key, for all curves.
+
+};
+
+#endif
@@ -0,0 +1,109 @@
+/*
+ *  Animator.cpp
+ *  Base
+ *
+ *  Created by loch on 5/9/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "Animator.h"
+#include "Assertion.h"
+#include "WorkerPool.h"
+#include "Profiler.h"
+
+#pragma mark Steps
+
+void Animator::Blend(const Pose &from, const Pose &to, Real weight, Pose &result) {
+    int count = from.getBoneCount();
+    ASSERT_EQ(to.getBoneCount(), count);
+    result.resize(count);
+
+    for (int i = 0; i < count; i++) {
+        Quaternion rotation(from.rotations[i]);
+        rotation.nlerp(to.rotations[i], weight);
+        result.rotations[i] = rotation;
+    }
+
+    for (int i = 0; i < count; i++) {
+        result.translations[i] = from.translations[i] +
+            (to.translations[i] - from.translations[i]) * weight;
+    }
+
+    for (int i = 0; i < count; i++) {
+        result.scales[i] = from.scales[i] + (to.scales[i] - from.scales[i]) * weight;
+    }
+}
+
+void Animator::LocalToModel(const Skeleton &skeleton, const Pose &pose, Matrix *model) {
+    int count = skeleton.getBoneCount();
+    ASSERT_EQ(pose.getBoneCount(), count);
+
+    // Parents always come first, so they're finished before any of their children.
+    const int *parents = skeleton.getParents();
+    for (int i = 0; i < count; i++) {
+        Skeleton::Compose(pose.rotations[i], pose.translations[i], pose.scales[i], model[i]);
+        if (parents[i] >= 0) {
+            model[i] = model[parents[i]] * model[i];
+        }
+    }
+}
+
+void Animator::BuildPalette(const Skeleton &skeleton, const Matrix *model, Matrix *palette) {
+    Matrix::Multiply(model, skeleton.getInverseBindMatrices(), palette, skeleton.getBoneCount());
+}
+
+#pragma mark Animator definitions
+
+Animator::Animator(WorkerPool *workers): _workers(workers), _characters(NULL),
+_characterCount(0), _chunkCount(0) {}
+
+Animator::~Animator() {}
+
+void Animator::animate(Character *characters, int count) {
+    PROFILE("Animation");
+    if (count == 0) { return; }
+
+    // A few pieces per thread evens things out when characters differ in cost.
+    _chunkCount = _workers ? std::min(count, (_workers->getThreadCount() + 1) * 4) : 1;
+    if (_scratch.size() < _chunkCount) {
+        _scratch.resize(_chunkCount);
+    }
+
+    _characters = characters;
+    _characterCount = count;
+    if (_workers) {
+        _workers->run(AnimateJob, this, _chunkCount);
+    } else {
+        AnimateJob(this, 0);
+    }
+
+    _characters = NULL;
+}
+
+void Animator::AnimateJob(void *data, int index) {
+    Animator *self = (Animator*)data;
+    int begin = (long long)self->_characterCount * index / self->_chunkCount;
+    int end = (long long)self->_characterCount * (index + 1) / self->_chunkCount;
+    for (int i = begin; i < end; i++) {
+        Animate(self->_characters[i], self->_scratch[index]);
+    }
+}
+
+void Animator::Animate(const Character &character, Scratch &scratch) {
+    const Skeleton &skeleton = *character.skeleton;
+    ASSERT_EQ(character.clip->getBoneCount(), skeleton.getBoneCount());
+
+    character.clip->sample(character.time, scratch.pose, character.loop);
+    if (character.blendClip && character.blendWeight > 0) {
+        character.blendClip->sample(character.blendTime, scratch.blend, character.loop);
+        Blend(scratch.pose, scratch.blend, character.blendWeight, scratch.pose);
+    }
+
+    if (scratch.model.size() < skeleton.getBoneCount()) {
+        scratch.model.resize(skeleton.getBoneCount());
+    }
+
+    LocalToModel(skeleton, scratch.pose, &scratch.model[0]);
+    BuildPalette(skeleton, &scratch.model[0], character.palette);
+}
@@ -0,0 +1,89 @@
+/*
+ *  Animator.h
+ *  Base
+ *
+ *  Created by loch on 5/9/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _ANIMATOR_H_
+#define _ANIMATOR_H_
+#include "AnimationClip.h"
+
+class WorkerPool;
+
+/*! Animator turns AnimationClips into matrix palettes for skinning. Each character goes
+ *  through the same steps:
+ *      1. Its clip is sampled into a local space Pose.
+ *      2. Optionally, a second clip is sampled and blended in.
+ *      3. The pose is taken to model space, in a single pass over the skeleton.
+ *      4. Each bone's inverse bind matrix is applied, giving the palette.
+ *
+ *  The steps are all available on their own, but the usual way to use this is to fill in
+ *  a Character for everything animated and hand the whole list to animate once a frame.
+ *  Characters are completely independent, so if the animator was given a WorkerPool the
+ *  list is split up across its threads. All of the scratch space is kept between calls,
+ *  so once it has grown to fit, animating allocates nothing.
+ * \brief Samples, blends, and skins many skeletons at once.
+ * \seealso Skeleton, AnimationClip */
+class Animator {
+public:
+    /*! Everything needed to animate a single character. */
+    struct Character {
+        const Skeleton *skeleton;
+        const AnimationClip *clip;
+        Real time;                         //!< The time in clip, in seconds.
+        const AnimationClip *blendClip;    //!< A second clip to blend in, or NULL.
+        Real blendTime;
+        Real blendWeight;                  //!< 0 for all clip, 1 for all blendClip.
+        bool loop;
+        Matrix *palette;                   //!< Room for a matrix for every bone.
+    };
+
+    /*! Blends each bone of two poses, which must have the same number of bones. The
+     *  result may be either input. */
+    static void Blend(const Pose &from, const Pose &to, Real weight, Pose &result);
+
+    /*! Finds the model space matrix of every bone in the given pose. */
+    static void LocalToModel(const Skeleton &skeleton, const Pose &pose, Matrix *model);
+
+    /*! Applies the inverse bind matrix of each bone to its model space matrix. The
+     *  palette may be the same array as the model space matrices. */
+    static void BuildPalette(const Skeleton &skeleton, const Matrix *model, Matrix *palette);
+
+public:
+    /*! Creates an animator that runs on the given pool, or just the calling thread if the
+     *  pool is NULL. The pool isn't owned by the animator. */
+    Animator(WorkerPool *workers = NULL);
+
+    ~Animator();
+
+    /*! Fills in the palette of every given character. */
+    void animate(Character *characters, int count);
+
+protected:
+    /*! Space reused by each piece of a job. */
+    struct Scratch {
+        Pose pose;
+        Pose blend;
+        std::vector<Matrix> model;
+    };
+
+    /*! Animates one piece of the current list. Used as a WorkerPool job, with the
+     *  Animator as the data. */
+    static void AnimateJob(void *data, int index);
+
+    /*! Runs every step for a single character. */
+    static void Animate(const Character &character, Scratch &scratch);
+
+protected:
+    WorkerPool *_workers;
+    Character *_characters;                //!< The list being animated by AnimateJob.
+    int _characterCount;
+    int _chunkCount;                       //!< The number of pieces the list is split into.
+    std::vector<Scratch> _scratch;         //!< One for each piece.
+
+};
+
+#endif
@@ -8,87 +8,291 @@
  */
 
 #include "Archive.h"
+#include "ArchiveTarget.h"
 #include "DataTarget.h"
+#include "MappedFile.h"
 #include "BinaryStream.h"
 #include "Assertion.h"
+#include "Math3D.h"
+
+#include <algorithm>
+#include <cstring>
 
 Archive::Archive(const std::string &n, IOTarget *t, bool cleanUp): _name(n), _target(t),
-_error(false), _cleanUp(cleanUp) {
-    loadEndOfCDR();
-    if (_endOfCDR.sizeOfCDR          == 0xFFFFFFFF ||
-        _endOfCDR.offsetOfStartOfCDR == 0xFFFFFFFF) {
-        Error("Unsupported ZIP format loaded!!!");
-        _error = true;
-        return;
+_error(false), _cleanUp(cleanUp), _mapped(NULL), _cdrOffset(0), _cdrSize(0), _cdrEntries(0) {
+    pthread_mutex_init(&_mutex, NULL);
+
+    // Mapped archives stay open for as long as the Archive exists, so the views handed
+    // out by open always point at valid memory.
+    if ((_mapped = dynamic_cast<MappedFile*>(_target))) {
+        if (!_mapped->isOpen() && !_mapped->open(IOTarget::Read)) {
+            Warn("Unable to map archive " << _name);
+            _error = true;
+            return;
+        }
     }
 
-    loadFileHeaders();
-    extractDirs();
+    loadEndOfCDR();
+    if (!_error) {
+        loadFileHeaders();
+    }
 }
 
 Archive::~Archive() {
     if (_cleanUp) {
         delete _target;
     }
+
+    pthread_mutex_destroy(&_mutex);
 }
 
-void Archive::extractDirs() {
-    std::list<std::string> topDirs;
-    std::list<FileHeader>::iterator topItr;
-    for (topItr = _files.begin(); topItr != _files.end(); topItr++) {
-        if (topItr->dir.size()) {
-            topDirs.push_front(topItr->dir);
-        }
+void Archive::releaseTarget() const {
+    if (!_mapped) {
+        _target->close();
     }
+}
 
-    // Remove the duplicates in the list.
-    topDirs.sort();
-    topDirs.unique();
-
-    // Because we want to add ALL directories, not just those containing files, we need to
-    // loop through all of the directories containing files (obtained above) and then add
-    // both them and all of their parents to the _dirs set. We break down the directories
-    // here rather than in the above loop because there will generally be far fewer
-    // directories than files in a ZIP and there will be at worst the same number.
-    std::list<std::string>::iterator itr;
-    for (itr = topDirs.begin(); itr != topDirs.end(); itr++) {
-        while(itr->size()) {
-            // Insert the current string.
-            _dirs.insert(*itr);
-
-            // Set pos to the last '/' or 0 if there are no more.
-            std::string::size_type pos = itr->rfind('/');
-            pos = pos == std::string::npos ? 0 : pos;
-
-            // Erase everything after pos.
-            itr->erase(pos);
-        }
-    }
+bool Archive::isZeroCopy() const {
+    return _mapped != NULL;
 }
 
 void Archive::loadFileHeaders() {
     BinaryStream bin(_target, IOTarget::Read, false);
-    bin.seek(_endOfCDR.offsetOfStartOfCDR, IOTarget::Beginning);
+    bin.seek(_cdrOffset, IOTarget::Beginning);
+
+    std::vector<PendingEntry> pending;
+    pending.reserve(Math::Min(_cdrEntries, _cdrSize / (long long)sizeof(ZIP_FileHeader)));
 
     ZIP_FileHeader current;
-    while(bin.position() - _endOfCDR.offsetOfStartOfCDR < _endOfCDR.sizeOfCDR) {
+    std::vector<char> cname, extra;
+    while(bin.position() - _cdrOffset < _cdrSize) {
         bin.read(&current, sizeof(ZIP_FileHeader));
         if (current.signature != ZIP_FileSig) {
             break;
         }
 
-        char* cname = new char[current.fileNameLength + 1];
-        cname[current.fileNameLength] = '\0';
+        unsigned short nameLength = current.fileNameLength;
+        unsigned short extraLength = current.extraFieldLength;
+        cname.resize(nameLength + 1);
+        extra.resize(extraLength);
+        bin.read(&cname[0], nameLength);
+        if (extraLength) { bin.read(&extra[0], extraLength); }
+        bin.seek((unsigned short)current.fileCommentLength, IOTarget::Current);
+
+        // Directories show up in the central directory as empty files with a trailing
+        // '/'. They're rebuilt from the file paths, so there's no need to keep them.
+        if (nameLength == 0 || cname[nameLength - 1] == '/') {
+            continue;
+        }
+
+        pending.push_back(PendingEntry());
+        PendingEntry &entry = pending.back();
+        entry.path.assign(&cname[0], nameLength);
+        entry.compressedSize = (unsigned int)current.compressedSize;
+        entry.uncompressedSize = (unsigned int)current.uncompressedSize;
+        entry.headerOffset = (unsigned int)current.relativeOffsetOfLocalHeader;
+        entry.method = current.compressionMethod;
+        readZip64Extra(extra, entry, current);
+        formatPath(entry.path);
+
+        if (current.generalPurposeBitFlag & 0x1) {
+            Warn("Encrypted files are not supported: " << entry.path);
+            entry.method = -1;
+        }
+    }
+
+    releaseTarget();
+
+    buildIndex(pending);
+}
+
+void Archive::readZip64Extra(const std::vector<char> &extra, PendingEntry &entry,
+                             const ZIP_FileHeader &header) {
+    unsigned int pos = 0;
+    while (pos + sizeof(ZIP_ExtraHeader) <= extra.size()) {
+        ZIP_ExtraHeader field;
+        memcpy(&field, &extra[pos], sizeof(ZIP_ExtraHeader));
+        pos += sizeof(ZIP_ExtraHeader);
+
+        unsigned int end = Math::Min(pos + (unsigned short)field.size, (unsigned int)extra.size());
+        if (field.id == ZIP64_ExtraID) {
+            // Only the values that didn't fit in the header are present, in this order.
+            long long *values[3] = { NULL, NULL, NULL };
+            int count = 0;
+            if ((unsigned int)header.uncompressedSize == ZIP64_Marker) { values[count++] = &entry.uncompressedSize; }
+            if ((unsigned int)header.compressedSize == ZIP64_Marker) { values[count++] = &entry.compressedSize; }
+            if ((unsigned int)header.relativeOffsetOfLocalHeader == ZIP64_Marker) { values[count++] = &entry.headerOffset; }
+
+            for (int i = 0; i < count && pos + sizeof(long long) <= end; i++) {
+                memcpy(values[i], &extra[pos], sizeof(long long));
+                pos += sizeof(long long);
+            }
+        }
+
+        pos = end;
+    }
+}
+
+void Archive::buildIndex(std::vector<PendingEntry> &pending) {
+    // Drop any duplicate paths in the archive, keeping whichever came first.
+    std::stable_sort(pending.begin(), pending.end());
+    std::vector<PendingEntry>::iterator last = std::unique(pending.begin(), pending.end());
+    if (last != pending.end()) {
+        Warn("Ignoring " << (pending.end() - last) << " duplicate files in " << _name);
+        pending.erase(last, pending.end());
+    }
+
+    // Gather the directories directly containing files first. There will generally be far
+    // fewer of these than files, so breaking them down into their parents afterwards is
+    // much cheaper than doing it for every file.
+    std::vector<std::string> dirs;
+    std::string::size_type pos;
+    for (unsigned int i = 0; i < pending.size(); i++) {
+        pos = pending[i].path.rfind('/');
+        if (pos != std::string::npos && (dirs.empty() || dirs.back().size() != pos ||
+            pending[i].path.compare(0, pos, dirs.back()) != 0)) {
+            dirs.push_back(pending[i].path.substr(0, pos));
+        }
+    }
+
+    // Add ALL directories, not just those containing files. The root is the empty string,
+    // so it always sorts to index 0.
+    unsigned int topCount = dirs.size();
+    for (unsigned int i = 0; i < topCount; i++) {
+        std::string dir = dirs[i];
+        while ((pos = dir.rfind('/')) != std::string::npos) {
+            dir.erase(pos);
+            dirs.push_back(dir);
+        }
+    }
+
+    dirs.push_back("");
+    std::sort(dirs.begin(), dirs.end());
+    dirs.erase(std::unique(dirs.begin(), dirs.end()), dirs.end());
+
+    // Fill in the tables.
+    _entries.resize(pending.size());
+    for (unsigned int i = 0; i < pending.size(); i++) {
+        Entry &entry = _entries[i];
+        entry.name = addName(pending[i].path);
+        entry.compressedSize = pending[i].compressedSize;
+        entry.uncompressedSize = pending[i].uncompressedSize;
+        entry.headerOffset = pending[i].headerOffset;
+        entry.method = pending[i].method;
+    }
+
+    _directories.resize(dirs.size());
+    for (unsigned int i = 0; i < dirs.size(); i++) {
+        Directory &dir = _directories[i];
+        dir.name = addName(dirs[i]);
+
+        // Everything below a directory shares its path followed by a '/', and '0' is the
+        // character directly after '/', so the range ends at the path followed by a '0'.
+        if (i == 0) {
+            dir.files = 0;
+            dir.filesEnd = pending.size();
+            dir.dirs = 1;
+            dir.dirsEnd = dirs.size();
+        } else {
+            std::string first = dirs[i] + '/', last = dirs[i] + '0';
+            dir.files    = std::lower_bound(pending.begin(), pending.end(), first) - pending.begin();
+            dir.filesEnd = std::lower_bound(pending.begin(), pending.end(), last) - pending.begin();
+            dir.dirs     = std::lower_bound(dirs.begin(), dirs.end(), first) - dirs.begin();
+            dir.dirsEnd  = std::lower_bound(dirs.begin(), dirs.end(), last) - dirs.begin();
+        }
+    }
+
+    // Find the parent of every file and directory, then group the children by parent with
+    // a counting sort. Both tables are already sorted by path, so the children of each
+    // directory stay sorted as well.
+    std::vector<unsigned int> fileParents(_entries.size()), dirParents(dirs.size(), 0);
+    for (unsigned int i = 0; i < pending.size(); i++) {
+        pos = pending[i].path.rfind('/');
+        fileParents[i] = pos == std::string::npos ? 0 : std::lower_bound(dirs.begin(),
+            dirs.end(), pending[i].path.substr(0, pos)) - dirs.begin();
+    }
+
+    for (unsigned int i = 1; i < dirs.size(); i++) {
+        pos = dirs[i].rfind('/');
+        dirParents[i] = pos == std::string::npos ? 0 : std::lower_bound(dirs.begin(),
+            dirs.end(), dirs[i].substr(0, pos)) - dirs.begin();
+    }
+
+    std::vector<unsigned int> fileCounts(dirs.size() + 1, 0), dirCounts(dirs.size() + 1, 0);
+    for (unsigned int i = 0; i < fileParents.size(); i++) { fileCounts[fileParents[i] + 1]++; }
+    for (unsigned int i = 1; i < dirParents.size(); i++) { dirCounts[dirParents[i] + 1]++; }
+    for (unsigned int i = 0; i < dirs.size(); i++) {
+        fileCounts[i + 1] += fileCounts[i];
+        dirCounts[i + 1] += dirCounts[i];
+        _directories[i].childFiles = _directories[i].childFilesEnd = fileCounts[i];
+        _directories[i].childDirs = _directories[i].childDirsEnd = dirCounts[i];
+    }
+
+    _childFiles.resize(fileParents.size());
+    for (unsigned int i = 0; i < fileParents.size(); i++) {
+        _childFiles[_directories[fileParents[i]].childFilesEnd++] = i;
+    }
+
+    _childDirs.resize(dirs.size() - 1);
+    for (unsigned int i = 1; i < dirParents.size(); i++) {
+        _childDirs[_directories[dirParents[i]].childDirsEnd++] = i;
+    }
+
+    buildBuckets(_entries, _entryBuckets);
+    buildBuckets(_directories, _dirBuckets);
+}
+
+Archive::Name Archive::addName(const std::string &path) {
+    Name name;
+    name.hash = Hash(path.data(), path.size());
+    name.offset = _names.size();
+    name.length = path.size();
+    _names.insert(_names.end(), path.begin(), path.end());
+    return name;
+}
+
+std::string Archive::getName(const Name &name) const {
+    return name.length ? std::string(&_names[name.offset], name.length) : std::string();
+}
 
-        bin.read(cname, current.fileNameLength);
-        bin.seek(current.extraSize(), IOTarget::Current);
-        std::string name(cname);
-        delete[] cname;
+template <typename T>
+void Archive::buildBuckets(const std::vector<T> &items, std::vector<unsigned int> &buckets) {
+    // Keep the load factor at or below one half so probe sequences stay short.
+    unsigned int size = 2;
+    while (size < items.size() * 2) { size <<= 1; }
+    buckets.assign(size, 0);
+
+    unsigned int mask = size - 1;
+    for (unsigned int i = 0; i < items.size(); i++) {
+        unsigned int bucket = items[i].name.hash & mask;
+        while (buckets[bucket]) { bucket = (bucket + 1) & mask; }
+        buckets[bucket] = i + 1;
+    }
+}
 
-        _files.push_front(FileHeader(current, name));
+template <typename T>
+int Archive::find(const std::vector<T> &items, const std::vector<unsigned int> &buckets,
+                  const std::string &path) const {
+    unsigned int hash = Hash(path.data(), path.size());
+    unsigned int mask = buckets.size() - 1;
+    for (unsigned int bucket = hash & mask; buckets[bucket]; bucket = (bucket + 1) & mask) {
+        const Name &name = items[buckets[bucket] - 1].name;
+        if (name.hash == hash && name.length == path.size() &&
+            (name.length == 0 || memcmp(&_names[name.offset], path.data(), name.length) == 0)) {
+            return buckets[bucket] - 1;
+        }
     }
 
-    _target->close();
+    return -1;
+}
+
+unsigned int Archive::Hash(const char *str, unsigned int length) {
+    unsigned int hash = 2166136261u;
+    for (unsigned int i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)str[i]) * 16777619u;
+    }
+
+    return hash;
 }
 
 const int ChunkSize = sizeof(ZIP_EndOfCDR) * 2;
@@ -96,6 +300,8 @@ void Archive::loadEndOfCDR() {
     BinaryStream bin(_target, IOTarget::Read, false);
     bin.seek(0, IOTarget::End);
     char chunk[ChunkSize];
+    ZIP_EndOfCDR endOfCDR;
+    long long endOfCDRPosition = 0;
     bool found = false;
 
     while(!found && !_error && bin.position() >= ChunkSize) {
@@ -105,8 +311,9 @@ void Archive::loadEndOfCDR() {
         for (int i = 0; i < ChunkSize; i++) {
             if (*((int*)(chunk + i)) == ZIP_EndOfCDRSig) {
                 bin.seek(i, IOTarget::Current);
-                bin.read(&_endOfCDR, sizeof(ZIP_EndOfCDR));
-                if (_endOfCDR.commentLength == bin.bytesLeft()) {
+                bin.read(&endOfCDR, sizeof(ZIP_EndOfCDR));
+                if (endOfCDR.commentLength == bin.bytesLeft()) {
+                    endOfCDRPosition = bin.position() - sizeof(ZIP_EndOfCDR);
                     found = true;
                 } else {
                     bin.seek(-ChunkSize, IOTarget::Current);
@@ -115,18 +322,72 @@ void Archive::loadEndOfCDR() {
         }    
     }
 
+    releaseTarget();
+
     if (!found || _error) {
         Warn("The given IOTarget does not point at a legitimate ZIP archive.");
         _error = true;
+        return;
+    }
+
+    _cdrOffset = (unsigned int)endOfCDR.offsetOfStartOfCDR;
+    _cdrSize = (unsigned int)endOfCDR.sizeOfCDR;
+    _cdrEntries = (unsigned short)endOfCDR.numberOfEntriesInCDR;
+
+    // Any value too large for the standard record is marked and stored in the ZIP64
+    // record instead.
+    if ((unsigned int)endOfCDR.offsetOfStartOfCDR == ZIP64_Marker ||
+        (unsigned int)endOfCDR.sizeOfCDR == ZIP64_Marker ||
+        (unsigned short)endOfCDR.numberOfEntriesInCDR == ZIP64_CountMarker) {
+        if (!loadZip64EndOfCDR(endOfCDRPosition)) {
+            Error("Unable to find the ZIP64 end of central directory in " << _name);
+            _error = true;
+        }
+    }
+}
+
+bool Archive::loadZip64EndOfCDR(long long endOfCDRPosition) {
+    if (endOfCDRPosition < (long long)sizeof(ZIP64_EndOfCDRLocator)) {
+        return false;
+    }
+
+    // The locator sits directly before the standard record.
+    BinaryStream bin(_target, IOTarget::Read, false);
+    ZIP64_EndOfCDRLocator locator;
+    bin.seek(endOfCDRPosition - sizeof(ZIP64_EndOfCDRLocator), IOTarget::Beginning);
+    bin.read(&locator, sizeof(ZIP64_EndOfCDRLocator));
+
+    ZIP64_EndOfCDR record;
+    bool valid = false;
+    if (locator.signature == ZIP64_EndOfCDRLocatorSig) {
+        bin.seek(locator.offsetOfEndOfCDR, IOTarget::Beginning);
+        valid = bin.read(&record, sizeof(ZIP64_EndOfCDR)) == sizeof(ZIP64_EndOfCDR) &&
+            record.signature == ZIP64_EndOfCDRSig;
+    }
+
+    releaseTarget();
+
+    if (valid) {
+        _cdrOffset = record.offsetOfStartOfCDR;
+        _cdrSize = record.sizeOfCDR;
+        _cdrEntries = record.numberOfEntriesInCDR;
     }
 
-    _target->close();
+    return valid;
 }
 
 const std::string& Archive::name() const {
     return _name;
 }
 
+unsigned int Archive::getFileCount() const {
+    return _entries.size();
+}
+
+unsigned int Archive::getDirectoryCount() const {
+    return _directories.empty() ? 0 : _directories.size() - 1;
+}
+
 bool Archive::exists(const std::string &p) const {
     if (_error) {
         Warn("Cannot make function calls on an invalid archive.");
@@ -135,18 +396,10 @@ bool Archive::exists(const std::string &p) const {
 
     std::string path(p);
     formatPath(path);
-
-    std::list<FileHeader>::const_iterator itr;
-    for (itr = _files.begin(); itr != _files.end(); itr++) {
-        if (itr->fullName == path) {
-            return true;
-        }
-    }
-
-    return false;
+    return find(_entries, _entryBuckets, path) >= 0;
 }
 
-DataTarget* Archive::open(const std::string &p) const {
+const Archive::Entry* Archive::findReadableEntry(const std::string &p) const {
     if (_error) {
         Warn("Cannot make function calls on an invalid archive.");
         return NULL;
@@ -155,22 +408,102 @@ DataTarget* Archive::open(const std::string &p) const {
     std::string path(p);
     formatPath(path);
 
-    DataTarget *result = NULL;
-    std::list<FileHeader>::const_iterator itr;
-    for (itr = _files.begin(); result == NULL && itr != _files.end(); itr++) {
-        if (itr->fullName == path) {
-            ASSERT_EQ(itr->compressedSize, itr->uncompressedSize);
-            BinaryStream bin(_target, IOTarget::Read, false);
-            bin.seek(itr->offset, IOTarget::Beginning);
+    int index = find(_entries, _entryBuckets, path);
+    if (index < 0) {
+        return NULL;
+    }
+
+    const Entry &entry = _entries[index];
+    if (entry.method != ZIP_Stored && entry.method != ZIP_Deflated) {
+        Warn("Unsupported compression method " << entry.method << " for " << path <<
+             " in " << _name);
+        return NULL;
+    }
 
-            unsigned char *data = new unsigned char[itr->uncompressedSize];
-            bin.read(data, itr->uncompressedSize);
+    return &entry;
+}
 
-            result = new DataTarget(data, itr->uncompressedSize);
-            
-            _target->close();
+long long Archive::getDataOffset(const Entry &entry) const {
+    // The local header's extra field doesn't have to match the central directory's, so
+    // the only way to know where the data starts is to read it.
+    ZIP_LocalFileHeader header;
+    memset(&header, 0, sizeof(ZIP_LocalFileHeader));
+    if (_mapped) {
+        if (entry.headerOffset + (long long)sizeof(ZIP_LocalFileHeader) <= _mapped->length()) {
+            memcpy(&header, _mapped->getData() + entry.headerOffset, sizeof(ZIP_LocalFileHeader));
         }
+    } else {
+        pthread_mutex_lock(&_mutex);
+        BinaryStream bin(_target, IOTarget::Read, false);
+        bin.seek(entry.headerOffset, IOTarget::Beginning);
+        bin.read(&header, sizeof(ZIP_LocalFileHeader));
+        releaseTarget();
+        pthread_mutex_unlock(&_mutex);
+    }
+
+    if (header.signature != ZIP_LocalFileSig) {
+        Warn("Bad local file header in " << _name);
+        return -1;
     }
+
+    return entry.headerOffset + sizeof(ZIP_LocalFileHeader) +
+        (unsigned short)header.fileNameLength + (unsigned short)header.extraFieldLength;
+}
+
+DataTarget* Archive::open(const std::string &path) const {
+    const Entry *entry = findReadableEntry(path);
+    long long offset = entry ? getDataOffset(*entry) : -1;
+    if (offset < 0) {
+        return NULL;
+    }
+
+    // Stored files in a mapped archive can be handed out as is.
+    if (_mapped && entry->method == ZIP_Stored) {
+        if (offset + entry->uncompressedSize > _mapped->length()) {
+            Warn("File extends past the end of the archive: " << path << " in " << _name);
+            return NULL;
+        }
+
+        _mapped->advise(MappedFile::WillNeed, offset, entry->uncompressedSize);
+        return new DataTarget(_mapped->getData() + offset, entry->uncompressedSize);
+    }
+
+    unsigned char *data = new unsigned char[entry->uncompressedSize];
+    long long count;
+    if (entry->method == ZIP_Stored) {
+        pthread_mutex_lock(&_mutex);
+        BinaryStream bin(_target, IOTarget::Read, false);
+        bin.seek(offset, IOTarget::Beginning);
+        count = bin.read(data, entry->uncompressedSize);
+        releaseTarget();
+        pthread_mutex_unlock(&_mutex);
+    } else {
+        // Inflate straight into the final buffer, so the only other memory needed is the
+        // ArchiveTarget's window.
+        ArchiveTarget stream(_target, offset, entry->compressedSize,
+                             entry->uncompressedSize, true, !_mapped, &_mutex);
+        stream.open(IOTarget::Read);
+        count = stream.read(data, entry->uncompressedSize);
+    }
+
+    if (count != entry->uncompressedSize) {
+        Warn("Only read " << count << " of " << entry->uncompressedSize << " bytes of " <<
+             path << " in " << _name);
+    }
+
+    return new DataTarget(data, entry->uncompressedSize);
+}
+
+IOTarget* Archive::openStream(const std::string &path) const {
+    const Entry *entry = findReadableEntry(path);
+    long long offset = entry ? getDataOffset(*entry) : -1;
+    if (offset < 0) {
+        return NULL;
+    }
+
+    ArchiveTarget *result = new ArchiveTarget(_target, offset, entry->compressedSize,
+        entry->uncompressedSize, entry->method == ZIP_Deflated, !_mapped, &_mutex);
+    result->open(IOTarget::Read);
     return result;
 }
 
@@ -184,30 +517,32 @@ std::list<std::string>* Archive::listing(const std::string &p, bool recurse,
 
     formatPath(path);
 
-    // Add the needed files to the list.
+    int index = find(_directories, _dirBuckets, path);
+    if (index < 0) {
+        return NULL;
+    }
+
+    const Directory &dir = _directories[index];
     std::list<std::string>* result = new std::list<std::string>;
-    std::list<FileHeader>::const_iterator itr;
-    for (itr = _files.begin(); itr != _files.end(); itr++) {
-        if ((!recurse && itr->dir == path) ||
-            ( recurse && itr->dir.find(path) == 0)) {
-            result->push_back(itr->fullName);
+    if (recurse) {
+        for (unsigned int i = dir.files; i < dir.filesEnd; i++) {
+            result->push_back(getName(_entries[i].name));
+        }
+    } else {
+        for (unsigned int i = dir.childFiles; i < dir.childFilesEnd; i++) {
+            result->push_back(getName(_entries[_childFiles[i]].name));
         }
     }
 
-    // Add the needed directories to the list.
+    // Directories are not stored with a trailing '/'. This adds one.
     if (dirs) {
-        std::set<std::string>::const_iterator itr;
-        for (itr = _dirs.begin(); itr != _dirs.end(); itr++) {
-            std::string containing = "";
-            int pos = itr->rfind('/', itr->size() - 2);
-            if (pos != std::string::npos) {
-                containing = itr->substr(0, pos);
+        if (recurse) {
+            for (unsigned int i = dir.dirs; i < dir.dirsEnd; i++) {
+                result->push_back(getName(_directories[i].name) + "/");
             }
-
-            if ((!recurse && containing == path) ||
-                ( recurse && containing.find(path) == 0)) {
-                // Directories are not stored with and internal '/'. This adds one.
-                result->push_back(*itr + "/");
+        } else {
+            for (unsigned int i = dir.childDirs; i < dir.childDirsEnd; i++) {
+                result->push_back(getName(_directories[_childDirs[i]].name) + "/");
             }
         }
     }
@@ -216,34 +551,23 @@ std::list<std::string>* Archive::listing(const std::string &p, bool recurse,
 }
 
 void Archive::formatPath(std::string &path) const {
+    // Paths in the archive always use '/' as a separator.
+    std::replace(path.begin(), path.end(), '\\', '/');
+
     // The internal directories have no leading or trailing symbols. Clean off any from
     // the path or the search will always fail.
-    while (path.size() && (*path.begin() == '.' || *path.begin() == '/')) {
-        path.erase(path.begin());
+    std::string::size_type start = 0;
+    while (start < path.size() && (path[start] == '.' || path[start] == '/')) {
+        start++;
     }
 
+    path.erase(0, start);
+
     while (path.size() && *path.rbegin() == '/') {
         path.erase(path.size() - 1, 1);
     }
 }
 
-/*
-In case I ever decide that listing w/ dirs is too slow.
-struct Directory {
-    Directory(const std::string &n):
-        fullName(n),
-        containing("") {
-        std::string::size_type pos = n.rfind('/', n.size() - 2);
-        if (pos != std::string::npos) {
-            containing = n.substr(0, pos);
-        }
-    }
-
-    std::string fullName;
-    std::string containing;
-};
-*/
-
 /*! Finds files matching the given pattern and returns a list of them.
  * \note The list must be deleted.
  * \param pattern The pattern to use when collecting filenames.
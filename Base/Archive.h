@@ -13,31 +13,72 @@
 #include "IOTarget.h"
 
 #include <string>
+#include <vector>
 #include <list>
-#include <set>
+#include <pthread.h>
 
 class DataTarget;
+class MappedFile;
+
+/*! Archive provides read access to the files in a ZIP. The central directory is read once
+ *  when the Archive is created and flattened into a compact index. Every path is stored
+ *  once in a shared name pool and the files and directories are kept in contiguous
+ *  tables, each sorted by path. An open addressed hash table on the normalized full path
+ *  makes exists and open constant time, and each directory knows the range of its direct
+ *  children as well as the range of everything below it, so listings only touch the
+ *  entries they return.
+ *
+ *  If the Archive is created with a MappedFile, the archive stays mapped for the life of
+ *  the Archive and stored files are returned as read only views straight into the mapping,
+ *  with no copying at all.
+ *
+ *  open, openStream, and the streams they return can be used from any number of threads
+ *  at once. Mapped archives are read without touching the target's position. Reads from
+ *  any other target take a lock on the Archive for each seek and read.
+ * \brief A read only, indexed view of a ZIP archive. */
 class Archive {
-struct FileHeader {
-    FileHeader(const ZIP_FileHeader &current, const std::string &n):
-        compressedSize(current.compressedSize),
-        uncompressedSize(current.uncompressedSize),
-        offset(current.relativeOffsetOfLocalHeader + sizeof(ZIP_LocalFileHeader) +
-               current.fileNameLength + current.extraFieldLength), 
-        fullName(n),
-        dir("") {
-        std::string::size_type pos = n.rfind('/');
-        if (pos != std::string::npos) {
-            dir = n.substr(0, pos);
-        }
-    }
-
-    int compressedSize;
-    int uncompressedSize;
-    int offset;
-    std::string fullName;
-    std::string dir;
-};
+    /*! A path in the name pool, along with its hash. */
+    struct Name {
+        unsigned int hash;   //!< The hash of the full path.
+        unsigned int offset; //!< Where the path starts in the name pool.
+        unsigned int length; //!< The length of the path.
+    };
+
+    /*! A single file in the archive. */
+    struct Entry {
+        Name name;
+        long long compressedSize;
+        long long uncompressedSize;
+        long long headerOffset; //!< Offset of the file's local header in the archive.
+        short method;           //!< The compression method used.
+    };
+
+    /*! A directory in the archive. Because both tables are sorted by path, everything
+     *  below a directory forms a single range in each of them. */
+    struct Directory {
+        Name name;
+        unsigned int childFiles;    //!< Start of the direct child files in _childFiles.
+        unsigned int childFilesEnd; //!< End of the direct child files in _childFiles.
+        unsigned int childDirs;     //!< Start of the direct child dirs in _childDirs.
+        unsigned int childDirsEnd;  //!< End of the direct child dirs in _childDirs.
+        unsigned int files;         //!< Start of every file below this one in _entries.
+        unsigned int filesEnd;      //!< End of every file below this one in _entries.
+        unsigned int dirs;          //!< Start of every dir below this one in _directories.
+        unsigned int dirsEnd;       //!< End of every dir below this one in _directories.
+    };
+
+    /*! A file header that has been read but not yet indexed. */
+    struct PendingEntry {
+        std::string path;
+        long long compressedSize;
+        long long uncompressedSize;
+        long long headerOffset;
+        short method;
+
+        bool operator<(const PendingEntry &rhs) const { return path < rhs.path; }
+        bool operator<(const std::string &rhs) const { return path < rhs; }
+        bool operator==(const PendingEntry &rhs) const { return path == rhs.path; }
+    };
 
 public:
     /*! Initialize an archive with the given IOTarget. Note that the IOTarget must NOT be
@@ -55,45 +96,115 @@ public:
      * \return The name of the archive. */
     const std::string& name() const;
 
-    /*! Checks to see if the file exists anywhere in the Archive. The entire archive is
-     *  searched and if any match is found, true is returned. If directories are specified
-     *  before the filename, then the directories will be matched when searching for the
-     *  file as well.
-     * \param path The filename to look for.
+    /*! Checks to see if the file exists in the Archive. Paths are normalized before the
+     *  lookup, so leading and trailing slashes are ignored and backslashes are treated as
+     *  directory separators.
+     * \param path The full path of the file to look for.
      * \return true if a file matching the name can be found. */
     bool exists(const std::string &path) const;
 
-    /*! Returns a DataTarget containing the requested file.
-     * \note The list must be deleted.
+    /*! Returns a DataTarget containing the requested file. Deflated files are inflated
+     *  directly into the DataTarget's buffer. If the archive is mapped, stored files are
+     *  returned as views into the mapping instead of being copied.
+     * \note The DataTarget must be deleted, and views must not outlive the Archive.
      * \param path The name to lookfor.
      * \return The DataTarget. NULL is returned if a match cannot be found. */
     DataTarget* open(const std::string &path) const;
 
+    /*! Returns an open IOTarget that streams the requested file out of the archive,
+     *  inflating it as it is read. Nothing is read until the stream is, so this is the
+     *  best way to consume very large files.
+     * \note The IOTarget must be deleted, and must not outlive the Archive.
+     * \param path The name to lookfor.
+     * \return The IOTarget. NULL is returned if a match cannot be found. */
+    IOTarget* openStream(const std::string &path) const;
+
     /*! Seturns a listing of files in the archive.
      * \note The list must be deleted.
      * \param path The path to start the listing from.
      * \param recurse true if the search should be recursive.
+     * \param dirs true if directories should be listed as well. Directories are listed
+     *        after files and always end with a '/'.
      * \return A pointer to a list of files in the archive. NULL is returned if the
-     *         specified path is not a directory. */ 
+     *         specified path is not a directory. */
     std::list<std::string>* listing(const std::string &path = "", bool recurse = true,
                                bool dirs = false) const;
 
+    /*! Returns true if the archive is mapped, and open returns views of stored files. */
+    bool isZeroCopy() const;
+
+    /*! Returns the number of files in the archive. */
+    unsigned int getFileCount() const;
+
+    /*! Returns the number of directories in the archive, not counting the root. */
+    unsigned int getDirectoryCount() const;
+
 private:
     void loadEndOfCDR();
     void loadFileHeaders();
-    void extractDirs();
+
+    /*! Closes the target after an operation, unless it is mapped. */
+    void releaseTarget() const;
+
+    /*! Reads the ZIP64 end of central directory record, given the position of the
+     *  standard record. */
+    bool loadZip64EndOfCDR(long long endOfCDRPosition);
+
+    /*! Pulls any values marked as being stored in the ZIP64 extra field out of the given
+     *  extra data. */
+    void readZip64Extra(const std::vector<char> &extra, PendingEntry &entry,
+                        const ZIP_FileHeader &header);
+
+    /*! Finds the entry with the given path, warning if it can't be read. Returns NULL
+     *  if it can't be found or uses an unsupported compression method. */
+    const Entry* findReadableEntry(const std::string &path) const;
+
+    /*! Returns the offset of the given entry's data, read from its local header. */
+    long long getDataOffset(const Entry &entry) const;
+
+    /*! Builds the entry and directory tables, and their hash tables, from the given
+     *  headers. The pending list is sorted in place. */
+    void buildIndex(std::vector<PendingEntry> &pending);
+
+    /*! Copies the given path into the name pool. */
+    Name addName(const std::string &path);
+
+    /*! Returns the given name as a string. */
+    std::string getName(const Name &name) const;
+
+    /*! Fills the given hash table with the indices of the given items. */
+    template <typename T>
+    void buildBuckets(const std::vector<T> &items, std::vector<unsigned int> &buckets);
+
+    /*! Looks the given path up in the given hash table. Returns -1 if it isn't found. */
+    template <typename T>
+    int find(const std::vector<T> &items, const std::vector<unsigned int> &buckets,
+             const std::string &path) const;
 
     void formatPath(std::string &path) const;
 
+    /*! FNV-1a hash of the given string. */
+    static unsigned int Hash(const char *str, unsigned int length);
+
 private:
     std::string _name;
     IOTarget *_target;
     bool _error;
     bool _cleanUp;
+    MappedFile *_mapped;                      //!< The target, if it is a MappedFile.
+    mutable pthread_mutex_t _mutex;           //!< Held while an unmapped _target is read.
+
+    long long _cdrOffset;                     //!< Offset of the central directory.
+    long long _cdrSize;                       //!< Size of the central directory in bytes.
+    long long _cdrEntries;                    //!< Number of entries in the central directory.
 
-    ZIP_EndOfCDR _endOfCDR;
-    std::list<FileHeader> _files;
-    std::set<std::string> _dirs;
+    std::vector<char> _names;                 //!< Every path in the archive, back to back.
+    std::vector<Entry> _entries;              //!< Every file, sorted by path.
+    std::vector<Directory> _directories;      //!< Every directory, sorted by path. 0 is the root.
+    std::vector<unsigned int> _childFiles;    //!< Entry indices, grouped by directory.
+    std::vector<unsigned int> _childDirs;     //!< Directory indices, grouped by parent.
+    std::vector<unsigned int> _entryBuckets;  //!< Hash table of entry indices + 1, 0 is empty.
+    std::vector<unsigned int> _dirBuckets;    //!< Hash table of directory indices + 1.
 };
 
 #endif
@@ -0,0 +1,263 @@
+/*
+ *  ArchiveTarget.cpp
+ *  Base
+ *
+ *  Created by loch on 4/23/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "ArchiveTarget.h"
+#include "MappedFile.h"
+#include "Assertion.h"
+#include "Math3D.h"
+
+ArchiveTarget::ArchiveTarget(IOTarget *source, long long offset, long long compressedSize,
+long long uncompressedSize, bool deflated, bool closeSource, pthread_mutex_t *sourceLock):
+_source(source), _mapped(dynamic_cast<MappedFile*>(source)), _sourceLock(sourceLock),
+_offset(offset), _compressedSize(compressedSize), _uncompressedSize(uncompressedSize),
+_deflated(deflated), _closeSource(closeSource), _open(false), _position(0), _consumed(0),
+_streamReady(false), _window(NULL), _hasPeek(false), _peek(0) {
+    ASSERT(_source);
+    memset(&_stream, 0, sizeof(z_stream));
+}
+
+ArchiveTarget::~ArchiveTarget() {
+    close();
+    if (_streamReady) {
+        inflateEnd(&_stream);
+    }
+
+    delete[] _window;
+}
+
+bool ArchiveTarget::open(OpenMode openFlags) {
+    if (openFlags & Write) {
+        Warn("Archive entries cannot be opened for writing.");
+        return false;
+    }
+
+    if (_deflated && !_window) {
+        _window = new unsigned char[WindowSize];
+    }
+
+    _open = true;
+    return true;
+}
+
+void ArchiveTarget::close() {
+    _open = false;
+}
+
+bool ArchiveTarget::isOpen() {
+    return _open;
+}
+
+long long ArchiveTarget::bytesLeft() {
+    return _uncompressedSize - _position;
+}
+
+bool ArchiveTarget::atEnd() {
+    return _position == _uncompressedSize;
+}
+
+long long ArchiveTarget::position() {
+    return _position;
+}
+
+long long ArchiveTarget::length() {
+    return _uncompressedSize;
+}
+
+char ArchiveTarget::peek() {
+    if (!_hasPeek && !atEnd()) {
+        // Reading advances the position, so step it back. The peeked byte is handed out
+        // by the next read.
+        char next;
+        if (read(&next, 1) == 1) {
+            _position--;
+            _peek = next;
+            _hasPeek = true;
+        }
+    }
+
+    return _hasPeek ? _peek : 0;
+}
+
+char ArchiveTarget::getc() {
+    char result = 0;
+    read(&result, 1);
+    return result;
+}
+
+long long ArchiveTarget::read(void* buffer, long long size) {
+    if (!_open) {
+        Warn("Attempted to read an archive entry that is not open.");
+        return 0;
+    }
+
+    size = Math::Min(size, bytesLeft());
+    if (size <= 0) {
+        return 0;
+    }
+
+    unsigned char *out = (unsigned char*)buffer;
+    long long total = 0;
+    if (_hasPeek) {
+        out[total++] = _peek;
+        _hasPeek = false;
+    }
+
+    if (_deflated) {
+        total += inflateInto(out + total, size - total);
+    } else {
+        total += readSource(out + total, _position + total, size - total);
+    }
+
+    _position += total;
+    return total;
+}
+
+long long ArchiveTarget::write(const void* buffer, long long size) {
+    Warn("Archive entries are read only.");
+    return 0;
+}
+
+bool ArchiveTarget::seek(long long offset, OffsetBase base) {
+    long long target = offset;
+    switch(base) {
+        case Current:   target += _position;          break;
+        case End:       target += _uncompressedSize;  break;
+        default: break;
+    }
+
+    if (target < 0 || target > _uncompressedSize) {
+        Warn("Tried to seek to " << target << " in an archive entry of length " <<
+             _uncompressedSize);
+        Math::Clamp(0LL, _uncompressedSize, target);
+    }
+
+    if (target == _position) {
+        return true;
+    }
+
+    if (!_deflated) {
+        _hasPeek = false;
+        _position = target;
+        return true;
+    }
+
+    // Deflate streams can only be walked forward. Going backward means starting over.
+    if (target < _position) {
+        rewind();
+    }
+
+    unsigned char scratch[4096];
+    while (_position < target) {
+        long long count = read(scratch, Math::Min(target - _position, (long long)sizeof(scratch)));
+        if (count == 0) {
+            Warn("Unable to seek past " << _position << " in an archive entry.");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+long long ArchiveTarget::readSource(void *buffer, long long position, long long size) {
+    // Mapped sources are copied from directly, so their position is never touched and
+    // any number of targets can read them at once.
+    if (_mapped && _mapped->isOpen()) {
+        long long start = _offset + position;
+        size = Math::Max(0LL, Math::Min(size, _mapped->length() - start));
+        memcpy(buffer, _mapped->getData() + start, size);
+        return size;
+    }
+
+    // Anything else has a single position shared with every other target reading the
+    // archive, so the seek and the read have to happen together.
+    if (_sourceLock) { pthread_mutex_lock(_sourceLock); }
+
+    if (!_source->isOpen()) {
+        _source->open(Read);
+    }
+
+    _source->seek(_offset + position, Beginning);
+    long long count = _source->read(buffer, size);
+    if (_closeSource) {
+        _source->close();
+    }
+
+    if (_sourceLock) { pthread_mutex_unlock(_sourceLock); }
+    return count;
+}
+
+long long ArchiveTarget::inflateInto(void *buffer, long long size) {
+    if (!_streamReady) {
+        // Negative window bits means a raw deflate stream, with no zlib header.
+        if (inflateInit2(&_stream, -MAX_WBITS) != Z_OK) {
+            Error("Unable to initialize zlib: " << (_stream.msg ? _stream.msg : ""));
+            return 0;
+        }
+
+        _streamReady = true;
+    }
+
+    // zlib counts bytes with 32 bit values, so very large reads are split up.
+    long long total = 0;
+    while (total < size) {
+        uInt chunk = (uInt)Math::Min(size - total, (long long)0x40000000);
+        _stream.next_out = (Bytef*)buffer + total;
+        _stream.avail_out = chunk;
+        bool done = !inflateChunk();
+        total += chunk - _stream.avail_out;
+        if (done) { break; }
+    }
+
+    return total;
+}
+
+bool ArchiveTarget::inflateChunk() {
+    while (_stream.avail_out > 0) {
+        if (_stream.avail_in == 0 && _consumed < _compressedSize) {
+            long long count = Math::Min((long long)WindowSize, _compressedSize - _consumed);
+            count = readSource(_window, _consumed, count);
+            if (count <= 0) {
+                Error("Unexpected end of data in archive entry.");
+                _error = Z_DATA_ERROR;
+                return false;
+            }
+
+            _consumed += count;
+            _stream.next_in = _window;
+            _stream.avail_in = (uInt)count;
+        }
+
+        int result = inflate(&_stream, Z_NO_FLUSH);
+        if (result == Z_STREAM_END) {
+            return false;
+        }
+
+        // Z_BUF_ERROR just means no progress could be made, which is only an error once
+        // we've run out of input.
+        if (result != Z_OK && (result != Z_BUF_ERROR || _consumed == _compressedSize)) {
+            Error("Error inflating archive entry: " << (_stream.msg ? _stream.msg : "truncated data"));
+            _error = result;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ArchiveTarget::rewind() {
+    if (_streamReady) {
+        inflateReset(&_stream);
+    }
+
+    _stream.next_in = NULL;
+    _stream.avail_in = 0;
+    _consumed = 0;
+    _position = 0;
+    _hasPeek = false;
+}
@@ -0,0 +1,125 @@
+/*
+ *  ArchiveTarget.h
+ *  Base
+ *
+ *  Created by loch on 4/23/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _ARCHIVETARGET_H_
+#define _ARCHIVETARGET_H_
+#include "IOTarget.h"
+#include <zlib.h>
+#include <pthread.h>
+
+class MappedFile;
+
+/*! ArchiveTarget streams a single entry out of an archive. Stored entries are read
+ *  straight from the archive's IOTarget. Deflated entries are read through a fixed size
+ *  window and inflated on demand, so an entry of any size can be consumed incrementally
+ *  without ever holding the whole thing in memory.
+ *
+ *  Seeking forward in a deflated entry inflates and discards everything in between, and
+ *  seeking backward restarts decompression from the beginning of the entry. Sequential
+ *  reads are the fast path.
+ * \note The source IOTarget is shared with the Archive and must outlive this target.
+ * \brief A read only IOTarget over one entry of an Archive.
+ * \seealso Archive::openStream */
+class ArchiveTarget : public IOTarget {
+public:
+    /*! The number of bytes of compressed data read from the source at a time. */
+    static const int WindowSize = 64 * 1024;
+
+    /*! Creates a target for the entry whose data starts at the given offset in source.
+     * \param source The IOTarget of the archive.
+     * \param offset The offset of the entry's data in the source.
+     * \param compressedSize The number of bytes the entry takes up in the source.
+     * \param uncompressedSize The number of bytes in the entry once inflated.
+     * \param deflated true if the entry is deflated rather than stored.
+     * \param closeSource true if the source should be closed after each read.
+     * \param sourceLock If given, held while the source is read, since other targets may
+     *        share it. Mapped sources are read without touching their position, so they
+     *        never need it. */
+    ArchiveTarget(IOTarget *source, long long offset, long long compressedSize,
+                  long long uncompressedSize, bool deflated, bool closeSource = true,
+                  pthread_mutex_t *sourceLock = NULL);
+
+    /*! D'tor */
+    virtual ~ArchiveTarget();
+
+    /*! \copydoc IOTarget::open */
+    virtual bool open(OpenMode openFlags = Read);
+
+    /*! \copydoc IOTarget::close */
+    virtual void close();
+
+    /*! \copydoc IOTarget::isOpen */
+    virtual bool isOpen();
+
+    /*! \copydoc IOTarget::bytesLeft */
+    virtual long long bytesLeft();
+
+    /*! \copydoc IOTarget::peek */
+    virtual char peek();
+
+    /*! \copydoc IOTarget::getc */
+    virtual char getc();
+
+    /*! \copydoc IOTarget::read */
+    virtual long long read(void* buffer, long long size);
+
+    /*! Archive entries are read only. Always returns 0. */
+    virtual long long write(const void* buffer, long long size);
+
+    /*! \copydoc IOTarget::atEnd */
+    virtual bool atEnd();
+
+    /*! \copydoc IOTarget::seek */
+    virtual bool seek(long long offset, OffsetBase base = Beginning);
+
+    /*! \copydoc IOTarget::position */
+    virtual long long position();
+
+    /*! \copydoc IOTarget::length */
+    virtual long long length();
+
+private:
+    /*! Reads the requested number of bytes from the source at the given position in the
+     *  entry's compressed data. Safe to call while other targets read the same source. */
+    long long readSource(void *buffer, long long position, long long size);
+
+    /*! Inflates up to size bytes into buffer, refilling the window as needed. */
+    long long inflateInto(void *buffer, long long size);
+
+    /*! Inflates until the stream's output buffer is full. Returns false if the end of the
+     *  entry was reached or an error occurred. */
+    bool inflateChunk();
+
+    /*! Throws away all decompression state and starts over at the beginning. */
+    void rewind();
+
+private:
+    IOTarget *_source;
+    MappedFile *_mapped;         //!< The source, if it is a MappedFile.
+    pthread_mutex_t *_sourceLock;
+    long long _offset;           //!< Offset of the entry's data in the source.
+    long long _compressedSize;
+    long long _uncompressedSize;
+    bool _deflated;
+    bool _closeSource;
+    bool _open;
+
+    long long _position;         //!< Position in the uncompressed data.
+    long long _consumed;         //!< Compressed bytes moved into the window so far.
+
+    z_stream _stream;
+    bool _streamReady;           //!< Whether or not _stream has been initialized.
+    unsigned char *_window;      //!< Compressed input, only allocated for deflated entries.
+
+    bool _hasPeek;               //!< Whether or not a byte has been peeked.
+    char _peek;                  //!< The byte at _position, if it has been peeked.
+
+};
+
+#endif
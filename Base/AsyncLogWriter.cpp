@@ -0,0 +1,231 @@
+/*
+ *  AsyncLogWriter.cpp
+ *  Base
+ *
+ *  Created by loch on 5/4/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "AsyncLogWriter.h"
+#include <unistd.h>
+#include <cstring>
+#include <sstream>
+
+#pragma mark AsyncLogWriter::Ring
+
+/*! A single producer, single consumer ring of length prefixed messages. The head and tail
+ *  only ever increase; positions in the buffer are taken modulo the size. A message that
+ *  won't fit before the end of the buffer is moved to the start, leaving a wrap marker in
+ *  its place. */
+class AsyncLogWriter::Ring {
+public:
+    static const unsigned int WrapMarker = 0xFFFFFFFF;
+
+    Ring(unsigned int size): _size(size), _head(0), _tail(0), _retired(0) {
+        _data = new unsigned char[size];
+    }
+
+    ~Ring() {
+        delete[] _data;
+    }
+
+    /*! Called only by the owning thread. */
+    bool push(const char *message, unsigned int length) {
+        unsigned int needed = RecordSize(length);
+        if (needed > _size / 2) { return false; }
+
+        unsigned int head = _head;
+        __sync_synchronize();
+        unsigned int used = head - _tail;
+
+        unsigned int position = head & (_size - 1);
+        unsigned int padding = position + needed > _size ? _size - position : 0;
+        if (used + padding + needed > _size) { return false; }
+
+        if (padding) {
+            *(unsigned int*)(_data + position) = WrapMarker;
+            position = 0;
+        }
+
+        *(unsigned int*)(_data + position) = length;
+        memcpy(_data + position + sizeof(unsigned int), message, length);
+
+        // The message has to be visible before the new head is.
+        __sync_synchronize();
+        _head = head + padding + needed;
+        return true;
+    }
+
+    /*! Called only by the writer. Appends every waiting message to the given string. */
+    bool drain(std::string &output) {
+        unsigned int tail = _tail;
+        unsigned int head = _head;
+        __sync_synchronize();
+        if (tail == head) { return false; }
+
+        while (tail != head) {
+            unsigned int position = tail & (_size - 1);
+            unsigned int length = *(unsigned int*)(_data + position);
+            if (length == WrapMarker) {
+                tail += _size - position;
+                continue;
+            }
+
+            output.append((const char*)_data + position + sizeof(unsigned int), length);
+            tail += RecordSize(length);
+        }
+
+        // Everything has to be read before the space is handed back.
+        __sync_synchronize();
+        _tail = tail;
+        return true;
+    }
+
+    void retire() { __sync_lock_test_and_set(&_retired, 1); }
+    bool isRetired() { return __sync_add_and_fetch(&_retired, 0) != 0; }
+
+protected:
+    /*! The length prefix plus the message, padded to keep the prefixes aligned. */
+    static unsigned int RecordSize(unsigned int length) {
+        return (sizeof(unsigned int) + length + 3) & ~3;
+    }
+
+protected:
+    unsigned char *_data;
+    unsigned int _size;
+    volatile unsigned int _head;    //!< Only written by the owning thread.
+    volatile unsigned int _tail;    //!< Only written by the writer.
+    volatile int _retired;
+
+};
+
+#pragma mark AsyncLogWriter definitions
+
+AsyncLogWriter::AsyncLogWriter(std::ostream *console, const std::string &filename,
+unsigned int ringSize): _console(console), _file(NULL), _ringSize(1), _dropped(0),
+_reportedDropped(0), _flushRequests(0), _flushesDone(0), _shutdown(0) {
+    while (_ringSize < ringSize) { _ringSize <<= 1; }
+
+    if (filename.size() > 0) {
+        _file = new std::ofstream(filename.c_str(), std::ofstream::app);
+        if (_file->fail()) {
+            delete _file;
+            _file = NULL;
+        }
+    }
+
+    pthread_key_create(&_ringKey, AsyncLogWriter::RetireRing);
+    pthread_mutex_init(&_ringMutex, NULL);
+
+    // Without a thread, write just drops everything, which is better than blocking.
+    if (pthread_create(&_thread, NULL, AsyncLogWriter::Launch, this) != 0) {
+        _shutdown = 1;
+    }
+}
+
+AsyncLogWriter::~AsyncLogWriter() {
+    if (!_shutdown) {
+        __sync_lock_test_and_set(&_shutdown, 1);
+        pthread_join(_thread, NULL);
+    }
+
+    // Threads that are still running won't retire their rings now.
+    pthread_key_delete(_ringKey);
+    for (int i = 0; i < _rings.size(); i++) {
+        delete _rings[i];
+    }
+
+    pthread_mutex_destroy(&_ringMutex);
+    delete _file;
+}
+
+bool AsyncLogWriter::write(const char *data, unsigned int length) {
+    if (_shutdown || !getRing()->push(data, length)) {
+        __sync_add_and_fetch(&_dropped, 1);
+        return false;
+    }
+
+    return true;
+}
+
+void AsyncLogWriter::flush() {
+    unsigned int request = __sync_add_and_fetch(&_flushRequests, 1);
+    while (!_shutdown && (int)(__sync_add_and_fetch(&_flushesDone, 0) - request) < 0) {
+        usleep(IdleSleep * 1000 / 2);
+    }
+}
+
+unsigned int AsyncLogWriter::getDroppedCount() const {
+    return _dropped;
+}
+
+void *AsyncLogWriter::Launch(void *writer) {
+    ((AsyncLogWriter*)writer)->writerLoop();
+    return NULL;
+}
+
+void AsyncLogWriter::RetireRing(void *ring) {
+    ((Ring*)ring)->retire();
+}
+
+AsyncLogWriter::Ring *AsyncLogWriter::getRing() {
+    Ring *ring = (Ring*)pthread_getspecific(_ringKey);
+    if (!ring) {
+        ring = new Ring(_ringSize);
+        pthread_setspecific(_ringKey, ring);
+
+        pthread_mutex_lock(&_ringMutex);
+        _rings.push_back(ring);
+        pthread_mutex_unlock(&_ringMutex);
+    }
+
+    return ring;
+}
+
+void AsyncLogWriter::writerLoop() {
+    while (!__sync_add_and_fetch(&_shutdown, 0)) {
+        // Anything requested before this pass started is covered by it.
+        unsigned int requests = __sync_add_and_fetch(&_flushRequests, 0);
+        bool wrote = drain();
+        __sync_lock_test_and_set(&_flushesDone, requests);
+
+        if (!wrote) {
+            usleep(IdleSleep * 1000);
+        }
+    }
+
+    // Catch anything logged right before shutting down.
+    drain();
+}
+
+bool AsyncLogWriter::drain() {
+    pthread_mutex_lock(&_ringMutex);
+    for (int i = 0; i < _rings.size(); i++) {
+        // Check retirement first. A retired ring never gets anything new, so once it's
+        // drained it can go.
+        bool retired = _rings[i]->isRetired();
+        _rings[i]->drain(_batch);
+        if (retired) {
+            delete _rings[i];
+            _rings.erase(_rings.begin() + i);
+            i--;
+        }
+    }
+    pthread_mutex_unlock(&_ringMutex);
+
+    unsigned int dropped = _dropped;
+    if (dropped != _reportedDropped) {
+        std::ostringstream report;
+        report << "\n" << (dropped - _reportedDropped) << " log messages dropped.";
+        _batch.append(report.str());
+        _reportedDropped = dropped;
+    }
+
+    if (_batch.empty()) { return false; }
+
+    if (_console) { _console->write(_batch.data(), _batch.size()); _console->flush(); }
+    if (_file)    { _file->write(_batch.data(), _batch.size());    _file->flush();    }
+    _batch.clear();
+    return true;
+}
@@ -0,0 +1,97 @@
+/*
+ *  AsyncLogWriter.h
+ *  Base
+ *
+ *  Created by loch on 5/4/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _ASYNCLOGWRITER_H_
+#define _ASYNCLOGWRITER_H_
+#include "Base.h"
+#include <pthread.h>
+#include <fstream>
+
+/*! AsyncLogWriter moves the cost of writing log output off of the threads doing the
+ *  logging. Each thread that logs gets its own ring buffer, which only it writes to and
+ *  only the writer thread reads from, so adding a message takes no locks at all: it is a
+ *  copy into the ring and a pair of memory barriers. The writer thread wakes up every few
+ *  milliseconds, gathers everything waiting in every ring into a single batch, and writes
+ *  the batch to the console and log file in one go.
+ *
+ *  Nothing ever blocks a logging thread. If its ring is full the message is dropped and
+ *  counted, and the writer reports how many were lost the next time it writes anything.
+ *  Messages are kept in order within a thread, but messages from different threads are
+ *  only ordered to within one batch.
+ *
+ *  Messages are written exactly as given, so all formatting happens before write is
+ *  called. This is normally used through LogStream::SetAsync, rather than directly.
+ * \brief Writes log messages from any number of threads on a background thread.
+ * \seealso LogStream */
+class AsyncLogWriter {
+public:
+    enum {
+        DefaultRingSize = 64 * 1024, //!< The bytes in each thread's ring.
+        IdleSleep = 2                //!< Milliseconds the writer sleeps when idle.
+    };
+
+    /*! Starts the writer thread. Output goes to the given stream and file, either of
+     *  which may be left out. ringSize is rounded up to a power of two. */
+    AsyncLogWriter(std::ostream *console, const std::string &filename,
+                   unsigned int ringSize = DefaultRingSize);
+
+    /*! Writes anything still waiting and stops the writer thread. Nothing may be logging
+     *  while this runs. */
+    ~AsyncLogWriter();
+
+    /*! Queues the given message to be written, from any thread.
+     * \return false if the message was dropped because the calling thread's ring was
+     *  full, or was too big to ever fit in it. */
+    bool write(const char *data, unsigned int length);
+
+    /*! Blocks until everything written before the call has been written out. */
+    void flush();
+
+    /*! Gets the number of messages that have been dropped so far. */
+    unsigned int getDroppedCount() const;
+
+protected:
+    class Ring;
+
+    static void *Launch(void *writer);
+
+    /*! Frees a thread's ring once that thread exits. Called by pthreads. */
+    static void RetireRing(void *ring);
+
+    /*! Gets the calling thread's ring, creating it if needed. */
+    Ring *getRing();
+
+    /*! The main loop of the writer thread. */
+    void writerLoop();
+
+    /*! Writes out everything currently waiting, returning true if there was anything. */
+    bool drain();
+
+protected:
+    std::ostream *_console;
+    std::ofstream *_file;
+    unsigned int _ringSize;
+
+    pthread_t _thread;
+    pthread_key_t _ringKey;
+    pthread_mutex_t _ringMutex;      //!< Guards _rings. Only taken when a thread's ring is
+                                     //!< created, and by the writer.
+    std::vector<Ring *> _rings;
+
+    std::string _batch;              //!< Reused between drains.
+    volatile unsigned int _dropped;
+    unsigned int _reportedDropped;   //!< The drop count as of the last report.
+
+    volatile unsigned int _flushRequests;
+    volatile unsigned int _flushesDone;
+    volatile int _shutdown;
+
+};
+
+#endif
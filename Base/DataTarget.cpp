@@ -12,11 +12,16 @@
 
 #include <memory>
 
-DataTarget::DataTarget(unsigned char *data, int length): _data(data), _length(length),
-_pos(0) {}
+DataTarget::DataTarget(unsigned char *data, long long length): _data(data), _length(length),
+_view(false), _pos(0) {}
+
+DataTarget::DataTarget(const unsigned char *data, long long length):
+_data(const_cast<unsigned char*>(data)), _length(length), _view(true), _pos(0) {}
 
 DataTarget::~DataTarget() {
-    delete[] _data;
+    if (!_view) {
+        delete[] _data;
+    }
 }
 
 bool DataTarget::open(OpenMode openFlags) {
@@ -57,6 +62,14 @@ long long DataTarget::length() {
     return _length;
 }
 
+const unsigned char* DataTarget::getData() const {
+    return _data;
+}
+
+bool DataTarget::isView() const {
+    return _view;
+}
+
 long long DataTarget::read(void* buffer, long long size) {
     long long toRead = Math::Min(size, bytesLeft());
     memcpy(buffer, _data + _pos, toRead);
@@ -65,6 +78,11 @@ long long DataTarget::read(void* buffer, long long size) {
 }
 
 long long DataTarget::write(const void* buffer, long long size) {
+    if (_view) {
+        Warn("Attempted to write to a read only DataTarget.");
+        return 0;
+    }
+
     long long toRead = Math::Min(size, bytesLeft());
     memcpy(_data + _pos, buffer, toRead);
     _pos += toRead;
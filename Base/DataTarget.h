@@ -13,7 +13,14 @@
 
 class DataTarget : public IOTarget {
 public:
-    DataTarget(unsigned char *data, int length);
+    /*! Creates a DataTarget that takes ownership of the given buffer, which must have
+     *  been allocated with new[]. */
+    DataTarget(unsigned char *data, long long length);
+
+    /*! Creates a read only view of the given memory. The memory is not copied or deleted,
+     *  so it must outlive the DataTarget. */
+    DataTarget(const unsigned char *data, long long length);
+
     ~DataTarget();
 
     /*! \copydoc IOTarget::open */
@@ -58,9 +65,16 @@ public:
     /*! \copydoc IOTarget::length */
     virtual long long length();
 
+    /*! Returns the underlying memory, so it can be parsed in place. */
+    const unsigned char* getData() const;
+
+    /*! Returns true if this is a read only view of memory owned by something else. */
+    bool isView() const;
+
 private:
     unsigned char *_data;
     long long _length;
+    bool _view;
 
     long long _pos;
 };
@@ -0,0 +1,265 @@
+/*
+ *  FastMath.cpp
+ *  Base
+ *
+ *  Created by loch on 5/8/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "FastMath.h"
+#include <math.h>
+
+#if SYS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace FastMath {
+
+#pragma mark Constants
+
+    static const double TwoPi = 6.283185307179586476925286766559;
+    static const Real HalfPi = 1.5707963267948966192313216916398f;
+    static const Real Pi = 3.1415926535897932384626433832795f;
+    static const Real TwoOverPi = 0.63661977236758134307553505349006f;
+
+    // Pi / 2 split in three, so that k * PiOverTwoA and k * PiOverTwoB are exact for any
+    // reasonable k, which keeps the reduced angle accurate (Cody and Waite's method).
+    static const Real PiOverTwoA = 1.5703125f;
+    static const Real PiOverTwoB = 4.837512969970703125e-4f;
+    static const Real PiOverTwoC = 7.54978995489188216e-8f;
+
+    // Minimax polynomials for sin(x) and cos(x) on [-pi/4, pi/4], from Cephes' sinf/cosf.
+    static const Real SinA = -1.6666654611e-1f;
+    static const Real SinB =  8.3321608736e-3f;
+    static const Real SinC = -1.9515295891e-4f;
+    static const Real CosA =  4.166664568298827e-2f;
+    static const Real CosB = -1.388731625493765e-3f;
+    static const Real CosC =  2.443315711809948e-5f;
+
+    // atan(x) / x as a polynomial in x^2 on [0, 1], from Abramowitz and Stegun 4.4.47.
+    static const Real AtanCoefficients[8] = {
+        -0.3333314528f, 0.1999355085f, -0.1420889944f, 0.1065626393f,
+        -0.0752896400f, 0.0429096138f, -0.0161657367f, 0.0028662257f
+    };
+
+#pragma mark Tables
+
+    // One extra entry in each, so interpolation never has to wrap.
+    static Real SinTable[SinTableSize + 1];
+    static Real AtanTable[AtanTableSize + 1];
+
+    static struct TableBuilder {
+        TableBuilder() {
+            for (int i = 0; i <= SinTableSize; i++) {
+                SinTable[i] = sin(TwoPi * i / SinTableSize);
+            }
+
+            for (int i = 0; i <= AtanTableSize; i++) {
+                AtanTable[i] = atan((double)i / AtanTableSize);
+            }
+        }
+    } BuildTables;
+
+    /*! Splits the angle into a table index, wrapped into one period, and the fraction of
+     *  the way to the next entry. */
+    static inline void TableIndex(Real radians, int offset, int &index, Real &fraction) {
+        double position = radians * (SinTableSize / TwoPi);
+        double whole = floor(position);
+        index = ((long long)whole + offset) & (SinTableSize - 1);
+        fraction = position - whole;
+    }
+
+    static inline Real TableLookup(int index, Real fraction) {
+        return SinTable[index] + (SinTable[index + 1] - SinTable[index]) * fraction;
+    }
+
+    Real TableSin(Real radians) {
+        int index; Real fraction;
+        TableIndex(radians, 0, index, fraction);
+        return TableLookup(index, fraction);
+    }
+
+    Real TableCos(Real radians) {
+        int index; Real fraction;
+        TableIndex(radians, SinTableSize / 4, index, fraction);
+        return TableLookup(index, fraction);
+    }
+
+    void TableSinCos(Real radians, Real &sine, Real &cosine) {
+        int index; Real fraction;
+        TableIndex(radians, 0, index, fraction);
+        sine = TableLookup(index, fraction);
+        index = (index + SinTableSize / 4) & (SinTableSize - 1);
+        cosine = TableLookup(index, fraction);
+    }
+
+    /*! Moves atan(min / max) of the absolute values into the right octant. */
+    static inline Real Atan2Octant(Real atan, Real y, Real x, bool swapped) {
+        if (swapped) { atan = HalfPi - atan; }
+        if (copysignf(1, x) < 0) { atan = Pi - atan; }
+
+        // Negative y, including -0, mirrors the result. Like libm, -0 counts for x too.
+        return copysignf(atan, y);
+    }
+
+    Real TableAtan2(Real y, Real x) {
+        Real ax = fabsf(x), ay = fabsf(y);
+        bool swapped = ay > ax;
+        Real ratio = swapped ? ax / ay : (ax > 0 ? ay / ax : 0);
+
+        Real position = ratio * AtanTableSize;
+        int index = (int)position;
+        if (index >= AtanTableSize) { index = AtanTableSize - 1; }
+        Real atan = AtanTable[index] + (AtanTable[index + 1] - AtanTable[index]) * (position - index);
+        return Atan2Octant(atan, y, x, swapped);
+    }
+
+#pragma mark Polynomials
+
+    /*! Reduces the angle to r in [-pi/4, pi/4], where radians = r + quadrant * pi / 2. */
+    static inline Real Reduce(Real radians, int &quadrant) {
+        Real scaled = radians * TwoOverPi;
+        quadrant = (int)(scaled + (scaled >= 0 ? .5f : -.5f));
+        Real k = quadrant;
+        return ((radians - k * PiOverTwoA) - k * PiOverTwoB) - k * PiOverTwoC;
+    }
+
+    static inline Real SinPolynomial(Real r, Real r2) {
+        return r + r * r2 * (SinA + r2 * (SinB + r2 * SinC));
+    }
+
+    static inline Real CosPolynomial(Real r2) {
+        return 1 - .5f * r2 + r2 * r2 * (CosA + r2 * (CosB + r2 * CosC));
+    }
+
+    Real PolySin(Real radians) {
+        Real sine, cosine;
+        PolySinCos(radians, sine, cosine);
+        return sine;
+    }
+
+    Real PolyCos(Real radians) {
+        Real sine, cosine;
+        PolySinCos(radians, sine, cosine);
+        return cosine;
+    }
+
+    void PolySinCos(Real radians, Real &sine, Real &cosine) {
+        int quadrant;
+        Real r = Reduce(radians, quadrant);
+        Real r2 = r * r;
+        Real s = SinPolynomial(r, r2);
+        Real c = CosPolynomial(r2);
+
+        // Each quarter turn rotates (cos, sin) to (-sin, cos).
+        switch (quadrant & 3) {
+            case 0: sine =  s; cosine =  c; break;
+            case 1: sine =  c; cosine = -s; break;
+            case 2: sine = -s; cosine = -c; break;
+            case 3: sine = -c; cosine =  s; break;
+        }
+    }
+
+    static inline Real AtanPolynomial(Real ratio) {
+        Real s = ratio * ratio;
+        Real sum = AtanCoefficients[7];
+        for (int i = 6; i >= 0; i--) {
+            sum = AtanCoefficients[i] + s * sum;
+        }
+
+        return ratio * (1 + s * sum);
+    }
+
+    Real PolyAtan2(Real y, Real x) {
+        Real ax = fabsf(x), ay = fabsf(y);
+        bool swapped = ay > ax;
+        Real ratio = swapped ? ax / ay : (ax > 0 ? ay / ax : 0);
+        return Atan2Octant(AtanPolynomial(ratio), y, x, swapped);
+    }
+
+#pragma mark Batches
+
+    void SinCos(const Real *radians, Real *sines, Real *cosines, unsigned int count) {
+        unsigned int i = 0;
+#if SYS_SSE2
+        const __m128i one = _mm_set1_epi32(1), two = _mm_set1_epi32(2);
+        for (; i + 4 <= count; i += 4) {
+            __m128 angle = _mm_loadu_ps(radians + i);
+            __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(TwoOverPi)));
+            __m128 k = _mm_cvtepi32_ps(quadrant);
+
+            __m128 r = _mm_sub_ps(angle, _mm_mul_ps(k, _mm_set1_ps(PiOverTwoA)));
+            r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(PiOverTwoB)));
+            r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(PiOverTwoC)));
+            __m128 r2 = _mm_mul_ps(r, r);
+
+            __m128 s = _mm_add_ps(_mm_set1_ps(SinB), _mm_mul_ps(r2, _mm_set1_ps(SinC)));
+            s = _mm_add_ps(_mm_set1_ps(SinA), _mm_mul_ps(r2, s));
+            s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), s));
+
+            __m128 c = _mm_add_ps(_mm_set1_ps(CosB), _mm_mul_ps(r2, _mm_set1_ps(CosC)));
+            c = _mm_add_ps(_mm_set1_ps(CosA), _mm_mul_ps(r2, c));
+            c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1), _mm_mul_ps(_mm_set1_ps(.5f), r2)),
+                           _mm_mul_ps(_mm_mul_ps(r2, r2), c));
+
+            // Odd quadrants swap sin and cos. Bit 1 of the quadrant flips the sine's sign,
+            // and bit 1 of the quadrant plus one flips the cosine's.
+            __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+            __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+            __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(
+                _mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+
+            __m128 sine = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+            __m128 cosine = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+            if (sines)   { _mm_storeu_ps(sines + i, _mm_xor_ps(sine, sinSign)); }
+            if (cosines) { _mm_storeu_ps(cosines + i, _mm_xor_ps(cosine, cosSign)); }
+        }
+#endif
+        // Whatever's left over, or everything without SSE2.
+        for (; i < count; i++) {
+            Real sine, cosine;
+            PolySinCos(radians[i], sine, cosine);
+            if (sines)   { sines[i] = sine; }
+            if (cosines) { cosines[i] = cosine; }
+        }
+    }
+
+    void Atan2(const Real *y, const Real *x, Real *results, unsigned int count) {
+        unsigned int i = 0;
+#if SYS_SSE2
+        const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+        const __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4) {
+            __m128 vy = _mm_loadu_ps(y + i), vx = _mm_loadu_ps(x + i);
+            __m128 ax = _mm_andnot_ps(signMask, vx), ay = _mm_andnot_ps(signMask, vy);
+
+            // The smaller over the larger, or 0 when both are 0.
+            __m128 larger = _mm_max_ps(ax, ay);
+            __m128 ratio = _mm_and_ps(_mm_cmpgt_ps(larger, zero),
+                _mm_div_ps(_mm_min_ps(ax, ay), larger));
+
+            __m128 s = _mm_mul_ps(ratio, ratio);
+            __m128 sum = _mm_set1_ps(AtanCoefficients[7]);
+            for (int c = 6; c >= 0; c--) {
+                sum = _mm_add_ps(_mm_set1_ps(AtanCoefficients[c]), _mm_mul_ps(s, sum));
+            }
+            __m128 atan = _mm_mul_ps(ratio, _mm_add_ps(_mm_set1_ps(1), _mm_mul_ps(s, sum)));
+
+            __m128 swapped = _mm_cmpgt_ps(ay, ax);
+            atan = _mm_or_ps(_mm_and_ps(swapped, _mm_sub_ps(_mm_set1_ps(HalfPi), atan)),
+                             _mm_andnot_ps(swapped, atan));
+
+            __m128 negative = _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(vx), 31));
+            atan = _mm_or_ps(_mm_and_ps(negative, _mm_sub_ps(_mm_set1_ps(Pi), atan)),
+                             _mm_andnot_ps(negative, atan));
+
+            // Negative y, including -0, mirrors the result.
+            _mm_storeu_ps(results + i, _mm_or_ps(atan, _mm_and_ps(vy, signMask)));
+        }
+#endif
+        for (; i < count; i++) {
+            results[i] = PolyAtan2(y[i], x[i]);
+        }
+    }
+};
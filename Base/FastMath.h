@@ -0,0 +1,70 @@
+/*
+ *  FastMath.h
+ *  Base
+ *
+ *  Created by loch on 5/8/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _FASTMATH_H_
+#define _FASTMATH_H_
+#include "Base.h"
+
+// The trig functions in Math are built on one of these, chosen by defining TRIG_MODE when
+// building Base. libm is the default. One value at a time, neither the tables nor the
+// polynomials measurably beat it, so they're only worth picking on a platform where they
+// do. The real win is the SSE batch functions below, which should be used directly.
+#define TRIG_LIBM       0
+#define TRIG_TABLE      1
+#define TRIG_POLYNOMIAL 2
+
+#ifndef TRIG_MODE
+#   define TRIG_MODE TRIG_LIBM
+#endif
+
+/*! FastMath provides trig functions that trade the last bit or so of accuracy, and
+ *  support for huge arguments, for speed. There are two families:
+ *
+ *  Table functions look up the nearest two entries in a table covering one period, and
+ *  interpolate linearly between them. The angle is reduced in double precision, so the
+ *  error doesn't grow with the argument. Sin, cos, and atan2 are all within 4e-7 of the
+ *  true value. The tables are built when
+ *  the program starts, so these can't be used from other static initializers.
+ *
+ *  Polynomial functions reduce the angle into [-pi/4, pi/4], then evaluate the minimax
+ *  polynomials from the Cephes library. Sin and cos are within 1e-7 for |x| < 1e4, and
+ *  the error grows in proportion to the argument past that. Atan2 uses the polynomial
+ *  from Abramowitz and Stegun 4.4.47, and is within 3e-7 everywhere.
+ *
+ *  The batch functions use the polynomials, four values at a time with SSE2. They give
+ *  the same results as the scalar polynomial functions, give or take rounding, and are
+ *  the only ones here that are reliably faster than libm.
+ *
+ *  The scalar functions can stand in for Math::Sin, Math::Cos, Math::SinCos, and
+ *  Math::Atan2 by setting TRIG_MODE.
+ * \brief Fast, approximate trig functions in table, polynomial, and batch forms. */
+namespace FastMath {
+    static const int SinTableSize  = 4096; //!< Entries in one period of the sin table.
+    static const int AtanTableSize = 1024; //!< Entries in the atan table, covering [0, 1].
+
+    Real TableSin(Real radians);
+    Real TableCos(Real radians);
+    void TableSinCos(Real radians, Real &sine, Real &cosine);
+    Real TableAtan2(Real y, Real x);
+
+    Real PolySin(Real radians);
+    Real PolyCos(Real radians);
+    void PolySinCos(Real radians, Real &sine, Real &cosine);
+    Real PolyAtan2(Real y, Real x);
+
+    /*! Finds the sine and cosine of each of the given angles. Either output may be NULL,
+     *  and either may be the same array as the angles. */
+    void SinCos(const Real *radians, Real *sines, Real *cosines, unsigned int count);
+
+    /*! Finds atan2(y[i], x[i]) for each pair. The results may be the same array as either
+     *  input. */
+    void Atan2(const Real *y, const Real *x, Real *results, unsigned int count);
+};
+
+#endif
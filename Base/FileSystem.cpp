@@ -11,6 +11,7 @@
 #include "Assertion.h"
 
 #include "File.h"
+#include "MappedFile.h"
 
 #include <cassert>
 #include <fstream>
@@ -143,6 +144,16 @@ unsigned long long FileSystem::Length(const std::string &name) {
     return result;
 }
 
+time_t FileSystem::LastModified(const std::string &path) {
+    std::string newPath(path);
+    FormatPath(newPath);
+    if (!boost::filesystem::exists(newPath)) {
+        return 0;
+    }
+
+    return boost::filesystem::last_write_time(newPath);
+}
+
 bool FileSystem::Touch(const std::string &path) {
     if (Exists(path)) {
         return false;
@@ -182,6 +193,17 @@ File* FileSystem::GetFile(const std::string &path, long openFlags) {
     return new File(dir, file, openFlags);
 }
 
+MappedFile* FileSystem::GetMappedFile(const std::string &path, long openFlags) {
+    if (IsDirectory(path)) {
+        Warn("Given name is of a directory: " << path);
+        return NULL;
+    }
+
+    std::string fullName(path);
+    FormatPath(fullName);
+    return new MappedFile(fullName, openFlags);
+}
+
 template<typename Iterator>
 std::list<std::string>* listing(const std::string &path, bool dirs) {
     if (!FileSystem::IsDirectory(path)) {
@@ -8,12 +8,14 @@
 #include <fstream>
 #include <string>
 #include <list>
+#include <ctime>
 
 class TextFile;
 class BinaryFile;
 class DataTarget;
 class Archive;
 class File;
+class MappedFile;
 
 /*! This class acts as a virtual representation of the file system. It gives the user
  *  direct access to the FS in several different ways. Common functions are implemented as
@@ -60,6 +62,12 @@ public:
      * \return The length of the file, or zero is it doesn't exist or is a directory. */
     static unsigned long long Length(const std::string &path);
 
+    /*! Checks when the given path was last modified. Directories are modified whenever
+     *  something is added to, removed from or renamed inside of them.
+     * \param path The path to check.
+     * \return The modification time, or zero if the path doesn't exist. */
+    static time_t LastModified(const std::string &path);
+
     /*! Acts as an analog to the standard unix touch command.
      * \param path The path to touch.
      * \return True on success, false if the file was not created or something else
@@ -80,6 +88,14 @@ public:
      *         BinaryStream or TextStream to delete). */
     static File* GetFile(const std::string &path, long openFlags = IOTarget::None);
 
+    /*! Takes the given path and constructs a MappedFile out of it. Mapped files are read
+     *  only, and are opened immediately unless no open flags are given. If the given path
+     *  is a directory, NULL is returned.
+     * \note The returned value must be deleted by the user.
+     * \param path The path to use when creating the MappedFile object.
+     * \return A pointer to a MappedFile object. */
+    static MappedFile* GetMappedFile(const std::string &path, long openFlags = IOTarget::Read);
+
     /*! This looks at the given path and gets a list of files inside of it. The result may
      *  optionally include directory and may optionally be recursive as well.
      * \note The returned value must be deleted by the user.
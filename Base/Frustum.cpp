@@ -8,8 +8,14 @@
  */
 
 #include "Frustum.h"
+#include "AABBArray.h"
+#include "Assertion.h"
 #include "Math3D.h"
 
+#if SYS_SSE
+#include <xmmintrin.h>
+#endif
+
 Frustum::Frustum():
     _projectionMatrix(Matrix::Identity()),
     _worldMatrix(Matrix::Identity())
@@ -204,6 +210,132 @@ Frustum::Collision Frustum::checkAABB(const Vector3 &min, const Vector3 &max) co
     return mode == VERTEX_INT ? INTERSECT : COMPLETE_IN;      
 }
 
+// The planes, split into components for the batch tests. The absolute value of each
+// normal is used to find how far the box's extent reaches towards the plane.
+struct PlaneComponents {
+    Real nx[6], ny[6], nz[6];
+    Real ax[6], ay[6], az[6];
+    Real d[6];
+};
+
+// Tests a single box against the planes, starting with the one in the plane cache.
+static unsigned char CheckBox(
+    const PlaneComponents &planes,
+    Real cx, Real cy, Real cz,
+    Real ex, Real ey, Real ez,
+    unsigned char *cachedPlane)
+{
+    unsigned char result = Frustum::COMPLETE_IN;
+    int start = cachedPlane ? *cachedPlane : 0;
+    for (int k = 0; k < 6; k++) {
+        int p = (start + k) % 6;
+        Real dist = cx * planes.nx[p] + cy * planes.ny[p] + cz * planes.nz[p] - planes.d[p];
+        Real reach = ex * planes.ax[p] + ey * planes.ay[p] + ez * planes.az[p];
+
+        // The furthest corner is behind the plane, so every corner is.
+        if (dist + reach < 0) {
+            if (cachedPlane) { *cachedPlane = p; }
+            return Frustum::COMPLETE_OUT;
+        }
+
+        // The nearest corner is behind the plane, so only part of the box is inside.
+        if (dist - reach < 0) { result = Frustum::INTERSECT; }
+    }
+
+    return result;
+}
+
+#if SYS_SSE
+static inline __m128 Dot(__m128 x, __m128 y, __m128 z, __m128 a, __m128 b, __m128 c) {
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, a), _mm_mul_ps(y, b)), _mm_mul_ps(z, c));
+}
+
+// Builds a vector from the values for each lane's cached plane.
+static inline __m128 Gather(const Real *values, const unsigned char *cache) {
+    return _mm_setr_ps(values[cache[0]], values[cache[1]], values[cache[2]], values[cache[3]]);
+}
+#endif
+
+void Frustum::checkAABBs(const AABBArray &boxes, unsigned int first, unsigned int count,
+    unsigned char *results, unsigned char *planeCache) const
+{
+    ASSERT(first + count <= boxes.size());
+    if (count == 0) { return; }
+
+    PlaneComponents planes;
+    for (int p = 0; p < 6; p++) {
+        const Vector3 &normal = _frustum[p].getNormal();
+        planes.nx[p] = normal[0]; planes.ax[p] = fabs(normal[0]);
+        planes.ny[p] = normal[1]; planes.ay[p] = fabs(normal[1]);
+        planes.nz[p] = normal[2]; planes.az[p] = fabs(normal[2]);
+        planes.d[p] = _frustum[p].getDistance();
+    }
+
+    const Real *cx = boxes.getCenters(0) + first;
+    const Real *cy = boxes.getCenters(1) + first;
+    const Real *cz = boxes.getCenters(2) + first;
+    const Real *ex = boxes.getExtents(0) + first;
+    const Real *ey = boxes.getExtents(1) + first;
+    const Real *ez = boxes.getExtents(2) + first;
+
+    unsigned int i = 0;
+
+#if SYS_SSE
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(cx + i), w = _mm_loadu_ps(ex + i);
+        __m128 y = _mm_loadu_ps(cy + i), h = _mm_loadu_ps(ey + i);
+        __m128 z = _mm_loadu_ps(cz + i), l = _mm_loadu_ps(ez + i);
+
+        // Try the plane that rejected each box last time. If all four are still out,
+        // there's nothing else to do.
+        if (planeCache) {
+            const unsigned char *c = planeCache + i;
+            __m128 dist = _mm_sub_ps(
+                Dot(x, y, z, Gather(planes.nx, c), Gather(planes.ny, c), Gather(planes.nz, c)),
+                Gather(planes.d, c));
+            __m128 reach = Dot(w, h, l, Gather(planes.ax, c), Gather(planes.ay, c), Gather(planes.az, c));
+
+            if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, reach), zero)) == 0xF) {
+                results[i] = results[i + 1] = results[i + 2] = results[i + 3] = COMPLETE_OUT;
+                continue;
+            }
+        }
+
+        int outMask = 0, intersectMask = 0;
+        for (int p = 0; p < 6 && outMask != 0xF; p++) {
+            __m128 dist = _mm_sub_ps(
+                Dot(x, y, z, _mm_set1_ps(planes.nx[p]), _mm_set1_ps(planes.ny[p]), _mm_set1_ps(planes.nz[p])),
+                _mm_set1_ps(planes.d[p]));
+            __m128 reach = Dot(w, h, l, _mm_set1_ps(planes.ax[p]), _mm_set1_ps(planes.ay[p]), _mm_set1_ps(planes.az[p]));
+
+            int newOut = _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, reach), zero)) & ~outMask;
+            intersectMask |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(dist, reach), zero));
+
+            if (newOut && planeCache) {
+                for (int lane = 0; lane < 4; lane++) {
+                    if (newOut & (1 << lane)) { planeCache[i + lane] = p; }
+                }
+            }
+
+            outMask |= newOut;
+        }
+
+        for (int lane = 0; lane < 4; lane++) {
+            results[i + lane] =
+                (outMask & (1 << lane))       ? COMPLETE_OUT :
+                (intersectMask & (1 << lane)) ? INTERSECT    : COMPLETE_IN;
+        }
+    }
+#endif
+
+    // Anything left over (or everything, without SSE) is done one box at a time.
+    for (; i < count; i++) {
+        results[i] = CheckBox(planes, cx[i], cy[i], cz[i], ex[i], ey[i], ez[i],
+            planeCache ? planeCache + i : NULL);
+    }
+}
+
 std::ostream& operator<<(std::ostream &lhs, const Frustum &rhs) {
     lhs << "Frustum" << std::endl;
     lhs << "  Left   " << rhs._frustum[Frustum::LEFT  ] << std::endl;
@@ -14,6 +14,8 @@
 #include "AABB.h"
 #include "Plane.h"
 
+class AABBArray;
+
 /*! The frustum is the imaginary box that extends outwards from a camera and represents
  *  the bounds of what a camera actually sees. The shape of this box is determined by the
  *  type of projection specified (either ortho or perspective). This object acts kind of
@@ -81,6 +83,20 @@ public:
     Collision checkAABB(const Vector3 &mins, const Vector3 &maxs) const;
     Collision checkAABB(const AABB3 &box) const;
 
+    /*! Tests 'count' boxes from the given array, starting at index 'first', and writes a
+     *  Collision value for each of them to 'results'. Rather than testing every corner,
+     *  only the nearest and furthest corners relative to each plane are considered, and
+     *  boxes are tested several at a time when vector instructions are available. The
+     *  results match checkAABB.
+     *
+     *  If a plane cache is given, it should hold one entry per box and persist between
+     *  calls. The plane that last rejected each box is stored there and tested first the
+     *  next time around, since a box that was outside of the frustum is likely to still
+     *  be outside of the same plane. Both 'results' and 'planeCache' are indexed from
+     *  'first', so results[0] is the result for boxes[first]. */
+    void checkAABBs(const AABBArray &boxes, unsigned int first, unsigned int count,
+        unsigned char *results, unsigned char *planeCache = NULL) const;
+
     friend std::ostream& operator<<(std::ostream &lhs, const Frustum &rhs);
 
 protected:
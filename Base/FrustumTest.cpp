@@ -8,11 +8,39 @@
 
 #include "FrustumTest.h"
 #include "Frustum.h"
+#include "AABBArray.h"
 #include "Matrix.h"
+#include <algorithm>
+#include <ctime>
 
 void TestFrustum::RunTests() {
     TestOrthoDecomp();
     TestPerspectiveDecomp();
+    TestBatchMatchesScalar();
+    TestBatchPlaneCache();
+    BenchmarkBatch();
+}
+
+static void FillRandomBoxes(AABBArray &boxes, int count, Real range, Real size) {
+    boxes.clear();
+    for (int i = 0; i < count; i++) {
+        boxes.add(AABB3(
+            Vector3(
+                (rand() / (Real)RAND_MAX - 0.5) * range,
+                (rand() / (Real)RAND_MAX - 0.5) * range,
+                (rand() / (Real)RAND_MAX - 0.5) * range),
+            Vector3(
+                rand() / (Real)RAND_MAX * size,
+                rand() / (Real)RAND_MAX * size,
+                rand() / (Real)RAND_MAX * size)));
+    }
+}
+
+static Frustum CreateTestFrustum() {
+    Frustum frustum;
+    frustum.setProjectionMatrix(Matrix::Perspective(1.0, Degree(60), 1.0, 200.0));
+    frustum.setWorldMatrix(Matrix::Translation(Vector3(10, -5, 80)).getInverse());
+    return frustum;
 }
 
 void TestFrustum::TestOrthoDecomp() {
@@ -51,3 +79,102 @@ void TestFrustum::TestPerspectiveDecomp() {
 //    TASSERT(frustum.getPlane(Frustum::NEAR  )->getDistance() < 0);
 //    TASSERT(frustum.getPlane(Frustum::FAR   )->getDistance() < 0);
 }
+
+void TestFrustum::TestBatchMatchesScalar() {
+    Frustum frustum = CreateTestFrustum();
+    AABBArray boxes;
+    srand(4);
+    FillRandomBoxes(boxes, 10003, 400, 10);
+
+    // Test an odd range to make sure leftover boxes are handled.
+    std::vector<unsigned char> results(boxes.size() - 2);
+    frustum.checkAABBs(boxes, 1, results.size(), &results[0]);
+
+    int counts[3] = {0, 0, 0}, mismatches = 0;
+    for (int i = 0; i < results.size(); i++) {
+        if (results[i] != frustum.checkAABB(boxes.get(i + 1))) { mismatches++; }
+        counts[results[i]]++;
+    }
+
+    TASSERT_EQ(mismatches, 0);
+    TASSERT(counts[Frustum::COMPLETE_OUT] > 0);
+    TASSERT(counts[Frustum::INTERSECT] > 0);
+    TASSERT(counts[Frustum::COMPLETE_IN] > 0);
+}
+
+void TestFrustum::TestBatchPlaneCache() {
+    Frustum frustum = CreateTestFrustum();
+    AABBArray boxes;
+    srand(5);
+    FillRandomBoxes(boxes, 1001, 400, 10);
+
+    std::vector<unsigned char> expected(boxes.size()), results(boxes.size());
+    std::vector<unsigned char> cache(boxes.size(), 0);
+    frustum.checkAABBs(boxes, 0, boxes.size(), &expected[0]);
+
+    // The cache shouldn't change the results, no matter how many times it's used.
+    for (int pass = 0; pass < 3; pass++) {
+        frustum.checkAABBs(boxes, 0, boxes.size(), &results[0], &cache[0]);
+        TASSERT(results == expected);
+    }
+
+    // Every rejected box should remember a plane it is completely behind.
+    int wrongPlanes = 0;
+    for (int i = 0; i < boxes.size(); i++) {
+        if (expected[i] != Frustum::COMPLETE_OUT) { continue; }
+        TASSERT(cache[i] < 6);
+        AABB3 box = boxes.get(i);
+        const Plane *plane = frustum.getPlane((Frustum::Sides)cache[i]);
+        Vector3 reach = box.getRadius() * plane->getNormal().getAbsolute();
+        if (plane->distanceFrom(box.getCenter()) + reach[0] + reach[1] + reach[2] >= 0) {
+            wrongPlanes++;
+        }
+    }
+
+    TASSERT_EQ(wrongPlanes, 0);
+}
+
+void TestFrustum::BenchmarkBatch() {
+    const int count = 100000, passes = 10;
+    Frustum frustum = CreateTestFrustum();
+    AABBArray boxes;
+    srand(6);
+    FillRandomBoxes(boxes, count, 400, 10);
+
+    std::vector<AABB3> scalarBoxes;
+    for (int i = 0; i < count; i++) { scalarBoxes.push_back(boxes.get(i)); }
+
+    std::vector<unsigned char> results(count), cache(count, 0);
+    int checksum[3] = {0, 0, 0};
+
+    clock_t start = clock();
+    for (int pass = 0; pass < passes; pass++) {
+        for (int i = 0; i < count; i++) {
+            results[i] = frustum.checkAABB(scalarBoxes[i]);
+        }
+    }
+    double scalarTime = (clock() - start) / (double)CLOCKS_PER_SEC;
+    checksum[0] = std::count(results.begin(), results.end(), Frustum::COMPLETE_OUT);
+
+    start = clock();
+    for (int pass = 0; pass < passes; pass++) {
+        frustum.checkAABBs(boxes, 0, count, &results[0]);
+    }
+    double batchTime = (clock() - start) / (double)CLOCKS_PER_SEC;
+    checksum[1] = std::count(results.begin(), results.end(), Frustum::COMPLETE_OUT);
+
+    start = clock();
+    for (int pass = 0; pass < passes; pass++) {
+        frustum.checkAABBs(boxes, 0, count, &results[0], &cache[0]);
+    }
+    double cachedTime = (clock() - start) / (double)CLOCKS_PER_SEC;
+    checksum[2] = std::count(results.begin(), results.end(), Frustum::COMPLETE_OUT);
+
+    TASSERT_EQ(checksum[0], checksum[1]);
+    TASSERT_EQ(checksum[0], checksum[2]);
+
+    Info("Frustum culling " << count << " boxes x " << passes << " passes:");
+    Info("  checkAABB:                " << scalarTime * 1000.0 << "ms");
+    Info("  checkAABBs:               " << batchTime  * 1000.0 << "ms");
+    Info("  checkAABBs (plane cache): " << cachedTime * 1000.0 << "ms");
+}
@@ -18,6 +18,9 @@ public:
 private:
     static void TestOrthoDecomp();
     static void TestPerspectiveDecomp();
+    static void TestBatchMatchesScalar();
+    static void TestBatchPlaneCache();
+    static void BenchmarkBatch();
 
 };
 
@@ -0,0 +1,540 @@
+/*
+ *  ImageCache.cpp
+ *  Base
+ *
+ *  Created by loch on 5/10/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "ImageCache.h"
+#include "MHT_Helper.h"
+#include "IOTarget.h"
+#include "Assertion.h"
+#include "Math3D.h"
+#include <climits>
+#include <cstring>
+
+#pragma mark Writing helpers
+
+static unsigned int Align(unsigned int offset) {
+    return (offset + MHT_LevelAlignment - 1) / MHT_LevelAlignment * MHT_LevelAlignment;
+}
+
+static bool IsLittleEndian() {
+    int check = 1;
+    return *(char*)&check == 1;
+}
+
+/*! Writes the given bytes, followed by enough zeros to bring the file to the target
+ *  offset. Returns false if anything could not be written. */
+static bool WriteAt(IOTarget *target, unsigned int &position, unsigned int offset,
+const void *data, unsigned int size) {
+    static const char padding[MHT_LevelAlignment] = { 0 };
+    ASSERT(offset >= position);
+    while (position < offset) {
+        unsigned int count = Math::Min(offset - position, MHT_LevelAlignment);
+        if (target->write(padding, count) != count) { return false; }
+        position += count;
+    }
+
+    if (size && target->write(data, size) != size) { return false; }
+    position += size;
+    return true;
+}
+
+/*! Gets the size of the given level of a chain starting at the given size. */
+static void LevelSize(unsigned int width, unsigned int height, int level,
+unsigned int &levelWidth, unsigned int &levelHeight) {
+    levelWidth = Math::Max(1u, width >> level);
+    levelHeight = Math::Max(1u, height >> level);
+}
+
+#pragma mark Block compression helpers
+
+/*! Packs an 8 bit color into 5:6:5, rounding to the nearest value. */
+static unsigned short Pack565(const int *color) {
+    return ((color[0] * 31 + 127) / 255) << 11 |
+           ((color[1] * 63 + 127) / 255) << 5 |
+           ((color[2] * 31 + 127) / 255);
+}
+
+/*! Expands a 5:6:5 color back to 8 bits a channel, the way the hardware does. */
+static void Unpack565(unsigned short packed, int *color) {
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+/*! Copies the 4x4 block at the given block coordinates out of an RGBA level, repeating
+ *  the last row and column for blocks that hang off of the edge. */
+static void ExtractBlock(const ImageCache::Level &level, unsigned int bx, unsigned int by,
+unsigned char *block) {
+    for (int y = 0; y < 4; y++) {
+        unsigned int row = Math::Min(by * 4 + y, level.height - 1);
+        for (int x = 0; x < 4; x++) {
+            unsigned int column = Math::Min(bx * 4 + x, level.width - 1);
+            memcpy(block + (y * 4 + x) * 4, &level.data[(row * level.width + column) * 4], 4);
+        }
+    }
+}
+
+/*! Compresses the colors of a block into 8 bytes, always in four color mode. The end
+ *  points are the extremes of the block along its principal axis. */
+static void CompressColorBlock(const unsigned char *block, unsigned char *result) {
+    float mean[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) { mean[c] += block[i * 4 + c] / 16.0f; }
+    }
+
+    // Covariance: xx, xy, xz, yy, yz, zz.
+    float covariance[6] = { 0, 0, 0, 0, 0, 0 };
+    for (int i = 0; i < 16; i++) {
+        float r = block[i * 4] - mean[0], g = block[i * 4 + 1] - mean[1], b = block[i * 4 + 2] - mean[2];
+        covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+        covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+    }
+
+    // A few rounds of power iteration is plenty to find the principal axis.
+    float axis[3] = { 1, 1, 1 };
+    for (int i = 0; i < 4; i++) {
+        float next[3] = {
+            covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+            covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+            covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2] };
+        float largest = Math::Max(fabsf(next[0]), Math::Max(fabsf(next[1]), fabsf(next[2])));
+        if (largest == 0) { break; }
+        for (int c = 0; c < 3; c++) { axis[c] = next[c] / largest; }
+    }
+
+    int low = 0, high = 0;
+    float lowest = 0, highest = 0;
+    for (int i = 0; i < 16; i++) {
+        float projection = block[i * 4] * axis[0] + block[i * 4 + 1] * axis[1] + block[i * 4 + 2] * axis[2];
+        if (i == 0 || projection < lowest)  { lowest = projection;  low = i;  }
+        if (i == 0 || projection > highest) { highest = projection; high = i; }
+    }
+
+    int ends[2][3];
+    for (int c = 0; c < 3; c++) {
+        ends[0][c] = block[high * 4 + c];
+        ends[1][c] = block[low * 4 + c];
+    }
+
+    // Four color mode needs the first end point to be the larger one.
+    unsigned short color0 = Pack565(ends[0]), color1 = Pack565(ends[1]);
+    if (color0 < color1) { std::swap(color0, color1); }
+
+    int palette[4][3];
+    Unpack565(color0, palette[0]);
+    Unpack565(color1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    unsigned int indices = 0;
+    if (color0 != color1) {
+        for (int i = 15; i >= 0; i--) {
+            int best = 0, bestDistance = INT_MAX;
+            for (int p = 0; p < 4; p++) {
+                int distance = 0;
+                for (int c = 0; c < 3; c++) {
+                    int delta = block[i * 4 + c] - palette[p][c];
+                    distance += delta * delta;
+                }
+
+                if (distance < bestDistance) { bestDistance = distance; best = p; }
+            }
+
+            indices = (indices << 2) | best;
+        }
+    }
+
+    result[0] = color0 & 0xFF; result[1] = color0 >> 8;
+    result[2] = color1 & 0xFF; result[3] = color1 >> 8;
+    for (int i = 0; i < 4; i++) { result[4 + i] = (indices >> (i * 8)) & 0xFF; }
+}
+
+/*! Compresses the alpha of a block into 8 bytes, using the eight value mode. */
+static void CompressAlphaBlock(const unsigned char *block, unsigned char *result) {
+    int alpha0 = 0, alpha1 = 255;
+    for (int i = 0; i < 16; i++) {
+        alpha0 = Math::Max(alpha0, (int)block[i * 4 + 3]);
+        alpha1 = Math::Min(alpha1, (int)block[i * 4 + 3]);
+    }
+
+    int palette[8] = { alpha0, alpha1 };
+    for (int i = 1; i < 7; i++) {
+        palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+    }
+
+    unsigned long long indices = 0;
+    if (alpha0 != alpha1) {
+        for (int i = 15; i >= 0; i--) {
+            int best = 0, bestDistance = INT_MAX;
+            for (int p = 0; p < 8; p++) {
+                int distance = abs(block[i * 4 + 3] - palette[p]);
+                if (distance < bestDistance) { bestDistance = distance; best = p; }
+            }
+
+            indices = (indices << 3) | best;
+        }
+    }
+
+    result[0] = alpha0;
+    result[1] = alpha1;
+    for (int i = 0; i < 6; i++) { result[2 + i] = (indices >> (i * 8)) & 0xFF; }
+}
+
+/*! Expands an 8 byte color block. DXT1 blocks in three color mode get a transparent
+ *  black for their fourth color. */
+static void DecompressColorBlock(const unsigned char *data, bool allowTransparent,
+unsigned char *block) {
+    unsigned short color0 = data[0] | data[1] << 8, color1 = data[2] | data[3] << 8;
+    int palette[4][4];
+    Unpack565(color0, palette[0]);
+    Unpack565(color1, palette[1]);
+    palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+
+    for (int c = 0; c < 3; c++) {
+        if (color0 > color1 || !allowTransparent) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        } else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+
+    if (color0 <= color1 && allowTransparent) { palette[3][3] = 0; }
+
+    unsigned int indices = data[4] | data[5] << 8 | data[6] << 16 | (unsigned int)data[7] << 24;
+    for (int i = 0; i < 16; i++) {
+        const int *color = palette[(indices >> (i * 2)) & 3];
+        for (int c = 0; c < 4; c++) { block[i * 4 + c] = color[c]; }
+    }
+}
+
+/*! Expands an 8 byte alpha block into the alpha channel of the given block. */
+static void DecompressAlphaBlock(const unsigned char *data, unsigned char *block) {
+    int palette[8] = { data[0], data[1] };
+    for (int i = 1; i < 7; i++) {
+        palette[i + 1] = data[0] > data[1] ?
+            ((7 - i) * data[0] + i * data[1]) / 7 : 0;
+    }
+
+    // Only the eight value mode is ever written, but read the six value mode properly.
+    if (data[0] <= data[1]) {
+        for (int i = 1; i < 5; i++) { palette[i + 1] = ((5 - i) * data[0] + i * data[1]) / 5; }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    unsigned long long indices = 0;
+    for (int i = 5; i >= 0; i--) { indices = (indices << 8) | data[2 + i]; }
+    for (int i = 0; i < 16; i++) {
+        block[i * 4 + 3] = palette[(indices >> (i * 3)) & 7];
+    }
+}
+
+#pragma mark ImageCache static definitions
+
+void ImageCache::Cook(const unsigned char *pixels, unsigned int width, unsigned int height,
+unsigned int pitch, int channels, bool bgr, bool flip, Format format, std::vector<Level> &levels) {
+    // Everything is built from RGBA, whatever it ends up stored as.
+    std::vector<Level> chain(1);
+    Convert(pixels, width, height, pitch, channels, bgr, flip, chain[0]);
+
+    while (chain.back().width > 1 || chain.back().height > 1) {
+        chain.push_back(Level());
+        Downsample(chain[chain.size() - 2], chain.back());
+    }
+
+    if (!IsCompressed(format)) {
+        levels.swap(chain);
+        return;
+    }
+
+    levels.resize(chain.size());
+    for (int i = 0; i < chain.size(); i++) {
+        Compress(chain[i], format, levels[i]);
+    }
+}
+
+void ImageCache::Convert(const unsigned char *pixels, unsigned int width, unsigned int height,
+unsigned int pitch, int channels, bool bgr, bool flip, Level &result) {
+    ASSERT(channels == 3 || channels == 4);
+    ASSERT(width > 0 && height > 0);
+
+    result.width = width;
+    result.height = height;
+    result.data.resize(width * height * 4);
+    int red = bgr ? 2 : 0, blue = bgr ? 0 : 2;
+    for (unsigned int y = 0; y < height; y++) {
+        const unsigned char *source = pixels + (flip ? height - 1 - y : y) * pitch;
+        unsigned char *destination = &result.data[y * width * 4];
+        for (unsigned int x = 0; x < width; x++, source += channels, destination += 4) {
+            destination[0] = source[red];
+            destination[1] = source[1];
+            destination[2] = source[blue];
+            destination[3] = channels == 4 ? source[3] : 255;
+        }
+    }
+}
+
+void ImageCache::Downsample(const Level &source, Level &result) {
+    result.width = Math::Max(1u, source.width / 2);
+    result.height = Math::Max(1u, source.height / 2);
+    result.data.resize(result.width * result.height * 4);
+
+    for (unsigned int y = 0; y < result.height; y++) {
+        unsigned int y0 = Math::Min(y * 2, source.height - 1);
+        unsigned int y1 = Math::Min(y * 2 + 1, source.height - 1);
+        const unsigned char *row0 = &source.data[y0 * source.width * 4];
+        const unsigned char *row1 = &source.data[y1 * source.width * 4];
+        unsigned char *destination = &result.data[y * result.width * 4];
+
+        for (unsigned int x = 0; x < result.width; x++) {
+            unsigned int x0 = Math::Min(x * 2, source.width - 1) * 4;
+            unsigned int x1 = Math::Min(x * 2 + 1, source.width - 1) * 4;
+            for (int c = 0; c < 4; c++) {
+                *destination++ = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4;
+            }
+        }
+    }
+}
+
+void ImageCache::Compress(const Level &source, Format format, Level &result) {
+    ASSERT(IsCompressed(format));
+    result.width = source.width;
+    result.height = source.height;
+    result.data.resize(GetLevelSize(source.width, source.height, format));
+
+    unsigned int blocksWide = (source.width + 3) / 4, blocksHigh = (source.height + 3) / 4;
+    unsigned char block[64];
+    unsigned char *destination = &result.data[0];
+    for (unsigned int by = 0; by < blocksHigh; by++) {
+        for (unsigned int bx = 0; bx < blocksWide; bx++) {
+            ExtractBlock(source, bx, by, block);
+            if (format == DXT5) {
+                CompressAlphaBlock(block, destination);
+                destination += 8;
+            }
+
+            CompressColorBlock(block, destination);
+            destination += 8;
+        }
+    }
+}
+
+void ImageCache::Decompress(const Level &source, Format format, Level &result) {
+    ASSERT(IsCompressed(format));
+    result.width = source.width;
+    result.height = source.height;
+    result.data.resize(source.width * source.height * 4);
+
+    unsigned int blocksWide = (source.width + 3) / 4, blocksHigh = (source.height + 3) / 4;
+    unsigned char block[64];
+    const unsigned char *data = &source.data[0];
+    for (unsigned int by = 0; by < blocksHigh; by++) {
+        for (unsigned int bx = 0; bx < blocksWide; bx++) {
+            if (format == DXT5) {
+                DecompressColorBlock(data + 8, false, block);
+                DecompressAlphaBlock(data, block);
+                data += 16;
+            } else {
+                DecompressColorBlock(data, true, block);
+                data += 8;
+            }
+
+            for (int y = 0; y < 4 && by * 4 + y < source.height; y++) {
+                for (int x = 0; x < 4 && bx * 4 + x < source.width; x++) {
+                    memcpy(&result.data[((by * 4 + y) * source.width + bx * 4 + x) * 4],
+                        block + (y * 4 + x) * 4, 4);
+                }
+            }
+        }
+    }
+}
+
+unsigned int ImageCache::GetLevelSize(unsigned int width, unsigned int height, Format format) {
+    switch (format) {
+    case DXT1: return ((width + 3) / 4) * ((height + 3) / 4) * 8;
+    case DXT5: return ((width + 3) / 4) * ((height + 3) / 4) * 16;
+    default:   return width * height * 4;
+    }
+}
+
+bool ImageCache::IsCompressed(Format format) {
+    return format == DXT1 || format == DXT5;
+}
+
+bool ImageCache::Write(IOTarget *target, Format format, const std::vector<Level> &levels) {
+    if (!IsLittleEndian()) {
+        Error("Texture caches can only be written on little endian hosts.");
+        return false;
+    }
+
+    if (levels.empty() || (format != RGBA && format != DXT1 && format != DXT5)) {
+        Error("Texture cache needs at least one level in a known format.");
+        return false;
+    }
+
+    MHT_Header header;
+    memset(&header, 0, sizeof(MHT_Header));
+    header.signature   = MHT_Signature;
+    header.version     = MHT_Version;
+    header.headerSize  = sizeof(MHT_Header);
+    header.byteOrder   = MHT_ByteOrder;
+    header.format      = format;
+    header.width       = levels[0].width;
+    header.height      = levels[0].height;
+    header.levelCount  = levels.size();
+    header.levelOffset = sizeof(MHT_Header);
+
+    std::vector<MHT_Level> levelTable(levels.size());
+    unsigned int offset = header.levelOffset + levels.size() * sizeof(MHT_Level);
+    for (int i = 0; i < levels.size(); i++) {
+        unsigned int width, height;
+        LevelSize(header.width, header.height, i, width, height);
+        if (levels[i].width != width || levels[i].height != height ||
+            levels[i].data.size() != GetLevelSize(width, height, format)) {
+            Error("Level " << i << " doesn't belong in a " << header.width << "x" <<
+                  header.height << " mip chain.");
+            return false;
+        }
+
+        offset = Align(offset);
+        levelTable[i].width = width;
+        levelTable[i].height = height;
+        levelTable[i].size = levels[i].data.size();
+        levelTable[i].offset = offset;
+        offset += levelTable[i].size;
+    }
+
+    header.fileSize = offset;
+
+    unsigned int position = 0;
+    bool success =
+        WriteAt(target, position, 0, &header, sizeof(MHT_Header)) &&
+        WriteAt(target, position, header.levelOffset, &levelTable[0],
+            levels.size() * sizeof(MHT_Level));
+
+    for (int i = 0; success && i < levels.size(); i++) {
+        success = WriteAt(target, position, levelTable[i].offset, &levels[i].data[0],
+            levelTable[i].size);
+    }
+
+    if (!success) {
+        Error("Unable to write texture cache.");
+    }
+
+    return success;
+}
+
+ImageCache::LevelView ImageCache::GetView(const Level &level) {
+    LevelView view;
+    view.width = level.width;
+    view.height = level.height;
+    view.size = level.data.size();
+    view.data = level.data.empty() ? NULL : &level.data[0];
+    return view;
+}
+
+bool ImageCache::IsImageCache(const unsigned char *data, long long length) {
+    return length >= sizeof(int) && *(const int*)data == MHT_Signature;
+}
+
+#pragma mark ImageCache definitions
+
+ImageCache::ImageCache(): _format(RGBA), _pixelBytes(0) {}
+
+ImageCache::~ImageCache() {}
+
+bool ImageCache::read(const unsigned char *data, long long length) {
+    _levels.clear();
+    _pixelBytes = 0;
+
+    if (length < sizeof(MHT_Header) || !IsImageCache(data, length)) {
+        Error("Not a texture cache.");
+        return false;
+    }
+
+    const MHT_Header *header = (const MHT_Header*)data;
+    if (header->byteOrder != MHT_ByteOrder) {
+        Error("Texture cache was written with a different byte order.");
+        return false;
+    }
+
+    if (header->version != MHT_Version || header->headerSize != sizeof(MHT_Header)) {
+        Error("Texture cache version " << header->version << " is not supported. Expected " <<
+              MHT_Version << ".");
+        return false;
+    }
+
+    // A full chain for the largest texture anything could create is 32 levels.
+    if (header->fileSize > length ||
+        (header->format != MHT_RGBA && header->format != MHT_DXT1 && header->format != MHT_DXT5) ||
+        header->width == 0 || header->height == 0 ||
+        header->levelCount == 0 || header->levelCount > 32 ||
+        header->levelOffset > length ||
+        (long long)header->levelCount * sizeof(MHT_Level) > length - header->levelOffset) {
+        Error("Texture cache is truncated or corrupt.");
+        return false;
+    }
+
+    _format = (Format)header->format;
+    const MHT_Level *levelTable = (const MHT_Level*)(data + header->levelOffset);
+    _levels.resize(header->levelCount);
+    for (int i = 0; i < header->levelCount; i++) {
+        const MHT_Level &entry = levelTable[i];
+        unsigned int width, height;
+        LevelSize(header->width, header->height, i, width, height);
+
+        if (entry.width != width || entry.height != height ||
+            entry.size != GetLevelSize(width, height, _format) ||
+            entry.offset > length || entry.size > length - entry.offset) {
+            Error("Texture cache has a corrupt level table.");
+            _levels.clear();
+            return false;
+        }
+
+        _levels[i].width = entry.width;
+        _levels[i].height = entry.height;
+        _levels[i].size = entry.size;
+        _levels[i].data = data + entry.offset;
+        _pixelBytes += entry.size;
+    }
+
+    return true;
+}
+
+ImageCache::Format ImageCache::getFormat() const {
+    return _format;
+}
+
+unsigned int ImageCache::getWidth() const {
+    return _levels.empty() ? 0 : _levels[0].width;
+}
+
+unsigned int ImageCache::getHeight() const {
+    return _levels.empty() ? 0 : _levels[0].height;
+}
+
+unsigned int ImageCache::getLevelCount() const {
+    return _levels.size();
+}
+
+const ImageCache::LevelView& ImageCache::getLevel(int index) const {
+    return _levels[index];
+}
+
+const std::vector<ImageCache::LevelView>& ImageCache::getLevels() const {
+    return _levels;
+}
+
+long long ImageCache::getPixelBytes() const {
+    return _pixelBytes;
+}
@@ -0,0 +1,131 @@
+/*
+ *  ImageCache.h
+ *  Base
+ *
+ *  Created by loch on 5/10/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _IMAGECACHE_H_
+#define _IMAGECACHE_H_
+#include "Base.h"
+
+class IOTarget;
+
+/*! ImageCache cooks images into, and reads them back out of, the engine's native binary
+ *  texture format (.mht). Loading an ordinary image means decoding it, flipping it into
+ *  the bottom up order OpenGL uses, and building every mipmap level on the CPU. A cache
+ *  holds the result of all of that, optionally block compressed as well, so loading one
+ *  is nothing more than validating the level table and pointing into the data.
+ *
+ *  Cooking happens offline, normally through TextureSDL::Factory::convert, and caches
+ *  are loaded straight out of a MappedFile at runtime.
+ * \note The layout of the file is described in MHT_Helper.h.
+ * \brief Cooks, writes, and reads .mht texture caches.
+ * \seealso TextureCacheFactory */
+class ImageCache {
+public:
+    /*! The ways levels may be stored. */
+    enum Format {
+        RGBA = 1,                 //!< Uncompressed, 4 bytes per pixel.
+        DXT1 = 2,                 //!< S3TC compressed, with no alpha.
+        DXT5 = 3                  //!< S3TC compressed, with interpolated alpha.
+    };
+
+    /*! A single level of a cooked image. */
+    struct Level {
+        unsigned int width;
+        unsigned int height;
+        std::vector<unsigned char> data;
+    };
+
+    /*! A level read from a cache. The data points into the cache's memory. */
+    struct LevelView {
+        unsigned int width;
+        unsigned int height;
+        unsigned int size;        //!< The number of bytes of data.
+        const unsigned char *data;
+    };
+
+public:
+    /*! Builds a complete mip chain from an 8 bit per channel image. The source has 3 or 4
+     *  channels per pixel, in RGB order, or BGR if bgr is set, and rows pitch bytes
+     *  apart. If flip is set, the rows are reversed, which is needed for images stored
+     *  top down, like nearly everything decoded from disk. Every level is converted to
+     *  the given format. */
+    static void Cook(const unsigned char *pixels, unsigned int width, unsigned int height,
+                     unsigned int pitch, int channels, bool bgr, bool flip, Format format,
+                     std::vector<Level> &levels);
+
+    /*! Converts an image in any of the layouts Cook accepts into a single RGBA level,
+     *  without building any mipmaps. */
+    static void Convert(const unsigned char *pixels, unsigned int width, unsigned int height,
+                        unsigned int pitch, int channels, bool bgr, bool flip, Level &result);
+
+    /*! Builds the next level down from an RGBA level, averaging each 2x2 block of pixels.
+     *  Odd edges are clamped, so non power of two sizes shrink exactly as OpenGL's
+     *  mipmap sizes do. */
+    static void Downsample(const Level &source, Level &result);
+
+    /*! Compresses an RGBA level into DXT1 or DXT5 blocks. */
+    static void Compress(const Level &source, Format format, Level &result);
+
+    /*! Expands a DXT1 or DXT5 level back into RGBA, for checking the compression and for
+     *  cards that can't sample S3TC directly. */
+    static void Decompress(const Level &source, Format format, Level &result);
+
+    /*! Gets the number of bytes a level of the given size and format takes up. */
+    static unsigned int GetLevelSize(unsigned int width, unsigned int height, Format format);
+
+    /*! Returns true if the given format is block compressed. */
+    static bool IsCompressed(Format format);
+
+    /*! Writes a cache containing the given levels, which must already be in the given
+     *  format, largest first.
+     * \return false if the levels are inconsistent or could not be written. */
+    static bool Write(IOTarget *target, Format format, const std::vector<Level> &levels);
+
+    /*! Gets a view of a level that hasn't been written yet, so in memory levels can be
+     *  treated exactly like cached ones. The view points into the level's data. */
+    static LevelView GetView(const Level &level);
+
+    /*! Returns true if the data looks like a texture cache of any version. */
+    static bool IsImageCache(const unsigned char *data, long long length);
+
+public:
+    ImageCache();
+    ~ImageCache();
+
+    /*! Reads the cache in the given memory, which is not copied and must outlive anything
+     *  returned by getLevel. The level table is bounds checked, but the pixels are never
+     *  touched.
+     * \return false if the data is not a valid cache for this version. */
+    bool read(const unsigned char *data, long long length);
+
+    Format getFormat() const;
+
+    /*! Gets the size of the largest level. */
+    unsigned int getWidth() const;
+    unsigned int getHeight() const;
+
+    /*! Gets the number of levels in the cache, including the full size one. */
+    unsigned int getLevelCount() const;
+
+    /*! Gets the level at the given index, where 0 is the largest. */
+    const LevelView& getLevel(int index) const;
+
+    /*! Gets every level, largest first. */
+    const std::vector<LevelView>& getLevels() const;
+
+    /*! Gets the number of bytes of pixel data in every level. */
+    long long getPixelBytes() const;
+
+private:
+    Format _format;
+    std::vector<LevelView> _levels;
+    long long _pixelBytes;
+
+};
+
+#endif
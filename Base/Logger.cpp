@@ -9,6 +9,7 @@
 
 #include "Assertion.h"
 #include "Logger.h"
+#include "AsyncLogWriter.h"
 #include <iostream>
 #include <fstream>
 
@@ -50,6 +51,7 @@ LogChannel LogStream::ActiveLogChannels = LogStream::DefaultChannel;
 LogStream::LogDestination LogStream::Dest = All;
 LogStream *LogStream::OutStream = NULL;
 LogStream *LogStream::NilStream = NULL;
+AsyncLogWriter *LogStream::AsyncWriter = NULL;
 bool LogStream::BreakOnError = false;
 int LogStream::IndentLevel = 0;
 int LogStream::IndentSize = 3;
@@ -97,6 +99,36 @@ bool LogStream::IsChannelEnabled(LogChannel channel) {
     return (((int)ActiveLogChannels & (int)channel) != 0);
 }
 
+LogChannel LogStream::GetActiveChannels() {
+    return ActiveLogChannels;
+}
+
+bool LogStream::IsEnabled(LogType type, LogChannel channel) {
+    return type >= LogLevel && IsChannelEnabled(channel);
+}
+
+void LogStream::SetAsync(bool async) {
+    if (async == IsAsync()) { return; }
+
+    if (async) {
+        // The writer takes over the console and log file, so the sync stream lets go.
+        DeleteOutStream();
+        AsyncWriter = new AsyncLogWriter(Dest & Console ? &std::cout : NULL,
+            Dest & Disk ? Logfile : "");
+    } else {
+        delete AsyncWriter;
+        AsyncWriter = NULL;
+    }
+}
+
+bool LogStream::IsAsync() {
+    return AsyncWriter != NULL;
+}
+
+unsigned int LogStream::GetDroppedCount() {
+    return AsyncWriter ? AsyncWriter->getDroppedCount() : 0;
+}
+
 void LogStream::SetPretext(const std::string &text) {
     Pretext = text;
 }
@@ -108,13 +140,20 @@ bool LogStream::SetBreakOnError(bool newVal) {
 }
 
 void LogStream::SetLogDestination(LogDestination dest) {
+    // The async writer is set up for the old destination, so start a new one.
+    bool async = IsAsync();
+    SetAsync(false);
     DeleteOutStream();
     Dest = dest;
+    SetAsync(async);
 }
 
 void LogStream::SetLogTarget(const std::string &filename) {
+    bool async = IsAsync();
+    SetAsync(false);
     DeleteOutStream();
     Logfile = filename;
+    SetAsync(async);
 }
 
 void LogStream::SetLogLevel(LogType level) {
@@ -122,10 +161,17 @@ void LogStream::SetLogLevel(LogType level) {
     LogLevel = level;
 }
 
+LogStream::LogType LogStream::GetLogLevel() {
+    return LogLevel;
+}
+
 void LogStream::ClearLogFile() {
+    bool async = IsAsync();
+    SetAsync(false);
     DeleteOutStream();
     FileOut.open(Logfile.c_str(), std::ofstream::trunc);
     FileOut.close();
+    SetAsync(async);
 }
 
 void LogStream::PrintAndCheckResult(char* string, LogType output) {
@@ -215,7 +261,44 @@ void LogStream::CreateOutStream() {
     OutStream = new LogStream(console, file);
 }
 
+void LogStream::Write(LogType type, bool newline, const char *file, int line, const std::string &message) {
+    std::list<std::string> lines;
+    tokenize<std::list<std::string> >(message, "\n", lines);
+
+    if (!AsyncWriter) {
+        std::list<std::string>::iterator itr;
+        for (itr = lines.begin(); itr != lines.end(); itr++) {
+            GetLogStream(type, newline, file, line) << (*itr);
+            Flush();
+        }
+
+        return;
+    }
+
+    if (BreakOnError && type == ErrorMessage) { ASSERT(0); }
+
+    // Build the whole message here, exactly as GetLogStream would have printed it, so the
+    // writer only has to copy bytes.
+    std::string record, temp;
+    std::list<std::string>::iterator itr;
+    for (itr = lines.begin(); itr != lines.end(); itr++) {
+        if (newline) {
+            record += "\n";
+            record += ReplaceTags(Pretext, temp, file, line);
+            record.append(IndentSize * IndentLevel, ' ');
+        }
+
+        record += *itr;
+    }
+
+    AsyncWriter->write(record.data(), record.size());
+}
+
 void LogStream::Flush() {
+    if (AsyncWriter) {
+        AsyncWriter->flush();
+    }
+
     if (OutStream) {
         // Reset here as it is called after each log call.
         if(AreColorsEnabled()) {
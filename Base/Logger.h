@@ -98,6 +98,8 @@ enum { GameLogicChannel = 0x2000 };
 
 typedef int LogChannel;
 
+class AsyncLogWriter;
+
 class LogStream {
 public :
     /*! LogType enumerates the different log levels available to the system. */
@@ -175,6 +177,9 @@ public:
      * \param level The minimum level of output to actually log. */
     static void SetLogLevel(LogType level);
 
+    /*! Gets the minimum level of output currently being logged. */
+    static LogType GetLogLevel();
+
     /*! Add and remove channels to display. Only the DefaultChannel will print by default. */
     static void EnableLogChannel(LogChannel channel);
     static void DisableLogChannel(LogChannel channel);
@@ -185,6 +190,27 @@ public:
     /*! Returns whether a given channel or combination of channels is enabled. */
     static bool IsChannelEnabled(LogChannel channel);
 
+    /*! Returns every channel currently enabled, combined into one value. */
+    static LogChannel GetActiveChannels();
+
+    /*! Returns whether a message of the given level on the given channel would be logged
+     *  at all. The logging macros check this before formatting anything. */
+    static bool IsEnabled(LogType type, LogChannel channel);
+
+    /*! Turns asynchronous logging on or off. While on, messages are formatted on the
+     *  calling thread and handed to an AsyncLogWriter, which writes them out on its own
+     *  thread, so logging never waits on the console or disk. Turning it off writes out
+     *  anything still waiting. This should only be changed while nothing else is logging.
+     * \seealso AsyncLogWriter */
+    static void SetAsync(bool async);
+
+    /*! Returns true if asynchronous logging is on. */
+    static bool IsAsync();
+
+    /*! Gets the number of messages dropped by asynchronous logging because a thread was
+     *  logging faster than they could be written. */
+    static unsigned int GetDroppedCount();
+
     /*! Sets the internal variable that determines if the filenames used to substitute the
      *  %f tag should be trimmed down or not.
      * \param val The new value. */
@@ -205,7 +231,18 @@ public:
      * \return        The appropriate LogStream object with the correct state. */
     static LogStream& GetLogStream(LogType type, bool newline, const std::string &file, int line);
 
-    /*! Causes all relevant streams to be flushed. */
+    /*! Logs an already formatted message, one line at a time. This is what the logging
+     *  macros call once a message has passed IsEnabled.
+     * \param type    The level of the message.
+     * \param newline Sets whether each line starts a new line of output with the pretext
+     *                and indentation, or continues the current one.
+     * \param file    The name of the file the output is coming from.
+     * \param line    The line number the output is coming from.
+     * \param message The text to log. */
+    static void Write(LogType type, bool newline, const char *file, int line, const std::string &message);
+
+    /*! Causes all relevant streams to be flushed. When logging asynchronously, this waits
+     *  for everything logged so far to be written. */
     static void Flush();
 
     /*! Inserts a simple separator to the log file to help organize things. */
@@ -251,6 +288,7 @@ protected:
     static bool TrimFilenames;  /*!< Determines if the log should shorten filenames.    */
     static LogStream *OutStream;/*!< Outputs based on the static state at its creation. */
     static LogStream *NilStream;/*!< Outputs to nowhere at all.                         */
+    static AsyncLogWriter *AsyncWriter; /*!< Writes output when logging asynchronously. */
 
 public:
     /*! Initializes LogStream class based on the static state. */
@@ -291,18 +329,10 @@ template <typename T> LogStream& LogStream::operator<<(const T &rhs) {
 
 #define LogAtLevelWithFL(to_log, newline, level, channel, file, line) \
     do { \
-        if (LogStream::IsChannelEnabled(channel)) { \
+        if (LogStream::IsEnabled(level, channel)) { \
             std::ostringstream stream; \
             stream << to_log; \
-            std::string str_val = stream.str(); \
-             \
-            std::list<std::string> log_list; \
-            tokenize <std::list<std::string> > (str_val, "\n", log_list); \
-             \
-            std::list<std::string>::iterator itr; \
-            for(itr = log_list.begin(); itr != log_list.end(); itr++) { \
-                LogStream::GetLogStream(level, newline, file, line) << (*itr); LogStream::Flush(); \
-            } \
+            LogStream::Write(level, newline, file, line, stream.str()); \
         } \
     } while(false)
 
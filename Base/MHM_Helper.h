@@ -0,0 +1,77 @@
+/*
+ *  MHM_Helper.h
+ *  Base
+ *
+ *  Created by loch on 4/28/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _MHM_HELPER_H_
+#define _MHM_HELPER_H_
+
+// The layout of the native .mhm mesh cache. Everything is little endian. The header is
+// followed by the bone, material, and mesh tables, then the string pool, and finally
+// the vertex and index streams, each starting on an MHM_StreamAlignment boundary.
+// Offsets are always from the start of the file, except for string offsets, which are
+// from the start of the string pool. Streams are tightly packed, in exactly the layout
+// the Buffer classes expect, so they can be handed straight to the card.
+
+static const int MHM_Signature = 0x314D484D;   //!< "MHM1"
+static const int MHM_ByteOrder = 0x01020304;   //!< Reads back differently on the wrong host.
+static const unsigned short MHM_Version = 1;
+
+static const unsigned int MHM_NoString = 0xFFFFFFFF; //!< A missing string.
+static const unsigned int MHM_NoStream = 0;          //!< A missing stream.
+static const unsigned int MHM_StreamAlignment = 16;
+
+static const unsigned int MHM_LightingEnabled = 0x1; //!< Material flag.
+
+#pragma pack(1)
+struct MHM_Header {
+    int signature;               //4 bytes  (0x314D484D)
+    unsigned short version;      //2 bytes
+    unsigned short headerSize;   //2 bytes
+    int byteOrder;               //4 bytes  (0x01020304)
+    unsigned int fileSize;       //4 bytes
+    unsigned int boneCount;      //4 bytes
+    unsigned int boneOffset;     //4 bytes
+    unsigned int materialCount;  //4 bytes
+    unsigned int materialOffset; //4 bytes
+    unsigned int meshCount;      //4 bytes
+    unsigned int meshOffset;     //4 bytes
+    unsigned int stringOffset;   //4 bytes
+    unsigned int stringSize;     //4 bytes
+};
+
+struct MHM_Bone {
+    unsigned int name;           //4 bytes
+    int parent;                  //4 bytes  (-1 for roots, always less than this bone's index)
+    float transform[16];         //64 bytes
+};
+
+struct MHM_Material {
+    unsigned int name;           //4 bytes
+    unsigned int texture;        //4 bytes  (MHM_NoString if untextured)
+    float ambient[4];            //16 bytes
+    float diffuse[4];            //16 bytes
+    unsigned int flags;          //4 bytes
+};
+
+struct MHM_Mesh {
+    unsigned int name;           //4 bytes
+    int material;                //4 bytes  (-1 for none)
+    int bone;                    //4 bytes  (-1 for none)
+    float min[3];                //12 bytes
+    float max[3];                //12 bytes
+    unsigned int vertexCount;    //4 bytes
+    unsigned int indexCount;     //4 bytes
+    unsigned int indexSize;      //4 bytes  (2 or 4)
+    unsigned int positions;      //4 bytes  (3 floats per vertex)
+    unsigned int normals;        //4 bytes  (3 floats per vertex, or MHM_NoStream)
+    unsigned int texCoords;      //4 bytes  (2 floats per vertex, or MHM_NoStream)
+    unsigned int indices;        //4 bytes  (or MHM_NoStream)
+};
+#pragma pack()
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ *  MHT_Helper.h
+ *  Base
+ *
+ *  Created by loch on 5/10/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _MHT_HELPER_H_
+#define _MHT_HELPER_H_
+
+// The layout of the native .mht texture cache. Everything is little endian. The header is
+// followed by the level table, then the pixel data for each level, largest first, each
+// starting on an MHT_LevelAlignment boundary. Offsets are always from the start of the
+// file. Rows are stored bottom up, the way OpenGL expects them, and compressed levels are
+// stored as the raw S3TC blocks, so every level can be handed straight to the card.
+
+static const int MHT_Signature = 0x3154484D;   //!< "MHT1"
+static const int MHT_ByteOrder = 0x01020304;   //!< Reads back differently on the wrong host.
+static const unsigned short MHT_Version = 1;
+
+static const unsigned int MHT_LevelAlignment = 16;
+
+static const unsigned int MHT_RGBA = 1;        //!< 4 bytes per pixel, R first.
+static const unsigned int MHT_DXT1 = 2;        //!< 8 bytes per 4x4 block, no alpha.
+static const unsigned int MHT_DXT5 = 3;        //!< 16 bytes per 4x4 block.
+
+#pragma pack(1)
+struct MHT_Header {
+    int signature;               //4 bytes  (0x3154484D)
+    unsigned short version;      //2 bytes
+    unsigned short headerSize;   //2 bytes
+    int byteOrder;               //4 bytes  (0x01020304)
+    unsigned int fileSize;       //4 bytes
+    unsigned int format;         //4 bytes  (MHT_RGBA, MHT_DXT1, or MHT_DXT5)
+    unsigned int width;          //4 bytes
+    unsigned int height;         //4 bytes
+    unsigned int levelCount;     //4 bytes
+    unsigned int levelOffset;    //4 bytes
+};
+
+struct MHT_Level {
+    unsigned int width;          //4 bytes
+    unsigned int height;         //4 bytes
+    unsigned int size;           //4 bytes  (in bytes)
+    unsigned int offset;         //4 bytes
+};
+#pragma pack()
+
+#endif
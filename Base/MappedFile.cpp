@@ -0,0 +1,187 @@
+/*
+ *  MappedFile.cpp
+ *  Base
+ *
+ *  Created by loch on 4/24/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "MappedFile.h"
+#include "FileSystem.h"
+#include "Assertion.h"
+#include "Math3D.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string &fullName, OpenMode openFlags):
+_fullName(fullName), _data(NULL), _length(0), _pos(0), _open(false) {
+    if (openFlags) {
+        open(openFlags);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (isOpen()) {
+        close();
+    }
+}
+
+bool MappedFile::open(OpenMode openFlags) {
+    if (openFlags & (Write | Append)) {
+        Warn("Mapped files cannot be opened for writing: " << _fullName);
+        return false;
+    }
+
+    if (isOpen()) {
+        return true;
+    }
+
+    int fd = ::open(_fullName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        Warn("Unable to open file for mapping: " << _fullName);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        Warn("Unable to stat file for mapping: " << _fullName);
+        ::close(fd);
+        return false;
+    }
+
+    // Zero length mappings aren't allowed, but an empty file is still a valid file.
+    _length = info.st_size;
+    if (_length > 0) {
+        void *mapping = mmap(NULL, _length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            Warn("Unable to map file: " << _fullName);
+            ::close(fd);
+            _length = 0;
+            return false;
+        }
+
+        _data = (unsigned char*)mapping;
+    }
+
+    // The mapping holds its own reference to the file.
+    ::close(fd);
+
+    _pos = 0;
+    _open = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (!isOpen()) {
+        Warn("Trying to close a file that is not open: " << _fullName);
+        return;
+    }
+
+    if (_data) {
+        munmap(_data, _length);
+    }
+
+    _data = NULL;
+    _length = 0;
+    _pos = 0;
+    _open = false;
+}
+
+bool MappedFile::isOpen() {
+    return _open;
+}
+
+bool MappedFile::atEnd() {
+    return _pos >= _length;
+}
+
+long long MappedFile::position() {
+    return _pos;
+}
+
+long long MappedFile::length() {
+    return isOpen() ? _length : FileSystem::Length(_fullName);
+}
+
+long long MappedFile::bytesLeft() {
+    return _length - _pos;
+}
+
+char MappedFile::peek() {
+    return atEnd() ? 0 : _data[_pos];
+}
+
+char MappedFile::getc() {
+    return atEnd() ? 0 : _data[_pos++];
+}
+
+long long MappedFile::read(void* buffer, long long size) {
+    long long toRead = Math::Min(size, bytesLeft());
+    if (toRead <= 0) {
+        return 0;
+    }
+
+    memcpy(buffer, _data + _pos, toRead);
+    _pos += toRead;
+    return toRead;
+}
+
+long long MappedFile::write(const void* buffer, long long size) {
+    Warn("Attempted to write to a mapped file: " << _fullName);
+    return 0;
+}
+
+bool MappedFile::seek(long long offset, OffsetBase base) {
+    switch(base) {
+        case Current:   offset += _pos;    break;
+        case End:       offset += _length; break;
+        default: break;
+    }
+
+    if (offset < 0 || offset > _length) {
+        Warn("Tried to seek to " << offset << " in " << _fullName);
+        Math::Clamp(0LL, _length, offset);
+        Warn("  Seeking to " << offset << " instead");
+    }
+
+    _pos = offset;
+    return true;
+}
+
+const unsigned char* MappedFile::getData() const {
+    return _data;
+}
+
+bool MappedFile::advise(AccessPattern pattern, long long offset, long long length) {
+    if (!_data || offset < 0 || offset >= _length) {
+        return false;
+    }
+
+    if (length < 0 || offset + length > _length) {
+        length = _length - offset;
+    }
+
+    // madvise only works on whole pages, so round the start down to a page boundary.
+    long long pageSize = sysconf(_SC_PAGESIZE);
+    long long start = offset - offset % pageSize;
+    length += offset - start;
+
+    int advice = MADV_NORMAL;
+    switch (pattern) {
+        case Sequential: advice = MADV_SEQUENTIAL; break;
+        case Random:     advice = MADV_RANDOM;     break;
+        case WillNeed:   advice = MADV_WILLNEED;   break;
+        case DontNeed:   advice = MADV_DONTNEED;   break;
+        default: break;
+    }
+
+    return madvise(_data + start, length, advice) == 0;
+}
+
+const std::string& MappedFile::fullName() {
+    return _fullName;
+}
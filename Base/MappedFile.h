@@ -0,0 +1,108 @@
+/*
+ *  MappedFile.h
+ *  Base
+ *
+ *  Created by loch on 4/24/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _MAPPEDFILE_H_
+#define _MAPPEDFILE_H_
+#include "IOTarget.h"
+
+#include <string>
+
+/*! MappedFile is a read only IOTarget backed by a memory mapping of a file. Opening the
+ *  file maps the whole thing into the address space, so reads are plain memory copies out
+ *  of the page cache, and anything that can work on a pointer can skip the copy entirely
+ *  by using getData. Pages are only brought in as they are touched, and advise can be
+ *  used to tell the OS how the data is going to be used.
+ * \note The pointer returned by getData is only valid while the file is open.
+ * \brief A memory mapped, read only file.
+ * \seealso FileSystem::GetMappedFile */
+class MappedFile : public IOTarget {
+protected:
+    /*! Creates a MappedFile pointing at the given path and opens it if any open flags
+     *  are given. Only reading is supported.
+     * \param fullName The full path of the file to map.
+     * \param openFlags The mode flags to use during the open call. */
+    MappedFile(const std::string &fullName, OpenMode openFlags);
+
+    // This enforces the use of the factory methods in FileSystem.
+    friend class FileSystem;
+
+public:
+    /*! Describes how mapped data is about to be used. */
+    enum AccessPattern {
+        Normal,     /*!< No particular pattern, the OS default.           */
+        Sequential, /*!< Read once from front to back. Read ahead heavily. */
+        Random,     /*!< Read in no particular order. Don't read ahead.    */
+        WillNeed,   /*!< Needed soon. Start paging it in now.              */
+        DontNeed    /*!< Not needed any time soon. The pages may be freed. */
+    };
+
+    /*! D'tor. Unmaps the file if it is still open. */
+    virtual ~MappedFile();
+
+    /*! Maps the file into memory. Fails if write access is requested.
+     * \copydoc IOTarget::open */
+    virtual bool open(OpenMode openFlags = Read);
+
+    /*! Unmaps the file, invalidating any pointers returned by getData. */
+    virtual void close();
+
+    /*! \copydoc IOTarget::isOpen */
+    virtual bool isOpen();
+
+    /*! \copydoc IOTarget::atEnd */
+    virtual bool atEnd();
+
+    /*! \copydoc IOTarget::seek */
+    virtual bool seek(long long offset, OffsetBase base = Beginning);
+
+    /*! \copydoc IOTarget::position */
+    virtual long long position();
+
+    /*! \copydoc IOTarget::length */
+    virtual long long length();
+
+    /*! \copydoc IOTarget::bytesLeft */
+    virtual long long bytesLeft();
+
+    /*! \copydoc IOTarget::peek */
+    virtual char peek();
+
+    /*! \copydoc IOTarget::getc */
+    virtual char getc();
+
+    /*! \copydoc IOTarget::read */
+    virtual long long read(void* buffer, long long size);
+
+    /*! Mapped files are read only. Always returns 0. */
+    virtual long long write(const void* buffer, long long size);
+
+    /*! Returns a pointer to the start of the mapped file, or NULL if it isn't open. */
+    const unsigned char* getData() const;
+
+    /*! Tells the OS how the given range of the file is going to be accessed. This is only
+     *  a hint, and may be ignored.
+     * \param pattern How the range will be accessed.
+     * \param offset The start of the range.
+     * \param length The length of the range. A negative length means the rest of the file.
+     * \return true if the hint was accepted. */
+    bool advise(AccessPattern pattern, long long offset = 0, long long length = -1);
+
+    /*! Returns the full path of the file. */
+    const std::string& fullName();
+
+protected:
+    std::string _fullName;
+    unsigned char *_data; //!< The start of the mapping.
+    long long _length;    //!< The length of the mapping.
+    long long _pos;
+    bool _open;
+
+};
+
+#endif
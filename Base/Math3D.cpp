@@ -12,6 +12,7 @@
 #include <time.h>
 
 #include "Math3D.h"
+#include "FastMath.h"
 
 #include "AABB.h"
 #include "Matrix.h"
@@ -74,15 +75,29 @@ namespace Math {
     Real Radians(const Real &rhs) { return rhs * PI / 180.0f; }
     Real Degrees(const Real &rhs) { return rhs * 180.0f / PI; }
 
+#if TRIG_MODE == TRIG_TABLE
+    Real Sin(const Radian &rhs) { return FastMath::TableSin(rhs.valueRadians()); }
+    Real Cos(const Radian &rhs) { return FastMath::TableCos(rhs.valueRadians()); }
+    void SinCos(const Radian &rhs, Real &s, Real &c) { FastMath::TableSinCos(rhs.valueRadians(), s, c); }
+    Radian Atan2(const Real &one, const Real &two) { return Radian(FastMath::TableAtan2(one, two)); }
+#elif TRIG_MODE == TRIG_POLYNOMIAL
+    Real Sin(const Radian &rhs) { return FastMath::PolySin(rhs.valueRadians()); }
+    Real Cos(const Radian &rhs) { return FastMath::PolyCos(rhs.valueRadians()); }
+    void SinCos(const Radian &rhs, Real &s, Real &c) { FastMath::PolySinCos(rhs.valueRadians(), s, c); }
+    Radian Atan2(const Real &one, const Real &two) { return Radian(FastMath::PolyAtan2(one, two)); }
+#else
     Real Sin(const Radian &rhs) { return sin(rhs.valueRadians()); }
     Real Cos(const Radian &rhs) { return cos(rhs.valueRadians()); }
-    Real Tan(const Radian &rhs) { return tan(rhs.valueRadians()); }
-    Real Cot(const Radian &rhs) { return 1.0 / Tan(rhs); }
+    void SinCos(const Radian &rhs, Real &s, Real &c) { s = Sin(rhs); c = Cos(rhs); }
+    Radian Atan2(const Real &one, const Real &two) { return Radian(atan2(one, two)); }
+#endif
+
+    Real Tan(const Radian &rhs) { Real s, c; SinCos(rhs, s, c); return s / c; }
+    Real Cot(const Radian &rhs) { Real s, c; SinCos(rhs, s, c); return c / s; }
 
     Radian Acos(const Real &rhs) { return Radian(acos(rhs)); }
     Radian Asin(const Real &rhs) { return Radian(asin(rhs)); }
     Radian Atan(const Real &rhs) { return Radian(atan(rhs)); }
-    Radian Atan2(const Real &one, const Real &two) { return Radian(atan2(one, two)); }
 
     int IAbs(int rhs) { return abs(rhs); }
     int ICeil(const Real &rhs) { return static_cast<int>(ceil(rhs)); }
@@ -45,8 +45,10 @@ namespace Math {
     Real Radians(const Real &degrees);
     Real Degrees(const Real &radians);
 
+    // These use the implementation picked by TRIG_MODE. See FastMath.h.
     Real Sin(const Radian &rhs);
     Real Cos(const Radian &rhs);
+    void SinCos(const Radian &rhs, Real &sine, Real &cosine);
     Real Tan(const Radian &rhs);
     Real Cot(const Radian &rhs);
 
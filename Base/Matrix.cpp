@@ -3,6 +3,370 @@
 #include "Vector.h"
 #include "Quaternion.h"
 
+#if SYS_SSE
+#include <xmmintrin.h>
+#if SYS_AVX
+#include <immintrin.h>
+#endif
+#elif SYS_NEON
+#include <arm_neon.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Kernels
+//////////////////////////////////////////////////////////////////////////////////////////
+// Everything here works on column major arrays, laid out exactly like m_mat. Matrices are
+// kept in vectors and structs with no particular alignment, so only unaligned loads and
+// stores are used. Unless noted, the result may be the same array as any of the inputs.
+
+#if SYS_SSE
+// Builds a vector from the given lanes of v, e.g. Shuffle(v, 1, 2, 0, 3) is (y, z, x, w).
+#define Shuffle(v, a, b, c, d) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(d, c, b, a))
+
+static inline __m128 Splat(__m128 v, int lane) {
+    switch (lane) {
+        case 0:  return Shuffle(v, 0, 0, 0, 0);
+        case 1:  return Shuffle(v, 1, 1, 1, 1);
+        case 2:  return Shuffle(v, 2, 2, 2, 2);
+        default: return Shuffle(v, 3, 3, 3, 3);
+    }
+}
+
+// The w lane of the result is 0 as long as the inputs' w lanes are equal.
+static inline __m128 Cross(__m128 a, __m128 b) {
+    return _mm_sub_ps(
+        _mm_mul_ps(Shuffle(a, 1, 2, 0, 3), Shuffle(b, 2, 0, 1, 3)),
+        _mm_mul_ps(Shuffle(a, 2, 0, 1, 3), Shuffle(b, 1, 2, 0, 3)));
+}
+
+// Returns the sum of every lane, in every lane.
+static inline __m128 HorizontalSum(__m128 v) {
+    v = _mm_add_ps(v, Shuffle(v, 2, 3, 0, 1));
+    return _mm_add_ps(v, Shuffle(v, 1, 0, 3, 2));
+}
+
+// Transforms (x, y, z, w) by the matrix with the given columns.
+static inline __m128 Transform(__m128 c0, __m128 c1, __m128 c2, __m128 c3,
+                               __m128 x, __m128 y, __m128 z, __m128 w) {
+    return _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(c0, x), _mm_mul_ps(c1, y)),
+        _mm_add_ps(_mm_mul_ps(c2, z), _mm_mul_ps(c3, w)));
+}
+
+// Writes the first three lanes, without touching whatever follows them.
+static inline void Store3(Real *result, __m128 v) {
+    _mm_storel_pi((__m64*)result, v);
+    _mm_store_ss(result + 2, _mm_movehl_ps(v, v));
+}
+#elif SYS_NEON
+static inline float32x4_t Transform(float32x4_t c0, float32x4_t c1, float32x4_t c2, float32x4_t c3,
+                                    Real x, Real y, Real z, Real w) {
+    float32x4_t result = vmulq_n_f32(c0, x);
+    result = vmlaq_n_f32(result, c1, y);
+    result = vmlaq_n_f32(result, c2, z);
+    return vmlaq_n_f32(result, c3, w);
+}
+
+static inline void Store3(Real *result, float32x4_t v) {
+    vst1_f32(result, vget_low_f32(v));
+    vst1q_lane_f32(result + 2, v, 2);
+}
+#endif
+
+/*! Multiplies a * b. */
+static inline void Multiply4x4(const Real *a, const Real *b, Real *result) {
+#if SYS_AVX
+    // Two columns of the result at a time. Each half of the 256 bit registers holds a
+    // copy of one of a's columns, multiplied by the matching element of one of b's.
+    __m128 a0 = _mm_loadu_ps(a), a1 = _mm_loadu_ps(a + 4);
+    __m128 a2 = _mm_loadu_ps(a + 8), a3 = _mm_loadu_ps(a + 12);
+    __m256 aa0 = _mm256_insertf128_ps(_mm256_castps128_ps256(a0), a0, 1);
+    __m256 aa1 = _mm256_insertf128_ps(_mm256_castps128_ps256(a1), a1, 1);
+    __m256 aa2 = _mm256_insertf128_ps(_mm256_castps128_ps256(a2), a2, 1);
+    __m256 aa3 = _mm256_insertf128_ps(_mm256_castps128_ps256(a3), a3, 1);
+    __m256 b01 = _mm256_loadu_ps(b), b23 = _mm256_loadu_ps(b + 8);
+
+    __m256 r01 = _mm256_add_ps(
+        _mm256_add_ps(_mm256_mul_ps(aa0, _mm256_permute_ps(b01, 0x00)), _mm256_mul_ps(aa1, _mm256_permute_ps(b01, 0x55))),
+        _mm256_add_ps(_mm256_mul_ps(aa2, _mm256_permute_ps(b01, 0xAA)), _mm256_mul_ps(aa3, _mm256_permute_ps(b01, 0xFF))));
+    __m256 r23 = _mm256_add_ps(
+        _mm256_add_ps(_mm256_mul_ps(aa0, _mm256_permute_ps(b23, 0x00)), _mm256_mul_ps(aa1, _mm256_permute_ps(b23, 0x55))),
+        _mm256_add_ps(_mm256_mul_ps(aa2, _mm256_permute_ps(b23, 0xAA)), _mm256_mul_ps(aa3, _mm256_permute_ps(b23, 0xFF))));
+
+    _mm256_storeu_ps(result, r01);
+    _mm256_storeu_ps(result + 8, r23);
+#elif SYS_SSE
+    __m128 a0 = _mm_loadu_ps(a), a1 = _mm_loadu_ps(a + 4);
+    __m128 a2 = _mm_loadu_ps(a + 8), a3 = _mm_loadu_ps(a + 12);
+    __m128 b0 = _mm_loadu_ps(b), b1 = _mm_loadu_ps(b + 4);
+    __m128 b2 = _mm_loadu_ps(b + 8), b3 = _mm_loadu_ps(b + 12);
+
+    _mm_storeu_ps(result,      Transform(a0, a1, a2, a3, Splat(b0, 0), Splat(b0, 1), Splat(b0, 2), Splat(b0, 3)));
+    _mm_storeu_ps(result + 4,  Transform(a0, a1, a2, a3, Splat(b1, 0), Splat(b1, 1), Splat(b1, 2), Splat(b1, 3)));
+    _mm_storeu_ps(result + 8,  Transform(a0, a1, a2, a3, Splat(b2, 0), Splat(b2, 1), Splat(b2, 2), Splat(b2, 3)));
+    _mm_storeu_ps(result + 12, Transform(a0, a1, a2, a3, Splat(b3, 0), Splat(b3, 1), Splat(b3, 2), Splat(b3, 3)));
+#elif SYS_NEON
+    float32x4_t a0 = vld1q_f32(a), a1 = vld1q_f32(a + 4);
+    float32x4_t a2 = vld1q_f32(a + 8), a3 = vld1q_f32(a + 12);
+    Real columns[16];
+    memcpy(columns, b, sizeof(columns));
+
+    for (int i = 0; i < 16; i += 4) {
+        vst1q_f32(result + i, Transform(a0, a1, a2, a3,
+            columns[i], columns[i + 1], columns[i + 2], columns[i + 3]));
+    }
+#else
+    const Real *m1 = a, *m2 = b;
+    Real newMatrix[16];
+    newMatrix[ 0] = m1[0] * m2[ 0] + m1[4] * m2[ 1] + m1[ 8] * m2[ 2] + m1[12] * m2[ 3];
+    newMatrix[ 4] = m1[0] * m2[ 4] + m1[4] * m2[ 5] + m1[ 8] * m2[ 6] + m1[12] * m2[ 7];
+    newMatrix[ 8] = m1[0] * m2[ 8] + m1[4] * m2[ 9] + m1[ 8] * m2[10] + m1[12] * m2[11];
+    newMatrix[12] = m1[0] * m2[12] + m1[4] * m2[13] + m1[ 8] * m2[14] + m1[12] * m2[15];
+    
+    newMatrix[ 1] = m1[1] * m2[ 0] + m1[5] * m2[ 1] + m1[ 9] * m2[2 ] + m1[13] * m2[ 3];
+    newMatrix[ 5] = m1[1] * m2[ 4] + m1[5] * m2[ 5] + m1[ 9] * m2[6 ] + m1[13] * m2[ 7];
+    newMatrix[ 9] = m1[1] * m2[ 8] + m1[5] * m2[ 9] + m1[ 9] * m2[10] + m1[13] * m2[11];
+    newMatrix[13] = m1[1] * m2[12] + m1[5] * m2[13] + m1[ 9] * m2[14] + m1[13] * m2[15];
+
+    newMatrix[ 2] = m1[2] * m2[ 0] + m1[6] * m2[ 1] + m1[10] * m2[2 ] + m1[14] * m2[ 3];
+    newMatrix[ 6] = m1[2] * m2[ 4] + m1[6] * m2[ 5] + m1[10] * m2[6 ] + m1[14] * m2[ 7];
+    newMatrix[10] = m1[2] * m2[ 8] + m1[6] * m2[ 9] + m1[10] * m2[10] + m1[14] * m2[11];
+    newMatrix[14] = m1[2] * m2[12] + m1[6] * m2[13] + m1[10] * m2[14] + m1[14] * m2[15];
+
+    newMatrix[ 3] = m1[3] * m2[ 0] + m1[7] * m2[ 1] + m1[11] * m2[2 ] + m1[15] * m2[ 3];
+    newMatrix[ 7] = m1[3] * m2[ 4] + m1[7] * m2[ 5] + m1[11] * m2[6 ] + m1[15] * m2[ 7];
+    newMatrix[11] = m1[3] * m2[ 8] + m1[7] * m2[ 9] + m1[11] * m2[10] + m1[15] * m2[11];
+    newMatrix[15] = m1[3] * m2[12] + m1[7] * m2[13] + m1[11] * m2[14] + m1[15] * m2[15];
+    memcpy(result, newMatrix, sizeof(newMatrix));
+#endif
+}
+
+/*! Multiplies m * (x, y, z, w). */
+static inline void Transform4(const Real *m, Real x, Real y, Real z, Real w, Real *result) {
+#if SYS_SSE
+    _mm_storeu_ps(result, Transform(
+        _mm_loadu_ps(m), _mm_loadu_ps(m + 4), _mm_loadu_ps(m + 8), _mm_loadu_ps(m + 12),
+        _mm_set1_ps(x), _mm_set1_ps(y), _mm_set1_ps(z), _mm_set1_ps(w)));
+#elif SYS_NEON
+    vst1q_f32(result, Transform(
+        vld1q_f32(m), vld1q_f32(m + 4), vld1q_f32(m + 8), vld1q_f32(m + 12), x, y, z, w));
+#else
+    Real nVec[4];
+    nVec[0] = x * m[0] + y * m[4] + z * m[8]  + w * m[12];
+    nVec[1] = x * m[1] + y * m[5] + z * m[9]  + w * m[13];
+    nVec[2] = x * m[2] + y * m[6] + z * m[10] + w * m[14];
+    nVec[3] = x * m[3] + y * m[7] + z * m[11] + w * m[15];
+    memcpy(result, nVec, sizeof(nVec));
+#endif
+}
+
+/*! Inverts a matrix whose bottom row is (0, 0, 0, 1). The inverse of the upper 3x3 is its
+ *  adjugate over its determinant, and the rows of the adjugate are just the cross
+ *  products of its columns. The translation is then undone by the inverted 3x3. */
+static inline void InverseAffine4x4(const Real *m, Real *result) {
+#if SYS_SSE
+    __m128 c0 = _mm_loadu_ps(m), c1 = _mm_loadu_ps(m + 4);
+    __m128 c2 = _mm_loadu_ps(m + 8), t = _mm_loadu_ps(m + 12);
+
+    __m128 r0 = Cross(c1, c2), r1 = Cross(c2, c0), r2 = Cross(c0, c1), r3 = _mm_setzero_ps();
+    __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), HorizontalSum(_mm_mul_ps(c0, r0)));
+    r0 = _mm_mul_ps(r0, invDet);
+    r1 = _mm_mul_ps(r1, invDet);
+    r2 = _mm_mul_ps(r2, invDet);
+
+    // The rows become columns, and the w lanes are all 0.
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    __m128 translation = _mm_sub_ps(_mm_setr_ps(0, 0, 0, 1),
+        Transform(r0, r1, r2, r3, Splat(t, 0), Splat(t, 1), Splat(t, 2), _mm_setzero_ps()));
+
+    _mm_storeu_ps(result, r0);
+    _mm_storeu_ps(result + 4, r1);
+    _mm_storeu_ps(result + 8, r2);
+    _mm_storeu_ps(result + 12, translation);
+#else
+    Real r[3][3];
+    r[0][0] = m[5] * m[10] - m[6] * m[9];
+    r[0][1] = m[6] * m[8]  - m[4] * m[10];
+    r[0][2] = m[4] * m[9]  - m[5] * m[8];
+    r[1][0] = m[9] * m[2]  - m[10] * m[1];
+    r[1][1] = m[10] * m[0] - m[8] * m[2];
+    r[1][2] = m[8] * m[1]  - m[9] * m[0];
+    r[2][0] = m[1] * m[6]  - m[2] * m[5];
+    r[2][1] = m[2] * m[4]  - m[0] * m[6];
+    r[2][2] = m[0] * m[5]  - m[1] * m[4];
+
+    Real invDet = 1 / (m[0] * r[0][0] + m[1] * r[0][1] + m[2] * r[0][2]);
+    Real inverse[16];
+    for (int row = 0; row < 3; row++) {
+        for (int col = 0; col < 3; col++) {
+            inverse[col * 4 + row] = r[row][col] * invDet;
+        }
+
+        inverse[row * 4 + 3] = 0;
+    }
+
+    for (int row = 0; row < 3; row++) {
+        inverse[12 + row] = -(inverse[row] * m[12] + inverse[4 + row] * m[13] + inverse[8 + row] * m[14]);
+    }
+
+    inverse[15] = 1;
+    memcpy(result, inverse, sizeof(inverse));
+#endif
+}
+
+/*! Builds the rotation matrix for the quaternion (w, x, y, z). Each element of the upper
+ *  3x3 is a constant plus two products of the quaternion's components, so each column is
+ *  built from a pair of shuffled products. */
+static inline void QuaternionToMatrix(const Real *q, Real *result) {
+#if SYS_SSE
+    __m128 v = _mm_loadu_ps(q);
+    __m128 v2 = _mm_add_ps(v, v);
+
+    // Lanes of v are (w, x, y, z). The w lanes of the signs zero out the w lanes below.
+    __m128 c0 = _mm_add_ps(_mm_setr_ps(1, 0, 0, 0), _mm_add_ps(
+        _mm_mul_ps(_mm_mul_ps(Shuffle(v2, 2, 1, 1, 0), _mm_setr_ps(-1, 1, 1, 0)), Shuffle(v, 2, 2, 3, 0)),
+        _mm_mul_ps(_mm_mul_ps(Shuffle(v2, 3, 0, 0, 0), _mm_setr_ps(-1, 1, -1, 0)), Shuffle(v, 3, 3, 2, 0))));
+    __m128 c1 = _mm_add_ps(_mm_setr_ps(0, 1, 0, 0), _mm_add_ps(
+        _mm_mul_ps(_mm_mul_ps(Shuffle(v2, 2, 1, 2, 0), _mm_setr_ps(1, -1, 1, 0)), Shuffle(v, 1, 1, 3, 0)),
+        _mm_mul_ps(_mm_mul_ps(Shuffle(v2, 0, 3, 0, 0), _mm_setr_ps(-1, -1, 1, 0)), Shuffle(v, 3, 3, 1, 0))));
+    __m128 c2 = _mm_add_ps(_mm_setr_ps(0, 0, 1, 0), _mm_add_ps(
+        _mm_mul_ps(_mm_mul_ps(Shuffle(v2, 3, 3, 1, 0), _mm_setr_ps(1, 1, -1, 0)), Shuffle(v, 1, 2, 1, 0)),
+        _mm_mul_ps(_mm_mul_ps(Shuffle(v2, 0, 0, 2, 0), _mm_setr_ps(1, -1, -1, 0)), Shuffle(v, 2, 1, 2, 0))));
+
+    _mm_storeu_ps(result, c0);
+    _mm_storeu_ps(result + 4, c1);
+    _mm_storeu_ps(result + 8, c2);
+    _mm_storeu_ps(result + 12, _mm_setr_ps(0, 0, 0, 1));
+#else
+    Real ww = 2.0 * q[0];
+    Real xx = 2.0 * q[1];
+    Real yy = 2.0 * q[2];
+    Real zz = 2.0 * q[3];
+
+    memset(result, 0, sizeof(Real) * 16);
+    result[0] = 1.0 - (yy * q[2]) - (zz * q[3]);
+    result[1] = (xx * q[2]) + (ww * q[3]);
+    result[2] = (xx * q[3]) - (ww * q[2]);
+
+    result[4] = (xx * q[2]) - (ww * q[3]);
+    result[5] = 1.0 - (xx * q[1]) - (zz * q[3]);
+    result[6] = (yy * q[3]) + (ww * q[1]);
+
+    result[8] = (xx * q[3]) + (ww * q[2]);
+    result[9] = (yy * q[3]) - (ww * q[1]);
+    result[10] = 1.0 - (xx * q[1]) - (yy * q[2]);
+    result[15] = 1;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Batch operations
+//////////////////////////////////////////////////////////////////////////////////////////
+void Matrix::Multiply(const Matrix &lhs, const Matrix *rhs, Matrix *results, unsigned int count) {
+#if SYS_SSE && !SYS_AVX
+    // Keep the shared matrix in registers for the whole batch.
+    __m128 a0 = _mm_loadu_ps(lhs.m_mat), a1 = _mm_loadu_ps(lhs.m_mat + 4);
+    __m128 a2 = _mm_loadu_ps(lhs.m_mat + 8), a3 = _mm_loadu_ps(lhs.m_mat + 12);
+    for (unsigned int i = 0; i < count; i++) {
+        const Real *b = rhs[i].m_mat;
+        __m128 b0 = _mm_loadu_ps(b), b1 = _mm_loadu_ps(b + 4);
+        __m128 b2 = _mm_loadu_ps(b + 8), b3 = _mm_loadu_ps(b + 12);
+        Real *result = results[i].m_mat;
+        _mm_storeu_ps(result,      Transform(a0, a1, a2, a3, Splat(b0, 0), Splat(b0, 1), Splat(b0, 2), Splat(b0, 3)));
+        _mm_storeu_ps(result + 4,  Transform(a0, a1, a2, a3, Splat(b1, 0), Splat(b1, 1), Splat(b1, 2), Splat(b1, 3)));
+        _mm_storeu_ps(result + 8,  Transform(a0, a1, a2, a3, Splat(b2, 0), Splat(b2, 1), Splat(b2, 2), Splat(b2, 3)));
+        _mm_storeu_ps(result + 12, Transform(a0, a1, a2, a3, Splat(b3, 0), Splat(b3, 1), Splat(b3, 2), Splat(b3, 3)));
+    }
+#else
+    // Copy the shared matrix, in case it's also one of the results.
+    Matrix shared(lhs.m_mat);
+    for (unsigned int i = 0; i < count; i++) {
+        Multiply4x4(shared.m_mat, rhs[i].m_mat, results[i].m_mat);
+    }
+#endif
+}
+
+void Matrix::Multiply(const Matrix *lhs, const Matrix *rhs, Matrix *results, unsigned int count) {
+    for (unsigned int i = 0; i < count; i++) {
+        Multiply4x4(lhs[i].m_mat, rhs[i].m_mat, results[i].m_mat);
+    }
+}
+
+void Matrix::TransformPoints(const Matrix &matrix, const Vector3 *points, Vector3 *results, unsigned int count) {
+    bool affine = matrix.isAffine();
+#if SYS_SSE
+    __m128 c0 = _mm_loadu_ps(matrix.m_mat), c1 = _mm_loadu_ps(matrix.m_mat + 4);
+    __m128 c2 = _mm_loadu_ps(matrix.m_mat + 8), c3 = _mm_loadu_ps(matrix.m_mat + 12);
+    for (unsigned int i = 0; i < count; i++) {
+        const Vector3 &p = points[i];
+        __m128 r = Transform(c0, c1, c2, c3,
+            _mm_set1_ps(p[0]), _mm_set1_ps(p[1]), _mm_set1_ps(p[2]), _mm_set1_ps(1.0f));
+        if (!affine) { r = _mm_div_ps(r, Splat(r, 3)); }
+        Store3(&results[i][0], r);
+    }
+#elif SYS_NEON
+    float32x4_t c0 = vld1q_f32(matrix.m_mat), c1 = vld1q_f32(matrix.m_mat + 4);
+    float32x4_t c2 = vld1q_f32(matrix.m_mat + 8), c3 = vld1q_f32(matrix.m_mat + 12);
+    for (unsigned int i = 0; i < count; i++) {
+        const Vector3 &p = points[i];
+        float32x4_t r = Transform(c0, c1, c2, c3, p[0], p[1], p[2], 1.0f);
+        if (!affine) { r = vmulq_n_f32(r, 1.0f / vgetq_lane_f32(r, 3)); }
+        Store3(&results[i][0], r);
+    }
+#else
+    Matrix shared(matrix.m_mat);
+    for (unsigned int i = 0; i < count; i++) {
+        results[i] = shared * points[i];
+    }
+#endif
+}
+
+void Matrix::TransformBounds(const Matrix &matrix, const AABB3 *bounds, AABB3 *results, unsigned int count) {
+    ASSERT(matrix.isAffine());
+
+    // The new radius along each axis is the sum of how far each of the old radii reach
+    // along it, once rotated. Scaling and translating the center works as normal.
+#if SYS_SSE
+    __m128 zero = _mm_setzero_ps();
+    __m128 c0 = _mm_loadu_ps(matrix.m_mat), c1 = _mm_loadu_ps(matrix.m_mat + 4);
+    __m128 c2 = _mm_loadu_ps(matrix.m_mat + 8), c3 = _mm_loadu_ps(matrix.m_mat + 12);
+    __m128 a0 = _mm_max_ps(c0, _mm_sub_ps(zero, c0));
+    __m128 a1 = _mm_max_ps(c1, _mm_sub_ps(zero, c1));
+    __m128 a2 = _mm_max_ps(c2, _mm_sub_ps(zero, c2));
+    Real center[4], radius[4];
+    for (unsigned int i = 0; i < count; i++) {
+        const Vector3 &c = bounds[i].getCenter(), &r = bounds[i].getRadius();
+        _mm_storeu_ps(center, Transform(c0, c1, c2, c3,
+            _mm_set1_ps(c[0]), _mm_set1_ps(c[1]), _mm_set1_ps(c[2]), _mm_set1_ps(1.0f)));
+        _mm_storeu_ps(radius, Transform(a0, a1, a2, zero,
+            _mm_set1_ps(r[0]), _mm_set1_ps(r[1]), _mm_set1_ps(r[2]), zero));
+        results[i] = AABB3(Vector3(center), Vector3(radius));
+    }
+#elif SYS_NEON
+    float32x4_t c0 = vld1q_f32(matrix.m_mat), c1 = vld1q_f32(matrix.m_mat + 4);
+    float32x4_t c2 = vld1q_f32(matrix.m_mat + 8), c3 = vld1q_f32(matrix.m_mat + 12);
+    float32x4_t a0 = vabsq_f32(c0), a1 = vabsq_f32(c1), a2 = vabsq_f32(c2), zero = vdupq_n_f32(0);
+    Real center[4], radius[4];
+    for (unsigned int i = 0; i < count; i++) {
+        const Vector3 &c = bounds[i].getCenter(), &r = bounds[i].getRadius();
+        vst1q_f32(center, Transform(c0, c1, c2, c3, c[0], c[1], c[2], 1.0f));
+        vst1q_f32(radius, Transform(a0, a1, a2, zero, r[0], r[1], r[2], 0.0f));
+        results[i] = AABB3(Vector3(center), Vector3(radius));
+    }
+#else
+    const Real *m = matrix.m_mat;
+    for (unsigned int i = 0; i < count; i++) {
+        Vector3 c = bounds[i].getCenter(), r = bounds[i].getRadius(), radius;
+        for (int axis = 0; axis < 3; axis++) {
+            radius[axis] =
+                Math::Abs(m[axis]) * r[0] + Math::Abs(m[4 + axis]) * r[1] + Math::Abs(m[8 + axis]) * r[2];
+        }
+
+        results[i] = AABB3(matrix * c, radius);
+    }
+#endif
+}
+
 Matrix Matrix::FromEuler(const Radian &pitch, const Radian &yaw, const Radian &roll) {
     Matrix m;
     m.fromEuler(pitch, yaw, roll);
@@ -95,23 +459,7 @@ Matrix Matrix::CenterOrtho(Real width, Real height, const Vector2 &center, Real
 Matrix::Matrix() { loadIdentity(); } ///\todo Don't load the identity by default for speed reasons.
 
 Matrix::Matrix(const Quaternion &q) {
-        Real ww = 2.0 * q[0];
-    Real xx = 2.0 * q[1];
-    Real yy = 2.0 * q[2];
-    Real zz = 2.0 * q[3];
-    
-    loadIdentity();    
-    m_mat[0] = 1.0 - (yy * q[2]) - (zz * q[3]);
-    m_mat[1] = (xx * q[2]) + (ww * q[3]);
-    m_mat[2] = (xx * q[3]) - (ww * q[2]);
-    
-    m_mat[4] = (xx * q[2]) - (ww * q[3]);
-    m_mat[5] = 1.0 - (xx * q[1]) - (zz * q[3]);
-    m_mat[6] = (yy * q[3]) + (ww * q[1]);
-    
-    m_mat[8] = (xx * q[3]) + (ww * q[2]);
-    m_mat[9] = (yy * q[3]) - (ww * q[1]);
-    m_mat[10] = 1.0 - (xx * q[1]) - (yy * q[2]);
+    QuaternionToMatrix(&q[0], m_mat);
 }
 
 Matrix::Matrix(const Real *oldMatrix) { set(oldMatrix); }
@@ -216,12 +564,10 @@ void Matrix::fromAxisAngle(const Radian &rad, const Real &x, const Real &y, cons
 //////////////////////////////////////////////////////////////////////////////////////////
 void Matrix::fromEuler(const Radian &pitch, const Radian &yaw, const Radian &roll) {
     loadIdentity();
-    Real sx = Math::Sin(pitch);
-    Real cx = Math::Cos(pitch);
-    Real sy = Math::Sin(yaw);
-    Real cy = Math::Cos(yaw);
-    Real sz = Math::Sin(roll);
-    Real cz = Math::Cos(roll);
+    Real sx, cx, sy, cy, sz, cz;
+    Math::SinCos(pitch, sx, cx);
+    Math::SinCos(yaw, sy, cy);
+    Math::SinCos(roll, sz, cz);
 
     m_mat[0]  = cy * cz;
     m_mat[1]  = sz * cy;
@@ -253,25 +599,17 @@ void Matrix::toEuler(Radian &pitch, Radian &yaw, Radian &roll) const {
 #pragma mark Vector Application
 //////////////////////////////////////////////////////////////////////////////////////////
 void Matrix::apply(Vector3 &vec) const {
-    Real invW = 1.0f / (vec[0] * m_mat[3] + vec[1] * m_mat[7] + vec[2] * m_mat[11] + m_mat[15]);
-
-    Real nVec[3];
-    nVec[0] = (vec[0] * m_mat[0] + vec[1] * m_mat[4] + vec[2] * m_mat[8]  + m_mat[12]) * invW;
-    nVec[1] = (vec[0] * m_mat[1] + vec[1] * m_mat[5] + vec[2] * m_mat[9]  + m_mat[13]) * invW;
-    nVec[2] = (vec[0] * m_mat[2] + vec[1] * m_mat[6] + vec[2] * m_mat[10] + m_mat[14]) * invW;
+    Real nVec[4];
+    Transform4(m_mat, vec[0], vec[1], vec[2], 1, nVec);
 
-    memcpy(&vec, &nVec, sizeof(Vector3));
+    Real invW = 1.0f / nVec[3];
+    vec[0] = nVec[0] * invW;
+    vec[1] = nVec[1] * invW;
+    vec[2] = nVec[2] * invW;
 }
 
 void Matrix::apply(Vector4 &vec) const {
-    Real nVec[4];
-    nVec[0] = (vec[0] * m_mat[0] + vec[1] * m_mat[4] + vec[2] * m_mat[8]  + vec[3] * m_mat[12]);
-    nVec[1] = (vec[0] * m_mat[1] + vec[1] * m_mat[5] + vec[2] * m_mat[9]  + vec[3] * m_mat[13]);
-    nVec[2] = (vec[0] * m_mat[2] + vec[1] * m_mat[6] + vec[2] * m_mat[10] + vec[3] * m_mat[14]);
-    nVec[3] = (vec[0] * m_mat[3] + vec[1] * m_mat[7] + vec[2] * m_mat[11] + vec[3] * m_mat[15]);
-
-    memcpy(&vec, &nVec, sizeof(Vector4));
-
+    Transform4(m_mat, vec[0], vec[1], vec[2], vec[3], &vec[0]);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -390,8 +728,8 @@ void Matrix::setRotation(Radian radians, Real x, Real y, Real z) {
         z /= len;
     }
 
-    Real cTheta = Math::Cos(radians);
-    Real sTheta = Math::Sin(radians);
+    Real sTheta, cTheta;
+    Math::SinCos(radians, sTheta, cTheta);
     Real invTheta = 1 - cTheta;
     
     m_mat[ 0] = x * x * invTheta + cTheta    ;
@@ -409,7 +747,22 @@ Vector3 Matrix::getTranslation() const {
     return Vector3(m_mat[12], m_mat[13], m_mat[14]);
 }
 
+bool Matrix::isAffine() const {
+    return m_mat[3] == 0 && m_mat[7] == 0 && m_mat[11] == 0 && m_mat[15] == 1;
+}
+
+Matrix Matrix::getAffineInverse() const {
+    Matrix result(Uninitialized);
+    InverseAffine4x4(m_mat, result.m_mat);
+    return result;
+}
+
 Matrix Matrix::getInverse() const {
+    // Nearly everything is an affine transformation, which has a much cheaper inverse.
+    if (isAffine()) {
+        return getAffineInverse();
+    }
+
     Real m0 = m_mat[0], m4 = m_mat[4], m8  = m_mat[ 8], m12 = m_mat[12];
     Real m1 = m_mat[1], m5 = m_mat[5], m9  = m_mat[ 9], m13 = m_mat[13];
     Real m2 = m_mat[2], m6 = m_mat[6], m10 = m_mat[10], m14 = m_mat[14];
@@ -474,43 +827,17 @@ Matrix Matrix::getInverse() const {
 //////////////////////////////////////////////////////////////////////////////////////////
 #pragma mark Operators
 //////////////////////////////////////////////////////////////////////////////////////////
-void Matrix::multiply(const Real* m1, const Real* m2, Real newMatrix[16]) {
-    newMatrix[ 0] = m1[0] * m2[ 0] + m1[4] * m2[ 1] + m1[ 8] * m2[ 2] + m1[12] * m2[ 3];
-    newMatrix[ 4] = m1[0] * m2[ 4] + m1[4] * m2[ 5] + m1[ 8] * m2[ 6] + m1[12] * m2[ 7];
-    newMatrix[ 8] = m1[0] * m2[ 8] + m1[4] * m2[ 9] + m1[ 8] * m2[10] + m1[12] * m2[11];
-    newMatrix[12] = m1[0] * m2[12] + m1[4] * m2[13] + m1[ 8] * m2[14] + m1[12] * m2[15];
-    
-    newMatrix[ 1] = m1[1] * m2[ 0] + m1[5] * m2[ 1] + m1[ 9] * m2[2 ] + m1[13] * m2[ 3];
-    newMatrix[ 5] = m1[1] * m2[ 4] + m1[5] * m2[ 5] + m1[ 9] * m2[6 ] + m1[13] * m2[ 7];
-    newMatrix[ 9] = m1[1] * m2[ 8] + m1[5] * m2[ 9] + m1[ 9] * m2[10] + m1[13] * m2[11];
-    newMatrix[13] = m1[1] * m2[12] + m1[5] * m2[13] + m1[ 9] * m2[14] + m1[13] * m2[15];
-
-    newMatrix[ 2] = m1[2] * m2[ 0] + m1[6] * m2[ 1] + m1[10] * m2[2 ] + m1[14] * m2[ 3];
-    newMatrix[ 6] = m1[2] * m2[ 4] + m1[6] * m2[ 5] + m1[10] * m2[6 ] + m1[14] * m2[ 7];
-    newMatrix[10] = m1[2] * m2[ 8] + m1[6] * m2[ 9] + m1[10] * m2[10] + m1[14] * m2[11];
-    newMatrix[14] = m1[2] * m2[12] + m1[6] * m2[13] + m1[10] * m2[14] + m1[14] * m2[15];
-
-    newMatrix[ 3] = m1[3] * m2[ 0] + m1[7] * m2[ 1] + m1[11] * m2[2 ] + m1[15] * m2[ 3];
-    newMatrix[ 7] = m1[3] * m2[ 4] + m1[7] * m2[ 5] + m1[11] * m2[6 ] + m1[15] * m2[ 7];
-    newMatrix[11] = m1[3] * m2[ 8] + m1[7] * m2[ 9] + m1[11] * m2[10] + m1[15] * m2[11];
-    newMatrix[15] = m1[3] * m2[12] + m1[7] * m2[13] + m1[11] * m2[14] + m1[15] * m2[15];
-}
-
 void Matrix::postMultiply(const Matrix &matrix) {
-    Real newMatrix[16];
-    multiply(m_mat, matrix.m_mat, newMatrix);
-    set(newMatrix);
+    Multiply4x4(m_mat, matrix.m_mat, m_mat);
 }
 
 void Matrix::preMultiply(const Matrix &matrix) {
-    Real newMatrix[16];
-    multiply(matrix.m_mat, m_mat, newMatrix);
-    set(newMatrix);
+    Multiply4x4(matrix.m_mat, m_mat, m_mat);
 }
 
 Matrix Matrix::operator*(const Matrix &lhs) const {
-    Matrix result(m_mat);
-    result.postMultiply(lhs);
+    Matrix result(Uninitialized);
+    Multiply4x4(m_mat, lhs.m_mat, result.m_mat);
     return result;
 }
 
@@ -2,6 +2,7 @@
 #define _MATRIX_H
 
 #include "Vector.h"
+#include "AABB.h"
 
 class Quaternion;
 
@@ -72,6 +73,25 @@ public:
     /*! Sets up an orthographic projection centered at a particular location. */
     static Matrix CenterOrtho(Real width, Real height, const Vector2 &center, Real near, Real far);
 
+#pragma mark Batch operations
+    /*! Sets results[i] to lhs * rhs[i] for each of the count matrices. The shared matrix
+     *  is only loaded once, so this is the fastest way to apply a single view or parent
+     *  transform to many matrices. Results may overlap either input. */
+    static void Multiply(const Matrix &lhs, const Matrix *rhs, Matrix *results, unsigned int count);
+
+    /*! Sets results[i] to lhs[i] * rhs[i] for each of the count pairs. */
+    static void Multiply(const Matrix *lhs, const Matrix *rhs, Matrix *results, unsigned int count);
+
+    /*! Transforms each of the given points, exactly as apply would. The divide by w is
+     *  skipped when the matrix is affine. Results may overlap the points. */
+    static void TransformPoints(const Matrix &matrix, const Vector3 *points, Vector3 *results,
+                                unsigned int count);
+
+    /*! Finds the smallest AABBs that contain each of the given AABBs after being
+     *  transformed by the given affine matrix. Results may overlap the bounds. */
+    static void TransformBounds(const Matrix &matrix, const AABB3 *bounds, AABB3 *results,
+                                unsigned int count);
+
 public:
 #pragma mark Initialization and destruction
     /*! Creates an identity matrix.
@@ -166,8 +186,16 @@ public:
 
     Vector3 getTranslation() const;
 
+    /*! Returns true if the bottom row is exactly (0, 0, 0, 1), meaning the matrix is made
+     *  up of nothing but rotation, scaling, shearing, and translation. */
+    bool isAffine() const;
+
+    /*! Inverts the matrix, using the faster affine inverse whenever isAffine is true. */
     Matrix getInverse() const;
 
+    /*! Inverts the matrix, assuming it is affine without checking. */
+    Matrix getAffineInverse() const;
+
 #pragma mark Operators
     void postMultiply(const Matrix &rhs);
     void preMultiply(const Matrix &rhs);
@@ -187,7 +215,10 @@ public:
     Real& operator()(int row, int col);
 
 private:
-    void multiply(const Real* m1, const Real* m2, Real newMatrix[16]);
+    enum NoInit { Uninitialized };
+
+    /*! Leaves the matrix uninitialized, for results that are about to be overwritten. */
+    explicit Matrix(NoInit) {}
 
 };
 
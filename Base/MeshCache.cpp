@@ -0,0 +1,396 @@
+/*
+ *  MeshCache.cpp
+ *  Base
+ *
+ *  Created by loch on 4/28/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "MeshCache.h"
+#include "MHM_Helper.h"
+#include "IOTarget.h"
+#include "Assertion.h"
+#include "Math3D.h"
+#include <cstring>
+
+#pragma mark Writing helpers
+
+static unsigned int Align(unsigned int offset) {
+    return (offset + MHM_StreamAlignment - 1) / MHM_StreamAlignment * MHM_StreamAlignment;
+}
+
+static bool IsLittleEndian() {
+    int check = 1;
+    return *(char*)&check == 1;
+}
+
+static unsigned int AddString(std::string &pool, const std::string &str) {
+    unsigned int offset = pool.size();
+    pool.append(str);
+    pool.push_back('\0');
+    return offset;
+}
+
+/*! Writes the given bytes, followed by enough zeros to bring the file to the target
+ *  offset. Returns false if anything could not be written. */
+static bool WriteAt(IOTarget *target, unsigned int &position, unsigned int offset,
+const void *data, unsigned int size) {
+    static const char padding[MHM_StreamAlignment] = { 0 };
+    ASSERT(offset >= position);
+    while (position < offset) {
+        unsigned int count = Math::Min(offset - position, MHM_StreamAlignment);
+        if (target->write(padding, count) != count) { return false; }
+        position += count;
+    }
+
+    if (size && target->write(data, size) != size) { return false; }
+    position += size;
+    return true;
+}
+
+#pragma mark MeshCache static definitions
+
+bool MeshCache::Write(IOTarget *target, const std::vector<Bone> &bones,
+const std::vector<Material> &materials, const std::vector<Mesh> &meshes) {
+    if (!IsLittleEndian()) {
+        Error("Mesh caches can only be written on little endian hosts.");
+        return false;
+    }
+
+    std::string strings;
+    std::vector<MHM_Bone> boneTable(bones.size());
+    std::vector<MHM_Material> materialTable(materials.size());
+    std::vector<MHM_Mesh> meshTable(meshes.size());
+
+    for (int i = 0; i < bones.size(); i++) {
+        if (bones[i].parent >= i) {
+            Error("Bone " << bones[i].name << " comes before its parent.");
+            return false;
+        }
+
+        boneTable[i].name = AddString(strings, bones[i].name);
+        boneTable[i].parent = bones[i].parent;
+        memcpy(boneTable[i].transform, bones[i].transform.getMatrix(), sizeof(float) * 16);
+    }
+
+    for (int i = 0; i < materials.size(); i++) {
+        const Material &material = materials[i];
+        materialTable[i].name = AddString(strings, material.name);
+        materialTable[i].texture = material.texture.empty() ?
+            MHM_NoString : AddString(strings, material.texture);
+        memcpy(materialTable[i].ambient, material.ambient.ptr(), sizeof(float) * 4);
+        memcpy(materialTable[i].diffuse, material.diffuse.ptr(), sizeof(float) * 4);
+        materialTable[i].flags = material.lighting ? MHM_LightingEnabled : 0;
+    }
+
+    // Lay everything out before writing anything, so the tables can go first.
+    MHM_Header header;
+    memset(&header, 0, sizeof(MHM_Header));
+    header.signature      = MHM_Signature;
+    header.version        = MHM_Version;
+    header.headerSize     = sizeof(MHM_Header);
+    header.byteOrder      = MHM_ByteOrder;
+    header.boneCount      = bones.size();
+    header.boneOffset     = sizeof(MHM_Header);
+    header.materialCount  = materials.size();
+    header.materialOffset = header.boneOffset + bones.size() * sizeof(MHM_Bone);
+    header.meshCount      = meshes.size();
+    header.meshOffset     = header.materialOffset + materials.size() * sizeof(MHM_Material);
+
+    for (int i = 0; i < meshes.size(); i++) {
+        meshTable[i].name = AddString(strings, meshes[i].name);
+    }
+
+    header.stringOffset = header.meshOffset + meshes.size() * sizeof(MHM_Mesh);
+    header.stringSize = strings.size();
+
+    unsigned int offset = header.stringOffset + header.stringSize;
+    for (int i = 0; i < meshes.size(); i++) {
+        const Mesh &mesh = meshes[i];
+        MHM_Mesh &entry = meshTable[i];
+        unsigned int vertexCount = mesh.positions.size();
+
+        if ((!mesh.normals.empty() && mesh.normals.size() != vertexCount) ||
+            (!mesh.texCoords.empty() && mesh.texCoords.size() != vertexCount)) {
+            Error("Mesh " << mesh.name << " has mismatched vertex streams.");
+            return false;
+        }
+
+        if (mesh.material >= (int)materials.size() || mesh.bone >= (int)bones.size()) {
+            Error("Mesh " << mesh.name << " refers to a missing material or bone.");
+            return false;
+        }
+
+        entry.material = mesh.material;
+        entry.bone = mesh.bone;
+        memcpy(entry.min, mesh.bounds.getMin().ptr(), sizeof(float) * 3);
+        memcpy(entry.max, mesh.bounds.getMax().ptr(), sizeof(float) * 3);
+        entry.vertexCount = vertexCount;
+        entry.indexCount = mesh.indices.size();
+        entry.indexSize = vertexCount <= 0x10000 ? sizeof(unsigned short) : sizeof(unsigned int);
+
+        offset = Align(offset);
+        entry.positions = offset;
+        offset += vertexCount * sizeof(float) * 3;
+
+        entry.normals = MHM_NoStream;
+        if (!mesh.normals.empty()) {
+            offset = Align(offset);
+            entry.normals = offset;
+            offset += vertexCount * sizeof(float) * 3;
+        }
+
+        entry.texCoords = MHM_NoStream;
+        if (!mesh.texCoords.empty()) {
+            offset = Align(offset);
+            entry.texCoords = offset;
+            offset += vertexCount * sizeof(float) * 2;
+        }
+
+        entry.indices = MHM_NoStream;
+        if (!mesh.indices.empty()) {
+            offset = Align(offset);
+            entry.indices = offset;
+            offset += entry.indexCount * entry.indexSize;
+        }
+    }
+
+    header.fileSize = offset;
+
+    // And now actually write it all out, in order.
+    unsigned int position = 0;
+    bool success =
+        WriteAt(target, position, 0, &header, sizeof(MHM_Header)) &&
+        WriteAt(target, position, header.boneOffset, bones.empty() ? NULL : &boneTable[0],
+            bones.size() * sizeof(MHM_Bone)) &&
+        WriteAt(target, position, header.materialOffset, materials.empty() ? NULL : &materialTable[0],
+            materials.size() * sizeof(MHM_Material)) &&
+        WriteAt(target, position, header.meshOffset, meshes.empty() ? NULL : &meshTable[0],
+            meshes.size() * sizeof(MHM_Mesh)) &&
+        WriteAt(target, position, header.stringOffset, strings.data(), strings.size());
+
+    for (int i = 0; success && i < meshes.size(); i++) {
+        const Mesh &mesh = meshes[i];
+        const MHM_Mesh &entry = meshTable[i];
+
+        // Vector2 and Vector3 are just packed Reals, so the vectors can be written as is.
+        success = WriteAt(target, position, entry.positions, mesh.positions.empty() ? NULL :
+            mesh.positions[0].ptr(), entry.vertexCount * sizeof(float) * 3);
+
+        if (success && entry.normals != MHM_NoStream) {
+            success = WriteAt(target, position, entry.normals, mesh.normals[0].ptr(),
+                entry.vertexCount * sizeof(float) * 3);
+        }
+
+        if (success && entry.texCoords != MHM_NoStream) {
+            success = WriteAt(target, position, entry.texCoords, mesh.texCoords[0].ptr(),
+                entry.vertexCount * sizeof(float) * 2);
+        }
+
+        if (success && entry.indices != MHM_NoStream) {
+            if (entry.indexSize == sizeof(unsigned short)) {
+                std::vector<unsigned short> narrow(mesh.indices.begin(), mesh.indices.end());
+                success = WriteAt(target, position, entry.indices, &narrow[0],
+                    entry.indexCount * entry.indexSize);
+            } else {
+                success = WriteAt(target, position, entry.indices, &mesh.indices[0],
+                    entry.indexCount * entry.indexSize);
+            }
+        }
+    }
+
+    if (!success) {
+        Error("Unable to write mesh cache.");
+    }
+
+    return success;
+}
+
+MeshCache::MeshView MeshCache::GetView(const Mesh &mesh) {
+    MeshView view;
+    view.name = mesh.name;
+    view.material = mesh.material;
+    view.bone = mesh.bone;
+    view.bounds = mesh.bounds;
+    view.vertexCount = mesh.positions.size();
+    view.indexCount = mesh.indices.size();
+    view.indexSize = sizeof(unsigned int);
+    view.positions = mesh.positions.empty() ? NULL : mesh.positions[0].ptr();
+    view.normals = mesh.normals.empty() ? NULL : mesh.normals[0].ptr();
+    view.texCoords = mesh.texCoords.empty() ? NULL : mesh.texCoords[0].ptr();
+    view.indices = mesh.indices.empty() ? NULL : &mesh.indices[0];
+    return view;
+}
+
+bool MeshCache::IsMeshCache(const unsigned char *data, long long length) {
+    return length >= sizeof(int) && *(const int*)data == MHM_Signature;
+}
+
+#pragma mark MeshCache definitions
+
+MeshCache::MeshCache(): _data(NULL), _length(0), _strings(NULL), _stringSize(0),
+_streamBytes(0) {}
+
+MeshCache::~MeshCache() {}
+
+bool MeshCache::read(const unsigned char *data, long long length) {
+    _data = data;
+    _length = length;
+    _bones.clear();
+    _materials.clear();
+    _meshes.clear();
+    _streamBytes = 0;
+
+    if (length < sizeof(MHM_Header) || !IsMeshCache(data, length)) {
+        Error("Not a mesh cache.");
+        return false;
+    }
+
+    const MHM_Header *header = (const MHM_Header*)data;
+    if (header->byteOrder != MHM_ByteOrder) {
+        Error("Mesh cache was written with a different byte order.");
+        return false;
+    }
+
+    if (header->version != MHM_Version || header->headerSize != sizeof(MHM_Header)) {
+        Error("Mesh cache version " << header->version << " is not supported. Expected " <<
+              MHM_Version << ".");
+        return false;
+    }
+
+    if (header->fileSize > length ||
+        !inBounds(header->boneOffset, header->boneCount, sizeof(MHM_Bone)) ||
+        !inBounds(header->materialOffset, header->materialCount, sizeof(MHM_Material)) ||
+        !inBounds(header->meshOffset, header->meshCount, sizeof(MHM_Mesh)) ||
+        !inBounds(header->stringOffset, header->stringSize, 1) ||
+        (header->stringSize > 0 && data[header->stringOffset + header->stringSize - 1] != '\0')) {
+        Error("Mesh cache is truncated or corrupt.");
+        return false;
+    }
+
+    _strings = (const char*)data + header->stringOffset;
+    _stringSize = header->stringSize;
+
+    const MHM_Bone *boneTable = (const MHM_Bone*)(data + header->boneOffset);
+    _bones.resize(header->boneCount);
+    for (int i = 0; i < header->boneCount; i++) {
+        if (!readString(boneTable[i].name, _bones[i].name) || boneTable[i].parent >= i) {
+            Error("Mesh cache has a corrupt bone table.");
+            return false;
+        }
+
+        _bones[i].parent = boneTable[i].parent;
+        _bones[i].transform = Matrix(boneTable[i].transform);
+    }
+
+    const MHM_Material *materialTable = (const MHM_Material*)(data + header->materialOffset);
+    _materials.resize(header->materialCount);
+    for (int i = 0; i < header->materialCount; i++) {
+        const MHM_Material &entry = materialTable[i];
+        Material &material = _materials[i];
+        if (!readString(entry.name, material.name) ||
+            (entry.texture != MHM_NoString && !readString(entry.texture, material.texture))) {
+            Error("Mesh cache has a corrupt material table.");
+            return false;
+        }
+
+        material.ambient = Vector4(entry.ambient);
+        material.diffuse = Vector4(entry.diffuse);
+        material.lighting = entry.flags & MHM_LightingEnabled;
+    }
+
+    const MHM_Mesh *meshTable = (const MHM_Mesh*)(data + header->meshOffset);
+    _meshes.resize(header->meshCount);
+    for (int i = 0; i < header->meshCount; i++) {
+        const MHM_Mesh &entry = meshTable[i];
+        MeshView &mesh = _meshes[i];
+
+        bool valid = readString(entry.name, mesh.name) &&
+            entry.material < (int)header->materialCount &&
+            entry.bone < (int)header->boneCount &&
+            (entry.indexSize == sizeof(unsigned short) || entry.indexSize == sizeof(unsigned int)) &&
+            entry.positions != MHM_NoStream &&
+            inBounds(entry.positions, entry.vertexCount, sizeof(float) * 3) &&
+            (entry.normals == MHM_NoStream || inBounds(entry.normals, entry.vertexCount, sizeof(float) * 3)) &&
+            (entry.texCoords == MHM_NoStream || inBounds(entry.texCoords, entry.vertexCount, sizeof(float) * 2)) &&
+            (entry.indices == MHM_NoStream || inBounds(entry.indices, entry.indexCount, entry.indexSize));
+
+        if (!valid) {
+            Error("Mesh cache has a corrupt mesh table.");
+            return false;
+        }
+
+        mesh.material = entry.material;
+        mesh.bone = entry.bone;
+        mesh.bounds.setMinMax(Vector3(entry.min), Vector3(entry.max));
+        mesh.vertexCount = entry.vertexCount;
+        mesh.indexCount = entry.indices == MHM_NoStream ? 0 : entry.indexCount;
+        mesh.indexSize = entry.indexSize;
+        mesh.positions = (const float*)(data + entry.positions);
+        mesh.normals = entry.normals == MHM_NoStream ? NULL : (const float*)(data + entry.normals);
+        mesh.texCoords = entry.texCoords == MHM_NoStream ? NULL : (const float*)(data + entry.texCoords);
+        mesh.indices = entry.indices == MHM_NoStream ? NULL : data + entry.indices;
+
+        _streamBytes += mesh.vertexCount * sizeof(float) * 3;
+        if (mesh.normals)   { _streamBytes += mesh.vertexCount * sizeof(float) * 3; }
+        if (mesh.texCoords) { _streamBytes += mesh.vertexCount * sizeof(float) * 2; }
+        _streamBytes += mesh.indexCount * mesh.indexSize;
+    }
+
+    return true;
+}
+
+unsigned int MeshCache::getBoneCount() const {
+    return _bones.size();
+}
+
+const MeshCache::Bone& MeshCache::getBone(int index) const {
+    return _bones[index];
+}
+
+unsigned int MeshCache::getMaterialCount() const {
+    return _materials.size();
+}
+
+const MeshCache::Material& MeshCache::getMaterial(int index) const {
+    return _materials[index];
+}
+
+unsigned int MeshCache::getMeshCount() const {
+    return _meshes.size();
+}
+
+const MeshCache::MeshView& MeshCache::getMesh(int index) const {
+    return _meshes[index];
+}
+
+const std::vector<MeshCache::Bone>& MeshCache::getBones() const {
+    return _bones;
+}
+
+const std::vector<MeshCache::Material>& MeshCache::getMaterials() const {
+    return _materials;
+}
+
+const std::vector<MeshCache::MeshView>& MeshCache::getMeshes() const {
+    return _meshes;
+}
+
+long long MeshCache::getStreamBytes() const {
+    return _streamBytes;
+}
+
+bool MeshCache::readString(unsigned int offset, std::string &result) const {
+    if (offset >= _stringSize) {
+        return false;
+    }
+
+    // The pool is known to end with a terminator, so this can't run off the end.
+    result = _strings + offset;
+    return true;
+}
+
+bool MeshCache::inBounds(unsigned int offset, unsigned int count, unsigned int size) const {
+    return offset <= _length && (long long)count * size <= _length - offset;
+}
@@ -0,0 +1,147 @@
+/*
+ *  MeshCache.h
+ *  Base
+ *
+ *  Created by loch on 4/28/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _MESHCACHE_H_
+#define _MESHCACHE_H_
+#include "Base.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "AABB.h"
+
+class IOTarget;
+
+/*! MeshCache reads and writes the engine's native binary mesh format (.mhm). A cache is
+ *  a flat image of everything needed to build a Model: a bone hierarchy, a set of simple
+ *  material descriptions, and a list of meshes, each with its bounding box and its vertex
+ *  and index streams. The streams are stored exactly as they are uploaded, so reading a
+ *  cache is nothing more than validating the tables and pointing into the data.
+ *
+ *  Caches are meant to be built offline from the slower interchange formats, like FBX,
+ *  and loaded straight out of a MappedFile at runtime.
+ * \note The layout of the file is described in MHM_Helper.h.
+ * \brief Reads and writes .mhm mesh caches.
+ * \seealso ModelCacheFactory */
+class MeshCache {
+public:
+    /*! A single bone in the hierarchy. */
+    struct Bone {
+        std::string name;
+        int parent;               //!< The index of the parent, or -1 for a root bone.
+        Matrix transform;         //!< The transformation relative to the parent.
+    };
+
+    /*! The parts of a material that are kept in the cache. */
+    struct Material {
+        std::string name;
+        std::string texture;      //!< The name of the texture, or empty for none.
+        Vector4 ambient;
+        Vector4 diffuse;
+        bool lighting;
+    };
+
+    /*! A mesh being written to a cache. Normals and texture coordinates are optional, but
+     *  if present, there must be one for every position. */
+    struct Mesh {
+        std::string name;
+        int material;             //!< The index of the material, or -1 for none.
+        int bone;                 //!< The index of the root bone, or -1 for none.
+        AABB3 bounds;
+        std::vector<Vector3> positions;
+        std::vector<Vector3> normals;
+        std::vector<Vector2> texCoords;
+        std::vector<unsigned int> indices;
+    };
+
+    /*! A mesh read from a cache. The streams point into the cache's data, and are NULL if
+     *  the mesh doesn't have them. */
+    struct MeshView {
+        std::string name;
+        int material;
+        int bone;
+        AABB3 bounds;
+        unsigned int vertexCount;
+        unsigned int indexCount;
+        unsigned int indexSize;   //!< The bytes in each index. Either 2 or 4.
+        const float *positions;   //!< 3 floats per vertex.
+        const float *normals;     //!< 3 floats per vertex.
+        const float *texCoords;   //!< 2 floats per vertex.
+        const void *indices;
+    };
+
+public:
+    /*! Writes a cache containing the given bones, materials, and meshes. Indices are
+     *  narrowed to 16 bits for any mesh small enough to allow it.
+     * \return false if the data is inconsistent or could not be written. */
+    static bool Write(IOTarget *target, const std::vector<Bone> &bones,
+                      const std::vector<Material> &materials, const std::vector<Mesh> &meshes);
+
+    /*! Gets a view of a mesh that hasn't been written yet, so in memory meshes can be
+     *  treated exactly like cached ones. The view points into the mesh's vectors. */
+    static MeshView GetView(const Mesh &mesh);
+
+    /*! Returns true if the data looks like a mesh cache of any version. */
+    static bool IsMeshCache(const unsigned char *data, long long length);
+
+public:
+    MeshCache();
+    ~MeshCache();
+
+    /*! Reads the cache in the given memory, which is not copied and must outlive anything
+     *  returned by getMesh. Every table and stream is bounds checked, but the contents of
+     *  the streams are never touched.
+     * \return false if the data is not a valid cache for this version. */
+    bool read(const unsigned char *data, long long length);
+
+    /*! Gets the number of bones in the cache. */
+    unsigned int getBoneCount() const;
+
+    /*! Gets the bone at the given index. Parents always come before their children. */
+    const Bone& getBone(int index) const;
+
+    /*! Gets the number of materials in the cache. */
+    unsigned int getMaterialCount() const;
+
+    /*! Gets the material at the given index. */
+    const Material& getMaterial(int index) const;
+
+    /*! Gets the number of meshes in the cache. */
+    unsigned int getMeshCount() const;
+
+    /*! Gets the mesh at the given index. */
+    const MeshView& getMesh(int index) const;
+
+    /*! Gets all of the bones, materials, and meshes in the cache. */
+    const std::vector<Bone>& getBones() const;
+    const std::vector<Material>& getMaterials() const;
+    const std::vector<MeshView>& getMeshes() const;
+
+    /*! Gets the number of bytes of vertex and index data in the cache. */
+    long long getStreamBytes() const;
+
+private:
+    /*! Looks up a string in the string pool, checking that it is in bounds. */
+    bool readString(unsigned int offset, std::string &result) const;
+
+    /*! Checks that count elements of size bytes at offset fit in the data. */
+    bool inBounds(unsigned int offset, unsigned int count, unsigned int size) const;
+
+private:
+    const unsigned char *_data;
+    long long _length;
+    const char *_strings;         //!< The start of the string pool.
+    unsigned int _stringSize;
+
+    std::vector<Bone> _bones;
+    std::vector<Material> _materials;
+    std::vector<MeshView> _meshes;
+    long long _streamBytes;
+
+};
+
+#endif
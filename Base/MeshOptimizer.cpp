@@ -0,0 +1,409 @@
+/*
+ *  MeshOptimizer.cpp
+ *  Base
+ *
+ *  Created by loch on 5/2/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "MeshOptimizer.h"
+#include "Assertion.h"
+#include "Math3D.h"
+#include <algorithm>
+#include <cstring>
+
+const Real MeshOptimizer::OverdrawThreshold = 1.05;
+
+#pragma mark Vertex cache helpers
+
+// The scoring constants from Forsyth's paper.
+static const Real CacheDecayPower   = 1.5;
+static const Real LastTriangleScore = 0.75;
+static const Real ValenceBoostScale = 2.0;
+static const Real ValenceBoostPower = 0.5;
+
+// Valence scores are tabled up to this many remaining triangles, which covers nearly
+// every vertex in a real mesh.
+static const unsigned int ValenceTableSize = 32;
+
+/*! Scores a vertex by its position in the modeled cache (-1 if it isn't in it) and the
+ *  number of triangles still using it. Higher scores get drawn sooner. */
+static Real VertexScore(int cachePosition, unsigned int remaining) {
+    static Real cacheTable[MeshOptimizer::ModelCacheSize];
+    static Real valenceTable[ValenceTableSize];
+    static bool initialized = false;
+    if (!initialized) {
+        for (int i = 0; i < MeshOptimizer::ModelCacheSize; i++) {
+            // The three most recent vertices all get the same score, so the triangle just
+            // drawn doesn't favor any one of its edges.
+            cacheTable[i] = i < 3 ? LastTriangleScore : Math::Pow(
+                1.0 - (i - 3) / (Real)(MeshOptimizer::ModelCacheSize - 3), CacheDecayPower);
+        }
+
+        valenceTable[0] = 0;
+        for (int i = 1; i < ValenceTableSize; i++) {
+            valenceTable[i] = ValenceBoostScale * Math::Pow(i, -ValenceBoostPower);
+        }
+
+        initialized = true;
+    }
+
+    if (remaining == 0) { return -1; }
+
+    Real score = cachePosition >= 0 ? cacheTable[cachePosition] : 0;
+    return score + (remaining < ValenceTableSize ? valenceTable[remaining] :
+        ValenceBoostScale * Math::Pow(remaining, -ValenceBoostPower));
+}
+
+/*! Tracks a FIFO cache with timestamps, so checking for a hit is constant time. */
+class FifoCache {
+public:
+    FifoCache(unsigned int vertexCount, int size): _stamps(vertexCount, 0), _time(0), _size(size) {}
+
+    /*! Touches the given vertex, returning true if it was a miss. */
+    bool miss(unsigned int vertex) {
+        if (_stamps[vertex] && _time - _stamps[vertex] < _size) { return false; }
+        _stamps[vertex] = ++_time;
+        return true;
+    }
+
+private:
+    std::vector<unsigned int> _stamps;
+    unsigned int _time;
+    unsigned int _size;
+};
+
+#pragma mark Overdraw helpers
+
+/*! A run of triangles drawn together, and the key it is sorted by. */
+struct TriangleCluster {
+    unsigned int start;
+    unsigned int count;
+    Real key;
+};
+
+static bool ClusterDrawsFirst(const TriangleCluster &lhs, const TriangleCluster &rhs) {
+    return lhs.key > rhs.key;
+}
+
+#pragma mark MeshOptimizer definitions
+
+MeshOptimizer::Statistics MeshOptimizer::Optimize(MeshCache::Mesh &mesh) {
+    ASSERT(mesh.indices.size() % 3 == 0);
+
+    Statistics stats;
+    stats.verticesBefore = mesh.positions.size();
+    stats.acmrBefore = ACMR(mesh.indices, mesh.positions.size());
+
+    if (mesh.indices.size()) {
+        WeldVertices(mesh);
+        OptimizeVertexCache(mesh.indices, mesh.positions.size());
+
+        // Hold on to the cache order, in case sorting for overdraw costs too much.
+        std::vector<unsigned int> cacheOrder(mesh.indices);
+        Real cacheAcmr = ACMR(mesh.indices, mesh.positions.size());
+        OptimizeOverdraw(mesh.indices, mesh.positions);
+        if (ACMR(mesh.indices, mesh.positions.size()) > cacheAcmr * OverdrawThreshold) {
+            mesh.indices.swap(cacheOrder);
+        }
+
+        OptimizeVertexFetch(mesh);
+        if (mesh.positions.size()) {
+            mesh.bounds = AABB3::FindBounds(&mesh.positions[0], mesh.positions.size());
+        }
+    }
+
+    stats.verticesAfter = mesh.positions.size();
+    stats.acmrAfter = ACMR(mesh.indices, mesh.positions.size());
+    return stats;
+}
+
+unsigned int MeshOptimizer::WeldVertices(MeshCache::Mesh &mesh) {
+    unsigned int vertexCount = mesh.positions.size();
+    bool hasNormals = mesh.normals.size() == vertexCount;
+    bool hasTexCoords = mesh.texCoords.size() == vertexCount;
+
+    // Open addressing, with the table kept under half full.
+    unsigned int tableSize = 1;
+    while (tableSize < vertexCount * 2) { tableSize <<= 1; }
+    std::vector<int> table(tableSize, -1);
+
+    std::vector<unsigned int> remap(vertexCount);
+    unsigned int unique = 0;
+    for (unsigned int i = 0; i < vertexCount; i++) {
+        // FNV-1a over every attribute of the vertex.
+        unsigned int hash = 2166136261u;
+        const unsigned char *bytes = (const unsigned char*)mesh.positions[i].ptr();
+        for (int j = 0; j < sizeof(Vector3); j++) { hash = (hash ^ bytes[j]) * 16777619u; }
+        if (hasNormals) {
+            bytes = (const unsigned char*)mesh.normals[i].ptr();
+            for (int j = 0; j < sizeof(Vector3); j++) { hash = (hash ^ bytes[j]) * 16777619u; }
+        }
+
+        if (hasTexCoords) {
+            bytes = (const unsigned char*)mesh.texCoords[i].ptr();
+            for (int j = 0; j < sizeof(Vector2); j++) { hash = (hash ^ bytes[j]) * 16777619u; }
+        }
+
+        unsigned int slot = hash & (tableSize - 1);
+        while (table[slot] >= 0) {
+            int other = table[slot];
+            if (!memcmp(mesh.positions[i].ptr(), mesh.positions[other].ptr(), sizeof(Vector3)) &&
+                (!hasNormals || !memcmp(mesh.normals[i].ptr(), mesh.normals[other].ptr(), sizeof(Vector3))) &&
+                (!hasTexCoords || !memcmp(mesh.texCoords[i].ptr(), mesh.texCoords[other].ptr(), sizeof(Vector2)))) {
+                break;
+            }
+
+            slot = (slot + 1) & (tableSize - 1);
+        }
+
+        if (table[slot] >= 0) {
+            remap[i] = table[slot];
+            continue;
+        }
+
+        // Compact in place. The table points at the compacted vertices, which are never
+        // written to again, and vertices only ever move down, so nothing is lost.
+        table[slot] = unique;
+        remap[i] = unique;
+        mesh.positions[unique] = mesh.positions[i];
+        if (hasNormals) { mesh.normals[unique] = mesh.normals[i]; }
+        if (hasTexCoords) { mesh.texCoords[unique] = mesh.texCoords[i]; }
+        unique++;
+    }
+
+    mesh.positions.resize(unique);
+    if (hasNormals) { mesh.normals.resize(unique); }
+    if (hasTexCoords) { mesh.texCoords.resize(unique); }
+
+    for (int i = 0; i < mesh.indices.size(); i++) {
+        mesh.indices[i] = remap[mesh.indices[i]];
+    }
+
+    return vertexCount - unique;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int> &indices, unsigned int vertexCount) {
+    unsigned int triangleCount = indices.size() / 3;
+    if (triangleCount < 2) { return; }
+
+    // Build the list of triangles using each vertex. Triangles are removed from the lists
+    // as they're drawn, so the first 'remaining' entries are always the live ones.
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (int i = 0; i < indices.size(); i++) {
+        remaining[indices[i]]++;
+    }
+
+    for (int i = 0; i < vertexCount; i++) {
+        offsets[i + 1] = offsets[i] + remaining[i];
+    }
+
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> filled(vertexCount, 0);
+    for (int i = 0; i < indices.size(); i++) {
+        unsigned int vertex = indices[i];
+        adjacency[offsets[vertex] + filled[vertex]++] = i / 3;
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<Real> vertexScore(vertexCount);
+    for (int i = 0; i < vertexCount; i++) {
+        vertexScore[i] = VertexScore(-1, remaining[i]);
+    }
+
+    std::vector<Real> triangleScore(triangleCount);
+    std::vector<bool> drawn(triangleCount, false);
+    int best = 0;
+    for (int i = 0; i < triangleCount; i++) {
+        triangleScore[i] = vertexScore[indices[i * 3 + 0]] +
+                           vertexScore[indices[i * 3 + 1]] +
+                           vertexScore[indices[i * 3 + 2]];
+        if (triangleScore[i] > triangleScore[best]) { best = i; }
+    }
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+
+    // The cache holds up to three extra vertices while a triangle is being added.
+    std::vector<unsigned int> cache, newCache;
+    cache.reserve(ModelCacheSize + 3);
+    newCache.reserve(ModelCacheSize + 3);
+
+    unsigned int cursor = 0;
+    while (result.size() < indices.size()) {
+        // Nothing in the cache has any triangles left, so start over with the next
+        // triangle that hasn't been drawn.
+        if (best < 0) {
+            while (drawn[cursor]) { cursor++; }
+            best = cursor;
+        }
+
+        const unsigned int *triangle = &indices[best * 3];
+        drawn[best] = true;
+        newCache.clear();
+        for (int i = 0; i < 3; i++) {
+            unsigned int vertex = triangle[i];
+            result.push_back(vertex);
+            newCache.push_back(vertex);
+
+            unsigned int *begin = &adjacency[offsets[vertex]];
+            unsigned int *end = begin + remaining[vertex];
+            *std::find(begin, end, (unsigned int)best) = *(end - 1);
+            remaining[vertex]--;
+        }
+
+        for (int i = 0; i < cache.size(); i++) {
+            if (cache[i] != triangle[0] && cache[i] != triangle[1] && cache[i] != triangle[2]) {
+                newCache.push_back(cache[i]);
+            }
+        }
+
+        // Rescore everything that was touched, including anything that fell out.
+        for (int i = 0; i < newCache.size(); i++) {
+            unsigned int vertex = newCache[i];
+            cachePosition[vertex] = i < ModelCacheSize ? i : -1;
+            vertexScore[vertex] = VertexScore(cachePosition[vertex], remaining[vertex]);
+        }
+
+        best = -1;
+        Real bestScore = -1;
+        for (int i = 0; i < newCache.size(); i++) {
+            unsigned int vertex = newCache[i];
+            for (int j = 0; j < remaining[vertex]; j++) {
+                unsigned int other = adjacency[offsets[vertex] + j];
+                const unsigned int *otherTriangle = &indices[other * 3];
+                triangleScore[other] = vertexScore[otherTriangle[0]] +
+                                       vertexScore[otherTriangle[1]] +
+                                       vertexScore[otherTriangle[2]];
+
+                if (triangleScore[other] > bestScore) {
+                    bestScore = triangleScore[other];
+                    best = other;
+                }
+            }
+        }
+
+        if (newCache.size() > ModelCacheSize) { newCache.resize(ModelCacheSize); }
+        cache.swap(newCache);
+    }
+
+    indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int> &indices,
+const std::vector<Vector3> &positions) {
+    unsigned int triangleCount = indices.size() / 3;
+    if (triangleCount < 2) { return; }
+
+    // Start a new cluster at every triangle that misses on all three vertices. Those are
+    // the points where the cache starts over, so moving clusters around costs little.
+    std::vector<TriangleCluster> clusters;
+    FifoCache cache(positions.size(), MeasureCacheSize);
+    for (unsigned int i = 0; i < triangleCount; i++) {
+        int misses = cache.miss(indices[i * 3 + 0]) +
+                     cache.miss(indices[i * 3 + 1]) +
+                     cache.miss(indices[i * 3 + 2]);
+
+        if (i == 0 || misses == 3) {
+            TriangleCluster cluster = { i, 0, 0 };
+            clusters.push_back(cluster);
+        }
+
+        clusters.back().count++;
+    }
+
+    if (clusters.size() < 2) { return; }
+
+    // Area weighted centroids and normals, for each cluster and for the whole mesh. The
+    // cross product is twice the area, which doesn't matter for comparisons.
+    std::vector<Vector3> centroids(clusters.size(), Vector3(0, 0, 0));
+    std::vector<Vector3> normals(clusters.size(), Vector3(0, 0, 0));
+    std::vector<Real> areas(clusters.size(), 0);
+    Vector3 meshCentroid(0, 0, 0);
+    Real meshArea = 0;
+    for (int i = 0; i < clusters.size(); i++) {
+        for (int j = 0; j < clusters[i].count; j++) {
+            const unsigned int *triangle = &indices[(clusters[i].start + j) * 3];
+            const Vector3 &a = positions[triangle[0]];
+            const Vector3 &b = positions[triangle[1]];
+            const Vector3 &c = positions[triangle[2]];
+
+            Vector3 normal = (b - a).crossProduct(c - a);
+            Real area = normal.length();
+            centroids[i] += (a + b + c) * (area / 3.0);
+            normals[i] += normal;
+            areas[i] += area;
+        }
+
+        meshCentroid += centroids[i];
+        meshArea += areas[i];
+    }
+
+    if (meshArea > 0) { meshCentroid /= meshArea; }
+
+    // Clusters facing out from the center are likely to occlude the rest, so draw them
+    // first. Degenerate clusters get a key of 0.
+    for (int i = 0; i < clusters.size(); i++) {
+        if (areas[i] <= 0) { continue; }
+        Vector3 centroid = centroids[i] / areas[i];
+        clusters[i].key = (centroid - meshCentroid).dotProduct(normals[i] / areas[i]);
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), ClusterDrawsFirst);
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (int i = 0; i < clusters.size(); i++) {
+        result.insert(result.end(),
+            indices.begin() + clusters[i].start * 3,
+            indices.begin() + (clusters[i].start + clusters[i].count) * 3);
+    }
+
+    indices.swap(result);
+}
+
+unsigned int MeshOptimizer::OptimizeVertexFetch(MeshCache::Mesh &mesh) {
+    unsigned int vertexCount = mesh.positions.size();
+    bool hasNormals = mesh.normals.size() == vertexCount;
+    bool hasTexCoords = mesh.texCoords.size() == vertexCount;
+
+    static const unsigned int Unused = 0xFFFFFFFF;
+    std::vector<unsigned int> remap(vertexCount, Unused);
+    std::vector<Vector3> positions, normals;
+    std::vector<Vector2> texCoords;
+    positions.reserve(vertexCount);
+    if (hasNormals) { normals.reserve(vertexCount); }
+    if (hasTexCoords) { texCoords.reserve(vertexCount); }
+
+    for (int i = 0; i < mesh.indices.size(); i++) {
+        unsigned int &vertex = mesh.indices[i];
+        if (remap[vertex] == Unused) {
+            remap[vertex] = positions.size();
+            positions.push_back(mesh.positions[vertex]);
+            if (hasNormals) { normals.push_back(mesh.normals[vertex]); }
+            if (hasTexCoords) { texCoords.push_back(mesh.texCoords[vertex]); }
+        }
+
+        vertex = remap[vertex];
+    }
+
+    mesh.positions.swap(positions);
+    if (hasNormals) { mesh.normals.swap(normals); }
+    if (hasTexCoords) { mesh.texCoords.swap(texCoords); }
+    return mesh.positions.size();
+}
+
+Real MeshOptimizer::ACMR(const std::vector<unsigned int> &indices, unsigned int vertexCount,
+int cacheSize) {
+    if (indices.size() < 3) { return 0; }
+
+    FifoCache cache(vertexCount, cacheSize);
+    unsigned int misses = 0;
+    for (int i = 0; i < indices.size(); i++) {
+        misses += cache.miss(indices[i]);
+    }
+
+    return misses / (Real)(indices.size() / 3);
+}
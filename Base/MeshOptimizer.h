@@ -0,0 +1,84 @@
+/*
+ *  MeshOptimizer.h
+ *  Base
+ *
+ *  Created by loch on 5/2/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _MESHOPTIMIZER_H_
+#define _MESHOPTIMIZER_H_
+#include "Base.h"
+#include "MeshCache.h"
+
+/*! MeshOptimizer reorders indexed triangle lists so they render faster. The full pass,
+ *  run by Optimize, works in four steps:
+ *      1. Vertices with identical attributes are welded together.
+ *      2. Triangles are reordered for the post transform vertex cache, using Tom
+ *         Forsyth's linear speed vertex cache optimization.
+ *      3. Runs of triangles that share the cache are sorted so the outward facing ones
+ *         are drawn first, which cuts down on overdraw (the second half of Tipsify). This
+ *         is only kept if it doesn't cost much vertex cache efficiency.
+ *      4. Vertices are reordered by first use, so vertex fetches walk forward through
+ *         memory, and any vertices nothing references are dropped.
+ *
+ *  Nothing here depends on the renderer, so meshes can be optimized offline, on the
+ *  loader threads, or just before being uploaded. Narrowing indices to 16 bits is left to
+ *  whatever finally stores them, like MeshCache::Write.
+ *
+ *  Efficiency is measured as the average cache miss ratio (ACMR): the number of vertices
+ *  transformed per triangle drawn. It ranges from 3 for unshared triangles down to about
+ *  0.5 for a perfectly ordered regular grid.
+ * \brief Optimizes triangle meshes for the vertex cache, overdraw, and vertex fetch. */
+class MeshOptimizer {
+public:
+    /*! The size of the post transform cache simulated when measuring ACMR. */
+    static const int MeasureCacheSize = 16;
+
+    /*! The size of the LRU cache modeled while reordering triangles. */
+    static const int ModelCacheSize = 32;
+
+    /*! How much worse the ACMR is allowed to get when reordering for overdraw. */
+    static const Real OverdrawThreshold;
+
+    /*! The result of optimizing a single mesh. */
+    struct Statistics {
+        unsigned int verticesBefore;
+        unsigned int verticesAfter;
+        Real acmrBefore;
+        Real acmrAfter;
+    };
+
+public:
+    /*! Runs every step on the given mesh, which must be an indexed triangle list. The
+     *  bounds are recomputed afterwards, in case any unused vertices were dropped. */
+    static Statistics Optimize(MeshCache::Mesh &mesh);
+
+    /*! Merges vertices whose position, normal, and texture coordinate are all bitwise
+     *  identical, updating the indices to match.
+     * \return The number of vertices removed. */
+    static unsigned int WeldVertices(MeshCache::Mesh &mesh);
+
+    /*! Reorders the triangles in the given list for the post transform vertex cache. */
+    static void OptimizeVertexCache(std::vector<unsigned int> &indices, unsigned int vertexCount);
+
+    /*! Splits the triangle list into clusters wherever the vertex cache would start over,
+     *  and sorts the clusters so those facing away from the center of the mesh are drawn
+     *  first. Meant to be run after OptimizeVertexCache. */
+    static void OptimizeOverdraw(std::vector<unsigned int> &indices,
+                                 const std::vector<Vector3> &positions);
+
+    /*! Reorders the vertices in the order the indices first reference them, dropping any
+     *  that are never referenced.
+     * \return The new number of vertices. */
+    static unsigned int OptimizeVertexFetch(MeshCache::Mesh &mesh);
+
+    /*! Simulates a FIFO post transform cache of the given size over the triangle list and
+     *  returns the average number of cache misses per triangle. */
+    static Real ACMR(const std::vector<unsigned int> &indices, unsigned int vertexCount,
+                     int cacheSize = MeasureCacheSize);
+
+};
+
+#endif
@@ -38,6 +38,31 @@
 #   define SYS_PLATFORM PLATFORM_LINUX
 #endif
 
+// Finds the available vector instruction sets.
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#   define SYS_SSE 1
+#else
+#   define SYS_SSE 0
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define SYS_SSE2 1
+#else
+#   define SYS_SSE2 0
+#endif
+
+#if defined(__AVX__)
+#   define SYS_AVX 1
+#else
+#   define SYS_AVX 0
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#   define SYS_NEON 1
+#else
+#   define SYS_NEON 0
+#endif
+
 // Sets the function helper.
 #if SYS_COMPILER == COMPILER_GNUC
 #   define SYS_FUNCTION __PRETTY_FUNCTION__
@@ -0,0 +1,503 @@
+/*
+ *  Profiler.cpp
+ *  Base
+ *
+ *  Created by loch on 5/6/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "Profiler.h"
+#include "Assertion.h"
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+#pragma mark Profiler internals
+
+/*! A single call to a zone, as recorded by its thread. */
+struct Profiler::Event {
+    const char *name;
+    uint64_t begin, end;
+    int parent;             //!< The index of the enclosing event in the buffer, or -1.
+};
+
+/*! A finished event kept for a capture. */
+struct Profiler::TraceEvent {
+    const char *name;
+    uint64_t begin, end;
+    int thread;
+};
+
+/*! The events recorded by a single thread. Only the owning thread and EndFrame touch it,
+ *  so the mutex is never contended for more than the length of a swap. */
+struct Profiler::ThreadBuffer {
+    ThreadBuffer(int index): index(index), retired(0) {
+        std::ostringstream stream;
+        stream << "Thread " << index;
+        name = stream.str();
+        pthread_mutex_init(&mutex, NULL);
+    }
+
+    ~ThreadBuffer() {
+        pthread_mutex_destroy(&mutex);
+    }
+
+    int index;
+    std::string name;
+    pthread_mutex_t mutex;
+    std::vector<Event> events;
+    std::vector<int> open;  //!< The indices of the events that haven't ended yet.
+    volatile int retired;
+};
+
+#pragma mark Profiler static declarations
+
+volatile int Profiler::Enabled = 0;
+pthread_once_t Profiler::InitializeOnce = PTHREAD_ONCE_INIT;
+pthread_key_t Profiler::BufferKey;
+pthread_mutex_t Profiler::BufferMutex;
+std::vector<Profiler::ThreadBuffer *> Profiler::Buffers;
+int Profiler::ThreadCount = 0;
+
+std::vector<Profiler::Zone> Profiler::Zones;
+std::map<std::pair<int, const char *>, int> Profiler::ZoneLookup;
+std::map<int, int> Profiler::ThreadZones;
+bool Profiler::ZonesSorted = true;
+unsigned int Profiler::FrameCount = 0;
+
+bool Profiler::Capturing = false;
+uint64_t Profiler::CaptureStart = 0;
+std::vector<Profiler::TraceEvent> Profiler::Capture;
+std::map<int, std::string> Profiler::CaptureThreads;
+
+#pragma mark Profiler::Zone definitions
+
+double Profiler::Zone::getAverage() const {
+    return frames ? (double)totalTime / frames : 0.0;
+}
+
+#pragma mark Profiler definitions
+
+void Profiler::SetEnabled(bool enabled) {
+    __sync_lock_test_and_set(&Enabled, enabled ? 1 : 0);
+}
+
+bool Profiler::IsEnabled() {
+    return Enabled != 0;
+}
+
+void Profiler::SetThreadName(const std::string &name) {
+    ThreadBuffer *buffer = GetBuffer();
+    pthread_mutex_lock(&buffer->mutex);
+    buffer->name = name;
+    pthread_mutex_unlock(&buffer->mutex);
+}
+
+bool Profiler::Begin(const char *name) {
+    if (!Enabled) { return false; }
+
+    ThreadBuffer *buffer = GetBuffer();
+    pthread_mutex_lock(&buffer->mutex);
+    Event event;
+    event.name = name;
+    event.parent = buffer->open.empty() ? -1 : buffer->open.back();
+    event.end = 0;
+    event.begin = Timer::Now();
+    buffer->open.push_back(buffer->events.size());
+    buffer->events.push_back(event);
+    pthread_mutex_unlock(&buffer->mutex);
+    return true;
+}
+
+void Profiler::End() {
+    uint64_t now = Timer::Now();
+    ThreadBuffer *buffer = GetBuffer();
+    pthread_mutex_lock(&buffer->mutex);
+    ASSERT(!buffer->open.empty());
+    buffer->events[buffer->open.back()].end = now;
+    buffer->open.pop_back();
+    pthread_mutex_unlock(&buffer->mutex);
+}
+
+void Profiler::EndFrame() {
+    pthread_once(&InitializeOnce, Profiler::Initialize);
+    uint64_t now = Timer::Now();
+
+    // Reset the per frame numbers. Zones that don't run this frame keep their history.
+    for (int i = 0; i < Zones.size(); i++) {
+        Zones[i].calls = 0;
+        Zones[i].time = 0;
+        Zones[i].minCall = 0;
+        Zones[i].maxCall = 0;
+    }
+
+    std::vector<Event> events;
+    pthread_mutex_lock(&BufferMutex);
+    for (int i = 0; i < Buffers.size(); i++) {
+        // Check retirement first. A retired buffer never gets anything new, so once it's
+        // been taken it can go.
+        bool retired = __sync_add_and_fetch(&Buffers[i]->retired, 0) != 0;
+        TakeEvents(Buffers[i], now, events);
+        Aggregate(Buffers[i], events);
+
+        if (retired) {
+            delete Buffers[i];
+            Buffers.erase(Buffers.begin() + i);
+            i--;
+        }
+    }
+    pthread_mutex_unlock(&BufferMutex);
+
+    // Fold the frame into the history of every zone that ran.
+    for (int i = 0; i < Zones.size(); i++) {
+        Zone &zone = Zones[i];
+        if (zone.calls == 0) { continue; }
+        zone.minFrame = zone.frames ? std::min(zone.minFrame, zone.time) : zone.time;
+        zone.maxFrame = std::max(zone.maxFrame, zone.time);
+        zone.totalTime += zone.time;
+        zone.totalCalls += zone.calls;
+        zone.frames++;
+    }
+
+    if (!ZonesSorted) { SortZones(); }
+    FrameCount++;
+}
+
+void Profiler::Reset() {
+    Zones.clear();
+    ZoneLookup.clear();
+    ThreadZones.clear();
+    ZonesSorted = true;
+    FrameCount = 0;
+    Capturing = false;
+    Capture.clear();
+    CaptureThreads.clear();
+
+    // Throw out anything recorded so far, but keep open zones open.
+    pthread_once(&InitializeOnce, Profiler::Initialize);
+    std::vector<Event> unused;
+    pthread_mutex_lock(&BufferMutex);
+    for (int i = 0; i < Buffers.size(); i++) {
+        TakeEvents(Buffers[i], Timer::Now(), unused);
+    }
+    pthread_mutex_unlock(&BufferMutex);
+}
+
+unsigned int Profiler::GetFrameCount() {
+    return FrameCount;
+}
+
+const std::vector<Profiler::Zone> &Profiler::GetZones() {
+    return Zones;
+}
+
+const Profiler::Zone *Profiler::FindZone(const std::string &thread, const std::string &path) {
+    int current = -1;
+    for (int i = 0; i < Zones.size(); i++) {
+        if (Zones[i].depth == 0 && Zones[i].name == thread) { current = i; break; }
+    }
+
+    size_t start = 0;
+    while (current >= 0 && start <= path.size()) {
+        size_t end = path.find('/', start);
+        if (end == std::string::npos) { end = path.size(); }
+        std::string name = path.substr(start, end - start);
+
+        int next = -1;
+        for (int i = current + 1; i < Zones.size() && Zones[i].depth > Zones[current].depth; i++) {
+            if (Zones[i].parent == current && Zones[i].name == name) { next = i; break; }
+        }
+
+        current = next;
+        start = end + 1;
+    }
+
+    return current >= 0 ? &Zones[current] : NULL;
+}
+
+std::string Profiler::GetSummary(int maxDepth) {
+    std::ostringstream summary;
+    summary << std::fixed << std::setprecision(2);
+    summary << std::left << std::setw(32) << "Zone" << std::right <<
+        std::setw(9) << "Last" << std::setw(9) << "Min" << std::setw(9) << "Avg" <<
+        std::setw(9) << "Max" << std::setw(8) << "Calls";
+
+    for (int i = 0; i < Zones.size(); i++) {
+        const Zone &zone = Zones[i];
+        if (zone.depth > maxDepth) { continue; }
+
+        std::string label = std::string(zone.depth * 2, ' ') + zone.name;
+        summary << "\n" << std::left << std::setw(32) << label.substr(0, 31) << std::right <<
+            std::setw(9) << zone.time * 1e-6 <<
+            std::setw(9) << zone.minFrame * 1e-6 <<
+            std::setw(9) << zone.getAverage() * 1e-6 <<
+            std::setw(9) << zone.maxFrame * 1e-6 <<
+            std::setw(8) << zone.calls;
+    }
+
+    return summary.str();
+}
+
+std::string Profiler::GetCaption() {
+    pthread_once(&InitializeOnce, Profiler::Initialize);
+    std::map<int, int>::iterator root = ThreadZones.find(GetBuffer()->index);
+    if (root == ThreadZones.end()) { return ""; }
+
+    std::ostringstream caption;
+    caption << std::fixed << std::setprecision(1);
+    bool open = false;
+    for (int i = root->second + 1; i < Zones.size() && Zones[i].depth > 0; i++) {
+        if (Zones[i].depth == 1) {
+            if (open) { caption << ")"; open = false; }
+            caption << (i == root->second + 1 ? "" : " ") << Zones[i].name << ": " <<
+                Zones[i].time * 1e-6 << "ms";
+        } else if (Zones[i].depth == 2) {
+            caption << (open ? ", " : " (") << Zones[i].name << " " << Zones[i].time * 1e-6;
+            open = true;
+        }
+    }
+
+    if (open) { caption << ")"; }
+    return caption.str();
+}
+
+void Profiler::StartCapture() {
+    Capture.clear();
+    CaptureThreads.clear();
+    CaptureStart = Timer::Now();
+    Capturing = true;
+}
+
+void Profiler::StopCapture() {
+    Capturing = false;
+}
+
+/*! Writes the given string as a JSON string literal. */
+static void WriteJSONString(std::ostream &out, const std::string &string) {
+    out << '"';
+    for (int i = 0; i < string.size(); i++) {
+        switch (string[i]) {
+            case '"':  out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n";  break;
+            case '\t': out << "\\t";  break;
+            default:
+                if ((unsigned char)string[i] < 0x20) { out << ' '; }
+                else { out << string[i]; }
+        }
+    }
+    out << '"';
+}
+
+void Profiler::WriteChromeTrace(std::ostream &out) {
+    // Chrome wants microseconds. Keep the nanoseconds as decimals.
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[";
+
+    bool first = true;
+    std::map<int, std::string>::iterator thread;
+    for (thread = CaptureThreads.begin(); thread != CaptureThreads.end(); thread++) {
+        out << (first ? "\n" : ",\n");
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread->first <<
+            ",\"args\":{\"name\":";
+        WriteJSONString(out, thread->second);
+        out << "}}";
+        first = false;
+    }
+
+    for (int i = 0; i < Capture.size(); i++) {
+        const TraceEvent &event = Capture[i];
+        out << (first ? "\n" : ",\n");
+        out << "{\"name\":";
+        WriteJSONString(out, event.name);
+        out << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread <<
+            ",\"ts\":" << (event.begin - CaptureStart) * 1e-3 <<
+            ",\"dur\":" << (event.end - event.begin) * 1e-3 << "}";
+        first = false;
+    }
+
+    out << "\n]}\n";
+}
+
+bool Profiler::WriteChromeTrace(const std::string &filename) {
+    std::ofstream file(filename.c_str());
+    if (file.fail()) {
+        Error("Could not open " << filename << " to write the profiler trace.");
+        return false;
+    }
+
+    WriteChromeTrace(file);
+    Info("Wrote " << Capture.size() << " profiler events to " << filename);
+    return !file.fail();
+}
+
+void Profiler::Initialize() {
+    pthread_key_create(&BufferKey, Profiler::RetireBuffer);
+    pthread_mutex_init(&BufferMutex, NULL);
+}
+
+void Profiler::RetireBuffer(void *buffer) {
+    __sync_lock_test_and_set(&((ThreadBuffer*)buffer)->retired, 1);
+}
+
+Profiler::ThreadBuffer *Profiler::GetBuffer() {
+    pthread_once(&InitializeOnce, Profiler::Initialize);
+    ThreadBuffer *buffer = (ThreadBuffer*)pthread_getspecific(BufferKey);
+    if (!buffer) {
+        pthread_mutex_lock(&BufferMutex);
+        buffer = new ThreadBuffer(ThreadCount++);
+        Buffers.push_back(buffer);
+        pthread_mutex_unlock(&BufferMutex);
+
+        pthread_setspecific(BufferKey, buffer);
+    }
+
+    return buffer;
+}
+
+void Profiler::TakeEvents(ThreadBuffer *buffer, uint64_t now, std::vector<Event> &events) {
+    events.clear();
+    pthread_mutex_lock(&buffer->mutex);
+    events.swap(buffer->events);
+
+    // Open zones end here for this frame, and start over again at the same time in the
+    // next, with their parents remapped to the new buffer.
+    for (int i = 0; i < buffer->open.size(); i++) {
+        Event &event = events[buffer->open[i]];
+        event.end = now;
+
+        Event next = event;
+        next.begin = now;
+        next.end = 0;
+        next.parent = i > 0 ? i - 1 : -1;
+        buffer->events.push_back(next);
+        buffer->open[i] = i;
+    }
+
+    pthread_mutex_unlock(&buffer->mutex);
+}
+
+void Profiler::Aggregate(ThreadBuffer *buffer, const std::vector<Event> &events) {
+    if (events.empty()) { return; }
+
+    int root;
+    std::map<int, int>::iterator rootItr = ThreadZones.find(buffer->index);
+    if (rootItr == ThreadZones.end()) {
+        root = Zones.size();
+        Zone zone = Zone();
+        zone.parent = -1;
+        zone.thread = buffer->index;
+        Zones.push_back(zone);
+        ThreadZones[buffer->index] = root;
+        ZonesSorted = false;
+    } else {
+        root = rootItr->second;
+    }
+
+    // Names can change between frames, so this always just takes the latest.
+    pthread_mutex_lock(&buffer->mutex);
+    Zones[root].name = buffer->name;
+    pthread_mutex_unlock(&buffer->mutex);
+
+    // Parents are always recorded before their children, so they are resolved first.
+    std::vector<int> eventZones(events.size());
+    for (int i = 0; i < events.size(); i++) {
+        const Event &event = events[i];
+        int zoneIndex = GetChild(event.parent < 0 ? root : eventZones[event.parent], event.name);
+        eventZones[i] = zoneIndex;
+
+        Zone &zone = Zones[zoneIndex];
+        uint64_t duration = event.end - event.begin;
+        zone.minCall = zone.calls ? std::min(zone.minCall, duration) : duration;
+        zone.maxCall = std::max(zone.maxCall, duration);
+        zone.time += duration;
+        zone.calls++;
+
+        // The thread itself is credited with the time spent in its outermost zones.
+        if (event.parent < 0) {
+            Zones[root].time += duration;
+            Zones[root].maxCall = std::max(Zones[root].maxCall, duration);
+            Zones[root].calls = 1;
+        }
+
+        if (Capturing && Capture.size() < MaxCaptureEvents) {
+            TraceEvent trace = { event.name, event.begin, event.end, buffer->index };
+            Capture.push_back(trace);
+            CaptureThreads[buffer->index] = Zones[root].name;
+        }
+    }
+}
+
+int Profiler::GetChild(int parent, const char *name) {
+    std::pair<int, const char *> key(parent, name);
+    std::map<std::pair<int, const char *>, int>::iterator itr = ZoneLookup.find(key);
+    if (itr != ZoneLookup.end()) { return itr->second; }
+
+    Zone zone = Zone();
+    zone.name = name;
+    zone.parent = parent;
+    zone.depth = Zones[parent].depth + 1;
+    zone.thread = Zones[parent].thread;
+
+    int index = Zones.size();
+    Zones.push_back(zone);
+    ZoneLookup[key] = index;
+    ZonesSorted = false;
+    return index;
+}
+
+void Profiler::SortZones() {
+    // Children are listed in the order they were created, which keeps the tree stable.
+    std::vector<std::vector<int> > children(Zones.size());
+    std::vector<int> roots;
+    for (int i = 0; i < Zones.size(); i++) {
+        if (Zones[i].parent < 0) { roots.push_back(i); }
+        else { children[Zones[i].parent].push_back(i); }
+    }
+
+    // Roots go in thread order, then everything follows depth first.
+    std::map<int, int> threadOrder;
+    for (int i = 0; i < roots.size(); i++) { threadOrder[Zones[roots[i]].thread] = roots[i]; }
+
+    std::vector<int> order, stack;
+    std::map<int, int>::reverse_iterator thread;
+    for (thread = threadOrder.rbegin(); thread != threadOrder.rend(); thread++) {
+        stack.push_back(thread->second);
+    }
+
+    while (!stack.empty()) {
+        int index = stack.back();
+        stack.pop_back();
+        order.push_back(index);
+        for (int i = children[index].size() - 1; i >= 0; i--) {
+            stack.push_back(children[index][i]);
+        }
+    }
+
+    std::vector<int> remap(Zones.size());
+    std::vector<Zone> sorted(Zones.size());
+    for (int i = 0; i < order.size(); i++) {
+        remap[order[i]] = i;
+    }
+
+    for (int i = 0; i < order.size(); i++) {
+        sorted[i] = Zones[order[i]];
+        if (sorted[i].parent >= 0) { sorted[i].parent = remap[sorted[i].parent]; }
+    }
+    Zones.swap(sorted);
+
+    std::map<std::pair<int, const char *>, int> lookup;
+    std::map<std::pair<int, const char *>, int>::iterator itr;
+    for (itr = ZoneLookup.begin(); itr != ZoneLookup.end(); itr++) {
+        lookup[std::make_pair(remap[itr->first.first], itr->first.second)] = remap[itr->second];
+    }
+    ZoneLookup.swap(lookup);
+
+    std::map<int, int>::iterator threadItr;
+    for (threadItr = ThreadZones.begin(); threadItr != ThreadZones.end(); threadItr++) {
+        threadItr->second = remap[threadItr->second];
+    }
+
+    ZonesSorted = true;
+}
@@ -0,0 +1,177 @@
+/*
+ *  Profiler.h
+ *  Base
+ *
+ *  Created by loch on 5/6/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+#include "Base.h"
+#include "Timer.h"
+#include <pthread.h>
+
+/*! Profiler is a hierarchical CPU profiler built on zones: named, nested scopes, usually
+ *  marked with the PROFILE macro. Each thread records its zones into its own buffer, so
+ *  threads never wait on each other while profiling. Once a frame, EndFrame gathers every
+ *  buffer and folds the frame's zones into a tree, keyed by thread and then by the path
+ *  of zone names leading to each one. Every node in the tree tracks the last frame's time
+ *  and call count, along with the minimum, average, and maximum time per frame since the
+ *  profiler was last reset.
+ *
+ *  The results can be read directly, as text for an overlay, or captured across a run of
+ *  frames and written out in the Chrome trace format, which chrome://tracing can open.
+ *
+ *  Zone names are compared by address, so they must be string literals, or at least
+ *  strings that outlive the profiler. Profiling is off until SetEnabled is called, and
+ *  costs a single test per zone while off. Defining DISABLE_PROFILER compiles the zones
+ *  out entirely.
+ * \brief Records nested, named timings from any thread, aggregated once per frame.
+ * \seealso ProfileZone */
+class Profiler {
+public:
+    /*! The aggregated timings for one zone. Times are in nanoseconds. */
+    struct Zone {
+        std::string name;
+        int parent;                 //!< The index of the parent zone, or -1 for a thread.
+        int depth;                  //!< 0 for a thread, 1 for its outermost zones, etc.
+        int thread;                 //!< The index of the thread the zone ran on.
+
+        unsigned int calls;         //!< Times the zone was entered during the last frame.
+        uint64_t time;              //!< Total time spent in the zone in the last frame.
+        uint64_t minCall, maxCall;  //!< The shortest and longest call in the last frame.
+
+        unsigned int frames;        //!< Frames the zone has run in since the last reset.
+        uint64_t minFrame, maxFrame;//!< The least and most time spent in a single frame.
+        uint64_t totalTime;         //!< Time spent in the zone over all of those frames.
+        uint64_t totalCalls;        //!< Calls made over all of those frames.
+
+        /*! The average time per frame, over the frames the zone ran in. */
+        double getAverage() const;
+    };
+
+    /*! The most trace events a single capture keeps, to bound its memory. */
+    static const unsigned int MaxCaptureEvents = 1 << 20;
+
+public:
+    /*! Turns recording on or off. Zones that are open when it is turned off still close
+     *  normally. */
+    static void SetEnabled(bool enabled);
+    static bool IsEnabled();
+
+    /*! Names the calling thread, for the zone tree and traces. Unnamed threads are given
+     *  a number. */
+    static void SetThreadName(const std::string &name);
+
+    /*! Opens a zone on the calling thread. Normally used through ProfileZone.
+     * \return false if nothing was recorded, in which case End must not be called. */
+    static bool Begin(const char *name);
+
+    /*! Closes the zone most recently opened on the calling thread. */
+    static void End();
+
+    /*! Marks the end of a frame, aggregating everything recorded since the last call. Zones
+     *  still open are split at the frame boundary. This and everything that reads the
+     *  results must be called from the same thread, normally the main loop. */
+    static void EndFrame();
+
+    /*! Forgets every zone and statistic, and stops any capture. Zones that are open stay
+     *  open. */
+    static void Reset();
+
+    /*! Gets the number of frames aggregated since the last reset. */
+    static unsigned int GetFrameCount();
+
+    /*! Gets every zone, in depth first order. A zone's children always follow it. */
+    static const std::vector<Zone> &GetZones();
+
+    /*! Finds the zone with the given path of names, separated by '/', under the named
+     *  thread, or returns NULL. */
+    static const Zone *FindZone(const std::string &thread, const std::string &path);
+
+    /*! Formats the zone tree as an indented table with a line per zone, showing the last
+     *  frame and the min/avg/max in milliseconds, for use in an overlay. */
+    static std::string GetSummary(int maxDepth = 8);
+
+    /*! Gets a single line summary of the calling thread's outermost zones and their
+     *  children, sized for a window caption. */
+    static std::string GetCaption();
+
+    /*! Starts keeping every zone recorded, for writing out as a trace. */
+    static void StartCapture();
+
+    /*! Stops capturing. The capture is kept until the next one starts. */
+    static void StopCapture();
+
+    /*! Writes the last capture as Chrome trace JSON. */
+    static void WriteChromeTrace(std::ostream &out);
+
+    /*! Writes the last capture as Chrome trace JSON to the given file. */
+    static bool WriteChromeTrace(const std::string &filename);
+
+protected:
+    struct Event;
+    struct TraceEvent;
+    struct ThreadBuffer;
+
+    static void Initialize();
+    static void RetireBuffer(void *buffer);
+    static ThreadBuffer *GetBuffer();
+
+    /*! Swaps out the given buffer's events, splitting any open zones at the given time. */
+    static void TakeEvents(ThreadBuffer *buffer, uint64_t now, std::vector<Event> &events);
+
+    /*! Folds one thread's events for the frame into the zone tree. */
+    static void Aggregate(ThreadBuffer *buffer, const std::vector<Event> &events);
+
+    /*! Gets the index of the named child of the given zone, creating it if needed. */
+    static int GetChild(int parent, const char *name);
+
+    /*! Puts the zones back in depth first order after new ones have been added. */
+    static void SortZones();
+
+protected:
+    static volatile int Enabled;
+    static pthread_once_t InitializeOnce;
+    static pthread_key_t BufferKey;
+    static pthread_mutex_t BufferMutex;      //!< Guards Buffers and ThreadCount.
+    static std::vector<ThreadBuffer *> Buffers;
+    static int ThreadCount;
+
+    static std::vector<Zone> Zones;
+    static std::map<std::pair<int, const char *>, int> ZoneLookup;
+    static std::map<int, int> ThreadZones;   //!< Thread index to root zone index.
+    static bool ZonesSorted;
+    static unsigned int FrameCount;
+
+    static bool Capturing;
+    static uint64_t CaptureStart;
+    static std::vector<TraceEvent> Capture;
+    static std::map<int, std::string> CaptureThreads;
+
+};
+
+/*! Opens a profiler zone for as long as it is in scope.
+ * \seealso Profiler */
+class ProfileZone {
+public:
+    explicit ProfileZone(const char *name): _active(Profiler::Begin(name)) {}
+    ~ProfileZone() { if (_active) { Profiler::End(); } }
+
+private:
+    bool _active;
+
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#ifdef DISABLE_PROFILER
+#   define PROFILE(name) do {} while (0)
+#else
+#   define PROFILE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#endif
+
+#endif
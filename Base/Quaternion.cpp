@@ -48,8 +48,10 @@ Quaternion::Quaternion(const Matrix &m) { fromMatrix(m); }
 void Quaternion::fromMatrix(const Matrix &m) {
     Real trace = m[0] + m[5] + m[10] + 1.0;
     Real s = .5;
-    
-    if (!Math::eq(trace, 0)) {
+
+    // Dividing by w is only accurate while w is large. Past 90 degrees or so, divide by
+    // whichever of x, y, or z is largest instead.
+    if (trace > 1) {
         s /= Math::Sqrt(trace);
         w = 0.25 / s;
         x = (m[6] - m[9]) * s;
@@ -61,7 +63,7 @@ void Quaternion::fromMatrix(const Matrix &m) {
             x = 0.25 / s;
             y = (m[4] + m[1]) * s;
             z = (m[8] + m[2]) * s;
-            w = (m[9] - m[6]) * s;
+            w = (m[6] - m[9]) * s;
         } else if(m[5] > m[10]) {
             s /= Math::Sqrt( 1.0 + m[5] - m[0] - m[10] );
             x = (m[4] + m[1]) * s;
@@ -73,7 +75,7 @@ void Quaternion::fromMatrix(const Matrix &m) {
             x = (m[8] + m[2]) * s;
             y = (m[9] + m[6]) * s;
             z = 0.25 / s;
-            w = (m[4] - m[1]) * s;
+            w = (m[1] - m[4]) * s;
         }
     }
     normalize();
@@ -120,12 +122,10 @@ void Quaternion::toEuler(Radian &nx, Radian &ny, Radian &nz) {
 }
 
 void Quaternion::fromEuler(const Radian &nx, const Radian &ny, const Radian &nz) {
-    Real sx = Math::Sin(nx * .5);
-    Real sy = Math::Sin(ny * .5);
-    Real sz = Math::Sin(nz * .5);
-    Real cx = Math::Cos(nx * .5);
-    Real cy = Math::Cos(ny * .5);
-    Real cz = Math::Cos(nz * .5);
+    Real sx, sy, sz, cx, cy, cz;
+    Math::SinCos(nx * .5, sx, cx);
+    Math::SinCos(ny * .5, sy, cy);
+    Math::SinCos(nz * .5, sz, cz);
     
     w = (cz * cy * cx) + (sz * sy * sx);
     x = (cz * cy * sx) - (sz * sy * cx);
@@ -169,9 +169,9 @@ void Quaternion::fromAngleAxis(const Radian &angle, const Real &nx, const Real &
 void Quaternion::fromAngleAxis(const Radian &angle, const Vector3 &axis) {
     // This is used to compensate for a non-unit axis.
     Real oneOverLength = 1.0f / axis.length();
-    Real sinAngle = Math::Sin(angle * 0.5f);
-    
-    w = Math::Cos(angle * 0.5f);
+    Real sinAngle;
+    Math::SinCos(angle * 0.5f, sinAngle, w);
+
     x = (axis.x * sinAngle) * oneOverLength;
     y = (axis.y * sinAngle) * oneOverLength;
     z = (axis.z * sinAngle) * oneOverLength;
@@ -206,6 +206,18 @@ void Quaternion::slerp(const Quaternion &other, Real percent) {
     normalize();
 }
 
+void Quaternion::nlerp(const Quaternion &other, Real percent) {
+    // q and -q are the same rotation, but only one of them is on the near side.
+    Real dot = w * other.w + x * other.x + y * other.y + z * other.z;
+    Real weight1 = (1.0 - percent);
+    Real weight2 = dot < 0 ? -percent : percent;
+    w = weight1 * w + weight2 * other.w;
+    x = weight1 * x + weight2 * other.x;
+    y = weight1 * y + weight2 * other.y;
+    z = weight1 * z + weight2 * other.z;
+    normalize();
+}
+
 Quaternion Quaternion::getLerp(const Quaternion &other, Real percent) const {
     Quaternion result(*this);
     result.lerp(other, percent);
@@ -58,6 +58,10 @@ public:
     void lerp(const Quaternion &other, Real percent);
     void slerp(const Quaternion &other, Real percent);
 
+    /*! Like lerp, but always takes the shorter way around, as slerp does. Much cheaper
+     *  than slerp, and close enough for nearby rotations, like neighboring keyframes. */
+    void nlerp(const Quaternion &other, Real percent);
+
     Quaternion getLerp(const Quaternion &other, Real percent) const;
     Quaternion getSlerp(const Quaternion &other, Real percent) const;
 
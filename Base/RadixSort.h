@@ -0,0 +1,71 @@
+/*
+ *  RadixSort.h
+ *  Base
+ *
+ *  Created by loch on 4/14/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _RADIXSORT_H_
+#define _RADIXSORT_H_
+#include "Base.h"
+#include <stdint.h>
+#include <cstring>
+
+/*! Sorts an array of items by their 64 bit 'key' member, smallest first. This is a least
+ *  significant digit radix sort with 8 bit digits, so it is stable and runs in linear
+ *  time. All eight digit histograms are built in a single pass over the keys, and any
+ *  digit that is the same for every key is skipped entirely, which is common when the
+ *  upper bits of the keys are sparsely used.
+ * \param items The items to sort.
+ * \param scratch Temporary space, with room for at least 'count' items.
+ * \param count The number of items to sort. */
+template <typename T>
+void RadixSort(T *items, T *scratch, unsigned int count) {
+    if (count < 2) { return; }
+
+    unsigned int histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+    for (unsigned int i = 0; i < count; i++) {
+        uint64_t key = items[i].key;
+        for (int pass = 0; pass < 8; pass++) {
+            histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+        }
+    }
+
+    T *src = items, *dst = scratch;
+    for (int pass = 0; pass < 8; pass++) {
+        int shift = pass * 8;
+        unsigned int *counts = histograms[pass];
+        if (counts[(src[0].key >> shift) & 0xFF] == count) { continue; }
+
+        unsigned int offsets[256];
+        unsigned int total = 0;
+        for (int digit = 0; digit < 256; digit++) {
+            offsets[digit] = total;
+            total += counts[digit];
+        }
+
+        for (unsigned int i = 0; i < count; i++) {
+            dst[offsets[(src[i].key >> shift) & 0xFF]++] = src[i];
+        }
+
+        std::swap(src, dst);
+    }
+
+    if (src != items) {
+        std::copy(src, src + count, items);
+    }
+}
+
+/*! Sorts a vector of items by their 64 bit 'key' member, using the given vector as
+ *  scratch space. The scratch vector is grown if needed, but never shrunk, so it can be
+ *  reused to avoid allocations. */
+template <typename T>
+void RadixSort(std::vector<T> &items, std::vector<T> &scratch) {
+    if (scratch.size() < items.size()) { scratch.resize(items.size()); }
+    if (items.size()) { RadixSort(&items[0], &scratch[0], items.size()); }
+}
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ *  RectPacker.cpp
+ *  Base
+ *
+ *  Created by loch on 5/12/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "RectPacker.h"
+#include "Math3D.h"
+#include <climits>
+
+#pragma mark RectPacker::Rect definitions
+
+bool RectPacker::Rect::isContainedIn(const Rect &other) const {
+    return x >= other.x && y >= other.y &&
+           x + width <= other.x + other.width &&
+           y + height <= other.y + other.height;
+}
+
+bool RectPacker::Rect::overlaps(const Rect &other) const {
+    return x < other.x + other.width && other.x < x + width &&
+           y < other.y + other.height && other.y < y + height;
+}
+
+#pragma mark RectPacker definitions
+
+RectPacker::RectPacker(int width, int height) {
+    reset(width, height);
+}
+
+void RectPacker::reset(int width, int height) {
+    _width = width;
+    _height = height;
+    _usedArea = 0;
+    _free.clear();
+    _free.push_back(Rect(0, 0, width, height));
+}
+
+bool RectPacker::insert(int width, int height, Rect &result) {
+    if (width <= 0 || height <= 0) { return false; }
+
+    // Best short side fit, with the long side breaking ties.
+    int bestShort = INT_MAX, bestLong = INT_MAX, best = -1;
+    for (int i = 0; i < _free.size(); i++) {
+        const Rect &free = _free[i];
+        if (free.width < width || free.height < height) { continue; }
+
+        int leftoverX = free.width - width, leftoverY = free.height - height;
+        int shortSide = Math::Min(leftoverX, leftoverY);
+        int longSide = Math::Max(leftoverX, leftoverY);
+        if (shortSide < bestShort || (shortSide == bestShort && longSide < bestLong)) {
+            bestShort = shortSide;
+            bestLong = longSide;
+            best = i;
+        }
+    }
+
+    if (best < 0) { return false; }
+
+    result = Rect(_free[best].x, _free[best].y, width, height);
+
+    // Anything split off is appended, so only the original rectangles need checking.
+    int count = _free.size();
+    for (int i = 0; i < count; i++) {
+        if (splitFreeRect(_free[i], result)) {
+            _free.erase(_free.begin() + i);
+            i--;
+            count--;
+        }
+    }
+
+    pruneFreeRects();
+    _usedArea += (long long)width * height;
+    return true;
+}
+
+bool RectPacker::splitFreeRect(const Rect &free, const Rect &used) {
+    if (!free.overlaps(used)) { return false; }
+
+    // Copy, since pushing may move the rectangle out from under the reference.
+    Rect f = free;
+    if (used.x > f.x) {
+        _free.push_back(Rect(f.x, f.y, used.x - f.x, f.height));
+    }
+
+    if (used.x + used.width < f.x + f.width) {
+        int x = used.x + used.width;
+        _free.push_back(Rect(x, f.y, f.x + f.width - x, f.height));
+    }
+
+    if (used.y > f.y) {
+        _free.push_back(Rect(f.x, f.y, f.width, used.y - f.y));
+    }
+
+    if (used.y + used.height < f.y + f.height) {
+        int y = used.y + used.height;
+        _free.push_back(Rect(f.x, y, f.width, f.y + f.height - y));
+    }
+
+    return true;
+}
+
+void RectPacker::pruneFreeRects() {
+    for (int i = 0; i < _free.size(); i++) {
+        for (int j = i + 1; j < _free.size(); j++) {
+            if (_free[i].isContainedIn(_free[j])) {
+                _free.erase(_free.begin() + i);
+                i--;
+                break;
+            }
+
+            if (_free[j].isContainedIn(_free[i])) {
+                _free.erase(_free.begin() + j);
+                j--;
+            }
+        }
+    }
+}
+
+Real RectPacker::getOccupancy() const {
+    return (Real)_usedArea / ((Real)_width * _height);
+}
+
+int RectPacker::getWidth() const  { return _width;  }
+int RectPacker::getHeight() const { return _height; }
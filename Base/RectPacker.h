@@ -0,0 +1,74 @@
+/*
+ *  RectPacker.h
+ *  Base
+ *
+ *  Created by loch on 5/12/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _RECTPACKER_H_
+#define _RECTPACKER_H_
+#include "Base.h"
+
+/*! RectPacker places rectangles in a fixed size bin without overlapping, using the
+ *  MaxRects algorithm with the best short side fit heuristic (from Jukka Jylanki's "A
+ *  Thousand Ways to Pack the Bin"). The packer tracks every maximal rectangle of free
+ *  space, which may overlap one another. Each new rectangle goes in whichever free
+ *  rectangle it fits most snugly along its shorter leftover side, and every free
+ *  rectangle it touches is split into the pieces left around it.
+ *
+ *  Rectangles are never rotated, since they're generally images with a fixed orientation.
+ *  Packing works best when rectangles are inserted largest first.
+ * \brief Packs rectangles into a bin.
+ * \seealso TextureAtlas */
+class RectPacker {
+public:
+    /*! A rectangle in the bin, with its origin in the corner nearest 0, 0. */
+    struct Rect {
+        Rect() {}
+        Rect(int x, int y, int w, int h): x(x), y(y), width(w), height(h) {}
+
+        /*! Returns true if the rectangle lies entirely within the given one. */
+        bool isContainedIn(const Rect &other) const;
+
+        /*! Returns true if the rectangles share any area. */
+        bool overlaps(const Rect &other) const;
+
+        int x, y, width, height;
+    };
+
+public:
+    /*! Creates an empty bin of the given size. */
+    RectPacker(int width, int height);
+
+    /*! Empties the bin, changing its size. */
+    void reset(int width, int height);
+
+    /*! Places a rectangle of the given size in the bin.
+     * \return false if there is no room left for it, in which case nothing changes. */
+    bool insert(int width, int height, Rect &result);
+
+    /*! Gets the fraction of the bin's area that has been used. */
+    Real getOccupancy() const;
+
+    int getWidth() const;
+    int getHeight() const;
+
+protected:
+    /*! Splits the free rectangle around the given used one, adding the pieces to the
+     *  end of the free list. Returns false if they don't overlap. */
+    bool splitFreeRect(const Rect &free, const Rect &used);
+
+    /*! Removes any free rectangle that is contained in another. */
+    void pruneFreeRects();
+
+protected:
+    int _width;
+    int _height;
+    long long _usedArea;
+    std::vector<Rect> _free;
+
+};
+
+#endif
@@ -0,0 +1,353 @@
+/*
+ *  ResourceLoader.cpp
+ *  Base
+ *
+ *  Created by loch on 4/26/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "ResourceLoader.h"
+#include "Assertion.h"
+#include "Logger.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+#pragma mark ResourceLoader::Request definitions
+
+ResourceLoader::Request::Request(const std::string &name, int priority): _name(name),
+_priority(priority), _state(Queued), _cancelled(false), _preparedBytes(0), _sequence(0),
+_references(1) {}
+
+ResourceLoader::Request::~Request() {}
+
+const std::string& ResourceLoader::Request::getName() const {
+    return _name;
+}
+
+int ResourceLoader::Request::getPriority() const {
+    return _priority;
+}
+
+ResourceLoader::RequestState ResourceLoader::Request::getState() const {
+    return (RequestState)_state;
+}
+
+bool ResourceLoader::Request::isDone() const {
+    return _state == Finished || _state == Failed || _state == Cancelled;
+}
+
+long long ResourceLoader::Request::getPreparedBytes() const {
+    return _preparedBytes;
+}
+
+void ResourceLoader::Request::retain() {
+    __sync_add_and_fetch(&_references, 1);
+}
+
+void ResourceLoader::Request::release() {
+    if (__sync_sub_and_fetch(&_references, 1) == 0) {
+        delete this;
+    }
+}
+
+#pragma mark ResourceLoader definitions
+
+bool ResourceLoader::QueueOrder::operator()(const Request *lhs, const Request *rhs) const {
+    if (lhs->_priority != rhs->_priority) {
+        return lhs->_priority < rhs->_priority;
+    }
+
+    return lhs->_sequence > rhs->_sequence;
+}
+
+ResourceLoader::ResourceLoader(int threadCount): _sequence(0), _inFlight(0), _outstanding(0),
+_shutdown(false), _finishedCount(0), _failedCount(0), _bytesPrepared(0), _rateBytes(0),
+_bytesPerSecond(0) {
+    pthread_mutex_init(&_mutex, NULL);
+    pthread_cond_init(&_wake, NULL);
+    pthread_cond_init(&_prepared, NULL);
+
+    for (int i = 0; i < threadCount; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, ResourceLoader::Launch, this) != 0) {
+            Warn("Could only create " << i << " of " << threadCount << " loader threads.");
+            break;
+        }
+
+        _threads.push_back(thread);
+    }
+
+    _rateTimer.start();
+}
+
+ResourceLoader::~ResourceLoader() {
+    pthread_mutex_lock(&_mutex);
+    _shutdown = true;
+    pthread_cond_broadcast(&_wake);
+    pthread_mutex_unlock(&_mutex);
+
+    for (int i = 0; i < _threads.size(); i++) {
+        pthread_join(_threads[i], NULL);
+    }
+
+    // Nothing else is running now, so just retire whatever is left.
+    for (int i = 0; i < _queue.size(); i++) {
+        _queue[i]->_state = Cancelled;
+        _ready.push_back(_queue[i]);
+    }
+
+    _queue.clear();
+    while (!_ready.empty()) {
+        Request *request = _ready.front();
+        _ready.pop_front();
+        request->_cancelled = true;
+        retireRequest(request);
+    }
+
+    pthread_cond_destroy(&_prepared);
+    pthread_cond_destroy(&_wake);
+    pthread_mutex_destroy(&_mutex);
+}
+
+int ResourceLoader::getThreadCount() const {
+    return _threads.size();
+}
+
+void ResourceLoader::submit(Request *request) {
+    ASSERT(request->_state == Queued);
+    request->retain();
+
+    pthread_mutex_lock(&_mutex);
+    request->_sequence = _sequence++;
+    _queue.push_back(request);
+    std::push_heap(_queue.begin(), _queue.end(), QueueOrder());
+    _outstanding++;
+    pthread_cond_signal(&_wake);
+    pthread_mutex_unlock(&_mutex);
+}
+
+void ResourceLoader::reprioritize(Request *request, int priority) {
+    pthread_mutex_lock(&_mutex);
+    request->_priority = priority;
+    if (request->_state == Queued) {
+        std::make_heap(_queue.begin(), _queue.end(), QueueOrder());
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+void ResourceLoader::cancel(Request *request) {
+    pthread_mutex_lock(&_mutex);
+    request->_cancelled = true;
+    if (request->_state == Queued) {
+        RequestQueue::iterator itr = std::find(_queue.begin(), _queue.end(), request);
+        if (itr != _queue.end()) {
+            _queue.erase(itr);
+            std::make_heap(_queue.begin(), _queue.end(), QueueOrder());
+            request->_state = Cancelled;
+            _ready.push_back(request);
+        }
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+void ResourceLoader::waitForPrepare(Request *request) {
+    pthread_mutex_lock(&_mutex);
+    while (request->_state == Preparing) {
+        pthread_cond_wait(&_prepared, &_mutex);
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+int ResourceLoader::update(double budgetMilliseconds) {
+    PROFILE("Resource Update");
+    updateRate();
+
+    Timer timer;
+    timer.start();
+
+    int retired = 0;
+    while (true) {
+        pthread_mutex_lock(&_mutex);
+        if (!_ready.empty()) {
+            Request *request = _ready.front();
+            _ready.pop_front();
+            pthread_mutex_unlock(&_mutex);
+            retireRequest(request);
+            retired++;
+        } else if (_threads.empty() && !_queue.empty()) {
+            // Without any workers, the preparing has to happen here.
+            Request *request = popQueued();
+            pthread_mutex_unlock(&_mutex);
+            prepareRequest(request);
+            continue;
+        } else {
+            pthread_mutex_unlock(&_mutex);
+            break;
+        }
+
+        timer.stop();
+        if (budgetMilliseconds >= 0 && timer.mseconds() >= budgetMilliseconds) {
+            break;
+        }
+    }
+
+    return retired;
+}
+
+void ResourceLoader::flush() {
+    while (true) {
+        update(-1);
+
+        pthread_mutex_lock(&_mutex);
+        bool done = _outstanding == 0;
+        while (!done && _ready.empty() && !_threads.empty()) {
+            pthread_cond_wait(&_prepared, &_mutex);
+        }
+        pthread_mutex_unlock(&_mutex);
+
+        if (done) { break; }
+    }
+}
+
+int ResourceLoader::getQueuedCount() {
+    pthread_mutex_lock(&_mutex);
+    int count = _queue.size();
+    pthread_mutex_unlock(&_mutex);
+    return count;
+}
+
+int ResourceLoader::getInFlightCount() {
+    pthread_mutex_lock(&_mutex);
+    int count = _inFlight;
+    pthread_mutex_unlock(&_mutex);
+    return count;
+}
+
+int ResourceLoader::getReadyCount() {
+    pthread_mutex_lock(&_mutex);
+    int count = _ready.size();
+    pthread_mutex_unlock(&_mutex);
+    return count;
+}
+
+int ResourceLoader::getOutstandingCount() {
+    pthread_mutex_lock(&_mutex);
+    int count = _outstanding;
+    pthread_mutex_unlock(&_mutex);
+    return count;
+}
+
+int ResourceLoader::getFinishedCount() const {
+    return _finishedCount;
+}
+
+int ResourceLoader::getFailedCount() const {
+    return _failedCount;
+}
+
+long long ResourceLoader::getBytesPrepared() {
+    pthread_mutex_lock(&_mutex);
+    long long bytes = _bytesPrepared;
+    pthread_mutex_unlock(&_mutex);
+    return bytes;
+}
+
+double ResourceLoader::getBytesPerSecond() const {
+    return _bytesPerSecond;
+}
+
+void* ResourceLoader::Launch(void *loader) {
+    static_cast<ResourceLoader*>(loader)->workerLoop();
+    return NULL;
+}
+
+void ResourceLoader::workerLoop() {
+    Profiler::SetThreadName("Resource Loader");
+
+    pthread_mutex_lock(&_mutex);
+    while (true) {
+        while (!_shutdown && _queue.empty()) {
+            pthread_cond_wait(&_wake, &_mutex);
+        }
+
+        if (_shutdown) { break; }
+
+        Request *request = popQueued();
+        pthread_mutex_unlock(&_mutex);
+
+        prepareRequest(request);
+
+        pthread_mutex_lock(&_mutex);
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+ResourceLoader::Request* ResourceLoader::popQueued() {
+    std::pop_heap(_queue.begin(), _queue.end(), QueueOrder());
+    Request *request = _queue.back();
+    _queue.pop_back();
+
+    request->_state = Preparing;
+    _inFlight++;
+    return request;
+}
+
+void ResourceLoader::prepareRequest(Request *request) {
+    PROFILE("Resource Prepare");
+    bool success = false;
+    try {
+        success = request->prepare();
+    } catch (std::exception &e) {
+        Error("Exception while preparing " << request->getName() << ": " << e.what());
+    }
+
+    pthread_mutex_lock(&_mutex);
+    request->_state = success ? Prepared : Failed;
+    _bytesPrepared += request->_preparedBytes;
+    _inFlight--;
+    _ready.push_back(request);
+    pthread_cond_broadcast(&_prepared);
+    pthread_mutex_unlock(&_mutex);
+}
+
+void ResourceLoader::retireRequest(Request *request) {
+    if (request->_cancelled) {
+        request->_state = Cancelled;
+    } else if (request->_state == Prepared) {
+        bool success = false;
+        try {
+            success = request->finish();
+        } catch (std::exception &e) {
+            Error("Exception while finishing " << request->getName() << ": " << e.what());
+        }
+
+        request->_state = success ? Finished : Failed;
+    }
+
+    if (request->_state == Finished) { _finishedCount++; }
+    if (request->_state == Failed)   { _failedCount++;   }
+
+    request->retire();
+
+    pthread_mutex_lock(&_mutex);
+    _outstanding--;
+    pthread_mutex_unlock(&_mutex);
+
+    request->release();
+}
+
+void ResourceLoader::updateRate() {
+    _rateTimer.stop();
+    double seconds = _rateTimer.seconds();
+    if (seconds < 0.05) { return; }
+    _rateTimer.start();
+
+    long long bytes = getBytesPrepared();
+    double current = (bytes - _rateBytes) / seconds;
+    _rateBytes = bytes;
+
+    // Smooth things out a bit so a single large resource doesn't make the rate jump around.
+    _bytesPerSecond = _bytesPerSecond * 0.75 + current * 0.25;
+}
@@ -0,0 +1,221 @@
+/*
+ *  ResourceLoader.h
+ *  Base
+ *
+ *  Created by loch on 4/26/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _RESOURCELOADER_H_
+#define _RESOURCELOADER_H_
+#include "Base.h"
+#include "Timer.h"
+#include <pthread.h>
+
+/*! ResourceLoader runs resource loads in the background. Every load is split into two
+ *  stages. The prepare stage does anything that doesn't need the GL context, like file
+ *  I/O and decoding, and runs on a set of worker threads. The finish stage does whatever
+ *  is left, like uploading to the card, and runs on the main thread when update is
+ *  called. update is given a time budget, so a pile of finished loads can never stall a
+ *  frame by more than a single finish.
+ *
+ *  Queued requests are prepared in order of priority, with higher priorities going
+ *  first. Requests can be reprioritized or cancelled at any point before they finish.
+ *
+ *  A loader with no worker threads prepares requests on the main thread from inside of
+ *  update, still respecting priorities and the time budget.
+ *
+ *  Since prepare runs alongside the main thread, it may only touch state that is safe to
+ *  share. ResourceGroupManager's openResource and mapResource are, for loose files and
+ *  archives alike, and a rescan of the resource locations makes any lookups in flight
+ *  wait for the new index. Anything else a factory reads from prepare must either be
+ *  immutable or guarded by its own lock.
+ * \brief Prepares resources on worker threads and finishes them on the main thread.
+ * \seealso ResourceManager::requestResource */
+class ResourceLoader {
+public:
+    /*! The stages a Request moves through, in order. Only one of Finished, Failed, and
+     *  Cancelled is ever reached. */
+    enum RequestState {
+        Queued,    /*!< Waiting for a worker.                     */
+        Preparing, /*!< Being prepared on a worker thread.        */
+        Prepared,  /*!< Waiting to be finished on the main thread. */
+        Finished,  /*!< Done. The resource is ready.              */
+        Failed,    /*!< Done. The resource could not be loaded.   */
+        Cancelled  /*!< Done. The request was cancelled.          */
+    };
+
+    /*! A single load moving through the loader. Requests are reference counted, since
+     *  they are shared between the loader, the owner, and whoever asked for the load.
+     *  Anyone holding on to a request must release it when done with it.
+     * \note State changes and the retire call happen on the thread that calls update,
+     *  with the exception of prepare, which happens on a worker thread. */
+    class Request {
+    public:
+        /*! Creates a new, queued request with a single reference. */
+        Request(const std::string &name, int priority);
+
+        /*! Gets the name of the resource being loaded. */
+        const std::string& getName() const;
+
+        /*! Gets the current priority of the request. */
+        int getPriority() const;
+
+        /*! Gets the current state of the request. */
+        RequestState getState() const;
+
+        /*! Returns true once the request has finished, failed, or been cancelled. */
+        bool isDone() const;
+
+        /*! Gets the number of bytes produced by the prepare stage. */
+        long long getPreparedBytes() const;
+
+        /*! Adds a reference to the request. */
+        void retain();
+
+        /*! Removes a reference to the request, deleting it once none are left. */
+        void release();
+
+    protected:
+        /*! Requests delete themselves once released. */
+        virtual ~Request();
+
+        /*! Does the thread safe part of the load. Called on a worker thread, so it must
+         *  not touch the GL context or anything else owned by the main thread.
+         * \return false if the load failed. */
+        virtual bool prepare() = 0;
+
+        /*! Does the rest of the load. Called on the main thread once prepared.
+         * \return false if the load failed. */
+        virtual bool finish() = 0;
+
+        /*! Called on the main thread exactly once, after the request reaches its final
+         *  state, no matter what that state is. Anything prepare made that finish didn't
+         *  consume should be cleaned up here. */
+        virtual void retire() = 0;
+
+        friend class ResourceLoader;
+
+    protected:
+        std::string _name;
+        int _priority;
+        volatile int _state;       //!< The RequestState of the request.
+        bool _cancelled;           //!< Set if cancelled while being prepared.
+        long long _preparedBytes;  //!< Set by prepare, used for load statistics.
+        unsigned int _sequence;    //!< Submission order, used to break priority ties.
+        volatile int _references;
+
+    };
+
+public:
+    /*! Creates a loader with the given number of worker threads. */
+    ResourceLoader(int threadCount);
+
+    /*! Cancels all outstanding requests, then stops and joins the worker threads. */
+    ~ResourceLoader();
+
+    /*! Gets the number of worker threads used for preparing requests. */
+    int getThreadCount() const;
+
+    /*! Queues the given request for loading. The loader holds a reference to the request
+     *  until it is retired. */
+    void submit(Request *request);
+
+    /*! Changes the priority of a queued request. Requests that have already left the
+     *  queue are unaffected. */
+    void reprioritize(Request *request, int priority);
+
+    /*! Cancels the request. Queued requests are pulled from the queue immediately.
+     *  Requests being prepared are allowed to finish preparing, but are never finished.
+     *  Either way, the request is retired by the next call to update. */
+    void cancel(Request *request);
+
+    /*! Blocks until the request is no longer being prepared on a worker thread. */
+    void waitForPrepare(Request *request);
+
+    /*! Finishes and retires prepared requests on the calling thread, which must be the
+     *  one that owns the GL context. At least one request is handled per call, so a
+     *  budget of 0 still makes progress.
+     * \param budgetMilliseconds How long to spend finishing requests. Negative means no
+     *  limit.
+     * \return The number of requests retired. */
+    int update(double budgetMilliseconds);
+
+    /*! Blocks until every outstanding request has been retired. */
+    void flush();
+
+    /*! Gets the number of requests waiting for a worker. */
+    int getQueuedCount();
+
+    /*! Gets the number of requests being prepared. */
+    int getInFlightCount();
+
+    /*! Gets the number of requests waiting to be finished on the main thread. */
+    int getReadyCount();
+
+    /*! Gets the number of submitted requests that haven't been retired yet. */
+    int getOutstandingCount();
+
+    /*! Gets the number of requests that have finished successfully. */
+    int getFinishedCount() const;
+
+    /*! Gets the number of requests that failed. */
+    int getFailedCount() const;
+
+    /*! Gets the total number of bytes prepared so far. */
+    long long getBytesPrepared();
+
+    /*! Gets the rate at which bytes have recently been prepared, averaged over the
+     *  time between calls to update. */
+    double getBytesPerSecond() const;
+
+protected:
+    /*! Orders the queue so the highest priority request is on top, with earlier
+     *  submissions winning ties. */
+    struct QueueOrder {
+        bool operator()(const Request *lhs, const Request *rhs) const;
+    };
+
+    typedef std::vector<Request*> RequestQueue;
+
+    static void* Launch(void *loader);
+
+    /*! The main loop of each worker thread. */
+    void workerLoop();
+
+    /*! Takes the next request off of the queue. Must be called with the lock held. */
+    Request* popQueued();
+
+    /*! Runs the prepare stage of the request. Must be called without the lock held. */
+    void prepareRequest(Request *request);
+
+    /*! Finishes (if appropriate) and retires the request. */
+    void retireRequest(Request *request);
+
+    /*! Updates the running bytes per second estimate. */
+    void updateRate();
+
+protected:
+    std::vector<pthread_t> _threads;
+    pthread_mutex_t _mutex;
+    pthread_cond_t _wake;        //!< Signaled when requests are queued or on shutdown.
+    pthread_cond_t _prepared;    //!< Signaled whenever a request leaves the Preparing state.
+
+    RequestQueue _queue;         //!< A heap of requests waiting to be prepared.
+    std::list<Request*> _ready;  //!< Requests waiting to be finished and retired.
+    unsigned int _sequence;      //!< The next submission number.
+    int _inFlight;               //!< The number of requests being prepared.
+    int _outstanding;            //!< Submitted requests that haven't been retired.
+    bool _shutdown;
+
+    int _finishedCount;
+    int _failedCount;
+    long long _bytesPrepared;    //!< The total bytes prepared so far.
+    long long _rateBytes;        //!< _bytesPrepared as of the last rate update.
+    double _bytesPerSecond;      //!< A smoothed estimate of the prepare rate.
+    Timer _rateTimer;            //!< Measures the time between rate updates.
+
+};
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ *  ResourceReferences.h
+ *  Base
+ *
+ *  Created by loch on 5/14/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _RESOURCEREFERENCES_H_
+#define _RESOURCEREFERENCES_H_
+#include "Base.h"
+
+/*! Anything that hands out named references that must be given back. ResourceManager
+ *  implements this, which lets Render types hold on to references without knowing about
+ *  any particular manager. */
+class ResourceReleaser {
+public:
+    virtual ~ResourceReleaser() {}
+
+    /*! Gives back a single reference to the named resource. */
+    virtual void releaseResource(const std::string &name) = 0;
+
+};
+
+/*! Tracks the references a resource acquired on its own behalf, like the textures used by
+ *  a Material, and releases them all when it goes away. Until then, the resources they
+ *  refer to can't be evicted.
+ * \note Every releaser must outlive the references added to it.
+ * \brief The references held by a single owner. */
+class ResourceReferences {
+public:
+    ResourceReferences() {}
+
+    ~ResourceReferences() { releaseAll(); }
+
+    /*! Records a reference acquired from the given releaser, to be released later. */
+    void add(ResourceReleaser *releaser, const std::string &name) {
+        _references.push_back(Reference(releaser, name));
+    }
+
+    /*! Releases every recorded reference. */
+    void releaseAll() {
+        for (unsigned int i = 0; i < _references.size(); i++) {
+            _references[i].first->releaseResource(_references[i].second);
+        }
+
+        _references.clear();
+    }
+
+    /*! Gets the number of references being held. */
+    unsigned int size() const { return _references.size(); }
+
+private:
+    typedef std::pair<ResourceReleaser*, std::string> Reference;
+
+    // References must only be released once, so there can't be copies.
+    ResourceReferences(const ResourceReferences &other);
+    ResourceReferences& operator=(const ResourceReferences &other);
+
+    std::vector<Reference> _references;
+
+};
+
+#endif
@@ -0,0 +1,109 @@
+/*
+ *  Skeleton.cpp
+ *  Base
+ *
+ *  Created by loch on 5/9/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "Skeleton.h"
+#include "Assertion.h"
+#include "Math3D.h"
+
+void Skeleton::Decompose(const Matrix &matrix, Quaternion &rotation, Vector3 &translation,
+Vector3 &scale) {
+    translation = matrix.getTranslation();
+    scale = Vector3(
+        Vector3(matrix[0], matrix[1], matrix[2]).length(),
+        Vector3(matrix[4], matrix[5], matrix[6]).length(),
+        Vector3(matrix[8], matrix[9], matrix[10]).length());
+
+    // A mirrored basis can't be a rotation, so push the flip into the scale.
+    Vector3 x(matrix[0], matrix[1], matrix[2]), y(matrix[4], matrix[5], matrix[6]);
+    if (x.crossProduct(y).dotProduct(Vector3(matrix[8], matrix[9], matrix[10])) < 0) {
+        scale.x = -scale.x;
+    }
+
+    Matrix normalized(matrix);
+    for (int column = 0; column < 3; column++) {
+        Real inverse = scale[column] != 0 ? 1.0 / scale[column] : 0;
+        for (int row = 0; row < 3; row++) {
+            normalized[column * 4 + row] *= inverse;
+        }
+    }
+
+    rotation = Quaternion(normalized);
+}
+
+void Skeleton::Compose(const Quaternion &rotation, const Vector3 &translation,
+const Vector3 &scale, Matrix &result) {
+    result = Matrix(rotation);
+    for (int row = 0; row < 3; row++) {
+        result[row]     *= scale.x;
+        result[row + 4] *= scale.y;
+        result[row + 8] *= scale.z;
+    }
+
+    result.setTranslation(translation);
+}
+
+Skeleton::Skeleton() {}
+
+Skeleton::Skeleton(const std::vector<MeshCache::Bone> &bones) {
+    for (int i = 0; i < bones.size(); i++) {
+        addBone(bones[i].name, bones[i].parent, bones[i].transform);
+    }
+}
+
+Skeleton::~Skeleton() {}
+
+int Skeleton::addBone(const std::string &name, int parent, const Matrix &transform) {
+    int index = _names.size();
+    if (parent >= index) {
+        THROW(InvalidStateError, "Bone " << name << " was added before its parent.");
+    }
+
+    _names.push_back(name);
+    _parents.push_back(parent);
+
+    _bindPose.resize(index + 1);
+    Decompose(transform, _bindPose.rotations[index], _bindPose.translations[index],
+        _bindPose.scales[index]);
+
+    _bindMatrices.push_back(parent >= 0 ? _bindMatrices[parent] * transform : transform);
+    _inverseBindMatrices.push_back(_bindMatrices[index].getInverse());
+    return index;
+}
+
+int Skeleton::getBoneCount() const {
+    return _names.size();
+}
+
+int Skeleton::findBone(const std::string &name) const {
+    for (int i = 0; i < _names.size(); i++) {
+        if (_names[i] == name) { return i; }
+    }
+
+    return -1;
+}
+
+const std::string &Skeleton::getName(int bone) const {
+    return _names[bone];
+}
+
+int Skeleton::getParent(int bone) const {
+    return _parents[bone];
+}
+
+const int *Skeleton::getParents() const {
+    return _parents.empty() ? NULL : &_parents[0];
+}
+
+const Pose &Skeleton::getBindPose() const {
+    return _bindPose;
+}
+
+const Matrix *Skeleton::getInverseBindMatrices() const {
+    return _inverseBindMatrices.empty() ? NULL : &_inverseBindMatrices[0];
+}
@@ -0,0 +1,104 @@
+/*
+ *  Skeleton.h
+ *  Base
+ *
+ *  Created by loch on 5/9/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _SKELETON_H_
+#define _SKELETON_H_
+#include "Base.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "Quaternion.h"
+#include "MeshCache.h"
+
+/*! The local transform of every bone in a skeleton, relative to each bone's parent. Each
+ *  part of the transform gets its own array, rather than keeping an array of SQTs, so
+ *  sampling and blending walk straight through memory one component at a time. */
+struct Pose {
+    Pose() {}
+    Pose(int boneCount): rotations(boneCount), translations(boneCount), scales(boneCount) {}
+
+    /*! Sets the number of bones, without clearing any that are kept. */
+    void resize(int boneCount) {
+        rotations.resize(boneCount);
+        translations.resize(boneCount);
+        scales.resize(boneCount);
+    }
+
+    int getBoneCount() const { return rotations.size(); }
+
+    std::vector<Quaternion> rotations;
+    std::vector<Vector3> translations;
+    std::vector<Vector3> scales;
+};
+
+/*! Skeleton is the flattened, runtime form of a bone hierarchy. Rather than a tree of
+ *  ModelBones linked by pointers, bones are kept in arrays and refer to their parents by
+ *  index, and every parent comes before its children. A single forward pass over the
+ *  arrays is then enough to take a pose from local space to model space.
+ *
+ *  Alongside the hierarchy, the skeleton keeps the bind pose: the transform of each bone
+ *  when the meshes were bound to it. The inverse of each bone's model space bind matrix
+ *  takes vertices into that bone's space, which is the first half of skinning.
+ * \brief A bone hierarchy laid out for fast animation.
+ * \seealso AnimationClip, Animator */
+class Skeleton {
+public:
+    /*! Splits an affine matrix into a rotation, translation, and scale. Shearing is
+     *  lost, and negative scales come out as a rotation plus a positive scale. */
+    static void Decompose(const Matrix &matrix, Quaternion &rotation, Vector3 &translation,
+                          Vector3 &scale);
+
+    /*! Builds the matrix for a single rotation, translation, and scale. */
+    static void Compose(const Quaternion &rotation, const Vector3 &translation,
+                        const Vector3 &scale, Matrix &result);
+
+public:
+    /*! Creates an empty skeleton. */
+    Skeleton();
+
+    /*! Creates a skeleton matching the bones from a MeshCache, which are already stored
+     *  parents first. */
+    Skeleton(const std::vector<MeshCache::Bone> &bones);
+
+    ~Skeleton();
+
+    /*! Adds a bone with the given bind transform, relative to its parent. The parent must
+     *  already have been added, or be -1 for a root bone.
+     * \return The index of the new bone. */
+    int addBone(const std::string &name, int parent, const Matrix &transform);
+
+    /*! Gets the number of bones in the skeleton. */
+    int getBoneCount() const;
+
+    /*! Gets the index of the first bone with the given name, or -1 if there isn't one. */
+    int findBone(const std::string &name) const;
+
+    const std::string &getName(int bone) const;
+
+    /*! Gets the index of the given bone's parent, or -1 for a root bone. */
+    int getParent(int bone) const;
+
+    /*! Gets the parent of every bone, in order. */
+    const int *getParents() const;
+
+    /*! Gets the local transform of every bone in the bind pose. */
+    const Pose &getBindPose() const;
+
+    /*! Gets the inverse of every bone's model space bind matrix, in order. */
+    const Matrix *getInverseBindMatrices() const;
+
+protected:
+    std::vector<std::string> _names;
+    std::vector<int> _parents;
+    Pose _bindPose;
+    std::vector<Matrix> _bindMatrices;        //!< The model space bind matrix of each bone.
+    std::vector<Matrix> _inverseBindMatrices;
+
+};
+
+#endif
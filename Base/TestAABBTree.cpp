@@ -0,0 +1,183 @@
+/*
+ *  TestAABBTree.cpp
+ *  Base
+ *
+ *  Created by loch on 4/9/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "TestAABBTree.h"
+#include "AABBTree.h"
+#include "Matrix.h"
+#include <algorithm>
+
+void TestAABBTree::RunTests() {
+    TestInsertRemove();
+    TestBalance();
+    TestUpdate();
+    TestQuery();
+    TestLooseQuery();
+}
+
+static AABB3 RandomBox(Real range, Real size) {
+    Vector3 center(
+        (rand() / (Real)RAND_MAX - 0.5) * range,
+        (rand() / (Real)RAND_MAX - 0.5) * range,
+        (rand() / (Real)RAND_MAX - 0.5) * range);
+    Vector3 radius(
+        rand() / (Real)RAND_MAX * size,
+        rand() / (Real)RAND_MAX * size,
+        rand() / (Real)RAND_MAX * size);
+    return AABB3(center, radius);
+}
+
+void TestAABBTree::TestInsertRemove() {
+    AABBTree<int> tree;
+    TASSERT_EQ(tree.getItemCount(), 0);
+    TASSERT_EQ(tree.getHeight(), -1);
+    TASSERT(tree.validate());
+
+    int a = tree.insert(AABB3(Vector3(0, 0, 0), Vector3(1, 1, 1)), 1);
+    TASSERT_EQ(tree.getItemCount(), 1);
+    TASSERT_EQ(tree.getHeight(), 0);
+    TASSERT_EQ(tree.getData(a), 1);
+
+    int b = tree.insert(AABB3(Vector3(5, 0, 0), Vector3(1, 1, 1)), 2);
+    int c = tree.insert(AABB3(Vector3(0, 5, 0), Vector3(1, 1, 1)), 3);
+    TASSERT_EQ(tree.getItemCount(), 3);
+    TASSERT_EQ(tree.getData(b), 2);
+    TASSERT_EQ(tree.getData(c), 3);
+    TASSERT(tree.validate());
+
+    tree.remove(b);
+    TASSERT_EQ(tree.getItemCount(), 2);
+    TASSERT_EQ(tree.getData(a), 1);
+    TASSERT_EQ(tree.getData(c), 3);
+    TASSERT(tree.validate());
+
+    tree.remove(a);
+    tree.remove(c);
+    TASSERT_EQ(tree.getItemCount(), 0);
+    TASSERT_EQ(tree.getHeight(), -1);
+    TASSERT(tree.validate());
+
+    // Freed nodes should be reused.
+    int d = tree.insert(AABB3(Vector3(0, 0, 0), Vector3(1, 1, 1)), 4);
+    TASSERT_EQ(tree.getData(d), 4);
+    TASSERT(d == a || d == b || d == c);
+}
+
+void TestAABBTree::TestBalance() {
+    // Inserting boxes in sorted order would give a linked list without rebalancing.
+    AABBTree<int> tree(0);
+    for (int i = 0; i < 1024; i++) {
+        tree.insert(AABB3(Vector3(i * 2, 0, 0), Vector3(0.5, 0.5, 0.5)), i);
+    }
+
+    TASSERT_EQ(tree.getItemCount(), 1024);
+    TASSERT(tree.getHeight() <= 20);
+    TASSERT(tree.validate());
+}
+
+void TestAABBTree::TestUpdate() {
+    AABBTree<int> tree(1);
+    int a = tree.insert(AABB3(Vector3(0, 0, 0), Vector3(1, 1, 1)), 1);
+    tree.insert(AABB3(Vector3(10, 0, 0), Vector3(1, 1, 1)), 2);
+    TASSERT_EQ(tree.getLooseAABB(a).getRadius(), Vector3(2, 2, 2));
+
+    // Small movements stay within the loose bounds.
+    TASSERT(!tree.update(a, AABB3(Vector3(0.5, 0, 0), Vector3(1, 1, 1))));
+    TASSERT_EQ(tree.getLooseAABB(a).getCenter(), Vector3(0, 0, 0));
+
+    // Larger ones require the leaf to be moved.
+    TASSERT(tree.update(a, AABB3(Vector3(20, 0, 0), Vector3(1, 1, 1))));
+    TASSERT_EQ(tree.getLooseAABB(a).getCenter(), Vector3(20, 0, 0));
+    TASSERT_EQ(tree.getData(a), 1);
+    TASSERT(tree.validate());
+
+    srand(1);
+    std::vector<int> proxies;
+    for (int i = 0; i < 500; i++) {
+        proxies.push_back(tree.insert(RandomBox(100, 2), i));
+    }
+
+    for (int i = 0; i < 2000; i++) {
+        tree.update(proxies[rand() % proxies.size()], RandomBox(100, 2));
+    }
+
+    TASSERT_EQ(tree.getItemCount(), 502);
+    TASSERT(tree.validate());
+}
+
+void TestAABBTree::TestQuery() {
+    Frustum frustum;
+    frustum.setProjectionMatrix(Matrix::Ortho(-10, 10, -10, 10, -10, 10));
+
+    // With no margin, the results should exactly match testing every box individually.
+    srand(2);
+    AABBTree<int> tree(0);
+    std::vector<AABB3> boxes;
+    for (int i = 0; i < 1000; i++) {
+        boxes.push_back(RandomBox(60, 3));
+        tree.insert(boxes.back(), i);
+    }
+
+    std::vector<int> intersecting, contained;
+    tree.query(frustum, intersecting, contained);
+    TASSERT(contained.size() > 0);
+
+    std::vector<int> expected, found;
+    for (int i = 0; i < boxes.size(); i++) {
+        if (frustum.checkAABB(boxes[i])) { expected.push_back(i); }
+    }
+
+    found.insert(found.end(), intersecting.begin(), intersecting.end());
+    found.insert(found.end(), contained.begin(), contained.end());
+    std::sort(found.begin(), found.end());
+    TASSERT_EQ(found.size(), expected.size());
+    TASSERT(found == expected);
+
+    for (int i = 0; i < contained.size(); i++) {
+        TASSERT_EQ(frustum.checkAABB(boxes[contained[i]]), Frustum::COMPLETE_IN);
+    }
+}
+
+void TestAABBTree::TestLooseQuery() {
+    Frustum frustum;
+    frustum.setProjectionMatrix(Matrix::Ortho(-10, 10, -10, 10, -10, 10));
+
+    // Loose leaves may return a few extra items, but should never miss any.
+    srand(3);
+    AABBTree<int> tree(2);
+    std::vector<AABB3> boxes;
+    std::vector<int> proxies;
+    for (int i = 0; i < 1000; i++) {
+        boxes.push_back(RandomBox(60, 3));
+        proxies.push_back(tree.insert(boxes.back(), i));
+    }
+
+    for (int i = 0; i < 1000; i++) {
+        int index = rand() % boxes.size();
+        boxes[index] = RandomBox(60, 3);
+        tree.update(proxies[index], boxes[index]);
+    }
+
+    std::vector<int> intersecting, contained;
+    tree.query(frustum, intersecting, contained);
+
+    std::vector<bool> found(boxes.size(), false);
+    for (int i = 0; i < intersecting.size(); i++) { found[intersecting[i]] = true; }
+    for (int i = 0; i < contained.size(); i++) { found[contained[i]] = true; }
+
+    int missing = 0;
+    for (int i = 0; i < boxes.size(); i++) {
+        if (frustum.checkAABB(boxes[i]) && !found[i]) { missing++; }
+    }
+
+    TASSERT_EQ(missing, 0);
+
+    for (int i = 0; i < contained.size(); i++) {
+        TASSERT_EQ(frustum.checkAABB(boxes[contained[i]]), Frustum::COMPLETE_IN);
+    }
+}
@@ -0,0 +1,28 @@
+/*
+ *  TestAABBTree.h
+ *  Base
+ *
+ *  Created by loch on 4/9/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _TESTAABBTREE_H_
+#define _TESTAABBTREE_H_
+#include "Test.h"
+
+class TestAABBTree : public Test<TestAABBTree> {
+public:
+    TestAABBTree(): Test<TestAABBTree>() {}
+    static void RunTests();
+
+private:
+    static void TestInsertRemove();
+    static void TestBalance();
+    static void TestUpdate();
+    static void TestQuery();
+    static void TestLooseQuery();
+
+};
+
+#endif
@@ -0,0 +1,391 @@
+/*
+ *  TestAnimation.cpp
+ *  Base
+ *
+ *  Created by loch on 5/9/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "TestAnimation.h"
+#include "Animator.h"
+#include "WorkerPool.h"
+#include "Timer.h"
+
+/*! Returns a value in [-range, range]. */
+static Real RandomReal(Real range) {
+    return (rand() / (Real)RAND_MAX * 2 - 1) * range;
+}
+
+static Quaternion RandomRotation() {
+    Vector3 axis(RandomReal(1), RandomReal(1), RandomReal(1) + 2);
+    axis.normalize();
+    return Quaternion::FromAxisAngle(Radian(RandomReal(Math::PI)), axis);
+}
+
+/*! True if the two quaternions are the same rotation, with every component within the
+ *  given tolerance once they're in the same hemisphere. */
+static bool SameRotation(const Quaternion &a, const Quaternion &b, Real tolerance) {
+    Real sign = a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z < 0 ? -1 : 1;
+    for (int i = 0; i < 4; i++) {
+        if (fabs(a.val[i] - b.val[i] * sign) > tolerance) { return false; }
+    }
+
+    return true;
+}
+
+/*! Builds a binary tree of bones, each a unit up from its parent. */
+static Skeleton BuildSkeleton(int boneCount) {
+    Skeleton skeleton;
+    for (int i = 0; i < boneCount; i++) {
+        Matrix transform;
+        transform.setTranslation(0, i > 0 ? 1 : 0, 0);
+        skeleton.addBone("bone" + to_s(i), i > 0 ? (i - 1) / 2 : -1, transform);
+    }
+
+    return skeleton;
+}
+
+/*! Builds a walk-like animation. Every bone swings back and forth, the root slides
+ *  forward at a constant speed, and the first child bobs up and down. */
+static std::vector<Pose> BuildFrames(int boneCount, int frameCount) {
+    std::vector<Pose> frames(frameCount, Pose(boneCount));
+    for (int frame = 0; frame < frameCount; frame++) {
+        Real phase = Math::PI * 2 * frame / (frameCount - 1);
+        Pose &pose = frames[frame];
+        for (int i = 0; i < boneCount; i++) {
+            pose.rotations[i] = Quaternion::FromAxisAngle(
+                Radian(.5 * sin(phase + i * .3)), Vector3(1, 0, 0));
+            pose.translations[i] = Vector3(0, i > 0 ? 1 : 0, 0);
+            pose.scales[i] = Vector3(1, 1, 1);
+        }
+
+        pose.translations[0] = Vector3(0, 0, frame * .05);
+        if (boneCount > 1) {
+            pose.translations[1].y += .05 * sin(phase);
+        }
+    }
+
+    return frames;
+}
+
+void TestAnimation::RunTests() {
+    TestQuantization();
+    TestSkeleton();
+    TestCompression();
+    TestSampling();
+    TestBlend();
+    TestPalette();
+    TestAnimate();
+    TestSpeed();
+}
+
+void TestAnimation::TestQuantization() {
+    unsigned short packed[3];
+    Quaternion result;
+
+    AnimationClip::QuantizeRotation(Quaternion(), packed);
+    AnimationClip::DequantizeRotation(packed, result);
+    TASSERT_EQ(result, Quaternion());
+
+    // The sign of the quaternion doesn't matter, only the rotation.
+    for (int i = 0; i < 10000; i++) {
+        Quaternion rotation = RandomRotation();
+        if (i % 2) {
+            rotation = Quaternion(-rotation.w, -rotation.x, -rotation.y, -rotation.z);
+        }
+
+        AnimationClip::QuantizeRotation(rotation, packed);
+        AnimationClip::DequantizeRotation(packed, result);
+        TASSERT(SameRotation(rotation, result, 5e-5));
+    }
+
+    // Every component gets to be the dropped one.
+    for (int i = 0; i < 4; i++) {
+        Real values[4] = { .1, .2, .3, .4 };
+        values[i] = -.8;
+        Real length = Math::Sqrt(values[0] * values[0] + values[1] * values[1] +
+            values[2] * values[2] + values[3] * values[3]);
+        Quaternion rotation(values[0] / length, values[1] / length, values[2] / length,
+            values[3] / length);
+
+        AnimationClip::QuantizeRotation(rotation, packed);
+        AnimationClip::DequantizeRotation(packed, result);
+        TASSERT(SameRotation(rotation, result, 5e-5));
+    }
+}
+
+void TestAnimation::TestSkeleton() {
+    Skeleton skeleton = BuildSkeleton(7);
+    TASSERT_EQ(skeleton.getBoneCount(), 7);
+    TASSERT_EQ(skeleton.getParent(0), -1);
+    TASSERT_EQ(skeleton.getParent(6), 2);
+    TASSERT_EQ(skeleton.findBone("bone5"), 5);
+    TASSERT_EQ(skeleton.findBone("missing"), -1);
+
+    // Bone 6 is three units up: 6 -> 2 -> 0.
+    Matrix bind = skeleton.getInverseBindMatrices()[6].getInverse();
+    TASSERT_EQ(bind.getTranslation(), Vector3(0, 2, 0));
+    TASSERT_EQ(skeleton.getBindPose().translations[6], Vector3(0, 1, 0));
+
+    // Decompose and compose should round trip any rotation, translation, and scale.
+    for (int i = 0; i < 100; i++) {
+        Quaternion rotation = RandomRotation();
+        Vector3 translation(RandomReal(10), RandomReal(10), RandomReal(10));
+        Vector3 scale(1 + rand() % 3, 1 + rand() % 3, 1 + rand() % 3);
+
+        Matrix composed, scaling;
+        Skeleton::Compose(rotation, translation, scale, composed);
+        scaling.setScale(scale);
+        TASSERT_EQ(composed, Matrix::Affine(rotation, translation) * scaling);
+
+        Quaternion outRotation;
+        Vector3 outTranslation, outScale;
+        Skeleton::Decompose(composed, outRotation, outTranslation, outScale);
+        TASSERT(SameRotation(rotation, outRotation, 1e-5));
+        TASSERT_EQ(outTranslation, translation);
+        TASSERT_EQ(outScale, scale);
+    }
+}
+
+void TestAnimation::TestCompression() {
+    const int bones = 8, frameCount = 61;
+    std::vector<Pose> frames = BuildFrames(bones, frameCount);
+
+    // Hold one bone still, so its rotation only needs to be stored once.
+    for (int i = 0; i < frameCount; i++) {
+        frames[i].rotations[5] = Quaternion();
+    }
+
+    AnimationClip clip("walk", 30, frames);
+    TASSERTS_EQ(clip.getName(), "walk");
+    TASSERT_EQ(clip.getBoneCount(), bones);
+    TASSERT_EQ(clip.getFrameCount(), frameCount);
+    TASSERT_EQ(clip.getDuration(), 2);
+
+    // The root slides in a straight line, so two keys cover it. The bob needs more, and
+    // everything else is constant, needing a single key each.
+    int keys = clip.getKeyCount();
+    TASSERT(keys > 2 + 2 * bones + 2);
+    TASSERT(keys < 2 + 2 * bones + frameCount / 2);
+
+    long long raw = (long long)frameCount * bones * (sizeof(Quaternion) + 2 * sizeof(Vector3));
+    Info("Compressed " << raw << " bytes of animation to " << clip.getByteCount() << ".");
+    TASSERT(clip.getByteCount() * 4 < raw);
+
+    // Every raw frame should come back out, to within the tolerances.
+    Pose pose;
+    for (int i = 0; i < frameCount; i++) {
+        clip.sample(i / 30.0, pose, false);
+        for (int bone = 0; bone < bones; bone++) {
+            TASSERT(SameRotation(pose.rotations[bone], frames[i].rotations[bone], 5e-5));
+            TASSERT(pose.translations[bone].distanceTo(frames[i].translations[bone]) <=
+                AnimationClip::DefaultTolerance + 1e-5);
+            TASSERT_EQ(pose.scales[bone], frames[i].scales[bone]);
+        }
+    }
+}
+
+void TestAnimation::TestSampling() {
+    std::vector<Pose> frames(3, Pose(1));
+    frames[0].rotations[0] = Quaternion();
+    frames[1].rotations[0] = Quaternion::FromAxisAngle(Radian(Math::PI / 2), Vector3(0, 0, 1));
+    frames[2].rotations[0] = Quaternion::FromAxisAngle(Radian(Math::PI), Vector3(0, 0, 1));
+    for (int i = 0; i < 3; i++) {
+        frames[i].translations[0] = Vector3(i * i, 0, 0);
+        frames[i].scales[0] = Vector3(1, 1, 1);
+    }
+
+    AnimationClip clip("turn", 2, frames, 1e-6);
+    TASSERT_EQ(clip.getDuration(), 1);
+
+    // Halfway between the first two frames.
+    Pose pose;
+    clip.sample(.25, pose, false);
+    Quaternion expected = Quaternion::FromAxisAngle(Radian(Math::PI / 4), Vector3(0, 0, 1));
+    TASSERT(SameRotation(pose.rotations[0], expected, 1e-4));
+    TASSERT_EQ(pose.translations[0], Vector3(.5, 0, 0));
+
+    // Clamped outside of the clip.
+    clip.sample(-1, pose, false);
+    TASSERT(SameRotation(pose.rotations[0], frames[0].rotations[0], 5e-5));
+    clip.sample(5, pose, false);
+    TASSERT(SameRotation(pose.rotations[0], frames[2].rotations[0], 5e-5));
+    TASSERT_EQ(pose.translations[0], Vector3(4, 0, 0));
+
+    // Wrapped around when looping, both ways.
+    Pose wrapped;
+    clip.sample(.75, pose, true);
+    clip.sample(2.75, wrapped, true);
+    TASSERT(SameRotation(pose.rotations[0], wrapped.rotations[0], 1e-4));
+    TASSERT_EQ(pose.translations[0], wrapped.translations[0]);
+    clip.sample(-.25, wrapped, true);
+    TASSERT(SameRotation(pose.rotations[0], wrapped.rotations[0], 1e-4));
+
+    // A single frame works for any time.
+    frames.resize(1);
+    AnimationClip still("still", 30, frames);
+    TASSERT_EQ(still.getDuration(), 0);
+    still.sample(12, pose);
+    TASSERT(SameRotation(pose.rotations[0], Quaternion(), 5e-5));
+}
+
+void TestAnimation::TestBlend() {
+    Pose from(2), to(2), result;
+    from.rotations[0] = Quaternion();
+    to.rotations[0] = Quaternion::FromAxisAngle(Radian(Math::PI / 2), Vector3(0, 1, 0));
+
+    // The same rotation, but in the opposite hemisphere, has to blend the short way.
+    Quaternion flipped = Quaternion::FromAxisAngle(Radian(Math::PI / 2), Vector3(0, 1, 0));
+    from.rotations[1] = Quaternion();
+    to.rotations[1] = Quaternion(-flipped.w, -flipped.x, -flipped.y, -flipped.z);
+    for (int i = 0; i < 2; i++) {
+        from.translations[i] = Vector3(0, 0, 0);
+        to.translations[i] = Vector3(2, 4, 6);
+        from.scales[i] = Vector3(1, 1, 1);
+        to.scales[i] = Vector3(3, 3, 3);
+    }
+
+    Animator::Blend(from, to, 0, result);
+    TASSERT(SameRotation(result.rotations[0], from.rotations[0], 1e-6));
+    TASSERT_EQ(result.translations[0], from.translations[0]);
+
+    Animator::Blend(from, to, 1, result);
+    TASSERT(SameRotation(result.rotations[0], to.rotations[0], 1e-6));
+    TASSERT_EQ(result.scales[1], to.scales[1]);
+
+    Animator::Blend(from, to, .5, result);
+    Quaternion halfway = Quaternion::FromAxisAngle(Radian(Math::PI / 4), Vector3(0, 1, 0));
+    TASSERT(SameRotation(result.rotations[0], halfway, 1e-6));
+    TASSERT(SameRotation(result.rotations[1], halfway, 1e-6));
+    TASSERT_EQ(result.translations[1], Vector3(1, 2, 3));
+    TASSERT_EQ(result.scales[0], Vector3(2, 2, 2));
+
+    // Blending in place.
+    Animator::Blend(from, to, .5, from);
+    TASSERT_EQ(from.translations[0], Vector3(1, 2, 3));
+}
+
+void TestAnimation::TestPalette() {
+    Skeleton skeleton = BuildSkeleton(15);
+    std::vector<Matrix> model(15), palette(15);
+
+    // The bind pose doesn't move anything.
+    Animator::LocalToModel(skeleton, skeleton.getBindPose(), &model[0]);
+    Animator::BuildPalette(skeleton, &model[0], &palette[0]);
+    for (int i = 0; i < 15; i++) {
+        TASSERT_EQ(palette[i], Matrix());
+    }
+
+    // Any other pose should match walking the hierarchy.
+    Pose pose = skeleton.getBindPose();
+    for (int i = 0; i < 15; i++) {
+        pose.rotations[i] = RandomRotation();
+    }
+
+    Animator::LocalToModel(skeleton, pose, &model[0]);
+    for (int i = 0; i < 15; i++) {
+        Matrix expected;
+        for (int bone = i; bone >= 0; bone = skeleton.getParent(bone)) {
+            Matrix local;
+            Skeleton::Compose(pose.rotations[bone], pose.translations[bone], pose.scales[bone], local);
+            expected = local * expected;
+        }
+
+        TASSERT_EQ(model[i], expected);
+    }
+
+    // A vertex sitting at a bone's origin in the bind pose follows that bone's origin.
+    Animator::BuildPalette(skeleton, &model[0], &palette[0]);
+    for (int i = 0; i < 15; i++) {
+        Vector3 origin = skeleton.getInverseBindMatrices()[i].getInverse().getTranslation();
+        TASSERT_EQ(palette[i] * origin, model[i].getTranslation());
+    }
+}
+
+void TestAnimation::TestAnimate() {
+    const int bones = 20, characters = 100;
+    Skeleton skeleton = BuildSkeleton(bones);
+    AnimationClip walk("walk", 30, BuildFrames(bones, 31));
+    AnimationClip idle("idle", 30, std::vector<Pose>(1, skeleton.getBindPose()));
+
+    std::vector<Animator::Character> list(characters);
+    std::vector<Matrix> serial(bones * characters), parallel(bones * characters);
+    for (int i = 0; i < characters; i++) {
+        Animator::Character &character = list[i];
+        character.skeleton = &skeleton;
+        character.clip = &walk;
+        character.time = i * .01;
+        character.blendClip = i % 3 ? &idle : NULL;
+        character.blendTime = 0;
+        character.blendWeight = (i % 10) / 10.0;
+        character.loop = true;
+        character.palette = &serial[i * bones];
+    }
+
+    Animator animator;
+    animator.animate(&list[0], characters);
+
+    for (int i = 0; i < characters; i++) {
+        list[i].palette = &parallel[i * bones];
+    }
+
+    WorkerPool pool(3);
+    Animator threaded(&pool);
+    threaded.animate(&list[0], characters);
+    TASSERT(memcmp(&serial[0], &parallel[0], serial.size() * sizeof(Matrix)) == 0);
+
+    // Check one character by hand, too.
+    Pose pose, blend;
+    std::vector<Matrix> expected(bones);
+    walk.sample(list[14].time, pose);
+    idle.sample(0, blend);
+    Animator::Blend(pose, blend, list[14].blendWeight, pose);
+    Animator::LocalToModel(skeleton, pose, &expected[0]);
+    Animator::BuildPalette(skeleton, &expected[0], &expected[0]);
+    for (int i = 0; i < bones; i++) {
+        TASSERT_EQ(parallel[14 * bones + i], expected[i]);
+    }
+}
+
+void TestAnimation::TestSpeed() {
+    const int bones = 60, characters = 1000, passes = 20;
+    Skeleton skeleton = BuildSkeleton(bones);
+    AnimationClip walk("walk", 30, BuildFrames(bones, 61));
+    AnimationClip run("run", 30, BuildFrames(bones, 31));
+
+    std::vector<Animator::Character> list(characters);
+    std::vector<Matrix> palettes(bones * characters);
+    for (int i = 0; i < characters; i++) {
+        Animator::Character &character = list[i];
+        character.skeleton = &skeleton;
+        character.clip = &walk;
+        character.time = i * .013;
+        character.blendClip = i % 2 ? &run : NULL;
+        character.blendTime = i * .007;
+        character.blendWeight = .5;
+        character.loop = true;
+        character.palette = &palettes[i * bones];
+    }
+
+    Animator animator;
+    Timer timer;
+    timer.start();
+    for (int pass = 0; pass < passes; pass++) {
+        animator.animate(&list[0], characters);
+    }
+    timer.stop();
+    Info("Animating " << characters << " characters with " << bones << " bones: " <<
+         timer.mseconds() / (Real)passes << "ms per frame on one thread.");
+
+    int threads = std::max(WorkerPool::GetProcessorCount() - 1, 1);
+    WorkerPool pool(threads);
+    Animator threaded(&pool);
+    timer.start();
+    for (int pass = 0; pass < passes; pass++) {
+        threaded.animate(&list[0], characters);
+    }
+    timer.stop();
+    Info("Animating " << characters << " characters with " << bones << " bones: " <<
+         timer.mseconds() / (Real)passes << "ms per frame on " << threads + 1 << " threads.");
+}
@@ -0,0 +1,31 @@
+/*
+ *  TestAnimation.h
+ *  Base
+ *
+ *  Created by loch on 5/9/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _TESTANIMATION_H_
+#define _TESTANIMATION_H_
+#include "Test.h"
+
+class TestAnimation : public Test<TestAnimation> {
+public:
+    TestAnimation(): Test<TestAnimation>() {}
+    static void RunTests();
+
+private:
+    static void TestQuantization();
+    static void TestSkeleton();
+    static void TestCompression();
+    static void TestSampling();
+    static void TestBlend();
+    static void TestPalette();
+    static void TestAnimate();
+    static void TestSpeed();
+
+};
+
+#endif
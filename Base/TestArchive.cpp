@@ -10,11 +10,47 @@
 #include "TestArchive.h"
 #include <BinaryStream.h>
 #include <FileSystem.h>
+#include <MappedFile.h>
+#include <Timer.h>
+#include <pthread.h>
+
+/*! Shared between the main thread and every StreamLoop. */
+struct StreamState {
+    Archive *archive;
+    std::vector<std::string> paths;
+    std::vector<std::string> expected; //!< The contents of each file, read up front.
+    volatile int mismatches;
+};
+
+/*! Streams every file in the archive, checking each against what was read up front. */
+static void* StreamLoop(void *arg) {
+    StreamState *state = static_cast<StreamState*>(arg);
+    for (int pass = 0; pass < 3; pass++) {
+        for (unsigned int i = 0; i < state->paths.size(); i++) {
+            IOTarget *target = state->archive->openStream(state->paths[i]);
+            std::string result(target ? target->length() : 0, 0);
+            if (!target || target->read(&result[0], result.size()) != (long long)result.size() ||
+                result != state->expected[i]) {
+                __sync_add_and_fetch(&state->mismatches, 1);
+            }
+
+            delete target;
+        }
+    }
+
+    return NULL;
+}
 
 
 void TestArchive::RunTests() {
     TestFromDisk();
     TestFromData();
+    TestIndex();
+    TestDeflated();
+    TestStreaming();
+    TestZip64();
+    TestThroughput();
+    TestConcurrentReads();
 }
 
 void TestStuff(IOTarget *target) {
@@ -49,6 +85,48 @@ void TestStuff(IOTarget *target) {
     delete file;
 }
 
+void TestArchive::TestIndex() {
+    std::list<std::string>* listing;
+    Archive a("test.zip", FileSystem::GetFile("test.zip"));
+    TASSERT_EQ(a.getFileCount(), 98);
+    TASSERT_EQ(a.getDirectoryCount(), 8);
+
+    // Lookups should ignore leading and trailing separators.
+    TASSERT(a.exists("materials/maps/crossfire2/cubemapdefault.vtf"));
+    TASSERT(a.exists("/materials/maps/crossfire2/cubemapdefault.vtf"));
+    TASSERT(a.exists("./materials\\maps\\crossfire2\\cubemapdefault.vtf"));
+    TASSERT(!a.exists("materials/maps/crossfire2/cubemapdefault"));
+    TASSERT(!a.exists("materials/maps/crossfire2"));
+    TASSERT(!a.exists(""));
+    TASSERT(!a.open("materials/maps/crossfire2/missing.vtf"));
+
+    listing = a.listing("materials/maps/crossfire2", false, false);
+    TASSERT(listing);
+    TASSERT_EQ(listing->size(), 28);
+    delete listing;
+
+    listing = a.listing("/materials/maps/crossfire2/", false, true);
+    TASSERT(listing);
+    TASSERT_EQ(listing->size(), 33);
+    TASSERTS_EQ(listing->back(), "materials/maps/crossfire2/vehicle/");
+    delete listing;
+
+    listing = a.listing("materials/maps/crossfire2/metal", true, true);
+    TASSERT(listing);
+    TASSERT_EQ(listing->size(), 49);
+    delete listing;
+
+    listing = a.listing("materials/maps", true, true);
+    TASSERT(listing);
+    TASSERT_EQ(listing->size(), 104);
+    TASSERTS_EQ(listing->back(), "materials/maps/crossfire2/vehicle/");
+    delete listing;
+
+    // Partial directory names should not match.
+    TASSERT(!a.listing("materials/map", true, false));
+    TASSERT(!a.listing("materials/maps/crossfire2/cubemapdefault.vtf", true, false));
+}
+
 void TestArchive::TestFromData() {
     BinaryStream *str = new BinaryStream(FileSystem::GetFile("test.zip"), IOTarget::Read, true);
 
@@ -63,3 +141,182 @@ void TestArchive::TestFromData() {
 void TestArchive::TestFromDisk() {
     TestStuff(FileSystem::GetFile("test.zip"));
 }
+
+void TestArchive::TestDeflated() {
+    Archive stored("test.zip", FileSystem::GetFile("test.zip"));
+    Archive deflated("test_deflate.zip", FileSystem::GetFile("test_deflate.zip"));
+    TASSERT_EQ(deflated.getFileCount(), stored.getFileCount());
+
+    // Every file should inflate to exactly what's in the stored archive.
+    std::list<std::string>* listing = stored.listing();
+    std::list<std::string>::iterator itr;
+    for (itr = listing->begin(); itr != listing->end(); itr++) {
+        DataTarget *lhs = stored.open(*itr);
+        DataTarget *rhs = deflated.open(*itr);
+        TASSERT(lhs && rhs);
+        TASSERT_EQ(lhs->length(), rhs->length());
+
+        std::vector<char> lhsData(lhs->length() + 1), rhsData(rhs->length() + 1);
+        lhs->read(&lhsData[0], lhs->length());
+        rhs->read(&rhsData[0], rhs->length());
+        TASSERT(lhsData == rhsData);
+
+        delete lhs;
+        delete rhs;
+    }
+
+    delete listing;
+}
+
+void TestArchive::TestStreaming() {
+    Archive stored("test.zip", FileSystem::GetFile("test.zip"));
+    Archive deflated("test_deflate.zip", FileSystem::GetFile("test_deflate.zip"));
+    const std::string path = "materials/maps/crossfire2/cubemapdefault.vtf";
+    TASSERT(!deflated.openStream("materials/maps/crossfire2/missing.vtf"));
+
+    DataTarget *expected = stored.open(path);
+    std::vector<char> data(expected->length());
+    expected->read(&data[0], data.size());
+    delete expected;
+
+    IOTarget *targets[2] = { stored.openStream(path), deflated.openStream(path) };
+    for (int i = 0; i < 2; i++) {
+        IOTarget *target = targets[i];
+        TASSERT(target);
+        TASSERT_EQ(target->length(), data.size());
+        TASSERT_EQ(target->peek(), 'V');
+        TASSERT_EQ(target->getc(), 'V');
+        TASSERT_EQ(target->position(), 1);
+
+        // Read the rest in odd sized pieces, to make sure they cross window boundaries.
+        std::vector<char> result(1, 'V');
+        char buffer[1000];
+        long long count;
+        while ((count = target->read(buffer, sizeof(buffer))) > 0) {
+            result.insert(result.end(), buffer, buffer + count);
+        }
+
+        TASSERT(target->atEnd());
+        TASSERT(result == data);
+
+        // Seeking backward and forward should land on the same bytes.
+        TASSERT(target->seek(100, IOTarget::Beginning));
+        TASSERT_EQ(target->getc(), data[100]);
+        TASSERT(target->seek(-10, IOTarget::End));
+        TASSERT_EQ(target->getc(), data[data.size() - 10]);
+        TASSERT(target->seek(5, IOTarget::Beginning));
+        TASSERT_EQ(target->peek(), data[5]);
+        TASSERT(target->seek(2, IOTarget::Current));
+        TASSERT_EQ(target->getc(), data[7]);
+        TASSERT_EQ(target->write(buffer, 1), 0);
+
+        delete target;
+    }
+}
+
+void TestArchive::TestZip64() {
+    Archive a("test_zip64.zip", FileSystem::GetFile("test_zip64.zip"));
+    TASSERT_EQ(a.getFileCount(), 2);
+    TASSERT(a.exists("materials/readme.txt"));
+
+    DataTarget *file = a.open("materials/readme.txt");
+    TASSERT(file);
+    TASSERT_EQ(file->length(), 380);
+    std::vector<char> text(file->length());
+    file->read(&text[0], text.size());
+    TASSERTS_EQ(std::string(&text[0], 19), "ZIP64 test archive\n");
+    delete file;
+
+    file = a.open("materials/maps/raw.bin");
+    TASSERT(file);
+    TASSERT_EQ(file->length(), 1024);
+    file->seek(300);
+    TASSERT_EQ((unsigned char)file->getc(), 300 % 256);
+    delete file;
+}
+
+/*! Reads every file in the given archive the given number of times and returns the rate
+ *  in MB/s. */
+static double MeasureThroughput(Archive &archive, int passes, bool streaming) {
+    std::list<std::string>* listing = archive.listing();
+    std::vector<char> buffer(16 * 1024);
+    long long bytes = 0;
+
+    Timer timer;
+    timer.start();
+    for (int i = 0; i < passes; i++) {
+        std::list<std::string>::iterator itr;
+        for (itr = listing->begin(); itr != listing->end(); itr++) {
+            IOTarget *target = streaming ? archive.openStream(*itr) : (IOTarget*)archive.open(*itr);
+            long long count;
+            while ((count = target->read(&buffer[0], buffer.size())) > 0) {
+                bytes += count;
+            }
+
+            delete target;
+        }
+    }
+
+    timer.stop();
+    delete listing;
+
+    return bytes / (1024.0 * 1024.0) / timer.seconds();
+}
+
+void TestArchive::TestThroughput() {
+    const int passes = 20;
+    Archive stored("test.zip", FileSystem::GetFile("test.zip"));
+    Archive deflated("test_deflate.zip", FileSystem::GetFile("test_deflate.zip"));
+
+    Info("Archive throughput (MB/s of uncompressed data):");
+    Info("  stored,   open:       " << MeasureThroughput(stored, passes, false));
+    Info("  stored,   openStream: " << MeasureThroughput(stored, passes, true));
+    Info("  deflated, open:       " << MeasureThroughput(deflated, passes, false));
+    Info("  deflated, openStream: " << MeasureThroughput(deflated, passes, true));
+
+    Archive storedMapped("test.zip", FileSystem::GetMappedFile("test.zip"));
+    Archive deflatedMapped("test_deflate.zip", FileSystem::GetMappedFile("test_deflate.zip"));
+    Info("  stored,   mapped:     " << MeasureThroughput(storedMapped, passes, false));
+    Info("  deflated, mapped:     " << MeasureThroughput(deflatedMapped, passes, false));
+}
+
+void TestArchive::TestConcurrentReads() {
+    Archive *archives[4] = {
+        new Archive("test.zip", FileSystem::GetFile("test.zip")),
+        new Archive("test_deflate.zip", FileSystem::GetFile("test_deflate.zip")),
+        new Archive("test.zip", FileSystem::GetMappedFile("test.zip")),
+        new Archive("test_deflate.zip", FileSystem::GetMappedFile("test_deflate.zip"))
+    };
+
+    for (int i = 0; i < 4; i++) {
+        StreamState state;
+        state.archive = archives[i];
+        state.mismatches = 0;
+
+        std::list<std::string> *listing = archives[i]->listing("", true, false);
+        TASSERT(listing);
+        state.paths.assign(listing->begin(), listing->end());
+        delete listing;
+
+        for (unsigned int j = 0; j < state.paths.size(); j++) {
+            DataTarget *target = archives[i]->open(state.paths[j]);
+            std::string contents(target->length(), 0);
+            target->read(&contents[0], contents.size());
+            state.expected.push_back(contents);
+            delete target;
+        }
+
+        // Every thread reads every file at once, all sharing the archive's target.
+        pthread_t threads[4];
+        for (int j = 0; j < 4; j++) {
+            pthread_create(&threads[j], NULL, StreamLoop, &state);
+        }
+
+        for (int j = 0; j < 4; j++) {
+            pthread_join(threads[j], NULL);
+        }
+
+        TASSERT_EQ(state.mismatches, 0);
+        delete archives[i];
+    }
+}
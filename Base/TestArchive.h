@@ -19,6 +19,12 @@ public:
 private:
     static void TestFromDisk();
     static void TestFromData();
+    static void TestIndex();
+    static void TestDeflated();
+    static void TestStreaming();
+    static void TestZip64();
+    static void TestThroughput();
+    static void TestConcurrentReads();
 
 };
 
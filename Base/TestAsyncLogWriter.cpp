@@ -0,0 +1,150 @@
+/*
+ *  TestAsyncLogWriter.cpp
+ *  Base
+ *
+ *  Created by loch on 5/4/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "TestAsyncLogWriter.h"
+#include "AsyncLogWriter.h"
+#include "WorkerPool.h"
+#include <sstream>
+
+static const int MessagesPerThread = 2000;
+
+/*! Logs a numbered run of messages, tagged with the piece index. Like LogStream's, each
+ *  message starts a new line. */
+static void LogMessages(void *data, int index) {
+    AsyncLogWriter *writer = static_cast<AsyncLogWriter*>(data);
+    for (int i = 0; i < MessagesPerThread; i++) {
+        std::ostringstream message;
+        message << "\n" << index << " " << i;
+
+        // Spin rather than drop, since this test is about ordering.
+        while (!writer->write(message.str().data(), message.str().size())) {}
+    }
+}
+
+static int EvaluationCount = 0;
+static int CountEvaluation() {
+    return ++EvaluationCount;
+}
+
+void TestAsyncLogWriter::RunTests() {
+    TestManyThreads();
+    TestDropping();
+    TestFiltering();
+    TestLogStream();
+}
+
+void TestAsyncLogWriter::TestManyThreads() {
+    std::ostringstream output;
+    AsyncLogWriter *writer = new AsyncLogWriter(&output, "", 1024);
+
+    // The pool's threads exit before the writer is destroyed, retiring their rings.
+    WorkerPool *pool = new WorkerPool(4);
+    pool->run(LogMessages, writer, 4);
+    delete pool;
+
+    writer->flush();
+    delete writer;
+
+    // Every message should be there exactly once, in order for each thread. Anything
+    // dropped was retried, so the drop report lines just get skipped.
+    std::vector<int> next(4, 0);
+    std::istringstream input(output.str());
+    std::string line;
+    int count = 0;
+    while (std::getline(input, line)) {
+        int thread, index;
+        if (!(std::istringstream(line) >> thread >> index)) { continue; }
+        TASSERT(thread >= 0 && thread < 4);
+        TASSERT_EQ(index, next[thread]);
+        next[thread] = index + 1;
+        count++;
+    }
+
+    TASSERT_EQ(count, 4 * MessagesPerThread);
+}
+
+void TestAsyncLogWriter::TestDropping() {
+    std::ostringstream output;
+    AsyncLogWriter *writer = new AsyncLogWriter(&output, "", 256);
+
+    // Nothing can be bigger than half a ring.
+    std::string big(200, 'x');
+    TASSERT(!writer->write(big.data(), big.size()));
+
+    // A tight loop will easily outrun the writer, but should never block.
+    int written = 0;
+    for (int i = 0; i < 10000; i++) {
+        written += writer->write("\nmessage", 8);
+    }
+
+    unsigned int dropped = writer->getDroppedCount();
+    TASSERT(dropped > 0);
+    TASSERT_EQ(written + dropped, 10001);
+
+    writer->flush();
+    delete writer;
+
+    // The writer reports drops in its output.
+    std::string result = output.str();
+    int messages = 0;
+    for (size_t i = result.find("\nmessage"); i != std::string::npos; i = result.find("\nmessage", i + 1)) {
+        messages++;
+    }
+
+    TASSERT_EQ(messages, written);
+    TASSERT(result.find("log messages dropped.") != std::string::npos);
+}
+
+void TestAsyncLogWriter::TestFiltering() {
+    // Other tests log too, so everything changed here is put back before asserting.
+    LogStream::LogType oldLevel = LogStream::GetLogLevel();
+    LogChannel oldChannels = LogStream::GetActiveChannels();
+
+    LogStream::SetLogLevel(LogStream::WarningMessage);
+    LogStream::EnableLogChannel(LogStream::DefaultChannel);
+
+    // Filtered messages shouldn't even be formatted.
+    EvaluationCount = 0;
+    Info("Filtered: " << CountEvaluation());
+    int levelCount = EvaluationCount;
+
+    LogStream::DisableLogChannel(LogStream::MathChannel);
+    WarnC(LogStream::MathChannel, "Filtered: " << CountEvaluation());
+    int channelCount = EvaluationCount;
+
+    LogStream::SetLogLevel(LogStream::InfoMessage);
+    bool infoEnabled = LogStream::IsEnabled(LogStream::InfoMessage, LogStream::DefaultChannel);
+    bool debugEnabled = LogStream::IsEnabled(LogStream::DebugMessage, LogStream::DefaultChannel);
+    bool mathEnabled = LogStream::IsEnabled(LogStream::ErrorMessage, LogStream::MathChannel);
+
+    LogStream::SetLogLevel(oldLevel);
+    LogStream::DisableAllChannels();
+    LogStream::EnableLogChannel(oldChannels);
+
+    TASSERT_EQ(levelCount, 0);
+    TASSERT_EQ(channelCount, 0);
+    TASSERT(infoEnabled);
+    TASSERT(!debugEnabled);
+    TASSERT(!mathEnabled);
+    TASSERT_EQ(LogStream::GetLogLevel(), oldLevel);
+    TASSERT_EQ(LogStream::GetActiveChannels(), oldChannels);
+}
+
+void TestAsyncLogWriter::TestLogStream() {
+    TASSERT(!LogStream::IsAsync());
+    LogStream::SetAsync(true);
+    TASSERT(LogStream::IsAsync());
+
+    Info("Logged asynchronously.\nOn two lines.");
+    LogStream::Flush();
+    TASSERT_EQ(LogStream::GetDroppedCount(), 0);
+
+    LogStream::SetAsync(false);
+    TASSERT(!LogStream::IsAsync());
+}
@@ -0,0 +1,27 @@
+/*
+ *  TestAsyncLogWriter.h
+ *  Base
+ *
+ *  Created by loch on 5/4/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _TESTASYNCLOGWRITER_H_
+#define _TESTASYNCLOGWRITER_H_
+#include "Test.h"
+
+class TestAsyncLogWriter : public Test<TestAsyncLogWriter> {
+public:
+    TestAsyncLogWriter(): Test<TestAsyncLogWriter>() {}
+    static void RunTests();
+
+private:
+    static void TestManyThreads();
+    static void TestDropping();
+    static void TestFiltering();
+    static void TestLogStream();
+
+};
+
+#endif
@@ -0,0 +1,218 @@
+/*
+ *  TestFastMath.cpp
+ *  Base
+ *
+ *  Created by loch on 5/8/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "TestFastMath.h"
+#include "FastMath.h"
+#include "Math3D.h"
+#include "Timer.h"
+#include <math.h>
+
+typedef Real (*UnaryFunction)(Real);
+typedef Real (*BinaryFunction)(Real, Real);
+
+static Real LibmSin(Real x) { return sin((double)x); }
+static Real LibmAtan2(Real y, Real x) { return atan2((double)y, (double)x); }
+
+/*! Returns the largest error of the given function against libm, over evenly spaced
+ *  samples in [-range, range]. */
+static double MaxError(UnaryFunction function, double (*reference)(double), double range) {
+    const int samples = 200001;
+    double worst = 0;
+    for (int i = 0; i < samples; i++) {
+        Real x = -range + 2 * range * i / (samples - 1);
+        worst = std::max(worst, fabs(function(x) - reference(x)));
+    }
+
+    return worst;
+}
+
+/*! Returns the largest error of the given atan2 against libm, around a circle and along
+ *  both axes. */
+static double MaxAtan2Error(BinaryFunction function) {
+    const int samples = 100000;
+    double worst = 0;
+    for (int i = 0; i < samples; i++) {
+        double angle = -M_PI + 2 * M_PI * i / samples;
+        Real radius = 1 + i % 1000;
+        Real y = radius * sin(angle), x = radius * cos(angle);
+        worst = std::max(worst, fabs(function(y, x) - atan2((double)y, (double)x)));
+    }
+
+    return worst;
+}
+
+void TestFastMath::RunTests() {
+    TestSinCosAccuracy();
+    TestAtan2Accuracy();
+    TestBatch();
+    TestMath();
+    TestSpeed();
+}
+
+void TestFastMath::TestSinCosAccuracy() {
+    double tableSin = MaxError(FastMath::TableSin, sin, 100);
+    double tableCos = MaxError(FastMath::TableCos, cos, 100);
+    double polySin = MaxError(FastMath::PolySin, sin, 100);
+    double polyCos = MaxError(FastMath::PolyCos, cos, 100);
+    double polyLarge = MaxError(FastMath::PolySin, sin, 10000);
+    double libm = MaxError(LibmSin, sin, 100);
+
+    Info("Sin error, table: " << tableSin << " polynomial: " << polySin << " float libm: " << libm);
+    Info("Cos error, table: " << tableCos << " polynomial: " << polyCos);
+    Info("Polynomial sin error to 1e4: " << polyLarge);
+
+    // The bounds documented in FastMath.h.
+    TASSERT(tableSin < 4e-7);
+    TASSERT(tableCos < 4e-7);
+    TASSERT(polySin < 1e-7);
+    TASSERT(polyCos < 1e-7);
+    TASSERT(polyLarge < 1e-7);
+
+    // Table reduction happens in double, so huge arguments are still fine.
+    TASSERT(fabs(FastMath::TableSin(123456.5f) - sin(123456.5)) < 5e-7);
+
+    Real sine, cosine;
+    FastMath::PolySinCos(-2.5f, sine, cosine);
+    TASSERT_EQ(sine, FastMath::PolySin(-2.5f));
+    TASSERT_EQ(cosine, FastMath::PolyCos(-2.5f));
+    FastMath::TableSinCos(7.25f, sine, cosine);
+    TASSERT(fabs(sine - sin(7.25)) < 4e-7);
+    TASSERT(fabs(cosine - cos(7.25)) < 4e-7);
+    TASSERT_EQ(FastMath::PolySin(0), 0);
+    TASSERT_EQ(FastMath::PolyCos(0), 1);
+}
+
+void TestFastMath::TestAtan2Accuracy() {
+    double table = MaxAtan2Error(FastMath::TableAtan2);
+    double poly = MaxAtan2Error(FastMath::PolyAtan2);
+    Info("Atan2 error, table: " << table << " polynomial: " << poly);
+    TASSERT(table < 4e-7);
+    TASSERT(poly < 3e-7);
+
+    // Axes and zeros have to land exactly where libm puts them.
+    BinaryFunction functions[] = { FastMath::TableAtan2, FastMath::PolyAtan2, LibmAtan2 };
+    for (int i = 0; i < 3; i++) {
+        TASSERT_EQ(functions[i](0, 1), 0);
+        TASSERT_EQ(functions[i](1, 0), Math::HALF_PI);
+        TASSERT_EQ(functions[i](-1, 0), -Math::HALF_PI);
+        TASSERT_EQ(functions[i](0, -1), Math::PI);
+        TASSERT_EQ(functions[i](-0.0f, -1), -Math::PI);
+        TASSERT_EQ(functions[i](0, 0), 0);
+        TASSERT_EQ(functions[i](0, -0.0f), Math::PI);
+        TASSERT_EQ(functions[i](-0.0f, -0.0f), -Math::PI);
+        TASSERT_EQ(functions[i](-3, -3), -.75 * Math::PI);
+    }
+}
+
+void TestFastMath::TestBatch() {
+    // An odd count, so both the vector loop and the leftovers are covered.
+    const int count = 1027;
+    std::vector<Real> angles(count), sines(count), cosines(count), y(count), x(count), atans(count);
+    for (int i = 0; i < count; i++) {
+        angles[i] = (i - count / 2) * .173f;
+        y[i] = sin(i * .37) * (i % 7);
+        x[i] = cos(i * .37) * (i % 5);
+    }
+
+    FastMath::SinCos(&angles[0], &sines[0], &cosines[0], count);
+    FastMath::Atan2(&y[0], &x[0], &atans[0], count);
+
+    double worstSin = 0, worstCos = 0, worstAtan = 0;
+    for (int i = 0; i < count; i++) {
+        worstSin = std::max(worstSin, fabs(sines[i] - sin((double)angles[i])));
+        worstCos = std::max(worstCos, fabs(cosines[i] - cos((double)angles[i])));
+        worstAtan = std::max(worstAtan, fabs(atans[i] - atan2((double)y[i], (double)x[i])));
+    }
+
+    TASSERT(worstSin < 1e-7);
+    TASSERT(worstCos < 1e-7);
+    TASSERT(worstAtan < 3e-7);
+
+    // Either output can be skipped, and the input can be overwritten.
+    std::vector<Real> inPlace(angles);
+    FastMath::SinCos(&inPlace[0], NULL, &inPlace[0], count);
+    for (int i = 0; i < count; i++) { TASSERT_EQ(inPlace[i], cosines[i]); }
+}
+
+void TestFastMath::TestMath() {
+    for (int i = -50; i <= 50; i++) {
+        Radian angle(i * .31);
+        Real sine, cosine;
+        Math::SinCos(angle, sine, cosine);
+        TASSERT_EQ(Math::Sin(angle), sin(i * .31));
+        TASSERT_EQ(Math::Cos(angle), cos(i * .31));
+        TASSERT_EQ(sine, Math::Sin(angle));
+        TASSERT_EQ(cosine, Math::Cos(angle));
+        if (fabs(cos(i * .31)) > .1) {
+            TASSERT(Math::eq(Math::Tan(angle), tan(i * .31), .01));
+        }
+
+        TASSERT_EQ(Math::Atan2(i, 7), Radian(atan2(i, 7.0)));
+    }
+}
+
+void TestFastMath::TestSpeed() {
+    const int count = 4096, passes = 200;
+    std::vector<Real> angles(count), sines(count), cosines(count);
+    for (int i = 0; i < count; i++) { angles[i] = (i - count / 2) * .01f; }
+
+    Timer timer;
+    Real sum = 0;
+
+    timer.start();
+    for (int pass = 0; pass < passes; pass++) {
+        for (int i = 0; i < count; i++) { sines[i] = sinf(angles[i]); cosines[i] = cosf(angles[i]); }
+        sum += sines[pass] + cosines[pass];
+    }
+    timer.stop();
+    Info("libm sin and cos: " << timer.nseconds() / (count * passes) << "ns each.");
+
+    timer.start();
+    for (int pass = 0; pass < passes; pass++) {
+        for (int i = 0; i < count; i++) { FastMath::TableSinCos(angles[i], sines[i], cosines[i]); }
+        sum += sines[pass] + cosines[pass];
+    }
+    timer.stop();
+    Info("Table sincos: " << timer.nseconds() / (count * passes) << "ns each.");
+
+    timer.start();
+    for (int pass = 0; pass < passes; pass++) {
+        for (int i = 0; i < count; i++) { FastMath::PolySinCos(angles[i], sines[i], cosines[i]); }
+        sum += sines[pass] + cosines[pass];
+    }
+    timer.stop();
+    Info("Polynomial sincos: " << timer.nseconds() / (count * passes) << "ns each.");
+
+    timer.start();
+    for (int pass = 0; pass < passes; pass++) {
+        FastMath::SinCos(&angles[0], &sines[0], &cosines[0], count);
+        sum += sines[pass] + cosines[pass];
+    }
+    timer.stop();
+    Info("Batch sincos: " << timer.nseconds() / (count * passes) << "ns each.");
+
+    timer.start();
+    for (int pass = 0; pass < passes; pass++) {
+        for (int i = 0; i < count; i++) { sines[i] = atan2f(angles[i], cosines[i]); }
+        sum += sines[pass];
+    }
+    timer.stop();
+    Info("libm atan2: " << timer.nseconds() / (count * passes) << "ns each.");
+
+    timer.start();
+    for (int pass = 0; pass < passes; pass++) {
+        FastMath::Atan2(&angles[0], &cosines[0], &sines[0], count);
+        sum += sines[pass];
+    }
+    timer.stop();
+    Info("Batch atan2: " << timer.nseconds() / (count * passes) << "ns each.");
+
+    // Keep the optimizer from throwing everything away.
+    TASSERT(sum == sum);
+}
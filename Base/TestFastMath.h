@@ -0,0 +1,28 @@
+/*
+ *  TestFastMath.h
+ *  Base
+ *
+ *  Created by loch on 5/8/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _TESTFASTMATH_H_
+#define _TESTFASTMATH_H_
+#include "Test.h"
+
+class TestFastMath : public Test<TestFastMath> {
+public:
+    TestFastMath(): Test<TestFastMath>() {}
+    static void RunTests();
+
+private:
+    static void TestSinCosAccuracy();
+    static void TestAtan2Accuracy();
+    static void TestBatch();
+    static void TestMath();
+    static void TestSpeed();
+
+};
+
+#endif
@@ -0,0 +1,301 @@
+/*
+ *  TestImageCache.cpp
+ *  Base
+ *
+ *  Created by loch on 5/10/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "TestImageCache.h"
+#include "ImageCache.h"
+#include "MHT_Helper.h"
+#include "DataTarget.h"
+#include "Timer.h"
+#include <zlib.h>
+
+/*! Builds a top down RGBA image with smooth gradients, a little noise, and an alpha ramp,
+ *  a lot like a typical terrain texture. */
+static std::vector<unsigned char> MakeImage(unsigned int width, unsigned int height) {
+    std::vector<unsigned char> pixels(width * height * 4);
+    for (unsigned int y = 0; y < height; y++) {
+        for (unsigned int x = 0; x < width; x++) {
+            unsigned char *pixel = &pixels[(y * width + x) * 4];
+            pixel[0] = x * 255 / width;
+            pixel[1] = y * 255 / height;
+            pixel[2] = 128 + rand() % 16;
+            pixel[3] = (x + y) * 255 / (width + height);
+        }
+    }
+
+    return pixels;
+}
+
+/*! Gets the root mean square difference between two RGBA levels, in the given channel. */
+static double RMSError(const ImageCache::Level &a, const ImageCache::Level &b, int channel) {
+    double sum = 0;
+    for (int i = channel; i < a.data.size(); i += 4) {
+        double delta = a.data[i] - b.data[i];
+        sum += delta * delta;
+    }
+
+    return sqrt(sum / (a.data.size() / 4));
+}
+
+/*! Writes the given levels to a buffer, returning the number of bytes written, or -1 if
+ *  writing failed. */
+static long long WriteCache(std::vector<unsigned char> &buffer, long long capacity,
+ImageCache::Format format, const std::vector<ImageCache::Level> &levels) {
+    DataTarget target(new unsigned char[capacity], capacity);
+    if (!ImageCache::Write(&target, format, levels)) {
+        return -1;
+    }
+
+    buffer.assign(target.getData(), target.getData() + target.position());
+    return buffer.size();
+}
+
+void TestImageCache::RunTests() {
+    TestCook();
+    TestCompression();
+    TestRoundTrip();
+    TestCorruption();
+    TestLoadSpeed();
+}
+
+void TestImageCache::TestCook() {
+    // A 5x3 BGR image, with padding at the end of each row.
+    const unsigned int width = 5, height = 3, pitch = 16;
+    unsigned char pixels[pitch * height];
+    for (unsigned int y = 0; y < height; y++) {
+        for (unsigned int x = 0; x < width; x++) {
+            unsigned char *pixel = pixels + y * pitch + x * 3;
+            pixel[0] = 10 * y;          // Blue
+            pixel[1] = 100 + x;         // Green
+            pixel[2] = 200 + x + y;     // Red
+        }
+    }
+
+    std::vector<ImageCache::Level> levels;
+    ImageCache::Cook(pixels, width, height, pitch, 3, true, true, ImageCache::RGBA, levels);
+
+    // Non power of two sizes shrink like OpenGL's: 5x3, 2x1, 1x1.
+    TASSERT_EQ(levels.size(), 3);
+    TASSERT_EQ(levels[1].width, 2);
+    TASSERT_EQ(levels[1].height, 1);
+    TASSERT_EQ(levels[2].width, 1);
+    TASSERT_EQ(levels[2].data.size(), 4);
+
+    // The first row out is the last row in, swizzled to RGBA with opaque alpha.
+    const unsigned char *first = &levels[0].data[0];
+    TASSERT_EQ(first[0], 202);
+    TASSERT_EQ(first[1], 100);
+    TASSERT_EQ(first[2], 20);
+    TASSERT_EQ(first[3], 255);
+    TASSERT_EQ(levels[0].data[(2 * width + 4) * 4], 204);
+
+    // Each pixel of the next level averages a 2x2 block: rows 0 and 1, columns 0 and 1.
+    TASSERT_EQ(levels[1].data[0], (202 + 203 + 201 + 202 + 2) / 4);
+    TASSERT_EQ(levels[1].data[1], (100 + 101 + 100 + 101 + 2) / 4);
+
+    // A single pixel image is already a complete chain.
+    ImageCache::Cook(pixels, 1, 1, 3, 3, false, false, ImageCache::RGBA, levels);
+    TASSERT_EQ(levels.size(), 1);
+    TASSERT_EQ(levels[0].data[0], 0);
+    TASSERT_EQ(levels[0].data[2], 200);
+
+    // Compressed chains go all the way down, too, with partial blocks padded out.
+    ImageCache::Cook(pixels, width, height, pitch, 3, true, true, ImageCache::DXT1, levels);
+    TASSERT_EQ(levels.size(), 3);
+    TASSERT_EQ(levels[0].data.size(), 2 * 1 * 8);
+    TASSERT_EQ(levels[2].data.size(), 8);
+}
+
+void TestImageCache::TestCompression() {
+    const unsigned int width = 64, height = 64;
+    std::vector<unsigned char> pixels = MakeImage(width, height);
+
+    ImageCache::Level source;
+    source.width = width;
+    source.height = height;
+    source.data = pixels;
+
+    ImageCache::Level compressed, decompressed;
+    ImageCache::Compress(source, ImageCache::DXT1, compressed);
+    TASSERT_EQ(compressed.data.size(), width * height / 2);
+    ImageCache::Decompress(compressed, ImageCache::DXT1, decompressed);
+
+    double red = RMSError(source, decompressed, 0), green = RMSError(source, decompressed, 1);
+    double blue = RMSError(source, decompressed, 2);
+    Info("DXT1 RMS error: " << red << ", " << green << ", " << blue);
+    TASSERT(red < 6 && green < 6 && blue < 6);
+
+    ImageCache::Compress(source, ImageCache::DXT5, compressed);
+    TASSERT_EQ(compressed.data.size(), width * height);
+    ImageCache::Decompress(compressed, ImageCache::DXT5, decompressed);
+    double alpha = RMSError(source, decompressed, 3);
+    Info("DXT5 alpha RMS error: " << alpha);
+    TASSERT(alpha < 2);
+    TASSERT(RMSError(source, decompressed, 1) < 6);
+
+    // A solid block of a color 5:6:5 can represent comes back exactly.
+    for (int i = 0; i < 16 * 4; i += 4) {
+        source.data[i] = 255; source.data[i + 1] = 0; source.data[i + 2] = 255; source.data[i + 3] = 77;
+    }
+
+    source.width = source.height = 4;
+    source.data.resize(16 * 4);
+    ImageCache::Compress(source, ImageCache::DXT5, compressed);
+    ImageCache::Decompress(compressed, ImageCache::DXT5, decompressed);
+    TASSERT(decompressed.data == source.data);
+
+    // Sizes that aren't a multiple of the block size only keep the pixels inside.
+    source.width = 3;
+    source.height = 2;
+    source.data.resize(3 * 2 * 4);
+    ImageCache::Compress(source, ImageCache::DXT1, compressed);
+    TASSERT_EQ(compressed.data.size(), 8);
+    ImageCache::Decompress(compressed, ImageCache::DXT1, decompressed);
+    TASSERT_EQ(decompressed.data.size(), 3 * 2 * 4);
+    TASSERT_EQ(decompressed.data[0], 255);
+    TASSERT_EQ(decompressed.data[3], 255);
+}
+
+void TestImageCache::TestRoundTrip() {
+    const unsigned int width = 40, height = 24;
+    std::vector<unsigned char> pixels = MakeImage(width, height);
+
+    ImageCache::Format formats[] = { ImageCache::RGBA, ImageCache::DXT1, ImageCache::DXT5 };
+    for (int f = 0; f < 3; f++) {
+        std::vector<ImageCache::Level> levels;
+        ImageCache::Cook(&pixels[0], width, height, width * 4, 4, false, true, formats[f], levels);
+        TASSERT_EQ(levels.size(), 6);
+
+        std::vector<unsigned char> buffer;
+        long long length = WriteCache(buffer, 64 * 1024, formats[f], levels);
+        TASSERT(length > sizeof(MHT_Header));
+        TASSERT(ImageCache::IsImageCache(&buffer[0], length));
+
+        ImageCache cache;
+        TASSERT(cache.read(&buffer[0], length));
+        TASSERT_EQ(cache.getFormat(), formats[f]);
+        TASSERT_EQ(cache.getWidth(), width);
+        TASSERT_EQ(cache.getHeight(), height);
+        TASSERT_EQ(cache.getLevelCount(), levels.size());
+
+        long long bytes = 0;
+        for (int i = 0; i < levels.size(); i++) {
+            const ImageCache::LevelView &level = cache.getLevel(i);
+            TASSERT_EQ(level.width, levels[i].width);
+            TASSERT_EQ(level.height, levels[i].height);
+            TASSERT_EQ(level.size, levels[i].data.size());
+            TASSERT(memcmp(level.data, &levels[i].data[0], level.size) == 0);
+            TASSERT_EQ((level.data - &buffer[0]) % MHT_LevelAlignment, 0);
+            bytes += level.size;
+        }
+
+        TASSERT_EQ(cache.getPixelBytes(), bytes);
+
+        // Running out of room while writing should fail cleanly.
+        std::vector<unsigned char> small;
+        TASSERT_EQ(WriteCache(small, length - 1, formats[f], levels), -1);
+    }
+
+    // Levels have to make up a proper chain.
+    std::vector<ImageCache::Level> levels;
+    ImageCache::Cook(&pixels[0], width, height, width * 4, 4, false, false, ImageCache::RGBA, levels);
+    std::vector<unsigned char> buffer;
+    TASSERT_EQ(WriteCache(buffer, 64 * 1024, ImageCache::DXT1, levels), -1);
+    levels[2].width++;
+    TASSERT_EQ(WriteCache(buffer, 64 * 1024, ImageCache::RGBA, levels), -1);
+}
+
+void TestImageCache::TestCorruption() {
+    std::vector<unsigned char> pixels = MakeImage(16, 16);
+    std::vector<ImageCache::Level> levels;
+    ImageCache::Cook(&pixels[0], 16, 16, 64, 4, false, false, ImageCache::DXT5, levels);
+
+    std::vector<unsigned char> buffer;
+    long long length = WriteCache(buffer, 64 * 1024, ImageCache::DXT5, levels);
+    TASSERT(length > 0);
+
+    ImageCache cache;
+    TASSERT(cache.read(&buffer[0], length));
+
+    // Anything cut off should be caught.
+    TASSERT(!cache.read(&buffer[0], length - 1));
+    TASSERT(!cache.read(&buffer[0], sizeof(MHT_Header) - 1));
+
+    MHT_Header *header = (MHT_Header*)&buffer[0];
+    header->version++;
+    TASSERT(!cache.read(&buffer[0], length));
+    header->version--;
+
+    header->format = 7;
+    TASSERT(!cache.read(&buffer[0], length));
+    header->format = MHT_DXT5;
+
+    header->signature = 0;
+    TASSERT(!ImageCache::IsImageCache(&buffer[0], length));
+    TASSERT(!cache.read(&buffer[0], length));
+    header->signature = MHT_Signature;
+
+    MHT_Level *level = (MHT_Level*)&buffer[header->levelOffset];
+    level[1].size *= 2;
+    TASSERT(!cache.read(&buffer[0], length));
+    level[1].size /= 2;
+
+    level[2].offset = length;
+    TASSERT(!cache.read(&buffer[0], length));
+    TASSERT_EQ(cache.getLevelCount(), 0);
+    level[2].offset = level[1].offset + level[1].size;
+
+    header->levelCount = 1000;
+    TASSERT(!cache.read(&buffer[0], length));
+    header->levelCount = levels.size();
+
+    TASSERT(cache.read(&buffer[0], length));
+}
+
+void TestImageCache::TestLoadSpeed() {
+    // The runtime cost of a loose image is decoding it, flipping it, and building its
+    // mipmaps. zlib stands in for the PNG decoder, which is mostly inflate anyway.
+    const unsigned int width = 512, height = 512, passes = 10;
+    std::vector<unsigned char> pixels = MakeImage(width, height);
+    uLongf packedSize = compressBound(pixels.size());
+    std::vector<unsigned char> packed(packedSize);
+    TASSERT_EQ(compress2(&packed[0], &packedSize, &pixels[0], pixels.size(), 6), Z_OK);
+
+    std::vector<ImageCache::Level> levels;
+    std::vector<unsigned char> decoded(pixels.size());
+    Timer timer;
+    timer.start();
+    for (int i = 0; i < passes; i++) {
+        uLongf decodedSize = decoded.size();
+        uncompress(&decoded[0], &decodedSize, &packed[0], packedSize);
+        ImageCache::Cook(&decoded[0], width, height, width * 4, 4, false, true, ImageCache::RGBA, levels);
+    }
+    timer.stop();
+    double loose = timer.mseconds() / (double)passes;
+
+    // A cooked image only needs its table checked and each level copied to the card.
+    std::vector<unsigned char> buffer;
+    long long length = WriteCache(buffer, 2 * 1024 * 1024, ImageCache::RGBA, levels);
+    TASSERT(length > 0);
+
+    ImageCache cache;
+    std::vector<unsigned char> staging(pixels.size());
+    timer.start();
+    for (int i = 0; i < passes; i++) {
+        cache.read(&buffer[0], length);
+        for (int j = 0; j < cache.getLevelCount(); j++) {
+            memcpy(&staging[0], cache.getLevel(j).data, cache.getLevel(j).size);
+        }
+    }
+    timer.stop();
+    double cooked = timer.mseconds() / (double)passes;
+
+    Info("512x512 texture load, decoded and mipmapped: " << loose << "ms, cooked: " <<
+         cooked << "ms.");
+    TASSERT(cooked < loose);
+}
@@ -0,0 +1,28 @@
+/*
+ *  TestImageCache.h
+ *  Base
+ *
+ *  Created by loch on 5/10/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _TESTIMAGECACHE_H_
+#define _TESTIMAGECACHE_H_
+#include "Test.h"
+
+class TestImageCache : public Test<TestImageCache> {
+public:
+    TestImageCache(): Test<TestImageCache>() {}
+    static void RunTests();
+
+private:
+    static void TestCook();
+    static void TestCompression();
+    static void TestRoundTrip();
+    static void TestCorruption();
+    static void TestLoadSpeed();
+
+};
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ *  TestMappedFile.cpp
+ *  Base
+ *
+ *  Created by loch on 4/24/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "TestMappedFile.h"
+#include <MappedFile.h>
+#include <DataTarget.h>
+#include <FileSystem.h>
+#include <Archive.h>
+
+void TestMappedFile::RunTests() {
+    TestRead();
+    TestSeek();
+    TestMappedArchive();
+}
+
+void TestMappedFile::TestRead() {
+    MappedFile *file = FileSystem::GetMappedFile("testFile");
+    TASSERT(file->isOpen());
+    TASSERT_EQ(file->length(), 12);
+    TASSERT(file->getData());
+    TASSERT_EQ(file->getData()[3], 'd');
+    TASSERT(file->advise(MappedFile::Sequential));
+
+    char buffer[16];
+    TASSERT_EQ(file->peek(), 'a');
+    TASSERT_EQ(file->getc(), 'a');
+    TASSERT_EQ(file->read(buffer, 4), 4);
+    TASSERT(memcmp(buffer, "bcde", 4) == 0);
+    TASSERT_EQ(file->read(buffer, sizeof(buffer)), 7);
+    TASSERT(file->atEnd());
+    TASSERT_EQ(file->read(buffer, sizeof(buffer)), 0);
+    TASSERT_EQ(file->write(buffer, 1), 0);
+
+    // Mapped files are read only.
+    file->close();
+    TASSERT(!file->isOpen());
+    TASSERT(!file->getData());
+    TASSERT(!file->open(IOTarget::ReadWrite));
+    TASSERT(file->open(IOTarget::Read));
+    TASSERT_EQ(file->getc(), 'a');
+    delete file;
+}
+
+void TestMappedFile::TestSeek() {
+    MappedFile *file = FileSystem::GetMappedFile("testFile");
+    TASSERT(file->seek(5, IOTarget::Beginning));
+    TASSERT_EQ(file->getc(), 'f');
+    TASSERT(file->seek(-2, IOTarget::End));
+    TASSERT_EQ(file->getc(), 'k');
+    TASSERT(file->seek(-3, IOTarget::Current));
+    TASSERT_EQ(file->position(), 8);
+    TASSERT_EQ(file->bytesLeft(), 4);
+    delete file;
+}
+
+void TestMappedFile::TestMappedArchive() {
+    Archive a("test.zip", FileSystem::GetMappedFile("test.zip"));
+    TASSERT(a.isZeroCopy());
+    TASSERT_EQ(a.getFileCount(), 98);
+
+    // Stored files should come back as views, with the same contents as a normal read.
+    Archive b("test.zip", FileSystem::GetFile("test.zip"));
+    TASSERT(!b.isZeroCopy());
+
+    std::list<std::string>* listing = a.listing();
+    std::list<std::string>::iterator itr;
+    for (itr = listing->begin(); itr != listing->end(); itr++) {
+        DataTarget *view = a.open(*itr);
+        DataTarget *copy = b.open(*itr);
+        TASSERT(view && copy);
+        TASSERT(view->isView());
+        TASSERT(!copy->isView());
+        TASSERT_EQ(view->length(), copy->length());
+        TASSERT(memcmp(view->getData(), copy->getData(), view->length()) == 0);
+        TASSERT_EQ(view->write("x", 1), 0);
+        delete view;
+        delete copy;
+    }
+
+    delete listing;
+
+    // Deflated files still have to be inflated into their own memory.
+    Archive c("test_deflate.zip", FileSystem::GetMappedFile("test_deflate.zip"));
+    DataTarget *file = c.open("materials/maps/crossfire2/cubemapdefault.vtf");
+    TASSERT(file);
+    TASSERT(!file->isView());
+    TASSERT_EQ(file->getc(), 'V');
+    delete file;
+
+    IOTarget *stream = c.openStream("materials/maps/crossfire2/cubemapdefault.vtf");
+    TASSERT(stream);
+    TASSERT_EQ(stream->getc(), 'V');
+    delete stream;
+    TASSERT(c.exists("materials/maps/crossfire2/cubemapdefault.vtf"));
+}
@@ -0,0 +1,26 @@
+/*
+ *  TestMappedFile.h
+ *  Base
+ *
+ *  Created by loch on 4/24/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _TESTMAPPEDFILE_H_
+#define _TESTMAPPEDFILE_H_
+#include "Test.h"
+
+class TestMappedFile : public Test<TestMappedFile> {
+public:
+    TestMappedFile(): Test<TestMappedFile>() {}
+    static void RunTests();
+
+private:
+    static void TestRead();
+    static void TestSeek();
+    static void TestMappedArchive();
+
+};
+
+#endif
@@ -11,6 +11,40 @@
 
 #include "Quaternion.h"
 #include "Matrix.h"
+#include "Timer.h"
+
+/*! Returns a value in [-range, range]. */
+static Real RandomReal(Real range) {
+    return (rand() / (Real)RAND_MAX * 2 - 1) * range;
+}
+
+/*! Builds a random rotation, scale, and translation. */
+static Matrix RandomAffine() {
+    Quaternion q(RandomReal(1), RandomReal(1), RandomReal(1), RandomReal(1));
+    Real length = Math::Sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+    Quaternion unit(q.w / length, q.x / length, q.y / length, q.z / length);
+
+    Matrix scale;
+    scale.setScale(1 + rand() % 3, 1 + rand() % 3, 1 + rand() % 3);
+    Matrix m = Matrix::Affine(unit, Vector3(RandomReal(50), RandomReal(50), RandomReal(50)));
+    return m * scale;
+}
+
+/*! The textbook row by column product, to check the optimized one against. */
+static Matrix ReferenceMultiply(const Matrix &a, const Matrix &b) {
+    Matrix result;
+    for (int row = 0; row < 4; row++) {
+        for (int col = 0; col < 4; col++) {
+            Real sum = 0;
+            for (int i = 0; i < 4; i++) {
+                sum += a(row, i) * b(i, col);
+            }
+            result(row, col) = sum;
+        }
+    }
+
+    return result;
+}
 
 void TestMatrix::RunTests() {
     TestRotation();
@@ -23,6 +57,149 @@ void TestMatrix::RunTests() {
     TestAxisAngleConversions();
     TestQuaternionConversions();
     TestInvertMatrix();
+    TestKernels();
+    TestBatch();
+    TestSpeed();
+}
+
+void TestMatrix::TestKernels() {
+    srand(1234);
+    for (int i = 0; i < 100; i++) {
+        Matrix a = RandomAffine(), b = RandomAffine();
+        Matrix product = ReferenceMultiply(a, b);
+        TASSERT_EQ(a * b, product);
+
+        Matrix pre(b), post(a);
+        pre.preMultiply(a);
+        post.postMultiply(b);
+        TASSERT_EQ(pre, product);
+        TASSERT_EQ(post, product);
+
+        // Multiplying a matrix by itself in place has to work, too.
+        Matrix square(a);
+        square.postMultiply(square);
+        TASSERT_EQ(square, ReferenceMultiply(a, a));
+
+        TASSERT(a.isAffine());
+        TASSERT_EQ(a.getAffineInverse() * a, Matrix());
+        TASSERT_EQ(a * a.getInverse(), Matrix());
+
+        Vector4 v(RandomReal(10), RandomReal(10), RandomReal(10), 1);
+        Vector4 expected;
+        for (int row = 0; row < 4; row++) {
+            expected[row] = a(row, 0) * v[0] + a(row, 1) * v[1] + a(row, 2) * v[2] + a(row, 3) * v[3];
+        }
+
+        TASSERT_EQ(a * v, expected);
+        TASSERT_EQ(a * Vector3(v[0], v[1], v[2]), Vector3(expected[0], expected[1], expected[2]));
+    }
+
+    // Projections aren't affine, and need the general inverse.
+    Matrix projection = Matrix::Perspective(1.5, Radian(1), 1, 100) * RandomAffine();
+    TASSERT(!projection.isAffine());
+    TASSERT_EQ(projection * projection.getInverse(), Matrix());
+
+    // Points transformed by a projection are divided by w.
+    Vector4 clip = projection * Vector4(1, 2, 3, 1);
+    Vector3 point = projection * Vector3(1, 2, 3);
+    TASSERT_EQ(point, Vector3(clip[0] / clip[3], clip[1] / clip[3], clip[2] / clip[3]));
+}
+
+void TestMatrix::TestBatch() {
+    srand(4321);
+    const int count = 37;
+    std::vector<Matrix> lhs, rhs, results(count);
+    std::vector<Vector3> points, transformed(count);
+    std::vector<AABB3> bounds, transformedBounds(count);
+    for (int i = 0; i < count; i++) {
+        lhs.push_back(RandomAffine());
+        rhs.push_back(RandomAffine());
+        points.push_back(Vector3(RandomReal(10), RandomReal(10), RandomReal(10)));
+        bounds.push_back(AABB3(points.back(), Vector3(1 + rand() % 4, 1 + rand() % 4, 1 + rand() % 4)));
+    }
+
+    Matrix::Multiply(lhs[0], &rhs[0], &results[0], count);
+    for (int i = 0; i < count; i++) { TASSERT_EQ(results[i], lhs[0] * rhs[i]); }
+
+    Matrix::Multiply(&lhs[0], &rhs[0], &results[0], count);
+    for (int i = 0; i < count; i++) { TASSERT_EQ(results[i], lhs[i] * rhs[i]); }
+
+    // Results can overwrite the inputs.
+    results = rhs;
+    Matrix::Multiply(lhs[0], &results[0], &results[0], count);
+    for (int i = 0; i < count; i++) { TASSERT_EQ(results[i], lhs[0] * rhs[i]); }
+
+    Matrix::TransformPoints(lhs[1], &points[0], &transformed[0], count);
+    for (int i = 0; i < count; i++) { TASSERT_EQ(transformed[i], lhs[1] * points[i]); }
+
+    Matrix projection = Matrix::Perspective(1.5, Radian(1), 1, 100);
+    Matrix::TransformPoints(projection, &points[0], &transformed[0], count);
+    for (int i = 0; i < count; i++) { TASSERT_EQ(transformed[i], projection * points[i]); }
+
+    // The transformed bounds must hold every transformed corner, and touch the extremes.
+    Matrix::TransformBounds(lhs[2], &bounds[0], &transformedBounds[0], count);
+    for (int i = 0; i < count; i++) {
+        Vector3 min = bounds[i].getMin(), max = bounds[i].getMax();
+        Vector3 low(1e30, 1e30, 1e30), high(-1e30, -1e30, -1e30);
+        for (int corner = 0; corner < 8; corner++) {
+            Vector3 p = lhs[2] * Vector3(corner & 1 ? max[0] : min[0],
+                                         corner & 2 ? max[1] : min[1],
+                                         corner & 4 ? max[2] : min[2]);
+            low = low.getMinimum(p);
+            high = high.getMaximum(p);
+        }
+
+        TASSERT_EQ(transformedBounds[i].getMin(), low);
+        TASSERT_EQ(transformedBounds[i].getMax(), high);
+    }
+}
+
+void TestMatrix::TestSpeed() {
+    const int count = 4096, passes = 100;
+    std::vector<Matrix> matrices, results(count);
+    std::vector<Vector3> points, transformed(count);
+    for (int i = 0; i < count; i++) {
+        matrices.push_back(RandomAffine());
+        points.push_back(Vector3(RandomReal(10), RandomReal(10), RandomReal(10)));
+    }
+
+    Matrix view = RandomAffine();
+    Timer timer;
+
+    timer.start();
+    for (int pass = 0; pass < passes; pass++) {
+        for (int i = 0; i < count; i++) {
+            results[i] = view * matrices[i];
+        }
+    }
+    timer.stop();
+    Info("Matrix multiply: " << timer.nseconds() / (count * passes) << "ns each.");
+
+    timer.start();
+    for (int pass = 0; pass < passes; pass++) {
+        Matrix::Multiply(view, &matrices[0], &results[0], count);
+    }
+    timer.stop();
+    Info("Batch matrix multiply: " << timer.nseconds() / (count * passes) << "ns each.");
+
+    timer.start();
+    for (int pass = 0; pass < passes; pass++) {
+        for (int i = 0; i < count; i++) {
+            results[i] = matrices[i].getInverse();
+        }
+    }
+    timer.stop();
+    Info("Matrix inverse: " << timer.nseconds() / (count * passes) << "ns each.");
+
+    timer.start();
+    for (int pass = 0; pass < passes; pass++) {
+        Matrix::TransformPoints(view, &points[0], &transformed[0], count);
+    }
+    timer.stop();
+    Info("Batch point transform: " << timer.nseconds() / (count * passes) << "ns each.");
+
+    // Keep the optimizer from throwing everything away.
+    TASSERT_EQ(results[0], matrices[0].getInverse());
 }
 
 void TestMatrix::TestInvertMatrix() {
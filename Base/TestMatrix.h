@@ -30,6 +30,10 @@ private:
     static void TestQuaternionConversions();
 
     static void TestInvertMatrix();
+
+    static void TestKernels();
+    static void TestBatch();
+    static void TestSpeed();
 };
 
 #endif
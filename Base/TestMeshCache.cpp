@@ -0,0 +1,230 @@
+/*
+ *  TestMeshCache.cpp
+ *  Base
+ *
+ *  Created by loch on 4/28/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "TestMeshCache.h"
+#include "MeshCache.h"
+#include "MHM_Helper.h"
+#include "DataTarget.h"
+#include "Timer.h"
+
+/*! Builds a mesh with a simple triangle fan over the given number of vertices. */
+static MeshCache::Mesh MakeMesh(const std::string &name, int vertexCount, bool normals, bool texCoords) {
+    MeshCache::Mesh mesh;
+    mesh.name = name;
+    mesh.material = -1;
+    mesh.bone = -1;
+    for (int i = 0; i < vertexCount; i++) {
+        mesh.positions.push_back(Vector3(i, i * 2, i * 3));
+        if (normals)   { mesh.normals.push_back(Vector3(0, 0, 1)); }
+        if (texCoords) { mesh.texCoords.push_back(Vector2(i, -i)); }
+    }
+
+    for (int i = 1; i + 1 < vertexCount; i++) {
+        mesh.indices.push_back(0);
+        mesh.indices.push_back(i);
+        mesh.indices.push_back(i + 1);
+    }
+
+    mesh.bounds = AABB3::FindBounds(&mesh.positions[0], mesh.positions.size());
+    return mesh;
+}
+
+/*! Writes the given data to a buffer of the given capacity, returning the number of bytes
+ *  written, or -1 if writing failed. */
+static long long WriteCache(std::vector<unsigned char> &buffer, long long capacity,
+const std::vector<MeshCache::Bone> &bones, const std::vector<MeshCache::Material> &materials,
+const std::vector<MeshCache::Mesh> &meshes) {
+    DataTarget target(new unsigned char[capacity], capacity);
+    if (!MeshCache::Write(&target, bones, materials, meshes)) {
+        return -1;
+    }
+
+    buffer.assign(target.getData(), target.getData() + target.position());
+    return buffer.size();
+}
+
+void TestMeshCache::RunTests() {
+    TestRoundTrip();
+    TestIndexWidth();
+    TestCorruption();
+    TestReadSpeed();
+}
+
+void TestMeshCache::TestRoundTrip() {
+    std::vector<MeshCache::Bone> bones(2);
+    bones[0].name = "root";
+    bones[0].parent = -1;
+    bones[1].name = "arm";
+    bones[1].parent = 0;
+    bones[1].transform.setTranslation(Vector3(1, 2, 3));
+
+    std::vector<MeshCache::Material> materials(1);
+    materials[0].name = "skin";
+    materials[0].texture = "skin.png";
+    materials[0].ambient = Vector4(.1, .2, .3, 1);
+    materials[0].diffuse = Vector4(.4, .5, .6, 1);
+    materials[0].lighting = true;
+
+    std::vector<MeshCache::Mesh> meshes;
+    meshes.push_back(MakeMesh("body", 5, true, true));
+    meshes.push_back(MakeMesh("points", 3, false, false));
+    meshes[0].material = 0;
+    meshes[0].bone = 1;
+    meshes[1].indices.clear();
+
+    std::vector<unsigned char> buffer;
+    long long length = WriteCache(buffer, 64 * 1024, bones, materials, meshes);
+    TASSERT(length > sizeof(MHM_Header));
+    TASSERT(MeshCache::IsMeshCache(&buffer[0], length));
+
+    MeshCache cache;
+    TASSERT(cache.read(&buffer[0], length));
+    TASSERT_EQ(cache.getBoneCount(), 2);
+    TASSERTS_EQ(cache.getBone(1).name, "arm");
+    TASSERT_EQ(cache.getBone(1).parent, 0);
+    TASSERT_EQ(cache.getBone(1).transform, bones[1].transform);
+
+    TASSERT_EQ(cache.getMaterialCount(), 1);
+    TASSERTS_EQ(cache.getMaterial(0).name, "skin");
+    TASSERTS_EQ(cache.getMaterial(0).texture, "skin.png");
+    TASSERT_EQ(cache.getMaterial(0).diffuse, materials[0].diffuse);
+    TASSERT(cache.getMaterial(0).lighting);
+
+    TASSERT_EQ(cache.getMeshCount(), 2);
+    const MeshCache::MeshView &body = cache.getMesh(0);
+    TASSERTS_EQ(body.name, "body");
+    TASSERT_EQ(body.material, 0);
+    TASSERT_EQ(body.bone, 1);
+    TASSERT_EQ(body.vertexCount, 5);
+    TASSERT_EQ(body.indexCount, 9);
+    TASSERT_EQ(body.bounds.getMax(), meshes[0].bounds.getMax());
+    TASSERT(memcmp(body.positions, &meshes[0].positions[0], 5 * sizeof(Vector3)) == 0);
+    TASSERT(memcmp(body.normals, &meshes[0].normals[0], 5 * sizeof(Vector3)) == 0);
+    TASSERT(memcmp(body.texCoords, &meshes[0].texCoords[0], 5 * sizeof(Vector2)) == 0);
+    TASSERT_EQ(((const unsigned short*)body.indices)[8], 4);
+
+    // Every stream should be aligned, relative to the start of the file.
+    TASSERT_EQ(((const unsigned char*)body.positions - &buffer[0]) % MHM_StreamAlignment, 0);
+    TASSERT_EQ(((const unsigned char*)body.indices - &buffer[0]) % MHM_StreamAlignment, 0);
+
+    const MeshCache::MeshView &points = cache.getMesh(1);
+    TASSERT_EQ(points.material, -1);
+    TASSERT(!points.normals);
+    TASSERT(!points.texCoords);
+    TASSERT(!points.indices);
+    TASSERT_EQ(points.indexCount, 0);
+
+    TASSERT_EQ(cache.getStreamBytes(), 5 * 32 + 9 * 2 + 3 * 12);
+
+    // Running out of room while writing should fail cleanly.
+    std::vector<unsigned char> small;
+    TASSERT_EQ(WriteCache(small, length - 1, bones, materials, meshes), -1);
+}
+
+void TestMeshCache::TestIndexWidth() {
+    std::vector<MeshCache::Bone> bones;
+    std::vector<MeshCache::Material> materials;
+    std::vector<MeshCache::Mesh> meshes;
+    meshes.push_back(MakeMesh("narrow", 0x10000, false, false));
+    meshes.push_back(MakeMesh("wide", 0x10001, false, false));
+
+    std::vector<unsigned char> buffer;
+    long long length = WriteCache(buffer, 8 * 1024 * 1024, bones, materials, meshes);
+    TASSERT(length > 0);
+
+    MeshCache cache;
+    TASSERT(cache.read(&buffer[0], length));
+    TASSERT_EQ(cache.getMesh(0).indexSize, 2);
+    TASSERT_EQ(cache.getMesh(1).indexSize, 4);
+    TASSERT_EQ(((const unsigned short*)cache.getMesh(0).indices)[cache.getMesh(0).indexCount - 1], 0xFFFF);
+    TASSERT_EQ(((const unsigned int*)cache.getMesh(1).indices)[cache.getMesh(1).indexCount - 1], 0x10000);
+
+    // In memory meshes can be viewed just like cached ones.
+    MeshCache::MeshView view = MeshCache::GetView(meshes[1]);
+    TASSERT_EQ(view.indexSize, 4);
+    TASSERT_EQ(view.indexCount, meshes[1].indices.size());
+    TASSERT_EQ(view.positions, meshes[1].positions[0].ptr());
+}
+
+void TestMeshCache::TestCorruption() {
+    std::vector<MeshCache::Bone> bones(1);
+    bones[0].name = "root";
+    bones[0].parent = -1;
+    std::vector<MeshCache::Material> materials;
+    std::vector<MeshCache::Mesh> meshes;
+    meshes.push_back(MakeMesh("mesh", 16, true, false));
+
+    std::vector<unsigned char> buffer;
+    long long length = WriteCache(buffer, 64 * 1024, bones, materials, meshes);
+    TASSERT(length > 0);
+
+    MeshCache cache;
+    TASSERT(cache.read(&buffer[0], length));
+
+    // Anything cut off should be caught.
+    TASSERT(!cache.read(&buffer[0], length - 1));
+    TASSERT(!cache.read(&buffer[0], sizeof(MHM_Header) - 1));
+
+    MHM_Header *header = (MHM_Header*)&buffer[0];
+    header->version++;
+    TASSERT(!cache.read(&buffer[0], length));
+    header->version--;
+
+    header->signature = 0;
+    TASSERT(!MeshCache::IsMeshCache(&buffer[0], length));
+    TASSERT(!cache.read(&buffer[0], length));
+    header->signature = MHM_Signature;
+
+    MHM_Mesh *mesh = (MHM_Mesh*)&buffer[header->meshOffset];
+    mesh->vertexCount = 1000000;
+    TASSERT(!cache.read(&buffer[0], length));
+    mesh->vertexCount = 16;
+
+    mesh->material = 0;
+    TASSERT(!cache.read(&buffer[0], length));
+    mesh->material = -1;
+
+    MHM_Bone *bone = (MHM_Bone*)&buffer[header->boneOffset];
+    bone->parent = 0;
+    TASSERT(!cache.read(&buffer[0], length));
+    bone->parent = -1;
+
+    TASSERT(cache.read(&buffer[0], length));
+
+    // Bones must come after their parents when writing, too.
+    bones.push_back(bones[0]);
+    bones[0].parent = 1;
+    std::vector<unsigned char> unused;
+    TASSERT_EQ(WriteCache(unused, 64 * 1024, bones, materials, meshes), -1);
+}
+
+void TestMeshCache::TestReadSpeed() {
+    const int passes = 1000;
+    std::vector<MeshCache::Bone> bones;
+    std::vector<MeshCache::Material> materials;
+    std::vector<MeshCache::Mesh> meshes;
+    for (int i = 0; i < 8; i++) {
+        meshes.push_back(MakeMesh("mesh", 4096, true, true));
+    }
+
+    std::vector<unsigned char> buffer;
+    long long length = WriteCache(buffer, 4 * 1024 * 1024, bones, materials, meshes);
+    TASSERT(length > 0);
+
+    MeshCache cache;
+    Timer timer;
+    timer.start();
+    for (int i = 0; i < passes; i++) {
+        cache.read(&buffer[0], length);
+    }
+    timer.stop();
+
+    Info("Mesh cache read time (8 meshes, 32k vertices): " << timer.mseconds() * 1000 / passes <<
+         "us per read.");
+}
@@ -0,0 +1,27 @@
+/*
+ *  TestMeshCache.h
+ *  Base
+ *
+ *  Created by loch on 4/28/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _TESTMESHCACHE_H_
+#define _TESTMESHCACHE_H_
+#include "Test.h"
+
+class TestMeshCache : public Test<TestMeshCache> {
+public:
+    TestMeshCache(): Test<TestMeshCache>() {}
+    static void RunTests();
+
+private:
+    static void TestRoundTrip();
+    static void TestIndexWidth();
+    static void TestCorruption();
+    static void TestReadSpeed();
+
+};
+
+#endif
@@ -0,0 +1,161 @@
+/*
+ *  TestMeshOptimizer.cpp
+ *  Base
+ *
+ *  Created by loch on 5/2/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "TestMeshOptimizer.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+
+/*! Builds a flat size x size grid of quads, with the triangles in a scrambled order and
+ *  every vertex duplicated once for each triangle using it, like a naive importer would. */
+static MeshCache::Mesh MakeGrid(int size) {
+    MeshCache::Mesh mesh;
+    mesh.material = -1;
+    mesh.bone = -1;
+
+    std::vector<int> order(size * size * 2);
+    for (int i = 0; i < order.size(); i++) { order[i] = i; }
+    for (int i = order.size() - 1; i > 0; i--) {
+        std::swap(order[i], order[(i * 7919) % (i + 1)]);
+    }
+
+    for (int i = 0; i < order.size(); i++) {
+        int x = (order[i] / 2) % size, y = (order[i] / 2) / size;
+        Vector3 corners[3];
+        if (order[i] % 2) {
+            corners[0] = Vector3(x, y, 0);
+            corners[1] = Vector3(x + 1, y, 0);
+            corners[2] = Vector3(x + 1, y + 1, 0);
+        } else {
+            corners[0] = Vector3(x, y, 0);
+            corners[1] = Vector3(x + 1, y + 1, 0);
+            corners[2] = Vector3(x, y + 1, 0);
+        }
+
+        for (int j = 0; j < 3; j++) {
+            mesh.indices.push_back(mesh.positions.size());
+            mesh.positions.push_back(corners[j]);
+            mesh.normals.push_back(Vector3(0, 0, 1));
+            mesh.texCoords.push_back(Vector2(corners[j].x / size, corners[j].y / size));
+        }
+    }
+
+    mesh.bounds = AABB3::FindBounds(&mesh.positions[0], mesh.positions.size());
+    return mesh;
+}
+
+/*! Lists the triangles of a mesh by position, rotated so the smallest corner comes first
+ *  (keeping the winding), and sorted. Meshes that draw the same triangles in any order
+ *  with any vertex layout give the same list. */
+static std::vector<std::vector<Real> > GetTriangles(const MeshCache::Mesh &mesh) {
+    std::vector<std::vector<Real> > triangles;
+    for (int i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        int first = 0;
+        for (int j = 1; j < 3; j++) {
+            if (mesh.positions[mesh.indices[i + j]] < mesh.positions[mesh.indices[i + first]]) {
+                first = j;
+            }
+        }
+
+        std::vector<Real> triangle;
+        for (int j = 0; j < 3; j++) {
+            const Vector3 &corner = mesh.positions[mesh.indices[i + (first + j) % 3]];
+            triangle.insert(triangle.end(), corner.ptr(), corner.ptr() + 3);
+        }
+
+        triangles.push_back(triangle);
+    }
+
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+void TestMeshOptimizer::RunTests() {
+    TestACMR();
+    TestWeld();
+    TestVertexFetch();
+    TestOptimize();
+}
+
+void TestMeshOptimizer::TestACMR() {
+    unsigned int fan[] = { 0, 1, 2, 0, 2, 3, 0, 3, 4 };
+    std::vector<unsigned int> indices(fan, fan + 9);
+    TASSERT_EQ(MeshOptimizer::ACMR(indices, 5), 5 / 3.0);
+
+    // With a tiny cache, the hub of the fan is pushed out before the second triangle.
+    TASSERT_EQ(MeshOptimizer::ACMR(indices, 5, 2), 6 / 3.0);
+
+    indices.clear();
+    TASSERT_EQ(MeshOptimizer::ACMR(indices, 5), 0);
+}
+
+void TestMeshOptimizer::TestWeld() {
+    MeshCache::Mesh mesh = MakeGrid(4);
+    TASSERT_EQ(mesh.positions.size(), 96);
+    TASSERT_EQ(MeshOptimizer::WeldVertices(mesh), 96 - 25);
+    TASSERT_EQ(mesh.positions.size(), 25);
+    TASSERT_EQ(mesh.normals.size(), 25);
+    TASSERT_EQ(mesh.texCoords.size(), 25);
+    TASSERT_EQ(*std::max_element(mesh.indices.begin(), mesh.indices.end()), 24);
+
+    // Vertices only weld when every attribute matches.
+    mesh = MakeGrid(4);
+    for (int i = 0; i < mesh.indices.size(); i += 3) {
+        mesh.texCoords[mesh.indices[i]].x += i;
+    }
+
+    TASSERT(mesh.positions.size() - MeshOptimizer::WeldVertices(mesh) > 25);
+}
+
+void TestMeshOptimizer::TestVertexFetch() {
+    MeshCache::Mesh mesh = MakeGrid(4);
+    MeshOptimizer::WeldVertices(mesh);
+
+    // Drop the first triangle, so a few vertices may go unused.
+    mesh.indices.erase(mesh.indices.begin(), mesh.indices.begin() + 3);
+    std::vector<std::vector<Real> > before = GetTriangles(mesh);
+
+    unsigned int used = MeshOptimizer::OptimizeVertexFetch(mesh);
+    TASSERT(used <= 25);
+    TASSERT_EQ(mesh.positions.size(), used);
+    TASSERT_EQ(mesh.normals.size(), used);
+
+    // Every index is either one seen before or the next new vertex.
+    unsigned int next = 0;
+    for (int i = 0; i < mesh.indices.size(); i++) {
+        TASSERT(mesh.indices[i] <= next);
+        if (mesh.indices[i] == next) { next++; }
+    }
+
+    TASSERT_EQ(next, used);
+    TASSERT(GetTriangles(mesh) == before);
+}
+
+void TestMeshOptimizer::TestOptimize() {
+    MeshCache::Mesh mesh = MakeGrid(32);
+    std::vector<std::vector<Real> > before = GetTriangles(mesh);
+
+    MeshOptimizer::Statistics stats = MeshOptimizer::Optimize(mesh);
+    TASSERT_EQ(stats.verticesBefore, 32 * 32 * 6);
+    TASSERT_EQ(stats.verticesAfter, 33 * 33);
+    TASSERT_EQ(stats.acmrBefore, 3);
+    TASSERT(stats.acmrAfter < 1);
+    TASSERT_EQ(stats.acmrAfter, MeshOptimizer::ACMR(mesh.indices, mesh.positions.size()));
+    TASSERT(GetTriangles(mesh) == before);
+    TASSERT_EQ(mesh.bounds.getMax(), Vector3(32, 32, 0));
+
+    // Welding first should do much better than just reordering the scrambled grid.
+    MeshCache::Mesh scrambled = MakeGrid(32);
+    MeshOptimizer::WeldVertices(scrambled);
+    Real scrambledAcmr = MeshOptimizer::ACMR(scrambled.indices, scrambled.positions.size());
+    TASSERT(scrambledAcmr > 1.5);
+    TASSERT(stats.acmrAfter < scrambledAcmr);
+
+    Info("Grid ACMR: " << stats.acmrBefore << " unwelded, " << scrambledAcmr <<
+         " scrambled, " << stats.acmrAfter << " optimized.");
+}
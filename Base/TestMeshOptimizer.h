@@ -0,0 +1,27 @@
+/*
+ *  TestMeshOptimizer.h
+ *  Base
+ *
+ *  Created by loch on 5/2/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _TESTMESHOPTIMIZER_H_
+#define _TESTMESHOPTIMIZER_H_
+#include "Test.h"
+
+class TestMeshOptimizer : public Test<TestMeshOptimizer> {
+public:
+    TestMeshOptimizer(): Test<TestMeshOptimizer>() {}
+    static void RunTests();
+
+private:
+    static void TestACMR();
+    static void TestWeld();
+    static void TestVertexFetch();
+    static void TestOptimize();
+
+};
+
+#endif
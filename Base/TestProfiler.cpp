@@ -0,0 +1,242 @@
+/*
+ *  TestProfiler.cpp
+ *  Base
+ *
+ *  Created by loch on 5/6/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "TestProfiler.h"
+#include "Profiler.h"
+#include <pthread.h>
+#include <unistd.h>
+
+/*! Busy waits for the given number of microseconds, so zones have a known minimum length
+ *  without depending on the scheduler. */
+static void Spin(int microseconds) {
+    uint64_t end = Timer::Now() + microseconds * 1000ull;
+    while (Timer::Now() < end) {}
+}
+
+static void *ProfileThread(void *name) {
+    Profiler::SetThreadName((const char*)name);
+    for (int i = 0; i < 3; i++) {
+        PROFILE("Load");
+        PROFILE("Decode");
+        Spin(10);
+    }
+
+    return NULL;
+}
+
+void TestProfiler::RunTests() {
+    TestTimer();
+    TestNesting();
+    TestStatistics();
+    TestOpenZones();
+    TestThreads();
+    TestChromeTrace();
+
+    Profiler::SetEnabled(false);
+    Profiler::Reset();
+}
+
+void TestProfiler::TestTimer() {
+    uint64_t first = Timer::Now();
+    uint64_t second = Timer::Now();
+    TASSERT(second >= first);
+
+    Timer timer;
+    timer.start();
+    usleep(2000);
+    timer.stop();
+    TASSERT(timer.mseconds() >= 2.0);
+    TASSERT(timer.mseconds() < 1000.0);
+    TASSERT_EQ(timer.nseconds(), timer.mseconds() * 1e6);
+}
+
+void TestProfiler::TestNesting() {
+    Profiler::Reset();
+
+    // Nothing is recorded while disabled.
+    Profiler::SetEnabled(false);
+    { PROFILE("Hidden"); }
+    Profiler::EndFrame();
+    TASSERT_EQ(Profiler::GetZones().size(), 0);
+
+    Profiler::SetEnabled(true);
+    Profiler::SetThreadName("Main");
+    {
+        PROFILE("Frame");
+        for (int i = 0; i < 3; i++) {
+            PROFILE("Update");
+            Spin(50);
+        }
+
+        PROFILE("Render");
+        { PROFILE("Cull"); Spin(50); }
+        { PROFILE("Draw"); }
+    }
+    Profiler::EndFrame();
+
+    const std::vector<Profiler::Zone> &zones = Profiler::GetZones();
+    TASSERT_EQ(zones.size(), 6);
+
+    // Depth first, with children in the order they first ran.
+    TASSERTS_EQ(zones[0].name, "Main");
+    TASSERTS_EQ(zones[1].name, "Frame");
+    TASSERTS_EQ(zones[2].name, "Update");
+    TASSERTS_EQ(zones[3].name, "Render");
+    TASSERTS_EQ(zones[4].name, "Cull");
+    TASSERTS_EQ(zones[5].name, "Draw");
+    TASSERT_EQ(zones[4].parent, 3);
+    TASSERT_EQ(zones[3].parent, 1);
+    TASSERT_EQ(zones[4].depth, 3);
+
+    const Profiler::Zone *update = Profiler::FindZone("Main", "Frame/Update");
+    TASSERT_EQ(update, &zones[2]);
+    TASSERT_EQ(update->calls, 3);
+    TASSERT(update->time >= 150000);
+    TASSERT(update->minCall >= 50000);
+    TASSERT(update->maxCall >= update->minCall);
+    TASSERT(zones[1].time >= update->time + zones[4].time);
+    TASSERT_EQ(zones[0].time, zones[1].time);
+
+    TASSERT(!Profiler::FindZone("Main", "Frame/Missing"));
+    TASSERT(!Profiler::FindZone("Other", "Frame"));
+
+    // The same names under a different parent are a different zone.
+    { PROFILE("Cull"); }
+    Profiler::EndFrame();
+    TASSERT_EQ(Profiler::GetZones().size(), 7);
+    TASSERT_EQ(Profiler::FindZone("Main", "Cull")->calls, 1);
+    TASSERT_EQ(Profiler::FindZone("Main", "Frame/Render/Cull")->calls, 0);
+    TASSERT_EQ(Profiler::GetFrameCount(), 3);
+
+    std::string caption = Profiler::GetCaption();
+    TASSERT(caption.find("Frame: ") == 0);
+    TASSERT(caption.find("(Update ") != std::string::npos);
+    TASSERT(caption.find("Cull: ") != std::string::npos);
+    TASSERT(Profiler::GetSummary().find("\n    Render") != std::string::npos);
+}
+
+void TestProfiler::TestStatistics() {
+    Profiler::Reset();
+    Profiler::SetEnabled(true);
+
+    int lengths[] = { 200, 1000, 600 };
+    for (int i = 0; i < 3; i++) {
+        { PROFILE("Work"); Spin(lengths[i]); }
+        Profiler::EndFrame();
+    }
+
+    // A frame the zone doesn't run in doesn't count against it.
+    Profiler::EndFrame();
+
+    const Profiler::Zone *work = Profiler::FindZone("Main", "Work");
+    TASSERT(work);
+    TASSERT_EQ(work->calls, 0);
+    TASSERT_EQ(work->frames, 3);
+    TASSERT_EQ(work->totalCalls, 3);
+    TASSERT(work->minFrame >= 200000 && work->minFrame < 600000);
+    TASSERT(work->maxFrame >= 1000000);
+    TASSERT(work->getAverage() >= 600000);
+    TASSERT(work->getAverage() > work->minFrame && work->getAverage() < work->maxFrame);
+}
+
+void TestProfiler::TestOpenZones() {
+    Profiler::Reset();
+    Profiler::SetEnabled(true);
+
+    {
+        PROFILE("Long");
+        { PROFILE("Before"); }
+        Profiler::EndFrame();
+        TASSERT_EQ(Profiler::FindZone("Main", "Long")->calls, 1);
+        TASSERT_EQ(Profiler::FindZone("Main", "Long/Before")->calls, 1);
+
+        // Turning profiling off doesn't leave the zone dangling.
+        Profiler::SetEnabled(false);
+        { PROFILE("Skipped"); }
+        Profiler::SetEnabled(true);
+        { PROFILE("After"); }
+    }
+
+    Profiler::EndFrame();
+    TASSERT_EQ(Profiler::FindZone("Main", "Long")->calls, 1);
+    TASSERT_EQ(Profiler::FindZone("Main", "Long")->frames, 2);
+    TASSERT_EQ(Profiler::FindZone("Main", "Long/After")->calls, 1);
+    TASSERT(!Profiler::FindZone("Main", "Long/Skipped"));
+    TASSERT(!Profiler::FindZone("Main", "After"));
+}
+
+void TestProfiler::TestThreads() {
+    Profiler::Reset();
+    Profiler::SetEnabled(true);
+
+    const char *names[] = { "Loader A", "Loader B" };
+    pthread_t threads[2];
+    for (int i = 0; i < 2; i++) {
+        pthread_create(&threads[i], NULL, ProfileThread, (void*)names[i]);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    { PROFILE("Wait"); }
+    Profiler::EndFrame();
+
+    for (int i = 0; i < 2; i++) {
+        const Profiler::Zone *decode = Profiler::FindZone(names[i], "Load/Decode");
+        TASSERT(decode);
+        if (!decode) { continue; }
+        TASSERT_EQ(decode->calls, 3);
+        TASSERT_EQ(decode->depth, 2);
+        TASSERT(decode->time >= 30000);
+        TASSERT(Profiler::GetZones()[decode->parent].thread == decode->thread);
+    }
+
+    TASSERT_EQ(Profiler::FindZone("Main", "Wait")->calls, 1);
+    TASSERT(!Profiler::FindZone("Main", "Load"));
+}
+
+void TestProfiler::TestChromeTrace() {
+    Profiler::Reset();
+    Profiler::SetEnabled(true);
+
+    { PROFILE("Ignored"); }
+    Profiler::EndFrame();
+
+    Profiler::StartCapture();
+    for (int i = 0; i < 2; i++) {
+        PROFILE("Frame \"quoted\"");
+        { PROFILE("Inner"); }
+    }
+    Profiler::EndFrame();
+    Profiler::StopCapture();
+
+    { PROFILE("Late"); }
+    Profiler::EndFrame();
+
+    std::ostringstream trace;
+    Profiler::WriteChromeTrace(trace);
+    std::string json = trace.str();
+
+    TASSERT(json.find("{\"traceEvents\":[") == 0);
+    TASSERT(json.find("\"ph\":\"M\",\"pid\":0,\"tid\":") != std::string::npos);
+    TASSERT(json.find("\"args\":{\"name\":\"Main\"}") != std::string::npos);
+    TASSERT(json.find("\"name\":\"Frame \\\"quoted\\\"\",\"ph\":\"X\"") != std::string::npos);
+    TASSERT(json.find("\"name\":\"Inner\"") != std::string::npos);
+    TASSERT(json.find("Ignored") == std::string::npos);
+    TASSERT(json.find("Late") == std::string::npos);
+    TASSERT(json.find("\"dur\":") != std::string::npos);
+    TASSERTS_EQ(json.substr(json.size() - 4), "\n]}\n");
+
+    int events = 0;
+    for (size_t i = json.find("\"ph\":\"X\""); i != std::string::npos; i = json.find("\"ph\":\"X\"", i + 1)) {
+        events++;
+    }
+    TASSERT_EQ(events, 4);
+}
@@ -0,0 +1,29 @@
+/*
+ *  TestProfiler.h
+ *  Base
+ *
+ *  Created by loch on 5/6/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _TESTPROFILER_H_
+#define _TESTPROFILER_H_
+#include "Test.h"
+
+class TestProfiler : public Test<TestProfiler> {
+public:
+    TestProfiler(): Test<TestProfiler>() {}
+    static void RunTests();
+
+private:
+    static void TestTimer();
+    static void TestNesting();
+    static void TestStatistics();
+    static void TestOpenZones();
+    static void TestThreads();
+    static void TestChromeTrace();
+
+};
+
+#endif
@@ -67,6 +67,14 @@ void TestQuaternion::TestMatrixConversion() {
     Matrix m2(q);
 
     TASSERT_EQ(m, m2);
+
+    // The matrix has to rotate things exactly as the quaternion does.
+    for (int i = 0; i < 20; i++) {
+        Quaternion r = Quaternion::FromAxisAngle(Radian(i * .7), Vector3(i % 3, 1, i % 5 - 2).getNormalized());
+        Vector3 v(i, 2 - i, 3);
+        TASSERT_EQ(Matrix(r) * v, r * v);
+        TASSERT(Matrix(r).isAffine());
+    }
 }
 
 void TestQuaternion::TestAxisAngleConversion() {
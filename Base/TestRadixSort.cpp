@@ -0,0 +1,96 @@
+/*
+ *  TestRadixSort.cpp
+ *  Base
+ *
+ *  Created by loch on 4/14/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "TestRadixSort.h"
+#include "RadixSort.h"
+#include <algorithm>
+
+struct KeyedItem {
+    uint64_t key;
+    int value;
+};
+
+static bool KeyLess(const KeyedItem &lhs, const KeyedItem &rhs) {
+    return lhs.key < rhs.key;
+}
+
+static bool SameOrder(const std::vector<KeyedItem> &lhs, const std::vector<KeyedItem> &rhs) {
+    if (lhs.size() != rhs.size()) { return false; }
+    for (int i = 0; i < lhs.size(); i++) {
+        if (lhs[i].key != rhs[i].key || lhs[i].value != rhs[i].value) { return false; }
+    }
+
+    return true;
+}
+
+void TestRadixSort::RunTests() {
+    TestSmall();
+    TestRandom();
+    TestStable();
+}
+
+void TestRadixSort::TestSmall() {
+    std::vector<KeyedItem> items, scratch;
+    RadixSort(items, scratch);
+    TASSERT_EQ(items.size(), 0);
+
+    KeyedItem item = { 5, 0 };
+    items.push_back(item);
+    RadixSort(items, scratch);
+    TASSERT_EQ(items[0].key, 5);
+
+    uint64_t keys[] = { 3, 0xFFFFFFFFFFFFFFFFull, 0, 1ull << 63, 256, 255 };
+    items.clear();
+    for (int i = 0; i < 6; i++) {
+        item.key = keys[i];
+        item.value = i;
+        items.push_back(item);
+    }
+
+    RadixSort(items, scratch);
+    TASSERT_EQ(items[0].value, 2);
+    TASSERT_EQ(items[1].value, 0);
+    TASSERT_EQ(items[2].value, 5);
+    TASSERT_EQ(items[3].value, 4);
+    TASSERT_EQ(items[4].value, 3);
+    TASSERT_EQ(items[5].value, 1);
+}
+
+void TestRadixSort::TestRandom() {
+    srand(7);
+    std::vector<KeyedItem> items, expected, scratch;
+    for (int i = 0; i < 10000; i++) {
+        KeyedItem item;
+        item.key = ((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^ rand();
+        item.value = i;
+        items.push_back(item);
+    }
+
+    expected = items;
+    std::stable_sort(expected.begin(), expected.end(), KeyLess);
+    RadixSort(items, scratch);
+    TASSERT(SameOrder(items, expected));
+}
+
+void TestRadixSort::TestStable() {
+    // Only a few distinct keys, in the upper bits, so most passes are skipped.
+    srand(8);
+    std::vector<KeyedItem> items, expected, scratch;
+    for (int i = 0; i < 1000; i++) {
+        KeyedItem item;
+        item.key = (uint64_t)(rand() % 4) << 60;
+        item.value = i;
+        items.push_back(item);
+    }
+
+    expected = items;
+    std::stable_sort(expected.begin(), expected.end(), KeyLess);
+    RadixSort(items, scratch);
+    TASSERT(SameOrder(items, expected));
+}
@@ -0,0 +1,26 @@
+/*
+ *  TestRadixSort.h
+ *  Base
+ *
+ *  Created by loch on 4/14/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _TESTRADIXSORT_H_
+#define _TESTRADIXSORT_H_
+#include "Test.h"
+
+class TestRadixSort : public Test<TestRadixSort> {
+public:
+    TestRadixSort(): Test<TestRadixSort>() {}
+    static void RunTests();
+
+private:
+    static void TestSmall();
+    static void TestRandom();
+    static void TestStable();
+
+};
+
+#endif
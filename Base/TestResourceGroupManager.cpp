@@ -0,0 +1,218 @@
+/*
+ *  TestResourceGroupManager.cpp
+ *  Base
+ *
+ *  Created by loch on 5/9/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "TestResourceGroupManager.h"
+#include "ResourceGroupManager.h"
+#include "FileSystem.h"
+#include <unistd.h>
+#include <pthread.h>
+
+/*! Shared between the main thread and LookupLoop. */
+struct LookupState {
+    ResourceGroupManager *manager;
+    volatile int stop;
+    int misses;
+};
+
+/*! Looks resources up the way a loader thread would, until told to stop. */
+static void* LookupLoop(void *arg) {
+    LookupState *state = static_cast<LookupState*>(arg);
+    while (!state->stop) {
+        if (!state->manager->hasResource("deepest")) { state->misses++; }
+        if (state->manager->findResource("readTest") != "./test/readTest") { state->misses++; }
+    }
+
+    return NULL;
+}
+
+/*! Shared between the main thread and every MapLoop. */
+struct MapState {
+    ResourceGroupManager *manager;
+    std::vector<std::string> names;
+    std::vector<std::string> expected; //!< The contents of each resource, read up front.
+    volatile int mismatches;
+};
+
+/*! Maps every resource a few times, the way a loader thread would, checking each one. */
+static void* MapLoop(void *arg) {
+    MapState *state = static_cast<MapState*>(arg);
+    for (int pass = 0; pass < 5; pass++) {
+        for (unsigned int i = 0; i < state->names.size(); i++) {
+            const unsigned char *data;
+            long long length;
+            IOTarget *target = state->manager->mapResource(state->names[i], data, length);
+            if (std::string((const char*)data, length) != state->expected[i]) {
+                __sync_add_and_fetch(&state->mismatches, 1);
+            }
+
+            delete target;
+        }
+    }
+
+    return NULL;
+}
+
+void TestResourceGroupManager::RunTests() {
+    TestBasenameLookup();
+    TestShadowing();
+    TestRescanChanged();
+    TestArchiveLocation();
+    TestThreadedRescan();
+    TestConcurrentArchiveReads("./test.zip");
+    TestConcurrentArchiveReads("./test_deflate.zip");
+}
+
+void TestResourceGroupManager::TestBasenameLookup() {
+    ResourceGroupManager manager;
+    manager.addResourceLocation("./test", true);
+    TASSERT_EQ(manager.getResourceCount(), 3);
+    TASSERT_EQ(manager.getShadowedCount(), 0);
+
+    // Resources are found by file name alone, no matter how deep they are.
+    TASSERT(manager.hasResource("deepest"));
+    TASSERT(manager.hasResource("readTest"));
+    TASSERTS_EQ(manager.findResource("deepest"), "./test/deeper/deepest");
+    TASSERTS_EQ(manager.findResource("readTest"), "./test/readTest");
+    TASSERT_EQ(manager.getResourceLength("readTest"), FileSystem::Length("./test/readTest"));
+
+    // Directories and partial paths aren't resources.
+    TASSERT(!manager.hasResource("deeper"));
+    TASSERT(!manager.hasResource("deeper/deepest"));
+    TASSERT(!manager.hasResource("garbage"));
+    TASSERT_EQ(manager.getResourceLength("garbage"), 0);
+
+    // Without recursion only the top level is indexed.
+    ResourceGroupManager shallow;
+    shallow.addResourceLocation("./test", false);
+    TASSERT_EQ(shallow.getResourceCount(), 2);
+    TASSERT(!shallow.hasResource("deepest"));
+}
+
+void TestResourceGroupManager::TestShadowing() {
+    // Both locations contain a testFile. The first location added wins.
+    ResourceGroupManager first;
+    first.addResourceLocation("./test");
+    first.addResourceLocation("./");
+    TASSERT_EQ(first.getShadowedCount(), 1);
+    TASSERTS_EQ(first.findResource("testFile"), "./test/testFile");
+
+    ResourceGroupManager second;
+    second.addResourceLocation("./");
+    second.addResourceLocation("./test");
+    TASSERT_EQ(second.getShadowedCount(), 1);
+    TASSERTS_EQ(second.findResource("testFile"), "./testFile");
+
+    // Rescanning starts the count over rather than adding to it.
+    second.rescanResourceLocations();
+    TASSERT_EQ(second.getShadowedCount(), 1);
+    TASSERTS_EQ(second.findResource("testFile"), "./testFile");
+}
+
+void TestResourceGroupManager::TestRescanChanged() {
+    std::string name = "./test/deeper/rescanTest";
+    FileSystem::Delete(name);
+
+    ResourceGroupManager manager;
+    manager.addResourceLocation("./test", true);
+    TASSERT(!manager.rescanChangedLocations());
+
+    // Modification times only have a resolution of a second, so wait one out before
+    // adding the file to make sure the directory actually looks different.
+    sleep(1);
+    TASSERT(FileSystem::Touch(name));
+    TASSERT(!manager.hasResource("rescanTest"));
+
+    TASSERT(manager.rescanChangedLocations());
+    TASSERT(manager.hasResource("rescanTest"));
+    TASSERT_EQ(manager.getResourceCount(), 4);
+    TASSERT(!manager.rescanChangedLocations());
+
+    TASSERT(FileSystem::Delete(name));
+}
+
+void TestResourceGroupManager::TestArchiveLocation() {
+    ResourceGroupManager manager;
+    manager.addResourceLocation("./test.zip", true);
+    TASSERT_EQ(manager.getResourceCount(), 98);
+    TASSERT(manager.hasResource("cubemapdefault.vtf"));
+    TASSERT(manager.hasResource("metalcombine001_512_512_232.vmt"));
+    TASSERT_EQ(manager.getResourceLength("cubemapdefault.vtf"), 9808);
+
+    // Archived resources can be streamed or pulled into memory.
+    IOTarget *target = manager.openResource("metalcombine001_512_512_232.vmt");
+    TASSERT(target);
+    TASSERT_EQ(target->length(), 131);
+    delete target;
+
+    const unsigned char *data = NULL;
+    long long length = 0;
+    target = manager.mapResource("cubemapdefault.vtf", data, length);
+    TASSERT(target);
+    TASSERT(data);
+    TASSERT_EQ(length, 9808);
+    delete target;
+
+    // But they have no path on disk to hand out.
+    bool threw = false;
+    try {
+        manager.findResource("cubemapdefault.vtf");
+    } catch (InvalidStateError &e) {
+        threw = true;
+    }
+
+    TASSERT(threw);
+}
+
+void TestResourceGroupManager::TestThreadedRescan() {
+    ResourceGroupManager manager;
+    manager.addResourceLocation("./test", true);
+
+    // Lookups made while the index is being rebuilt wait for it, so they never miss.
+    LookupState state = { &manager, 0, 0 };
+    pthread_t thread;
+    pthread_create(&thread, NULL, LookupLoop, &state);
+    for (int i = 0; i < 50; i++) {
+        manager.rescanResourceLocations();
+    }
+
+    state.stop = 1;
+    pthread_join(thread, NULL);
+    TASSERT_EQ(state.misses, 0);
+}
+
+void TestResourceGroupManager::TestConcurrentArchiveReads(const std::string &location) {
+    ResourceGroupManager manager;
+    manager.addResourceLocation(location, true);
+
+    MapState state;
+    state.manager = &manager;
+    state.mismatches = 0;
+    manager.getResourceNames(state.names);
+    TASSERT_EQ(state.names.size(), 98);
+
+    for (unsigned int i = 0; i < state.names.size(); i++) {
+        const unsigned char *data;
+        long long length;
+        IOTarget *target = manager.mapResource(state.names[i], data, length);
+        state.expected.push_back(std::string((const char*)data, length));
+        delete target;
+    }
+
+    // Every thread reads every entry out of the same archive at once.
+    pthread_t threads[4];
+    for (int i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, MapLoop, &state);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    TASSERT_EQ(state.mismatches, 0);
+}
@@ -0,0 +1,30 @@
+/*
+ *  TestResourceGroupManager.h
+ *  Base
+ *
+ *  Created by loch on 5/9/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _TESTRESOURCEGROUPMANAGER_H_
+#define _TESTRESOURCEGROUPMANAGER_H_
+#include "Test.h"
+#include <string>
+
+class TestResourceGroupManager : public Test<TestResourceGroupManager> {
+public:
+    TestResourceGroupManager(): Test<TestResourceGroupManager>() {}
+    static void RunTests();
+
+private:
+    static void TestBasenameLookup();
+    static void TestShadowing();
+    static void TestRescanChanged();
+    static void TestArchiveLocation();
+    static void TestThreadedRescan();
+    static void TestConcurrentArchiveReads(const std::string &location);
+
+};
+
+#endif
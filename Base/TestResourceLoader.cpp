@@ -0,0 +1,287 @@
+/*
+ *  TestResourceLoader.cpp
+ *  Base
+ *
+ *  Created by loch on 4/26/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "TestResourceLoader.h"
+#include "ResourceLoader.h"
+#include "ResourceManager.h"
+#include "ResourceGroupManager.h"
+
+/*! Records the order requests are prepared and finished in. */
+class RecordingRequest : public ResourceLoader::Request {
+public:
+    RecordingRequest(const std::string &name, int priority, std::vector<std::string> *log,
+                     bool fail = false):
+        ResourceLoader::Request(name, priority), _log(log), _fail(fail), _retired(0) {}
+
+    int retiredCount() const { return _retired; }
+
+protected:
+    virtual bool prepare() {
+        if (_log) { _log->push_back(_name); }
+        _preparedBytes = 10;
+        return !_fail;
+    }
+
+    virtual bool finish() { return true; }
+    virtual void retire() { _retired++; }
+
+    std::vector<std::string> *_log;
+    bool _fail;
+    int _retired;
+};
+
+/*! Builds ints from their names, recording how many times each stage is hit. */
+class IntFactory : public ResourceFactory<int> {
+public:
+    IntFactory(): ResourceFactory<int>(NULL), prepares(0), finishes(0) {}
+
+    virtual bool canLoad(const std::string &name) { return true; }
+    virtual int* load(const std::string &name) { return new int(atoi(name.c_str())); }
+
+    virtual bool canPrepare(const std::string &name) { return true; }
+
+    virtual PreparedResource* prepare(const std::string &name) {
+        __sync_add_and_fetch(&prepares, 1);
+        return new PreparedResource(sizeof(int));
+    }
+
+    virtual int* finish(const std::string &name, PreparedResource *prepared) {
+        finishes++;
+        return load(name);
+    }
+
+    volatile int prepares;
+    int finishes;
+};
+
+/*! The contents of a resource, as read on a worker thread. */
+class PreparedContents : public PreparedResource {
+public:
+    PreparedContents(const std::string &contents): PreparedResource(contents.size()),
+        contents(contents) {}
+
+    std::string contents;
+};
+
+/*! Loads the raw contents of resources, reading them in prepare the way textures and
+ *  models do. */
+class ContentsFactory : public ResourceFactory<std::string> {
+public:
+    ContentsFactory(ResourceGroupManager *manager): ResourceFactory<std::string>(manager) {}
+
+    virtual bool canLoad(const std::string &name) { return true; }
+    virtual std::string* load(const std::string &name) {
+        PreparedResource *prepared = prepare(name);
+        std::string *result = finish(name, prepared);
+        delete prepared;
+        return result;
+    }
+
+    virtual bool canPrepare(const std::string &name) { return true; }
+
+    virtual PreparedResource* prepare(const std::string &name) {
+        const unsigned char *data;
+        long long length;
+        IOTarget *target = _resourceGroupManager->mapResource(name, data, length);
+        PreparedContents *result = new PreparedContents(std::string((const char*)data, length));
+        delete target;
+        return result;
+    }
+
+    virtual std::string* finish(const std::string &name, PreparedResource *prepared) {
+        return new std::string(static_cast<PreparedContents*>(prepared)->contents);
+    }
+};
+
+void TestResourceLoader::RunTests() {
+    TestPriorityOrder();
+    TestCancel();
+    TestFailure();
+    TestThreaded();
+    TestManagerRequests();
+    TestArchiveRequests();
+}
+
+void TestResourceLoader::TestPriorityOrder() {
+    ResourceLoader loader(0);
+    std::vector<std::string> log;
+
+    RecordingRequest *low = new RecordingRequest("low", 1, &log);
+    RecordingRequest *high = new RecordingRequest("high", 10, &log);
+    RecordingRequest *first = new RecordingRequest("first", 5, &log);
+    RecordingRequest *second = new RecordingRequest("second", 5, &log);
+    RecordingRequest *bumped = new RecordingRequest("bumped", 0, &log);
+
+    loader.submit(low);
+    loader.submit(high);
+    loader.submit(first);
+    loader.submit(second);
+    loader.submit(bumped);
+    loader.reprioritize(bumped, 20);
+    TASSERT_EQ(loader.getQueuedCount(), 5);
+    TASSERT_EQ(loader.getOutstandingCount(), 5);
+
+    TASSERT_EQ(loader.update(-1), 5);
+    TASSERT_EQ(log.size(), 5);
+    TASSERT_EQ(log[0], "bumped");
+    TASSERT_EQ(log[1], "high");
+    TASSERT_EQ(log[2], "first");
+    TASSERT_EQ(log[3], "second");
+    TASSERT_EQ(log[4], "low");
+
+    TASSERT_EQ(high->getState(), ResourceLoader::Finished);
+    TASSERT_EQ(high->retiredCount(), 1);
+    TASSERT_EQ(loader.getOutstandingCount(), 0);
+    TASSERT_EQ(loader.getFinishedCount(), 5);
+    TASSERT_EQ(loader.getBytesPrepared(), 50);
+
+    low->release();
+    high->release();
+    first->release();
+    second->release();
+    bumped->release();
+}
+
+void TestResourceLoader::TestCancel() {
+    ResourceLoader loader(0);
+    std::vector<std::string> log;
+
+    RecordingRequest *kept = new RecordingRequest("kept", 0, &log);
+    RecordingRequest *dropped = new RecordingRequest("dropped", 0, &log);
+    loader.submit(kept);
+    loader.submit(dropped);
+    loader.cancel(dropped);
+    TASSERT_EQ(loader.getQueuedCount(), 1);
+
+    loader.flush();
+    TASSERT_EQ(log.size(), 1);
+    TASSERT_EQ(log[0], "kept");
+    TASSERT_EQ(kept->getState(), ResourceLoader::Finished);
+    TASSERT_EQ(dropped->getState(), ResourceLoader::Cancelled);
+    TASSERT_EQ(dropped->retiredCount(), 1);
+    TASSERT(dropped->isDone());
+
+    kept->release();
+    dropped->release();
+}
+
+void TestResourceLoader::TestFailure() {
+    ResourceLoader loader(2);
+    RecordingRequest *request = new RecordingRequest("broken", 0, NULL, true);
+    loader.submit(request);
+    loader.flush();
+
+    TASSERT_EQ(request->getState(), ResourceLoader::Failed);
+    TASSERT_EQ(request->retiredCount(), 1);
+    TASSERT_EQ(loader.getFailedCount(), 1);
+    TASSERT_EQ(loader.getFinishedCount(), 0);
+    request->release();
+}
+
+void TestResourceLoader::TestThreaded() {
+    ResourceLoader loader(4);
+    TASSERT_EQ(loader.getThreadCount(), 4);
+
+    std::vector<RecordingRequest*> requests;
+    for (int i = 0; i < 500; i++) {
+        requests.push_back(new RecordingRequest("threaded", i % 7, NULL));
+        loader.submit(requests.back());
+    }
+
+    // Cancel a few along the way. They may be queued, preparing, or prepared.
+    for (int i = 0; i < requests.size(); i += 50) {
+        loader.cancel(requests[i]);
+    }
+
+    loader.flush();
+    TASSERT_EQ(loader.getOutstandingCount(), 0);
+    TASSERT_EQ(loader.getQueuedCount(), 0);
+    TASSERT_EQ(loader.getInFlightCount(), 0);
+    TASSERT_EQ(loader.getReadyCount(), 0);
+    TASSERT_EQ(loader.getFinishedCount(), 490);
+
+    for (int i = 0; i < requests.size(); i++) {
+        TASSERT_EQ(requests[i]->retiredCount(), 1);
+        TASSERT_EQ(requests[i]->getState(), i % 50 ? ResourceLoader::Finished :
+            ResourceLoader::Cancelled);
+        requests[i]->release();
+    }
+}
+
+void TestResourceLoader::TestManagerRequests() {
+    ResourceLoader loader(2);
+    ResourceManager<int> manager;
+    IntFactory *factory = new IntFactory();
+    manager.registerFactory(factory);
+    manager.setResourceLoader(&loader);
+
+    // Duplicate requests share the same load.
+    ResourceManager<int>::Request *a = manager.requestResource("42", 1);
+    ResourceManager<int>::Request *b = manager.requestResource("42", 3);
+    ResourceManager<int>::Request *c = manager.requestResource("7");
+    TASSERT(a == b);
+    TASSERT_EQ(a->getPriority(), 3);
+    TASSERT_EQ(manager.getPendingCount(), 2);
+
+    manager.cancelRequest(c);
+    loader.flush();
+    TASSERT_EQ(manager.getPendingCount(), 0);
+    TASSERT_EQ(factory->finishes, 1);
+
+    TASSERT_EQ(a->getState(), ResourceLoader::Finished);
+    TASSERT_EQ(*a->getResource(), 42);
+    TASSERT_EQ(manager.getCachedResource("42"), a->getResource());
+    TASSERT_EQ(manager.resourcesLoaded(), 1);
+    TASSERT_EQ(c->getState(), ResourceLoader::Cancelled);
+    TASSERT(c->getResource() == NULL);
+
+    // Cached resources come back already finished.
+    ResourceManager<int>::Request *d = manager.requestResource("42");
+    TASSERT_EQ(d->getState(), ResourceLoader::Finished);
+    TASSERT_EQ(d->getResource(), a->getResource());
+    TASSERT_EQ(loader.getOutstandingCount(), 0);
+
+    a->release();
+    b->release();
+    c->release();
+    d->release();
+}
+
+void TestResourceLoader::TestArchiveRequests() {
+    ResourceGroupManager resources;
+    resources.addResourceLocation("./test_deflate.zip", true);
+
+    std::vector<std::string> names;
+    resources.getResourceNames(names);
+    TASSERT_EQ(names.size(), 98);
+
+    ResourceLoader loader(4);
+    ResourceManager<std::string> manager;
+    ContentsFactory *factory = new ContentsFactory(&resources);
+    manager.registerFactory(factory);
+    manager.setResourceLoader(&loader);
+
+    // Every entry is requested at once, so the workers all read the archive together.
+    std::vector<ResourceManager<std::string>::Request*> requests;
+    for (int i = 0; i < names.size(); i++) {
+        requests.push_back(manager.requestResource(names[i]));
+    }
+
+    loader.flush();
+    TASSERT_EQ(loader.getFailedCount(), 0);
+    TASSERT_EQ(loader.getFinishedCount(), names.size());
+
+    for (int i = 0; i < requests.size(); i++) {
+        TASSERT_EQ(requests[i]->getState(), ResourceLoader::Finished);
+        std::string *expected = factory->load(names[i]);
+        TASSERT(*requests[i]->getResource() == *expected);
+        delete expected;
+        requests[i]->release();
+    }
+}
@@ -0,0 +1,29 @@
+/*
+ *  TestResourceLoader.h
+ *  Base
+ *
+ *  Created by loch on 4/26/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _TESTRESOURCELOADER_H_
+#define _TESTRESOURCELOADER_H_
+#include "Test.h"
+
+class TestResourceLoader : public Test<TestResourceLoader> {
+public:
+    TestResourceLoader(): Test<TestResourceLoader>() {}
+    static void RunTests();
+
+private:
+    static void TestPriorityOrder();
+    static void TestCancel();
+    static void TestFailure();
+    static void TestThreaded();
+    static void TestManagerRequests();
+    static void TestArchiveRequests();
+
+};
+
+#endif
@@ -10,8 +10,58 @@
 #include "TestResourceManager.h"
 #include "ResourceManager.h"
 
+/*! Builds ints from their names. */
+class ValueFactory : public ResourceFactory<int> {
+public:
+    ValueFactory(): ResourceFactory<int>(NULL) {}
+    virtual bool canLoad(const std::string &name) { return true; }
+    virtual int* load(const std::string &name) { return new int(atoi(name.c_str())); }
+};
+
+/*! Treats each int as its own size in bytes. */
+class SizedManager : public ResourceManager<int> {
+public:
+    SizedManager() { registerFactory(new ValueFactory()); }
+
+    bool isCached(const std::string &name) {
+        return _namedResources.find(name) != _namedResources.end();
+    }
+
+protected:
+    virtual void measureResource(const int *resource, long long &cpuBytes,
+                                 long long &gpuBytes) const {
+        gpuBytes = *resource;
+    }
+};
+
+/*! Stands in for a Material, which holds references to the Textures it uses. */
+struct Holder {
+    ResourceReferences references;
+};
+
+/*! Builds Holders that acquire the int named by the Holder's name, the way
+ *  MaterialFactory acquires textures. */
+class HolderFactory : public ResourceFactory<Holder> {
+public:
+    HolderFactory(SizedManager *values): ResourceFactory<Holder>(NULL), _values(values) {}
+    virtual bool canLoad(const std::string &name) { return true; }
+    virtual Holder* load(const std::string &name) {
+        Holder *holder = new Holder();
+        _values->acquireResource(name);
+        holder->references.add(_values, name);
+        return holder;
+    }
+
+private:
+    SizedManager *_values;
+};
+
 void TestResourceManager::RunTests() {
     TestResourceAddition();
+    TestMemoryBudget();
+    TestReferences();
+    TestGroups();
+    TestOwnedReferences();
     TestResourceRetrieval();
 }
 
@@ -45,3 +95,119 @@ void TestResourceManager::TestResourceRetrieval() {
     TASSERT(manager.getCachedResource("name") == NULL);
     TASSERT(manager.getCachedResource("unname") == NULL);
 }
+
+void TestResourceManager::TestMemoryBudget() {
+    SizedManager manager;
+    manager.setMemoryBudget(100);
+
+    manager.getOrLoadResource("40");
+    manager.getOrLoadResource("30");
+    manager.getOrLoadResource("20");
+    TASSERT_EQ(manager.getMemoryUsage(), 90);
+
+    // The oldest resource goes first.
+    manager.getOrLoadResource("50");
+    TASSERT_EQ(manager.getMemoryUsage(), 100);
+    TASSERT(!manager.isCached("40"));
+
+    // Using a resource keeps it around.
+    manager.getOrLoadResource("30");
+    manager.getOrLoadResource("60");
+    TASSERT_EQ(manager.getMemoryUsage(), 90);
+    TASSERT(manager.isCached("30"));
+    TASSERT(manager.isCached("60"));
+    TASSERT(!manager.isCached("20"));
+    TASSERT(!manager.isCached("50"));
+
+    ResourceStats stats = manager.getStats();
+    TASSERT_EQ(stats.loaded, 2);
+    TASSERT_EQ(stats.gpuBytes, 90);
+    TASSERT_EQ(stats.evictions, 3);
+    TASSERT_EQ(stats.hits, 1);
+    TASSERT_EQ(stats.misses, 5);
+
+    // Lowering the budget evicts immediately.
+    manager.setMemoryBudget(60);
+    TASSERT_EQ(manager.getMemoryUsage(), 60);
+    TASSERT(!manager.isCached("30"));
+}
+
+void TestResourceManager::TestReferences() {
+    SizedManager manager;
+    manager.setMemoryBudget(50);
+
+    manager.acquireResource("40");
+    manager.acquireResource("40");
+    TASSERT_EQ(manager.getReferenceCount("40"), 2);
+
+    // Neither can go. The new one was just handed out, and the old one is referenced.
+    manager.getOrLoadResource("30");
+    TASSERT_EQ(manager.getMemoryUsage(), 70);
+
+    manager.releaseResource("40");
+    TASSERT(manager.isCached("40"));
+
+    manager.releaseResource("40");
+    TASSERT_EQ(manager.getReferenceCount("40"), 0);
+    TASSERT(!manager.isCached("40"));
+    TASSERT_EQ(manager.getMemoryUsage(), 30);
+}
+
+void TestResourceManager::TestGroups() {
+    ResourceLoader loader(0);
+    SizedManager manager;
+    manager.setResourceLoader(&loader);
+
+    manager.addToGroup("Level", "10");
+    manager.addToGroup("Level", "20");
+    manager.getOrLoadResource("10");
+    manager.getOrLoadResource("20");
+    manager.getOrLoadResource("5");
+
+    manager.pinGroup("Level");
+    TASSERT(manager.isPinned("10"));
+    TASSERT(!manager.isPinned("5"));
+    TASSERT_EQ(manager.getStats().pinned, 2);
+
+    TASSERT_EQ(manager.evictResources(0), 1);
+    TASSERT_EQ(manager.getMemoryUsage(), 30);
+
+    manager.unloadGroup("Level");
+    TASSERT(!manager.isPinned("10"));
+    TASSERT_EQ(manager.resourcesLoaded(), 0);
+
+    manager.prefetchGroup("Level");
+    TASSERT_EQ(manager.getPendingCount(), 2);
+    loader.flush();
+    TASSERT_EQ(manager.getPendingCount(), 0);
+    TASSERT(manager.isCached("10"));
+    TASSERT(manager.isCached("20"));
+    TASSERT_EQ(manager.getMemoryUsage(), 30);
+}
+
+void TestResourceManager::TestOwnedReferences() {
+    // Declared first so the holders go before the values they reference.
+    SizedManager values;
+    ResourceManager<Holder> holders;
+    holders.registerFactory(new HolderFactory(&values));
+
+    holders.getOrLoadResource("40");
+    TASSERT_EQ(values.getReferenceCount("40"), 1);
+
+    // While its holder is loaded, the value can't be evicted.
+    TASSERT_EQ(values.evictResources(0), 0);
+    TASSERT(values.isCached("40"));
+
+    // Unloading the holder gives the reference back, so now it can.
+    holders.unloadResource("40");
+    TASSERT_EQ(values.getReferenceCount("40"), 0);
+    TASSERT_EQ(values.evictResources(0), 1);
+    TASSERT(!values.isCached("40"));
+
+    // Groups release the same way.
+    holders.addToGroup("Level", "30");
+    holders.getOrLoadResource("30");
+    holders.unloadGroup("Level");
+    TASSERT_EQ(values.getReferenceCount("30"), 0);
+    TASSERT_EQ(values.evictResources(0), 1);
+}
@@ -20,6 +20,10 @@ private:
     typedef int Resource;
     static void TestResourceAddition();
     static void TestResourceRetrieval();
+    static void TestMemoryBudget();
+    static void TestReferences();
+    static void TestGroups();
+    static void TestOwnedReferences();
 
 };
 
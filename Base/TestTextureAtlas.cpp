@@ -0,0 +1,209 @@
+/*
+ *  TestTextureAtlas.cpp
+ *  Base
+ *
+ *  Created by loch on 5/12/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "TestTextureAtlas.h"
+#include "TextureAtlas.h"
+#include "RectPacker.h"
+
+/*! Builds an image filled with a single color. */
+static ImageCache::Level MakeImage(unsigned int width, unsigned int height, int seed) {
+    ImageCache::Level image;
+    image.width = width;
+    image.height = height;
+    image.data.resize(width * height * 4);
+    for (int i = 0; i < image.data.size(); i += 4) {
+        image.data[i + 0] = seed * 37;
+        image.data[i + 1] = seed * 91 + 64;
+        image.data[i + 2] = seed * 13 + 128;
+        image.data[i + 3] = 255;
+    }
+
+    return image;
+}
+
+/*! Fills an atlas with a mix of tile and icon sized images. */
+static void AddImages(TextureAtlas &atlas, int count) {
+    static const unsigned int sizes[][2] = { {16, 16}, {32, 32}, {8, 24}, {13, 7}, {24, 48}, {1, 1} };
+    for (int i = 0; i < count; i++) {
+        std::ostringstream name;
+        name << "image" << i << ".png";
+        atlas.add(name.str(), MakeImage(sizes[i % 6][0], sizes[i % 6][1], i + 1));
+    }
+}
+
+/*! Checks that every texel of each image's region, plus one texel of gutter all the way
+ *  around it, holds only that image's color at every level of every page. Returns the
+ *  largest difference found in any channel. */
+static int LargestBleed(const TextureAtlas &atlas, bool compressed, ImageCache::Format format) {
+    int largest = 0;
+    for (int i = 0; i < atlas.getImageCount(); i++) {
+        const TextureAtlas::Region &region = atlas.getRegion(i);
+        const std::vector<ImageCache::Level> &page = atlas.getPage(region.page);
+        ImageCache::Level expected = MakeImage(1, 1, i + 1);
+
+        for (int k = 0; k < page.size(); k++) {
+            ImageCache::Level level;
+            if (compressed) { ImageCache::Decompress(page[k], format, level); }
+            else { level = page[k]; }
+
+            int x0 = (region.x >> k) - 1, y0 = (region.y >> k) - 1;
+            int x1 = (region.x + region.width + (1 << k) - 1) >> k;
+            int y1 = (region.y + region.height + (1 << k) - 1) >> k;
+            for (int y = y0; y <= y1; y++) {
+                for (int x = x0; x <= x1; x++) {
+                    const unsigned char *texel = &level.data[(y * level.width + x) * 4];
+                    for (int c = 0; c < 4; c++) {
+                        largest = Math::Max(largest, abs(texel[c] - expected.data[c]));
+                    }
+                }
+            }
+        }
+    }
+
+    return largest;
+}
+
+void TestTextureAtlas::RunTests() {
+    TestPacker();
+    TestPlacement();
+    TestGutters();
+    TestCompressedGutters();
+    TestRemap();
+}
+
+void TestTextureAtlas::TestPacker() {
+    RectPacker packer(256, 256);
+    std::vector<RectPacker::Rect> placed;
+    srand(7);
+
+    // Keep going until something doesn't fit.
+    RectPacker::Rect rect;
+    while (packer.insert(4 + rand() % 28, 4 + rand() % 28, rect)) {
+        placed.push_back(rect);
+    }
+
+    TASSERT(placed.size() > 50);
+    TASSERT(packer.getOccupancy() > .8);
+    Info("Packed " << placed.size() << " rectangles at " << packer.getOccupancy() * 100 << "% occupancy.");
+
+    RectPacker::Rect bin(0, 0, 256, 256);
+    for (int i = 0; i < placed.size(); i++) {
+        TASSERT(placed[i].isContainedIn(bin));
+        for (int j = i + 1; j < placed.size(); j++) {
+            TASSERT(!placed[i].overlaps(placed[j]));
+        }
+    }
+
+    // A failed insert changes nothing.
+    Real occupancy = packer.getOccupancy();
+    TASSERT(!packer.insert(257, 1, rect));
+    TASSERT_EQ(packer.getOccupancy(), occupancy);
+
+    // Exact fits fill the bin completely.
+    packer.reset(64, 64);
+    for (int i = 0; i < 16; i++) {
+        TASSERT(packer.insert(16, 16, rect));
+    }
+
+    TASSERT(!packer.insert(1, 1, rect));
+    TASSERT_EQ(packer.getOccupancy(), 1);
+}
+
+void TestTextureAtlas::TestPlacement() {
+    TextureAtlas::Options options;
+    options.pageWidth = options.pageHeight = 128;
+    options.padding = 2;
+    options.mipLevels = 3;
+    TextureAtlas atlas(options);
+
+    TASSERT_EQ(atlas.getAlignment(), 4);
+    TASSERT_EQ(atlas.getGutter(), 4);
+
+    // Enough to spill onto a second page, plus one that can't fit anywhere.
+    AddImages(atlas, 30);
+    int huge = atlas.add("huge.png", MakeImage(128, 16, 99));
+    TASSERT_EQ(atlas.build(), 30);
+    TASSERT_EQ(atlas.getPageCount(), 2);
+    TASSERT_EQ(atlas.getRegion(huge).page, -1);
+    TASSERT(!atlas.findRegion("huge.png"));
+    TASSERT(atlas.findRegion("image3.png") == &atlas.getRegion(3));
+
+    for (int i = 0; i < 30; i++) {
+        const TextureAtlas::Region &a = atlas.getRegion(i);
+        TASSERT(a.page >= 0);
+        TASSERT_EQ((a.x - atlas.getGutter()) % atlas.getAlignment(), 0);
+        TASSERT_EQ((a.y - atlas.getGutter()) % atlas.getAlignment(), 0);
+        TASSERT(a.x + a.width + atlas.getGutter() <= 128);
+        TASSERT(a.y + a.height + atlas.getGutter() <= 128);
+
+        // Images, with their gutters, never overlap.
+        RectPacker::Rect cellA(a.x - 4, a.y - 4, a.width + 8, a.height + 8);
+        for (int j = i + 1; j < 30; j++) {
+            const TextureAtlas::Region &b = atlas.getRegion(j);
+            RectPacker::Rect cellB(b.x - 4, b.y - 4, b.width + 8, b.height + 8);
+            TASSERT(a.page != b.page || !cellA.overlaps(cellB));
+        }
+    }
+
+    // The mip chain stops once gutters would run out.
+    TASSERT_EQ(atlas.getPage(0).size(), 3);
+    TASSERT_EQ(atlas.getPage(0)[2].width, 32);
+    TASSERT(atlas.getOccupancy() > 0 && atlas.getOccupancy() < 1);
+}
+
+void TestTextureAtlas::TestGutters() {
+    TextureAtlas::Options options;
+    options.pageWidth = options.pageHeight = 256;
+    options.padding = 1;
+    options.mipLevels = 4;
+    TextureAtlas atlas(options);
+    AddImages(atlas, 40);
+    TASSERT_EQ(atlas.build(), 40);
+
+    // Box filtering whole aligned cells never mixes images, at any kept level.
+    TASSERT_EQ(LargestBleed(atlas, false, ImageCache::RGBA), 0);
+}
+
+void TestTextureAtlas::TestCompressedGutters() {
+    TextureAtlas::Options options;
+    options.pageWidth = options.pageHeight = 256;
+    options.mipLevels = 2;
+    options.format = ImageCache::DXT1;
+    TextureAtlas atlas(options);
+    TASSERT_EQ(atlas.getAlignment(), 8);
+
+    AddImages(atlas, 30);
+    TASSERT_EQ(atlas.build(), 30);
+    TASSERT_EQ(atlas.getPage(0)[0].data.size(), 256 * 256 / 2);
+
+    // Every block holds a single color, so only 5:6:5 rounding is left.
+    TASSERT(LargestBleed(atlas, true, ImageCache::DXT1) <= 4);
+}
+
+void TestTextureAtlas::TestRemap() {
+    TextureAtlas::Region region;
+    region.page = 0;
+    region.offset = Vector2(.25, .5);
+    region.scale = Vector2(.125, .25);
+
+    float coords[] = { 0, 0, 7,  1, 1, 7,  .5, .5, 7 };
+    TASSERT(TextureAtlas::IsInUnitRange(coords, 3, 3));
+    TextureAtlas::RemapTexCoords(region, coords, 3, 3);
+    TASSERT_EQ(coords[0], .25f);
+    TASSERT_EQ(coords[1], .5f);
+    TASSERT_EQ(coords[2], 7);
+    TASSERT_EQ(coords[3], .375f);
+    TASSERT_EQ(coords[4], .75f);
+    TASSERT_EQ(coords[6], .3125f);
+
+    // Repeating coordinates can't be remapped.
+    float repeating[] = { 0, 0, 1.5, 1 };
+    TASSERT(!TextureAtlas::IsInUnitRange(repeating, 2));
+    TASSERT(TextureAtlas::IsInUnitRange(repeating, 1));
+}
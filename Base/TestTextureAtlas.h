@@ -0,0 +1,28 @@
+/*
+ *  TestTextureAtlas.h
+ *  Base
+ *
+ *  Created by loch on 5/12/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _TESTTEXTUREATLAS_H_
+#define _TESTTEXTUREATLAS_H_
+#include "Test.h"
+
+class TestTextureAtlas : public Test<TestTextureAtlas> {
+public:
+    TestTextureAtlas(): Test<TestTextureAtlas>() {}
+    static void RunTests();
+
+private:
+    static void TestPacker();
+    static void TestPlacement();
+    static void TestGutters();
+    static void TestCompressedGutters();
+    static void TestRemap();
+
+};
+
+#endif
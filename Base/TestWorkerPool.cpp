@@ -0,0 +1,76 @@
+/*
+ *  TestWorkerPool.cpp
+ *  Base
+ *
+ *  Created by loch on 4/12/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "TestWorkerPool.h"
+#include "WorkerPool.h"
+
+void TestWorkerPool::RunTests() {
+    TestNoThreads();
+    TestEveryIndexOnce();
+    TestRepeatedJobs();
+    TestTinyJobs();
+}
+
+static void CountIndex(void *data, int index) {
+    int *counts = static_cast<int*>(data);
+    __sync_fetch_and_add(counts + index, 1);
+}
+
+static bool CheckCounts(const std::vector<int> &counts, int expected) {
+    for (int i = 0; i < counts.size(); i++) {
+        if (counts[i] != expected) { return false; }
+    }
+
+    return true;
+}
+
+void TestWorkerPool::TestNoThreads() {
+    WorkerPool pool(0);
+    TASSERT_EQ(pool.getThreadCount(), 0);
+
+    std::vector<int> counts(100, 0);
+    pool.run(CountIndex, &counts[0], counts.size());
+    TASSERT(CheckCounts(counts, 1));
+}
+
+void TestWorkerPool::TestEveryIndexOnce() {
+    WorkerPool pool(4);
+    TASSERT_EQ(pool.getThreadCount(), 4);
+
+    std::vector<int> counts(10000, 0);
+    pool.run(CountIndex, &counts[0], counts.size());
+    TASSERT(CheckCounts(counts, 1));
+
+    // Fewer pieces than threads.
+    std::vector<int> few(2, 0);
+    pool.run(CountIndex, &few[0], few.size());
+    TASSERT(CheckCounts(few, 1));
+}
+
+void TestWorkerPool::TestRepeatedJobs() {
+    WorkerPool pool(WorkerPool::GetProcessorCount());
+    std::vector<int> counts(64, 0);
+    for (int i = 0; i < 500; i++) {
+        pool.run(CountIndex, &counts[0], counts.size());
+    }
+
+    TASSERT(CheckCounts(counts, 500));
+}
+
+void TestWorkerPool::TestTinyJobs() {
+    // With more threads than pieces, most workers wake up to find nothing left, and may
+    // still be on their way out when the next job starts.
+    WorkerPool pool(4);
+    std::vector<int> counts(1, 0);
+    for (int i = 0; i < 5000; i++) {
+        pool.run(CountIndex, &counts[0], counts.size());
+    }
+
+    TASSERT(CheckCounts(counts, 5000));
+}
@@ -0,0 +1,27 @@
+/*
+ *  TestWorkerPool.h
+ *  Base
+ *
+ *  Created by loch on 4/12/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _TESTWORKERPOOL_H_
+#define _TESTWORKERPOOL_H_
+#include "Test.h"
+
+class TestWorkerPool : public Test<TestWorkerPool> {
+public:
+    TestWorkerPool(): Test<TestWorkerPool>() {}
+    static void RunTests();
+
+private:
+    static void TestNoThreads();
+    static void TestEveryIndexOnce();
+    static void TestRepeatedJobs();
+    static void TestTinyJobs();
+
+};
+
+#endif
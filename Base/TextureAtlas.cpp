@@ -0,0 +1,239 @@
+/*
+ *  TextureAtlas.cpp
+ *  Base
+ *
+ *  Created by loch on 5/12/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "TextureAtlas.h"
+#include "Assertion.h"
+#include "Math3D.h"
+#include <algorithm>
+#include <cstring>
+
+/*! Orders images tallest first, then widest, which is what MaxRects packs best. */
+class LargestFirst {
+public:
+    LargestFirst(const std::vector<ImageCache::Level> &images): _images(images) {}
+
+    bool operator()(int a, int b) const {
+        const ImageCache::Level &left = _images[a], &right = _images[b];
+        if (left.height != right.height) { return left.height > right.height; }
+        if (left.width != right.width) { return left.width > right.width; }
+        return a < b;
+    }
+
+private:
+    const std::vector<ImageCache::Level> &_images;
+
+};
+
+static bool IsPowerOfTwo(unsigned int value) {
+    return value && !(value & (value - 1));
+}
+
+#pragma mark TextureAtlas::Options definitions
+
+TextureAtlas::Options::Options():
+    pageWidth(1024),
+    pageHeight(1024),
+    padding(2),
+    mipLevels(3),
+    format(ImageCache::RGBA)
+{}
+
+#pragma mark TextureAtlas static definitions
+
+void TextureAtlas::RemapTexCoords(const Region &region, float *coords, unsigned int count,
+unsigned int stride) {
+    for (unsigned int i = 0; i < count; i++, coords += stride) {
+        coords[0] = region.offset[0] + coords[0] * region.scale[0];
+        coords[1] = region.offset[1] + coords[1] * region.scale[1];
+    }
+}
+
+bool TextureAtlas::IsInUnitRange(const float *coords, unsigned int count, unsigned int stride) {
+    for (unsigned int i = 0; i < count; i++, coords += stride) {
+        if (!(coords[0] >= 0 && coords[0] <= 1 && coords[1] >= 0 && coords[1] <= 1)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#pragma mark TextureAtlas definitions
+
+TextureAtlas::TextureAtlas(const Options &options): _options(options) {
+    ASSERT(IsPowerOfTwo(_options.pageWidth) && IsPowerOfTwo(_options.pageHeight));
+    _options.mipLevels = Math::Max(_options.mipLevels, 1u);
+
+    // See the class description for why these have to be so.
+    _alignment = (ImageCache::IsCompressed(_options.format) ? 4 : 1) << (_options.mipLevels - 1);
+    _gutter = Math::Max(_options.padding, 1u << (_options.mipLevels - 1));
+
+    ASSERT(_alignment <= _options.pageWidth && _alignment <= _options.pageHeight);
+}
+
+TextureAtlas::~TextureAtlas() {}
+
+int TextureAtlas::add(const std::string &name, const ImageCache::Level &image) {
+    ASSERT_EQ(image.data.size(), image.width * image.height * 4);
+    _names.push_back(name);
+    _images.push_back(image);
+    return _images.size() - 1;
+}
+
+int TextureAtlas::build() {
+    std::vector<int> order(_images.size());
+    for (int i = 0; i < order.size(); i++) { order[i] = i; }
+    std::sort(order.begin(), order.end(), LargestFirst(_images));
+
+    // Pack in units of the alignment, so every cell lands on a multiple of it.
+    int binWidth = _options.pageWidth / _alignment, binHeight = _options.pageHeight / _alignment;
+    std::vector<RectPacker> packers;
+    _regions.assign(_images.size(), Region());
+
+    int placed = 0;
+    for (int i = 0; i < order.size(); i++) {
+        const ImageCache::Level &image = _images[order[i]];
+        Region &region = _regions[order[i]];
+        region.page = -1;
+        region.width = image.width;
+        region.height = image.height;
+
+        int cellWidth = getCellSize(image.width) / _alignment;
+        int cellHeight = getCellSize(image.height) / _alignment;
+        if (cellWidth > binWidth || cellHeight > binHeight) {
+            Warn("Image " << _names[order[i]] << " (" << image.width << "x" << image.height <<
+                 ") is too big for a " << _options.pageWidth << "x" << _options.pageHeight <<
+                 " atlas page.");
+            continue;
+        }
+
+        // First fit across the pages. A fresh page always has room.
+        RectPacker::Rect cell;
+        int page = 0;
+        while (page < packers.size() && !packers[page].insert(cellWidth, cellHeight, cell)) {
+            page++;
+        }
+
+        if (page == packers.size()) {
+            packers.push_back(RectPacker(binWidth, binHeight));
+            packers.back().insert(cellWidth, cellHeight, cell);
+        }
+
+        region.page = page;
+        region.x = cell.x * _alignment + _gutter;
+        region.y = cell.y * _alignment + _gutter;
+        region.offset = Vector2((Real)region.x / _options.pageWidth,
+                                (Real)region.y / _options.pageHeight);
+        region.scale = Vector2((Real)region.width / _options.pageWidth,
+                               (Real)region.height / _options.pageHeight);
+        placed++;
+    }
+
+    _pages.assign(packers.size(), std::vector<ImageCache::Level>());
+    for (int page = 0; page < _pages.size(); page++) {
+        std::vector<ImageCache::Level> chain(1);
+        fillPage(page, chain[0]);
+        while (chain.size() < _options.mipLevels &&
+               (chain.back().width > 1 || chain.back().height > 1)) {
+            chain.push_back(ImageCache::Level());
+            ImageCache::Downsample(chain[chain.size() - 2], chain.back());
+        }
+
+        if (!ImageCache::IsCompressed(_options.format)) {
+            _pages[page].swap(chain);
+            continue;
+        }
+
+        _pages[page].resize(chain.size());
+        for (int i = 0; i < chain.size(); i++) {
+            ImageCache::Compress(chain[i], _options.format, _pages[page][i]);
+        }
+    }
+
+    return placed;
+}
+
+void TextureAtlas::fillPage(int page, ImageCache::Level &result) {
+    result.width = _options.pageWidth;
+    result.height = _options.pageHeight;
+    result.data.assign(result.width * result.height * 4, 0);
+
+    for (int i = 0; i < _regions.size(); i++) {
+        const Region &region = _regions[i];
+        if (region.page != page) { continue; }
+
+        // Fill the whole cell, clamping to the image, which extrudes its edges out into
+        // the gutter and the alignment padding.
+        const ImageCache::Level &image = _images[i];
+        unsigned int left = region.x - _gutter, bottom = region.y - _gutter;
+        unsigned int right = left + getCellSize(region.width);
+        unsigned int top = bottom + getCellSize(region.height);
+        for (unsigned int y = bottom; y < top; y++) {
+            int sourceY = Math::Min(Math::Max((int)y - (int)region.y, 0), (int)image.height - 1);
+            const unsigned char *source = &image.data[sourceY * image.width * 4];
+            unsigned char *destination = &result.data[(y * result.width + left) * 4];
+            for (unsigned int x = left; x < right; x++, destination += 4) {
+                int sourceX = Math::Min(Math::Max((int)x - (int)region.x, 0), (int)image.width - 1);
+                memcpy(destination, source + sourceX * 4, 4);
+            }
+        }
+    }
+}
+
+unsigned int TextureAtlas::getCellSize(unsigned int size) const {
+    return (size + _gutter * 2 + _alignment - 1) / _alignment * _alignment;
+}
+
+int TextureAtlas::getPageCount() const {
+    return _pages.size();
+}
+
+const std::vector<ImageCache::Level>& TextureAtlas::getPage(int page) const {
+    return _pages[page];
+}
+
+int TextureAtlas::getImageCount() const {
+    return _images.size();
+}
+
+const std::string& TextureAtlas::getName(int index) const {
+    return _names[index];
+}
+
+const TextureAtlas::Region& TextureAtlas::getRegion(int index) const {
+    return _regions[index];
+}
+
+const TextureAtlas::Region* TextureAtlas::findRegion(const std::string &name) const {
+    for (int i = 0; i < _names.size() && i < _regions.size(); i++) {
+        if (_names[i] == name) {
+            return _regions[i].page >= 0 ? &_regions[i] : NULL;
+        }
+    }
+
+    return NULL;
+}
+
+Real TextureAtlas::getOccupancy() const {
+    if (_pages.empty()) { return 0; }
+
+    long long used = 0;
+    for (int i = 0; i < _regions.size(); i++) {
+        if (_regions[i].page >= 0) { used += _regions[i].width * _regions[i].height; }
+    }
+
+    return (Real)used / ((Real)_options.pageWidth * _options.pageHeight * _pages.size());
+}
+
+const TextureAtlas::Options& TextureAtlas::getOptions() const {
+    return _options;
+}
+
+unsigned int TextureAtlas::getAlignment() const { return _alignment; }
+unsigned int TextureAtlas::getGutter() const    { return _gutter;    }
@@ -0,0 +1,125 @@
+/*
+ *  TextureAtlas.h
+ *  Base
+ *
+ *  Created by loch on 5/12/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _TEXTUREATLAS_H_
+#define _TEXTUREATLAS_H_
+#include "ImageCache.h"
+#include "RectPacker.h"
+#include "Vector.h"
+
+/*! TextureAtlas packs many small images into a few large pages, so things drawn with
+ *  different images can share a single texture. Each image is given a region of a page,
+ *  and texture coordinates meant for the image are remapped into that region with
+ *  RemapTexCoords.
+ *
+ *  Images are surrounded by a gutter of their own edge texels, so bilinear filtering at
+ *  an image's edge never picks up its neighbors. Mipmaps are harder, since every level
+ *  down averages texels across twice the distance. Each image's cell (the image plus its
+ *  gutter) is aligned to and padded out to 2^(mipLevels - 1) texels, and the gutter is at
+ *  least that wide, so down to the last kept level each cell still covers whole texels
+ *  and still has a texel of gutter around its image. The mip chain stops there. For
+ *  compressed pages, cells are aligned to four times that, so no DXT block ever holds
+ *  two images.
+ *
+ *  More mip levels means wider gutters, which wastes more space on tiny images. Only
+ *  images drawn with coordinates in [0, 1] can be atlased, since repeating one would
+ *  walk into its neighbors.
+ * \brief Packs small images into shared texture pages.
+ * \seealso RectPacker
+ * \seealso AtlasBuilder */
+class TextureAtlas {
+public:
+    struct Options {
+        Options();
+
+        unsigned int pageWidth;   //!< Must be a power of two.
+        unsigned int pageHeight;  //!< Must be a power of two.
+        unsigned int padding;     //!< The minimum gutter around each image, in texels.
+        unsigned int mipLevels;   //!< The number of levels kept in each page's chain.
+        ImageCache::Format format;
+    };
+
+    /*! Where an image ended up. Page is -1 if it didn't fit on a page at all. */
+    struct Region {
+        int page;
+        unsigned int x, y;        //!< The image's bottom left texel in the page.
+        unsigned int width, height;
+        Vector2 offset;           //!< The image's corner in page texture coordinates.
+        Vector2 scale;            //!< The image's size in page texture coordinates.
+    };
+
+public:
+    /*! Maps texture coordinates for a whole image into its region. Coordinates are
+     *  stride floats apart, and only the first two of each are changed. */
+    static void RemapTexCoords(const Region &region, float *coords, unsigned int count,
+                               unsigned int stride = 2);
+
+    /*! Returns true if every coordinate is in [0, 1], meaning the image is never
+     *  repeated and can safely be atlased. */
+    static bool IsInUnitRange(const float *coords, unsigned int count, unsigned int stride = 2);
+
+public:
+    TextureAtlas(const Options &options = Options());
+    ~TextureAtlas();
+
+    /*! Adds an RGBA image to be packed, in the bottom up order ImageCache uses.
+     * \return The image's index, for getRegion. */
+    int add(const std::string &name, const ImageCache::Level &image);
+
+    /*! Packs every image added so far into pages and builds each page's mip chain.
+     *  Packing starts over each time this is called.
+     * \return The number of images placed. Images too big for an empty page aren't. */
+    int build();
+
+    /*! Gets the number of pages built. */
+    int getPageCount() const;
+
+    /*! Gets a page's mip chain, in the atlas format. */
+    const std::vector<ImageCache::Level>& getPage(int page) const;
+
+    int getImageCount() const;
+
+    const std::string& getName(int index) const;
+
+    const Region& getRegion(int index) const;
+
+    /*! Finds the named image's region, returning NULL if there isn't one. */
+    const Region* findRegion(const std::string &name) const;
+
+    /*! Gets the fraction of the pages' area used by images, not counting gutters. */
+    Real getOccupancy() const;
+
+    const Options& getOptions() const;
+
+    /*! Gets the alignment cells are placed at, in texels. */
+    unsigned int getAlignment() const;
+
+    /*! Gets the width of the gutter around each image, in texels. */
+    unsigned int getGutter() const;
+
+protected:
+    /*! Gets the size of the cell holding an image of the given size, gutters included. */
+    unsigned int getCellSize(unsigned int size) const;
+
+    /*! Copies every image placed on the given page into a full size RGBA level. */
+    void fillPage(int page, ImageCache::Level &result);
+
+protected:
+    Options _options;
+    unsigned int _alignment;
+    unsigned int _gutter;
+
+    std::vector<std::string> _names;
+    std::vector<ImageCache::Level> _images;
+    std::vector<Region> _regions;
+    std::vector<std::vector<ImageCache::Level> > _pages;
+
+};
+
+#endif
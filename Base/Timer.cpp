@@ -10,24 +10,58 @@
 #include "Timer.h"
 #include "Logger.h"
 
-Timer::Timer(): _start(0), _elapsed(0), _factor(0.0) {
-    mach_timebase_info_data_t info = {0,0}; 
+#if SYS_PLATFORM == PLATFORM_APPLE
+#   include <mach/mach_time.h>
+#elif SYS_PLATFORM == PLATFORM_WIN32
+#   include <windows.h>
+#else
+#   include <time.h>
+#endif
+
+#if SYS_PLATFORM == PLATFORM_APPLE
+/*! The mach timebase never changes, so it is only looked up once. */
+static double GetTimebaseFactor() {
+    mach_timebase_info_data_t info = {0,0};
     mach_timebase_info(&info);
+    return (double) info.numer / (double) info.denom;
+}
+#elif SYS_PLATFORM == PLATFORM_WIN32
+static double GetCounterFactor() {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return 1e9 / (double) frequency.QuadPart;
+}
+#endif
 
-    _factor = (double) info.numer / (double) info.denom;
+uint64_t Timer::Now() {
+#if SYS_PLATFORM == PLATFORM_APPLE
+    static const double factor = GetTimebaseFactor();
+    return (uint64_t)(mach_absolute_time() * factor);
+#elif SYS_PLATFORM == PLATFORM_WIN32
+    static const double factor = GetCounterFactor();
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart * factor);
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+#endif
 }
 
-void Timer::start() { _start   = mach_absolute_time(); }
-void Timer::stop()  { _elapsed = mach_absolute_time() - _start; }
+Timer::Timer(): _start(0), _elapsed(0) {}
+
+void Timer::start() { _start   = Now(); }
+void Timer::stop()  { _elapsed = Now() - _start; }
 
 double Timer::seconds() {
-    return _elapsed * _factor * 1e-9;
+    return _elapsed * 1e-9;
 }
 
 double Timer::mseconds() {
-    return _elapsed * _factor * 1e-6;
+    return _elapsed * 1e-6;
 }
 
 double Timer::nseconds() {
-    return _elapsed * _factor;
+    return _elapsed;
 }
@@ -9,9 +9,21 @@
 
 #ifndef _TIMER_H_
 #define _TIMER_H_
-#include <mach/mach_time.h>
+#include "Platform.h"
+#include <stdint.h>
 
+/*! Timer measures intervals against the system's monotonic clock, with nanosecond
+ *  precision wherever the platform provides it. On OS X that's mach_absolute_time, on
+ *  Windows the performance counter, and everywhere else clock_gettime(CLOCK_MONOTONIC).
+ *  The clock never goes backwards and isn't affected by changes to the wall clock, so
+ *  it's safe to compare readings taken on different threads.
+ * \brief Measures elapsed time with a monotonic, high resolution clock. */
 class Timer {
+public:
+    /*! Gets the current reading of the monotonic clock, in nanoseconds. Only differences
+     *  between readings mean anything. */
+    static uint64_t Now();
+
 public:
     Timer();
     void start();
@@ -23,7 +35,6 @@ public:
 
 private:
     uint64_t _start, _elapsed;
-    double _factor;
 
 };
 
@@ -1,9 +0,0 @@
-#ifndef _TRIGTABLES_H_
-#define _TRIGTABLES_H_
-
-extern void setupTrigTables();
-extern double getSin(double radians);
-extern double getCos(double radians);
-extern double getTan(double radians);
-
-#endif
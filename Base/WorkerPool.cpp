@@ -0,0 +1,131 @@
+/*
+ *  WorkerPool.cpp
+ *  Base
+ *
+ *  Created by loch on 4/12/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "WorkerPool.h"
+#include "Assertion.h"
+#include <unistd.h>
+
+int WorkerPool::GetProcessorCount() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? count : 1;
+}
+
+WorkerPool::WorkerPool(int threadCount): _function(NULL), _data(NULL), _count(0), _next(0),
+_finished(0), _generation(0), _active(0), _shutdown(false) {
+    pthread_mutex_init(&_mutex, NULL);
+    pthread_cond_init(&_wake, NULL);
+    pthread_cond_init(&_done, NULL);
+
+    for (int i = 0; i < threadCount; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, WorkerPool::Launch, this) != 0) {
+            Warn("Could only create " << i << " of " << threadCount << " worker threads.");
+            break;
+        }
+
+        _threads.push_back(thread);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    pthread_mutex_lock(&_mutex);
+    _shutdown = true;
+    pthread_cond_broadcast(&_wake);
+    pthread_mutex_unlock(&_mutex);
+
+    for (int i = 0; i < _threads.size(); i++) {
+        pthread_join(_threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&_done);
+    pthread_cond_destroy(&_wake);
+    pthread_mutex_destroy(&_mutex);
+}
+
+int WorkerPool::getThreadCount() const {
+    return _threads.size();
+}
+
+void WorkerPool::run(JobFunction function, void *data, int count) {
+    if (count <= 0) { return; }
+
+    if (_threads.empty()) {
+        for (int i = 0; i < count; i++) { function(data, i); }
+        return;
+    }
+
+    // A worker woken for the last job may not have gotten the mutex until after that job
+    // returned, in which case it's still in work(). Let it leave before resetting anything.
+    pthread_mutex_lock(&_mutex);
+    while (_active > 0) {
+        pthread_cond_wait(&_done, &_mutex);
+    }
+
+    _function = function;
+    _data = data;
+    _count = count;
+    _next = 0;
+    _finished = 0;
+    _generation++;
+    pthread_cond_broadcast(&_wake);
+    pthread_mutex_unlock(&_mutex);
+
+    work();
+
+    // Wait for every piece to finish AND for every worker to stop looking for more, so
+    // the next job can safely reset everything.
+    pthread_mutex_lock(&_mutex);
+    while (__sync_add_and_fetch(&_finished, 0) < _count || _active > 0) {
+        pthread_cond_wait(&_done, &_mutex);
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+void* WorkerPool::Launch(void *pool) {
+    static_cast<WorkerPool*>(pool)->workerLoop();
+    return NULL;
+}
+
+void WorkerPool::workerLoop() {
+    unsigned int seen = 0;
+    pthread_mutex_lock(&_mutex);
+    while (true) {
+        while (!_shutdown && seen == _generation) {
+            pthread_cond_wait(&_wake, &_mutex);
+        }
+
+        if (_shutdown) { break; }
+
+        seen = _generation;
+        _active++;
+        pthread_mutex_unlock(&_mutex);
+
+        work();
+
+        pthread_mutex_lock(&_mutex);
+        _active--;
+        if (_active == 0) { pthread_cond_signal(&_done); }
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+void WorkerPool::work() {
+    while (true) {
+        int index = __sync_fetch_and_add(&_next, 1);
+        if (index >= _count) { break; }
+
+        _function(_data, index);
+
+        if (__sync_add_and_fetch(&_finished, 1) == _count) {
+            pthread_mutex_lock(&_mutex);
+            pthread_cond_signal(&_done);
+            pthread_mutex_unlock(&_mutex);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ *  WorkerPool.h
+ *  Base
+ *
+ *  Created by loch on 4/12/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _WORKERPOOL_H_
+#define _WORKERPOOL_H_
+#include "Base.h"
+#include <pthread.h>
+
+/*! WorkerPool maintains a set of worker threads that can be used to split a job up into
+ *  a number of independent pieces and run them in parallel. The threads are created once
+ *  and sleep between jobs, so running a job doesn't allocate anything or spawn threads.
+ *
+ *  The thread that calls run participates in the job, so a pool with N threads can have
+ *  N + 1 pieces in flight at once. A pool with no threads simply runs everything on the
+ *  calling thread.
+ * \brief A fixed set of threads for running data parallel jobs. */
+class WorkerPool {
+public:
+    /*! The function called for each piece of a job. It is given the user data passed to
+     *  run and the index of the piece to handle. */
+    typedef void (*JobFunction)(void *data, int index);
+
+    /*! Gets the number of processors available on this machine. */
+    static int GetProcessorCount();
+
+public:
+    /*! Creates a pool with the given number of worker threads. */
+    WorkerPool(int threadCount);
+
+    /*! Stops and joins all of the worker threads. */
+    ~WorkerPool();
+
+    /*! Gets the number of worker threads in the pool, not including the caller. */
+    int getThreadCount() const;
+
+    /*! Calls the given function once for each index in [0, count), spread across the
+     *  worker threads and the calling thread. Returns once every piece is finished. Only
+     *  one job may run at a time. */
+    void run(JobFunction function, void *data, int count);
+
+protected:
+    static void* Launch(void *pool);
+
+    /*! The main loop of each worker thread. */
+    void workerLoop();
+
+    /*! Handles pieces of the current job until there are none left. */
+    void work();
+
+protected:
+    std::vector<pthread_t> _threads;
+    pthread_mutex_t _mutex;
+    pthread_cond_t _wake;        //!< Signaled when a new job is started or on shutdown.
+    pthread_cond_t _done;        //!< Signaled when the last worker finishes a job.
+
+    JobFunction _function;       //!< The function for the current job.
+    void *_data;                 //!< The user data for the current job.
+    int _count;                  //!< The number of pieces in the current job.
+    volatile int _next;          //!< The next piece to be handed out.
+    volatile int _finished;      //!< The number of pieces finished so far.
+
+    unsigned int _generation;    //!< Incremented each time a job starts.
+    int _active;                 //!< The number of workers currently in work().
+    bool _shutdown;
+
+};
+
+#endif
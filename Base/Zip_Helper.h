@@ -13,6 +13,15 @@
 static const int ZIP_EndOfCDRSig  = 0x06054b50;
 static const int ZIP_LocalFileSig = 0x04034b50;
 static const int ZIP_FileSig      = 0x02014b50;
+static const int ZIP64_EndOfCDRSig        = 0x06064b50;
+static const int ZIP64_EndOfCDRLocatorSig = 0x07064b50;
+
+static const short ZIP_Stored   = 0; //!< Compression method for uncompressed entries.
+static const short ZIP_Deflated = 8; //!< Compression method for raw deflate entries.
+
+static const short ZIP64_ExtraID = 0x0001; //!< Tag of the ZIP64 extended information field.
+static const unsigned int ZIP64_Marker = 0xFFFFFFFF; //!< Marks a 32 bit field as in the ZIP64 extra.
+static const unsigned short ZIP64_CountMarker = 0xFFFF; //!< Marks a 16 bit count as in the ZIP64 record.
 
 #pragma pack(1)
 struct ZIP_LocalFileHeader {
@@ -69,6 +78,33 @@ struct ZIP_EndOfCDR {
     short commentLength;                  //2 bytes
     // .ZIP file comment (variable size)
 };
+
+struct ZIP64_EndOfCDRLocator {
+    int       signature;                  //4 bytes  (0x07064b50)
+    int       diskWithEndOfCDR;           //4 bytes
+    long long offsetOfEndOfCDR;           //8 bytes
+    int       numberOfDisks;              //4 bytes
+};
+
+struct ZIP64_EndOfCDR {
+    int       signature;                  //4 bytes  (0x06064b50)
+    long long sizeOfRecord;               //8 bytes
+    short     versionMadeBy;              //2 bytes
+    short     versionNeededToExtract;     //2 bytes
+    int       numberOfThisDisk;           //4 bytes
+    int       numberOfTheDiskWithStartOfCDR; //4 bytes
+    long long numberOfEntriesInCDROnThisDisk; //8 bytes
+    long long numberOfEntriesInCDR;       //8 bytes
+    long long sizeOfCDR;                  //8 bytes
+    long long offsetOfStartOfCDR;         //8 bytes
+    // zip64 extensible data sector (variable size)
+};
+
+struct ZIP_ExtraHeader {
+    short id;                             //2 bytes
+    short size;                           //2 bytes
+    // data (variable size)
+};
 #pragma pack()
 #endif
 
@@ -125,4 +161,42 @@ struct ZIP_EndOfCDR {
         the starting disk number        4 bytes
         .ZIP file comment length        2 bytes
         .ZIP file comment       (variable size)
+
+  D.  Zip64 end of central directory record:
+        zip64 end of central dir
+        signature                       4 bytes  (0x06064b50)
+        size of zip64 end of central
+        directory record                8 bytes
+        version made by                 2 bytes
+        version needed to extract       2 bytes
+        number of this disk             4 bytes
+        number of the disk with the
+        start of the central directory  4 bytes
+        total number of entries in the
+        central directory on this disk  8 bytes
+        total number of entries in the
+        central directory               8 bytes
+        size of the central directory   8 bytes
+        offset of start of central
+        directory with respect to
+        the starting disk number        8 bytes
+        zip64 extensible data sector    (variable size)
+
+  E.  Zip64 end of central directory locator:
+        zip64 end of central dir locator
+        signature                       4 bytes  (0x07064b50)
+        number of the disk with the
+        start of the zip64 end of
+        central directory               4 bytes
+        relative offset of the zip64
+        end of central directory record 8 bytes
+        total number of disks           4 bytes
+
+  F.  Zip64 extended information extra field (0x0001). Only the fields whose values in the
+      file header are 0xFFFFFFFF are present, in this order:
+        original uncompressed file size 8 bytes
+        size of compressed data         8 bytes
+        offset of local header record   8 bytes
+        number of the disk on which
+        this file starts                4 bytes
 */
@@ -0,0 +1,186 @@
+/*
+ *  AtlasBuilder.cpp
+ *  Mountainhome
+ *
+ *  Created by loch on 5/12/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "AtlasBuilder.h"
+#include "BasicMaterial.h"
+#include "MaterialManager.h"
+#include "TextureManager.h"
+#include "TextureCache.h"
+#include "TextureSDL.h"
+#include "ResourceGroupManager.h"
+
+#include <Base/FileSystem.h>
+#include <Base/Logger.h>
+
+#include <Render/Model.h>
+#include <Render/ModelMesh.h>
+#include <Render/RenderOperation.h>
+#include <Render/VertexArray.h>
+#include <Render/Buffer.h>
+
+AtlasBuilder::AtlasBuilder(const std::string &name, ResourceGroupManager *rManager,
+TextureManager *tManager, MaterialManager *mManager, const TextureAtlas::Options &options):
+    _name(name),
+    _resourceGroupManager(rManager),
+    _textureManager(tManager),
+    _materialManager(mManager),
+    _atlas(options)
+{}
+
+AtlasBuilder::~AtlasBuilder() {}
+
+bool AtlasBuilder::addTexture(const std::string &name) {
+    ImageCache::Level image;
+
+    std::string ext;
+    FileSystem::ExtractExtension(name, ext, true);
+    if (ext == "mht") {
+        // Only the largest level is needed. The atlas builds its own mipmaps.
+        const unsigned char *data = NULL;
+        long long length = 0;
+        IOTarget *source = _resourceGroupManager->mapResource(name, data, length);
+
+        ImageCache cache;
+        if (!cache.read(data, length)) {
+            delete source;
+            return false;
+        }
+
+        const ImageCache::LevelView &view = cache.getLevel(0);
+        image.width = view.width;
+        image.height = view.height;
+        image.data.assign(view.data, view.data + view.size);
+        if (ImageCache::IsCompressed(cache.getFormat())) {
+            ImageCache::Level compressed = image;
+            ImageCache::Decompress(compressed, cache.getFormat(), image);
+        }
+
+        delete source;
+    } else {
+        TextureSDL::Factory decoder(_resourceGroupManager, _textureManager);
+        if (!decoder.decode(name, image)) {
+            return false;
+        }
+    }
+
+    _atlas.add(name, image);
+    return true;
+}
+
+int AtlasBuilder::build() {
+    int placed = _atlas.build();
+    Info("Atlas " << _name << ": " << placed << " of " << _atlas.getImageCount() <<
+         " textures on " << _atlas.getPageCount() << " pages, " <<
+         _atlas.getOccupancy() * 100 << "% used.");
+
+    _pages.clear();
+    _materials.clear();
+    _regions.clear();
+    _remapped.clear();
+
+    for (int i = 0; i < _atlas.getPageCount(); i++) {
+        const std::vector<ImageCache::Level> &levels = _atlas.getPage(i);
+        std::vector<ImageCache::LevelView> views;
+        for (int j = 0; j < levels.size(); j++) {
+            views.push_back(ImageCache::GetView(levels[j]));
+        }
+
+        // Neighbors are only a gutter away, so don't let anything wrap into them.
+        std::ostringstream name;
+        name << _name << "-page" << i;
+        Texture *page = TextureCacheFactory::BuildTexture(name.str(), views,
+            _atlas.getOptions().format, _textureManager);
+        page->setTexCoordHandling(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+        _pages.push_back(page);
+    }
+
+    return placed;
+}
+
+int AtlasBuilder::apply(Model *model) {
+    int moved = 0;
+    for (int i = 0; i < model->getMeshCount(); i++) {
+        ModelMesh *mesh = model->getMesh(i);
+        BasicMaterial *material = dynamic_cast<BasicMaterial*>(mesh->getDefaultMaterial());
+        if (!material || !material->getTexture()) { continue; }
+
+        const TextureAtlas::Region *region = findRegion(material->getTexture());
+        if (!region) { continue; }
+
+        RenderOperation *op = mesh->getRenderOperation();
+        TexCoordBuffer *coords = op && op->getVertexArray() ?
+            op->getVertexArray()->getTexCoordBuffer(0) : NULL;
+        if (!coords) { continue; }
+
+        // Shared buffers only need moving once, and can't be moved twice.
+        RemapMap::iterator itr = _remapped.find(coords);
+        if (itr != _remapped.end()) {
+            if (itr->second != region) {
+                Warn("Mesh " << mesh->getName() << " shares texture coordinates with a mesh "
+                     "using a different texture. Leaving it off of the atlas.");
+                continue;
+            }
+        } else if (coords->remap(*region)) {
+            _remapped[coords] = region;
+        } else {
+            Info("Mesh " << mesh->getName() << " repeats its texture. Leaving it off of the atlas.");
+            continue;
+        }
+
+        mesh->setDefaultMaterial(getMaterial(region->page, material));
+        moved++;
+    }
+
+    return moved;
+}
+
+const TextureAtlas::Region* AtlasBuilder::findRegion(const Texture *texture) {
+    RegionMap::iterator itr = _regions.find(texture);
+    if (itr != _regions.end()) {
+        return itr->second;
+    }
+
+    const TextureAtlas::Region *region = _atlas.findRegion(_textureManager->getNameOf(texture));
+    _regions[texture] = region;
+    return region;
+}
+
+BasicMaterial* AtlasBuilder::getMaterial(int page, const BasicMaterial *source) {
+    for (int i = 0; i < _materials.size(); i++) {
+        BasicMaterial *material = _materials[i];
+        if (material->getTexture() == _pages[page] &&
+            material->getLightingEnabled() == source->getLightingEnabled() &&
+            material->getAmbient() == source->getAmbient() &&
+            material->getDiffuse() == source->getDiffuse())
+        {
+            return material;
+        }
+    }
+
+    std::ostringstream name;
+    name << _name << "-page" << page << "-material" << _materials.size();
+    BasicMaterial *material = new BasicMaterial(name.str(), source->getAmbient(),
+        source->getDiffuse(), _pages[page]);
+    material->setLightingEnabled(source->getLightingEnabled());
+    _materialManager->registerResource(material);
+    _materials.push_back(material);
+    return material;
+}
+
+int AtlasBuilder::getPageCount() const {
+    return _pages.size();
+}
+
+Texture* AtlasBuilder::getPage(int page) {
+    return _pages[page];
+}
+
+const TextureAtlas& AtlasBuilder::getAtlas() const {
+    return _atlas;
+}
@@ -0,0 +1,91 @@
+/*
+ *  AtlasBuilder.h
+ *  Mountainhome
+ *
+ *  Created by loch on 5/12/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _ATLASBUILDER_H_
+#define _ATLASBUILDER_H_
+#include <Base/TextureAtlas.h>
+#include <map>
+
+class ResourceGroupManager;
+class TextureManager;
+class MaterialManager;
+class TexCoordBuffer;
+class BasicMaterial;
+class Texture;
+class Model;
+
+/*! Moves models textured with lots of small images onto a few shared atlas pages, so
+ *  the RenderQueue can group what used to be separate textures. Textures are added by
+ *  name and decoded from disk again, since reading them back off of the card is slow.
+ *  Once built, each page is uploaded as its own Texture, named "<atlas>-page<N>".
+ *
+ *  apply moves a Model's meshes onto the atlas. Each mesh drawn with a BasicMaterial
+ *  whose texture was atlased has its texture coordinates remapped in place, and is
+ *  switched to a BasicMaterial shared by every mesh with the same page, colors, and
+ *  lighting. Sharing the Material means RenderContext doesn't change any state between
+ *  those meshes, and meshes sharing geometry as well can be instanced together.
+ *
+ *  Meshes are left alone if their coordinates repeat the texture, or if they share a
+ *  TexCoordBuffer with a mesh that was moved into a different region. Generic Materials
+ *  aren't touched, since there's no telling what their shaders do with texcoords.
+ * \brief Packs textures into atlas pages and moves models onto them.
+ * \seealso TextureAtlas */
+class AtlasBuilder {
+public:
+    AtlasBuilder(const std::string &name, ResourceGroupManager *rManager,
+                 TextureManager *tManager, MaterialManager *mManager,
+                 const TextureAtlas::Options &options = TextureAtlas::Options());
+
+    ~AtlasBuilder();
+
+    /*! Decodes the named texture and queues it for packing. Loose images and .mht caches
+     *  both work.
+     * \return false if the texture couldn't be decoded. */
+    bool addTexture(const std::string &name);
+
+    /*! Packs every texture added so far and uploads the pages.
+     * \return The number of textures placed. */
+    int build();
+
+    /*! Moves every mesh in the model that can use the atlas onto it.
+     * \return The number of meshes moved. */
+    int apply(Model *model);
+
+    int getPageCount() const;
+
+    Texture* getPage(int page);
+
+    const TextureAtlas& getAtlas() const;
+
+protected:
+    /*! Finds the region the given texture was packed into, or NULL if it wasn't. */
+    const TextureAtlas::Region* findRegion(const Texture *texture);
+
+    /*! Gets the shared Material for the given page that looks like the given one. */
+    BasicMaterial* getMaterial(int page, const BasicMaterial *source);
+
+protected:
+    typedef std::map<const Texture *, const TextureAtlas::Region *> RegionMap;
+    typedef std::map<TexCoordBuffer *, const TextureAtlas::Region *> RemapMap;
+
+    std::string _name;
+    ResourceGroupManager *_resourceGroupManager;
+    TextureManager *_textureManager;
+    MaterialManager *_materialManager;
+
+    TextureAtlas _atlas;
+    std::vector<Texture *> _pages;
+    std::vector<BasicMaterial *> _materials;  //!< Owned by the MaterialManager.
+
+    RegionMap _regions;                        //!< Lookups by Texture, cached.
+    RemapMap _remapped;                        //!< Every buffer moved so far.
+
+};
+
+#endif
@@ -7,7 +7,10 @@
  *
  */
 
+#include <Base/ResourceLoader.h>
 #include <Base/FileSystem.h>
+#include <Base/WorkerPool.h>
+#include <algorithm>
 
 #include "Content.h"
 
@@ -19,6 +22,7 @@
 #include "FontManager.h"
 
 ResourceGroupManager *Content::_resourceGroupManager = NULL;
+ResourceLoader *Content::_resourceLoader = NULL;
 MaterialManager *Content::_materialManager = NULL;
 TextureManager *Content::_textureManager = NULL;
 ShaderManager *Content::_shaderManager = NULL;
@@ -30,6 +34,7 @@ TextureManager * Content::GetTextureManager()   { return _textureManager;  }
 ShaderManager * Content::GetShaderManager()     { return _shaderManager;   }
 ModelManager * Content::GetModelManager()       { return _modelManager;    }
 FontManager * Content::GetFontManager()         { return _fontManager;     }
+ResourceLoader * Content::GetResourceLoader()   { return _resourceLoader;  }
 
 void Content::Initialize() {
     _resourceGroupManager = new ResourceGroupManager();
@@ -38,6 +43,18 @@ void Content::Initialize() {
     _modelManager = new ModelManager(_resourceGroupManager, _textureManager);
     _materialManager = new MaterialManager(_resourceGroupManager, _shaderManager, _textureManager);
     _fontManager = new FontManager(_resourceGroupManager, _materialManager, _textureManager, _shaderManager);
+
+    // Leave a processor free for the main thread.
+    _resourceLoader = new ResourceLoader(std::max(WorkerPool::GetProcessorCount() - 1, 1));
+    _textureManager->setResourceLoader(_resourceLoader);
+    _shaderManager->setResourceLoader(_resourceLoader);
+    _modelManager->setResourceLoader(_resourceLoader);
+    _materialManager->setResourceLoader(_resourceLoader);
+    _fontManager->setResourceLoader(_resourceLoader);
+}
+
+void Content::UpdateLoader(double budgetMilliseconds) {
+    _resourceLoader->update(budgetMilliseconds);
 }
 
 void Content::AddResourceDir(const std::string &dir) {
@@ -13,6 +13,7 @@
 #include <string>
 
 class ResourceGroupManager;
+class ResourceLoader;
 class MaterialManager;
 class TextureManager;
 class ShaderManager;
@@ -63,12 +64,19 @@ public:
 
     static FontManager * GetFontManager();
 
+    static ResourceLoader * GetResourceLoader();
+
     static void Initialize();
 
     static void AddResourceDir(const std::string &dir);
 
+    /*! Finishes background resource loads on the main thread. This should be called once
+     *  a frame, and will spend roughly the given amount of time uploading resources. */
+    static void UpdateLoader(double budgetMilliseconds);
+
 private:
     static ResourceGroupManager *_resourceGroupManager;
+    static ResourceLoader *_resourceLoader;
     static MaterialManager *_materialManager;
     static TextureManager *_textureManager;
     static ShaderManager *_shaderManager;
@@ -13,7 +13,9 @@
 #include "ShaderGLSL.h"
 #include "MaterialManager.h"
 
-FontManager::FontManager(ResourceGroupManager *rManager, MaterialManager *mManager, TextureManager *tManager, ShaderManager *sManager) {
+FontManager::FontManager(ResourceGroupManager *rManager, MaterialManager *mManager, TextureManager *tManager, ShaderManager *sManager):
+    ResourceManager<Font>(rManager)
+{
     registerFactory(new FontTTF::Factory(rManager, mManager, tManager));
 
     std::string fontVert =
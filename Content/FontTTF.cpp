@@ -44,12 +44,15 @@ bool FontTTF::Factory::canLoad(const std::string &name) {
 }
 
 Font* FontTTF::Factory::load(const std::string &name) {
+    std::string path = getPathFromKey("font");
     Font *font = new FontTTF(
-        _materialManager->getOrLoadResource("font"),
-        getPathFromKey("font"),
+        _materialManager->acquireResource("font"),
+        path,
         _ptree.get<int>("size"),
         _textureManager);
 
+    // The font keeps its material until it is unloaded.
+    font->holdReference(_materialManager, "font");
     font->setDefaultColor(_ptree.get<Vector4>("color", Vector4(1, 1, 1, 1)));
 
     return font;
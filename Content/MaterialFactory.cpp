@@ -56,7 +56,7 @@ ShaderParameter * MaterialFactory::parseInt<1>(const std::vector<std::string> &t
     return result;
 }
 
-ShaderParameter* MaterialFactory::parseShaderParameter(const std::string &input) {
+ShaderParameter* MaterialFactory::parseShaderParameter(const std::string &input, Material *mat) {
     // Break the string into tokens.
     std::vector<std::string> tokens;
     tokenize(input, " ", tokens);
@@ -78,8 +78,11 @@ ShaderParameter* MaterialFactory::parseShaderParameter(const std::string &input)
         default: THROW(InternalError, "Unhandled case value: " << tokens.size());
         }
     } else if (tokens[0] == "texture") {
+        Texture *texture = _textureManager->acquireResource(tokens[1]);
+        if (texture) { mat->holdReference(_textureManager, tokens[1]); }
+
         ShaderParameter *result = new ShaderParameter();
-        result->setData(_textureManager->getOrLoadResource(tokens[1]));
+        result->setData(texture);
         return result;
     }
 
@@ -101,7 +104,7 @@ void MaterialFactory::setGenericParameters(Material *mat) {
 
         if (generic) {
             std::string value = itr->second.get_value<std::string>();
-            mat->setShaderParameter(itr->first, parseShaderParameter(value));
+            mat->setShaderParameter(itr->first, parseShaderParameter(value, mat));
         }
     }
 }
@@ -110,12 +113,14 @@ Material* MaterialFactory::load(const std::string &name) {
     Material *mat = NULL;
     // If a shader is not set, we have a BasicMaterial, otherwise a generic Material.
     if (_ptree.find("shader") == _ptree.not_found()) {
+        BasicMaterial *basic = new BasicMaterial();
         Texture *texture = NULL;
         if (_ptree.find("texture") != _ptree.not_found()) {
-            texture = _textureManager->getOrLoadResource(_ptree.get<std::string>("texture"));
+            std::string textureName = _ptree.get<std::string>("texture");
+            texture = _textureManager->acquireResource(textureName);
+            if (texture) { basic->holdReference(_textureManager, textureName); }
         }
 
-        BasicMaterial *basic = new BasicMaterial();
         basic->setAmbient(_ptree.get<Vector4>("ambient",Vector4(1.0f)));
         basic->setDiffuse(_ptree.get<Vector4>("diffuse",Vector4(1.0f)));
         basic->setLightingEnabled(_ptree.get<bool>("lighting", false));
@@ -124,7 +129,7 @@ Material* MaterialFactory::load(const std::string &name) {
         mat = basic;
     } else {
         std::string name = _ptree.get<std::string>("shader");
-        Shader *shader = _shaderManager->getOrLoadResource(name);
+        Shader *shader = _shaderManager->acquireResource(name);
 
         if (!shader) {
             THROW(InternalError, "Could not load a shader named: " << name);
@@ -132,6 +137,7 @@ Material* MaterialFactory::load(const std::string &name) {
 
         mat = new Material(name);
         mat->setShader(shader);
+        mat->holdReference(_shaderManager, name);
         setGenericParameters(mat);
     }
 
@@ -21,7 +21,7 @@ public:
     Material* load(const std::string &args);
 
 private:
-    ShaderParameter * parseShaderParameter(const std::string &input);
+    ShaderParameter * parseShaderParameter(const std::string &input, Material *mat);
 
     void setGenericParameters(Material *mat);
 
@@ -13,7 +13,9 @@
 
 #include "BasicMaterial.h"
 
-MaterialManager::MaterialManager(ResourceGroupManager *rManager, ShaderManager *sManager, TextureManager *tManager) {
+MaterialManager::MaterialManager(ResourceGroupManager *rManager, ShaderManager *sManager, TextureManager *tManager):
+    ResourceManager<Material>(rManager)
+{
     registerFactory(new MaterialFactory(rManager, sManager, tManager));
 
     BasicMaterial::Init(sManager);
@@ -0,0 +1,178 @@
+/*
+ *  ModelCache.cpp
+ *  Mountainhome
+ *
+ *  Created by loch on 4/28/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "ModelCache.h"
+#include "TextureManager.h"
+#include "BasicMaterial.h"
+#include "ResourceGroupManager.h"
+
+#include <Base/FileSystem.h>
+#include <Base/MappedFile.h>
+#include <Base/Exception.h>
+
+#include <Render/VertexArray.h>
+#include <Render/RenderOperation.h>
+#include <Render/Buffer.h>
+
+/*! A mapped and validated cache, waiting to be uploaded. */
+class PreparedModelCache : public PreparedResource {
+public:
+    PreparedModelCache(IOTarget *source): source(source) {}
+    virtual ~PreparedModelCache() { delete source; }
+
+    IOTarget *source;   //!< Owns the memory the cache points into.
+    MeshCache cache;
+
+    void setBytes(long long bytes) { _bytes = bytes; }
+};
+
+#pragma mark ModelCacheFactory static definitions
+
+Model* ModelCacheFactory::BuildModel(
+    const std::string &name,
+    const std::vector<MeshCache::Bone> &cacheBones,
+    const std::vector<MeshCache::Material> &cacheMaterials,
+    const std::vector<MeshCache::MeshView> &cacheMeshes,
+    TextureManager *tManager
+) {
+    // Parents always come first, so the hierarchy can be built in a single pass.
+    std::vector<ModelBone *> bones;
+    ModelBone *root = NULL;
+    for (int i = 0; i < cacheBones.size(); i++) {
+        const MeshCache::Bone &source = cacheBones[i];
+        ModelBone *parent = source.parent >= 0 ? bones[source.parent] : NULL;
+        ModelBone *bone = new ModelBone(source.name, i, source.transform, parent,
+            std::vector<ModelBone *>());
+
+        if (parent) { parent->addChild(bone); }
+        else if (!root) { root = bone; }
+        bones.push_back(bone);
+    }
+
+    // Only build the materials something actually uses.
+    std::vector<Material *> materials(cacheMaterials.size(), (Material *)NULL);
+    std::vector<std::string> textures;
+    std::vector<ModelMesh *> meshes;
+    for (int i = 0; i < cacheMeshes.size(); i++) {
+        const MeshCache::MeshView &mesh = cacheMeshes[i];
+
+        Material *material = NULL;
+        if (mesh.material >= 0) {
+            if (!materials[mesh.material]) {
+                const MeshCache::Material &source = cacheMaterials[mesh.material];
+                BasicMaterial *basic = new BasicMaterial(source.name, source.ambient, source.diffuse);
+                basic->setLightingEnabled(source.lighting);
+                if (tManager && !source.texture.empty()) {
+                    Texture *texture = tManager->acquireResource(source.texture);
+                    if (texture) { textures.push_back(source.texture); }
+                    basic->setTexture(texture);
+                }
+
+                materials[mesh.material] = basic;
+            }
+
+            material = materials[mesh.material];
+        }
+
+        // The Buffers only read from the data they're given, so the const can go.
+        VertexArray *vertexArray = new VertexArray();
+        vertexArray->setPositionBuffer(new PositionBuffer(GL_STATIC_DRAW, GL_FLOAT, 3,
+            mesh.vertexCount, (void*)mesh.positions));
+
+        if (mesh.normals) {
+            vertexArray->setNormalBuffer(new NormalBuffer(GL_STATIC_DRAW, GL_FLOAT,
+                mesh.vertexCount, (void*)mesh.normals));
+        }
+
+        if (mesh.texCoords) {
+            vertexArray->setTexCoordBuffer(0, new TexCoordBuffer(GL_STATIC_DRAW, GL_FLOAT, 2,
+                mesh.vertexCount, (void*)mesh.texCoords));
+        }
+
+        // Caches are already narrowed, but meshes coming straight from an importer may not be.
+        IndexBuffer *indexBuffer = NULL;
+        if (mesh.indices && mesh.indexSize == sizeof(unsigned int) && mesh.vertexCount <= 0x10000) {
+            const unsigned int *source = (const unsigned int *)mesh.indices;
+            std::vector<unsigned short> narrow(source, source + mesh.indexCount);
+            indexBuffer = new IndexBuffer(GL_STATIC_DRAW, GL_UNSIGNED_SHORT,
+                mesh.indexCount, &narrow[0]);
+        } else if (mesh.indices) {
+            indexBuffer = new IndexBuffer(GL_STATIC_DRAW,
+                mesh.indexSize == sizeof(unsigned short) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+                mesh.indexCount, (void*)mesh.indices);
+        }
+
+        RenderOperation *op = new RenderOperation(TRIANGLES, vertexArray, indexBuffer);
+        ModelBone *bone = mesh.bone >= 0 ? bones[mesh.bone] : NULL;
+        meshes.push_back(new ModelMesh(mesh.name, op, material, bone, mesh.bounds));
+    }
+
+    // The model holds on to its textures until it is unloaded.
+    Model *model = new Model(name, root, meshes, bones);
+    for (int i = 0; i < textures.size(); i++) {
+        model->holdReference(tManager, textures[i]);
+    }
+
+    return model;
+}
+
+#pragma mark ModelCacheFactory definitions
+
+ModelCacheFactory::ModelCacheFactory(ResourceGroupManager *manager, TextureManager *tManager):
+ResourceFactory<Model>(manager), _textureManager(tManager) {}
+
+ModelCacheFactory::~ModelCacheFactory() {}
+
+bool ModelCacheFactory::canLoad(const std::string &name) {
+    std::string ext;
+    FileSystem::ExtractExtension(name, ext, true);
+    return ext == "mhm";
+}
+
+Model* ModelCacheFactory::load(const std::string &name) {
+    PreparedResource *prepared = prepare(name);
+    Model *result = finish(name, prepared);
+    delete prepared;
+    return result;
+}
+
+bool ModelCacheFactory::canPrepare(const std::string &name) {
+    return canLoad(name);
+}
+
+PreparedResource* ModelCacheFactory::prepare(const std::string &name) {
+    const unsigned char *data = NULL;
+    long long length = 0;
+    PreparedModelCache *prepared = new PreparedModelCache(
+        _resourceGroupManager->mapResource(name, data, length));
+
+    if (!prepared->cache.read(data, length)) {
+        delete prepared;
+        THROW(InvalidStateError, "Invalid mesh cache: " << name);
+    }
+
+    // Fault the streams in here rather than during the upload on the main thread.
+    MappedFile *file = dynamic_cast<MappedFile*>(prepared->source);
+    if (file) {
+        file->advise(MappedFile::WillNeed);
+    }
+
+    prepared->setBytes(length);
+    return prepared;
+}
+
+Model* ModelCacheFactory::finish(const std::string &name, PreparedResource *prepared) {
+    if (!prepared) {
+        return load(name);
+    }
+
+    const MeshCache &cache = static_cast<PreparedModelCache*>(prepared)->cache;
+    return BuildModel(name, cache.getBones(), cache.getMaterials(), cache.getMeshes(),
+        _textureManager);
+}
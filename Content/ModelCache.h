@@ -0,0 +1,53 @@
+/*
+ *  ModelCache.h
+ *  Mountainhome
+ *
+ *  Created by loch on 4/28/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _MODELCACHE_H_
+#define _MODELCACHE_H_
+#include "ResourceManager.h"
+#include "Model.h"
+#include <Base/MeshCache.h>
+
+class TextureManager;
+
+/*! Loads Models from the engine's native .mhm mesh caches. Caches are mapped rather than
+ *  read and their streams are handed directly to the Buffers, so loading one involves no
+ *  per vertex work at all. On the loader threads, the file is mapped, validated, and
+ *  paged in, leaving only the buffer uploads for the main thread.
+ *
+ *  This is also where Models are built from MeshCache data in general, so other factories
+ *  can extract their data into the same structures and share the construction code.
+ * \brief Builds Models out of .mhm mesh caches.
+ * \seealso MeshCache
+ * \seealso ModelFBXFactory::convert */
+class ModelCacheFactory : public ResourceFactory<Model> {
+public:
+    /*! Builds a Model from the given cache data. Textures named by the materials are
+     *  acquired from the given TextureManager, which may be NULL to skip texturing. */
+    static Model* BuildModel(const std::string &name, const std::vector<MeshCache::Bone> &bones,
+                             const std::vector<MeshCache::Material> &materials,
+                             const std::vector<MeshCache::MeshView> &meshes,
+                             TextureManager *tManager);
+
+public:
+    ModelCacheFactory(ResourceGroupManager *manager, TextureManager *tManager);
+    virtual ~ModelCacheFactory();
+
+    bool canLoad(const std::string &args);
+    Model* load(const std::string &args);
+
+    bool canPrepare(const std::string &args);
+    PreparedResource* prepare(const std::string &args);
+    Model* finish(const std::string &args, PreparedResource *prepared);
+
+private:
+    TextureManager *_textureManager;
+
+};
+
+#endif
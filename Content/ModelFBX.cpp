@@ -7,11 +7,13 @@
  */
 
 #include "ModelFBX.h"
+#include "ModelCache.h"
 #include <Base/FileSystem.h>
 #include <Base/Exception.h>
 
 #include <Base/Quaternion.h>
 #include <Base/SQT.h>
+#include <Base/MeshOptimizer.h>
 
 #include <Render/VertexArray.h>
 #include <Render/IndexBuffer.h>
@@ -72,6 +74,37 @@ bool ModelFBXFactory::canLoad(const std::string &name) {
 }
 
 Model *ModelFBXFactory::load(const std::string &name) {
+    std::vector<MeshCache::Material> materials;
+    std::vector<MeshCache::Mesh> meshes;
+    if (!extractScene(name, Content::GetModelManager()->getDefaultTransform(), materials, meshes)) {
+        return NULL;
+    }
+
+    std::vector<MeshCache::MeshView> views;
+    for (int i = 0; i < meshes.size(); i++) {
+        views.push_back(MeshCache::GetView(meshes[i]));
+    }
+
+    return ModelCacheFactory::BuildModel(name, std::vector<MeshCache::Bone>(), materials,
+        views, _textureManager);
+}
+
+bool ModelFBXFactory::convert(const std::string &name, IOTarget *target, const SQT &transform) {
+    std::vector<MeshCache::Material> materials;
+    std::vector<MeshCache::Mesh> meshes;
+    if (!extractScene(name, transform, materials, meshes)) {
+        return false;
+    }
+
+    return MeshCache::Write(target, std::vector<MeshCache::Bone>(), materials, meshes);
+}
+
+bool ModelFBXFactory::extractScene(
+    const std::string &name,
+    const SQT &transform,
+    std::vector<MeshCache::Material> &materials,
+    std::vector<MeshCache::Mesh> &meshes
+) {
     bool status;
 
     // Get version information for version checking
@@ -88,12 +121,12 @@ Model *ModelFBXFactory::load(const std::string &name) {
 
     if(status == false) {
         Error("Failed to load " << name << ": " << _importer->GetLastErrorString());
-        return NULL;
+        return false;
     }
 
     if(!_importer->IsFBX()) {
         Error("Failed to load " << name << ": not a valid FBX file.");
-        return NULL;
+        return false;
     }
 
     // Set up properties for the things we want out of the scene
@@ -118,24 +151,28 @@ Model *ModelFBXFactory::load(const std::string &name) {
 
     if(status == false) {
         Error("Failed to import FBX " << name);
-        return NULL;
+        return false;
     }
 
     // Get the root node
     KFbxNode *rootNode = _scene->GetRootNode();
     if(!rootNode) {
         Error("FBX file " << name << " contains no data!");
-        return NULL;
+        return false;
     }
 
-    std::vector<ModelMesh *> meshes;
-    buildModelMeshesFromScene(name, rootNode, meshes);
+    buildMeshesFromScene(name, rootNode, transform, materials, meshes);
     _scene->Destroy();
-
-    return new Model(name, meshes);
+    return true;
 }
 
-void ModelFBXFactory::buildModelMeshesFromScene(const std::string &name, KFbxNode *node, std::vector<ModelMesh *> &meshes) {
+void ModelFBXFactory::buildMeshesFromScene(
+    const std::string &name,
+    KFbxNode *node,
+    const SQT &transform,
+    std::vector<MeshCache::Material> &materials,
+    std::vector<MeshCache::Mesh> &meshes
+) {
     // Query the node name ...
     KString nodeName = node->GetName();
 
@@ -145,7 +182,10 @@ void ModelFBXFactory::buildModelMeshesFromScene(const std::string &name, KFbxNod
     if(attr != NULL) {
         // Get the type of attribute present, and branch accordingly
         switch (attr->GetAttributeType()) {
-        case KFbxNodeAttribute::eMESH:      meshes.push_back(fbxMeshToModelMesh(name, (KFbxMesh*)attr)); break;
+        case KFbxNodeAttribute::eMESH:
+            meshes.push_back(MeshCache::Mesh());
+            fbxMeshToCacheMesh(name, (KFbxMesh*)attr, transform, materials, meshes.back());
+            break;
         case KFbxNodeAttribute::eSKELETON: Info("Skipping eSKELETON node"); break; // FIXME: build some bones, eventually.
         case KFbxNodeAttribute::eMARKER:   Info("Skipping eMARKER node");   break; // Don't care.
         case KFbxNodeAttribute::eLIGHT:    Info("Skipping eLIGHT node");    break; // Don't care.
@@ -157,11 +197,17 @@ void ModelFBXFactory::buildModelMeshesFromScene(const std::string &name, KFbxNod
 
     // Parse the child nodes
     for(int i = 0; i < node->GetChildCount(); i++) {
-        buildModelMeshesFromScene(name, node->GetChild(i), meshes);
+        buildMeshesFromScene(name, node->GetChild(i), transform, materials, meshes);
     }
 }
 
-ModelMesh * ModelFBXFactory::fbxMeshToModelMesh(const std::string &name, KFbxMesh *mesh) {
+void ModelFBXFactory::fbxMeshToCacheMesh(
+    const std::string &name,
+    KFbxMesh *mesh,
+    const SQT &defaultTransform,
+    std::vector<MeshCache::Material> &materials,
+    MeshCache::Mesh &result
+) {
     unsigned int i, j;
     KFbxNode *node = mesh->GetNode();
 
@@ -333,9 +379,9 @@ ModelMesh * ModelFBXFactory::fbxMeshToModelMesh(const std::string &name, KFbxMes
     // ==========
 
     // Get the materials from the parent layer
-    std::vector <Material*> matList;
-    parseMaterialsFromNode(name, node, matList);
-    if(matList.size() > 1) {
+    int firstMaterial = materials.size();
+    parseMaterialsFromNode(name, node, materials);
+    if(materials.size() - firstMaterial > 1) {
         Warn("Multitexturing is currently not supported in Mountainhome, "
              "only one material will be used.");
     }
@@ -347,8 +393,6 @@ ModelMesh * ModelFBXFactory::fbxMeshToModelMesh(const std::string &name, KFbxMes
     Vector3 scaling(node->LclScaling.Get().Buffer());
     Vector3 translation(node->LclTranslation.Get().Buffer());
 
-    const SQT &defaultTransform = Content::GetModelManager()->getDefaultTransform();
-
     Quaternion normalTransformation = defaultTransform.getOrientation() *
         Quaternion::FromEuler(
             Radian(eulerRotation[0]),
@@ -369,24 +413,34 @@ ModelMesh * ModelFBXFactory::fbxMeshToModelMesh(const std::string &name, KFbxMes
         normalTransformation.apply(normals[i]);
     }
 
-    // Create the ModelMesh and return the result.
-    IndexBuffer *indexBuffer = new IndexBuffer(GL_STATIC_DRAW, GL_UNSIGNED_INT, indices.size(), &indices[0]);
-    VertexArray *vertexArray = new VertexArray();
-    vertexArray->setPositionBuffer(new PositionBuffer(GL_STATIC_DRAW, GL_FLOAT, 3, verts.size(), &verts[0]));
-    vertexArray->setNormalBuffer(new NormalBuffer(GL_STATIC_DRAW, GL_FLOAT, normals.size(), &normals[0]));
-    vertexArray->setTexCoordBuffer(0, new TexCoordBuffer(GL_STATIC_DRAW, GL_FLOAT, 2, texCoords.size(), &texCoords[0]));
-
-    AABB3 bounds = AABB3::FindBounds(&verts[0], verts.size());
-    RenderOperation *op = new RenderOperation(TRIANGLES, vertexArray, indexBuffer);
-    return new ModelMesh(mesh->GetName(), op, matList.front(), NULL, bounds);
+    // Fill in the cache mesh. Only the first material is used.
+    result.name = mesh->GetName();
+    result.material = materials.size() > firstMaterial ? firstMaterial : -1;
+    result.bone = -1;
+    result.bounds = AABB3::FindBounds(&verts[0], verts.size());
+    result.positions.swap(verts);
+    if(fbxNormals) { result.normals.swap(normals); }
+    if(fbxTexCoords) { result.texCoords.swap(texCoords); }
+    result.indices.swap(indices);
+
+    // The loop above leaves duplicate vertices and the triangles in whatever order the
+    // modeling tool wrote them, so clean both up.
+    MeshOptimizer::Statistics stats = MeshOptimizer::Optimize(result);
+    Info("Optimized mesh '" << result.name << "': " <<
+         stats.verticesBefore << " -> " << stats.verticesAfter << " vertices, ACMR " <<
+         stats.acmrBefore << " -> " << stats.acmrAfter);
 }
 
-void ModelFBXFactory::parseMaterialsFromNode(const std::string &name, KFbxNode *node, std::vector<Material*> &matList) {
+void ModelFBXFactory::parseMaterialsFromNode(const std::string &name, KFbxNode *node, std::vector<MeshCache::Material> &matList) {
     unsigned int matCount = node->GetMaterialCount();
 
     for (unsigned int i = 0; i < matCount; i++) {
         KFbxSurfaceMaterial *fbxMat = node->GetMaterial(i);
-        BasicMaterial *mat = new BasicMaterial(name + " material");
+        MeshCache::Material mat;
+        mat.name = name + " material";
+        mat.ambient = Vector4(1, 1, 1, 1);
+        mat.diffuse = Vector4(1, 1, 1, 1);
+        mat.lighting = false;
 
         // Get the textures for this layer
         std::vector <std::string> textureNames;
@@ -424,9 +478,9 @@ void ModelFBXFactory::parseMaterialsFromNode(const std::string &name, KFbxNode *
             KFbxPropertyDouble3 ambient = lSurface->GetAmbientColor();
             KFbxPropertyDouble3 diffuse = lSurface->GetDiffuseColor();
             float alpha = 1.0 - lSurface->GetTransparencyFactor().Get();
-            mat->setAmbient(Vector4(ambient.Get()[0], ambient.Get()[1], ambient.Get()[2], alpha));
-            mat->setDiffuse(Vector4(diffuse.Get()[0], diffuse.Get()[1], diffuse.Get()[2], alpha));
-            mat->setLightingEnabled(true);
+            mat.ambient = Vector4(ambient.Get()[0], ambient.Get()[1], ambient.Get()[2], alpha);
+            mat.diffuse = Vector4(diffuse.Get()[0], diffuse.Get()[1], diffuse.Get()[2], alpha);
+            mat.lighting = true;
         }
         else {
             THROW(NotImplementedError, "Unhandled material class found in ModelFBX");
@@ -438,8 +492,7 @@ void ModelFBXFactory::parseMaterialsFromNode(const std::string &name, KFbxNode *
 
         if (textureNames.size() == 1) {
             Info("Found texture " << textureNames.front());
-            Texture *textureToBind = _textureManager->getOrLoadResource(textureNames.front());
-            mat->setTexture(textureToBind);
+            mat.texture = textureNames.front();
         }
 
         matList.push_back(mat);
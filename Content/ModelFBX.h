@@ -10,6 +10,8 @@
 #define _MODELFACTORYFBX_H_
 #include "ResourceManager.h"
 #include "Model.h"
+#include <Base/MeshCache.h>
+#include <Base/SQT.h>
 
 #pragma GCC diagnostic ignored "-Wall"
 #include <fbxsdk.h>
@@ -25,17 +27,32 @@ public:
     bool canLoad(const std::string &args);
     Model* load(const std::string &args);
 
+    /*! Imports the named FBX file and writes it to target as a .mhm mesh cache, which
+     *  ModelCacheFactory can load far faster than the FBX SDK can. The given transform
+     *  is baked into the cache, the same way the ModelManager's default transform is
+     *  applied when loading FBX files directly.
+     * eturn false if the file could not be imported or written. */
+    bool convert(const std::string &name, IOTarget *target, const SQT &transform = SQT());
+
 private:
-    /*! Extracts relevant data from the imported scene and builds a set of ModelMeshes,
+    /*! Imports the named file and extracts the materials and meshes from it. */
+    bool extractScene(const std::string &name, const SQT &transform,
+                      std::vector<MeshCache::Material> &materials,
+                      std::vector<MeshCache::Mesh> &meshes);
+
+    /*! Extracts relevant data from the imported scene and builds a set of cache meshes,
      *  returning the new objects in a vector. */
-    void buildModelMeshesFromScene(const std::string &name, KFbxNode *node, std::vector<ModelMesh *> &meshes);
+    void buildMeshesFromScene(const std::string &name, KFbxNode *node, const SQT &transform,
+                              std::vector<MeshCache::Material> &materials,
+                              std::vector<MeshCache::Mesh> &meshes);
 
-    /*! Converts a KFbxMesh into a ModelMeshPart, translating appropriate attribures using
+    /*! Converts a KFbxMesh into a cache mesh, translating appropriate attribures using
      *  by the affine transformation details gathered from its node. */
-    ModelMesh * fbxMeshToModelMesh(const std::string &name, KFbxMesh *mesh);
+    void fbxMeshToCacheMesh(const std::string &name, KFbxMesh *mesh, const SQT &transform,
+                            std::vector<MeshCache::Material> &materials, MeshCache::Mesh &result);
 
-    /*! Converts KFbxSurfaceMaterials into Materials and returns them in a vector */
-    void parseMaterialsFromNode(const std::string &name, KFbxNode *node, std::vector<Material*> &matList);
+    /*! Converts KFbxSurfaceMaterials into cache materials and appends them to a vector */
+    void parseMaterialsFromNode(const std::string &name, KFbxNode *node, std::vector<MeshCache::Material> &matList);
 
     /*! Converts an FBX matrix into a Mountainhome Matrix */
     void convertMatrix(KFbxXMatrix *matrix, Matrix &mhMatrix);
@@ -12,14 +12,17 @@
 #include "ModelMS3D.h"
 #include "ModelMD5.h"
 #include "ModelFBX.h"
+#include "ModelCache.h"
 
 ModelManager::ModelManager(ResourceGroupManager *manager, TextureManager *tManager):
+    ResourceManager<Model>(manager),
     _defaultTransform()
 {
     registerFactory(new Model3DS::Factory());
     registerFactory(new ModelMS3D::Factory());
     registerFactory(new ModelMD5::Factory());
     registerFactory(new ModelFBXFactory(manager, tManager));
+    registerFactory(new ModelCacheFactory(manager, tManager));
 }
 
 ModelManager::~ModelManager() {}
@@ -36,6 +39,12 @@ const SQT & ModelManager::getDefaultTransform() {
     return _defaultTransform;
 }
 
+void ModelManager::measureResource(const Model *resource, long long &cpuBytes,
+long long &gpuBytes) const {
+    cpuBytes = resource->getSystemByteCount();
+    gpuBytes = resource->getByteCount();
+}
+
 //#include "MeshMS3D.h"
 //#include "Mesh3DS.h"
 //#include "Common.h"
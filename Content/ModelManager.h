@@ -25,6 +25,11 @@ public:
 
     const SQT & getDefaultTransform();
 
+protected:
+    /*! Reports the model's geometry buffers and bookkeeping. */
+    virtual void measureResource(const Model *resource, long long &cpuBytes,
+                                 long long &gpuBytes) const;
+
 //	//Load a model.
 //	static Model* Load(const char* directory, const char* filename);
 //	//Loads an animated Model.
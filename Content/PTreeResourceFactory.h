@@ -12,6 +12,7 @@
 #include "ResourceGroupManager.h"
 #include "ResourceFactory.h"
 #include "PropertyTree.h"
+#include <sstream>
 
 /*! This class provides a specialization of the ResourceFactory that makes use of the
  *  boost ptree library. It automatically loads up the property tree before calling the
@@ -29,9 +30,14 @@ public:
 
     /*! \seealso ResourceFactory::loadIfPossible */
     virtual Resource* loadIfPossible(const std::string &basename) {
-        // Load the property tree from disk.
-        std::string filename = ResourceFactory<Resource>::_resourceGroupManager->findResource(basename);
-        read_ini(filename, _ptree);
+        // Load the property tree. This goes through mapResource so it works in archives.
+        const unsigned char *data;
+        long long length;
+        IOTarget *source = ResourceFactory<Resource>::_resourceGroupManager->mapResource(
+            basename, data, length);
+        std::istringstream stream(std::string((const char*)data, length));
+        delete source;
+        read_ini(stream, _ptree);
 
         // Loop over the required keys list and make sure all are present.
         std::list<std::string>::iterator itr = _requiredKeys.begin();
@@ -63,6 +69,8 @@ protected:
         _requiredKeys.push_back(key);
     }
 
+    /*! Returns the path to the resource named by the given key, or an empty string if
+     *  the key isn't set. \seealso ResourceGroupManager::findResource */
     std::string getPathFromKey(const std::string &key) {
         std::string value = _ptree.get<std::string>(key, "");
         if (value.size() == 0) { return ""; }
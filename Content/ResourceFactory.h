@@ -10,6 +10,23 @@
 #ifndef _RESOURCEFACTORY_H_
 #define _RESOURCEFACTORY_H_
 
+/*! Holds whatever a factory was able to build for a resource off of the main thread,
+ *  until the factory can finish building it on the main thread. Factories subclass this
+ *  to carry their own data.
+ * \seealso ResourceFactory::prepare */
+class PreparedResource {
+public:
+    PreparedResource(long long bytes = 0): _bytes(bytes) {}
+    virtual ~PreparedResource() {}
+
+    /*! Gets the number of bytes read or decoded while preparing. */
+    long long getBytes() const { return _bytes; }
+
+protected:
+    long long _bytes;
+
+};
+
 /*! This class provides an abstract interface for classes which implement loading
  *  algorithms for individual resource types.
  * \brief An abstrct interface for resource factories. */
@@ -44,6 +61,23 @@ public:
     /*! Actually builds a new resource and returns it. */
     virtual Resource* load(const std::string &name) = 0;
 
+    /*! Returns true if this factory can load the given resource and is able to do part
+     *  of the work in prepare. Called on the main thread. By default, nothing can be
+     *  prepared, and asynchronous requests simply call loadIfPossible when finishing. */
+    virtual bool canPrepare(const std::string &name) { return false; }
+
+    /*! Does as much of the work of loading the given resource as possible without
+     *  touching the GL context or anything else that isn't thread safe. This is called
+     *  from a ResourceLoader worker thread, and only if canPrepare returned true.
+     * \return The prepared data, or NULL if everything is left to finish. */
+    virtual PreparedResource* prepare(const std::string &name) { return NULL; }
+
+    /*! Builds the resource on the main thread from the results of prepare. The prepared
+     *  data is owned by the caller. The default just calls load. */
+    virtual Resource* finish(const std::string &name, PreparedResource *prepared) {
+        return load(name);
+    }
+
 protected:
     ResourceGroupManager *_resourceGroupManager;
     bool _autoRegister;
@@ -9,47 +9,309 @@
 
 #include "ResourceGroupManager.h"
 #include "FileSystem.h"
+#include "MappedFile.h"
+#include "DataTarget.h"
+#include "Archive.h"
 
-ResourceGroupManager::ResourceGroupManager() {}
-ResourceGroupManager::~ResourceGroupManager() {}
+ResourceGroupManager::ResourceGroupManager(): _shadowedCount(0) {
+    pthread_mutex_init(&_mutex, NULL);
+    rehash(0);
+}
+
+ResourceGroupManager::~ResourceGroupManager() {
+    for (unsigned int i = 0; i < _resourceLocs.size(); i++) {
+        delete _resourceLocs[i].archive;
+    }
+
+    pthread_mutex_destroy(&_mutex);
+}
 
 void ResourceGroupManager::addResourceLocation(const std::string &loc, bool recurse) {
     Info("Adding resource location: " << loc << " [recursive: " << recurse << "]");
-    _resourceLocs.push_back(ResourceLocation(loc, recurse));
+    ResourceLocation location(loc, recurse);
+
+    std::string ext;
+    FileSystem::ExtractExtension(loc, ext);
+    if (ext == "zip") {
+        // GetMappedFile refuses directories, which are just indexed like any other.
+        MappedFile *file = FileSystem::GetMappedFile(loc);
+        if (file) {
+            location.archive = new Archive(loc, file);
+        }
+    }
+
+    pthread_mutex_lock(&_mutex);
+    _resourceLocs.push_back(location);
+    indexLocation(_resourceLocs.size() - 1);
+    pthread_mutex_unlock(&_mutex);
 }
 
 IOTarget* ResourceGroupManager::openResource(const std::string &name) {
-    std::string loc = findResource(name);
-    return FileSystem::GetFile(loc, IOTarget::Read);
+    std::string path;
+    Archive *archive;
+    if (!lookup(name, path, archive)) {
+        THROW(ItemNotFoundError, "Could not find resource named '" << name << "'.");
+    }
+
+    if (archive) {
+        IOTarget *stream = archive->openStream(path);
+        if (!stream) {
+            THROW(InternalError, "Could not read resource: " << name);
+        }
+
+        return stream;
+    }
+
+    return FileSystem::GetFile(path, IOTarget::Read);
+}
+
+IOTarget* ResourceGroupManager::mapResource(const std::string &name,
+const unsigned char *&data, long long &length) {
+    std::string path;
+    Archive *archive;
+    if (!lookup(name, path, archive)) {
+        THROW(ItemNotFoundError, "Could not find resource named '" << name << "'.");
+    }
+
+    // Stored files in mapped archives come back as views into the mapping, so they are
+    // never copied. Anything deflated is inflated straight into its final buffer.
+    if (archive) {
+        DataTarget *target = archive->open(path);
+        if (!target) {
+            THROW(InternalError, "Could not read resource: " << name);
+        }
+
+        data = target->getData();
+        length = target->length();
+        return target;
+    }
+
+    MappedFile *file = FileSystem::GetMappedFile(path);
+    if (file && file->isOpen()) {
+        data = file->getData();
+        length = file->length();
+        return file;
+    }
+
+    delete file;
+
+    // Couldn't map it, so fall back to reading it in.
+    IOTarget *stream = FileSystem::GetFile(path, IOTarget::Read);
+    length = stream->length();
+    unsigned char *buffer = new unsigned char[length];
+    long long count = stream->read(buffer, length);
+    delete stream;
+
+    if (count != length) {
+        delete[] buffer;
+        THROW(InternalError, "Could not read resource: " << name);
+    }
+
+    data = buffer;
+    return new DataTarget(buffer, length);
 }
 
 std::string ResourceGroupManager::findResource(const std::string &name) {
-    ResourceLocationList::iterator itr;
-    for (itr = _resourceLocs.begin(); itr != _resourceLocs.end(); itr++) {
-        std::string loc = findResourceInLocation(name, *itr);
-        if (loc.size() > 0) { return loc; }
+    std::string path;
+    Archive *archive;
+    if (!lookup(name, path, archive)) {
+        // Nothing matched. Bail!
+        THROW(ItemNotFoundError, "Could not find resource named '" << name << "'.");
+    }
+
+    // Files in archives have no path anything else could open.
+    if (archive) {
+        THROW(InvalidStateError, "Resource '" << name << "' is in an archive and can " <<
+            "only be read with openResource or mapResource.");
+    }
+
+    return path;
+}
+
+bool ResourceGroupManager::hasResource(const std::string &name) {
+    pthread_mutex_lock(&_mutex);
+    bool found = findIndexEntry(name) != NULL;
+    pthread_mutex_unlock(&_mutex);
+    return found;
+}
+
+unsigned int ResourceGroupManager::getResourceCount() const {
+    pthread_mutex_lock(&_mutex);
+    unsigned int count = _index.size();
+    pthread_mutex_unlock(&_mutex);
+    return count;
+}
+
+void ResourceGroupManager::getResourceNames(std::vector<std::string> &names) const {
+    pthread_mutex_lock(&_mutex);
+    names.reserve(names.size() + _index.size());
+    for (unsigned int i = 0; i < _index.size(); i++) {
+        names.push_back(_index[i].name);
+    }
+
+    pthread_mutex_unlock(&_mutex);
+}
+
+long long ResourceGroupManager::getResourceLength(const std::string &name) {
+    if (!hasResource(name)) { return 0; }
+
+    IOTarget *target = openResource(name);
+    long long length = target->length();
+    delete target;
+    return length;
+}
+
+unsigned int ResourceGroupManager::getShadowedCount() const {
+    pthread_mutex_lock(&_mutex);
+    unsigned int count = _shadowedCount;
+    pthread_mutex_unlock(&_mutex);
+    return count;
+}
+
+void ResourceGroupManager::rescanResourceLocations() {
+    // Lookups from loader threads block until the new index is complete, rather than
+    // seeing it half built.
+    pthread_mutex_lock(&_mutex);
+    Info("Rescanning " << _resourceLocs.size() << " resource locations.");
+    _index.clear();
+    _stamps.clear();
+    _shadowedCount = 0;
+    rehash(0);
+
+    for (unsigned int i = 0; i < _resourceLocs.size(); i++) {
+        indexLocation(i);
+    }
+
+    pthread_mutex_unlock(&_mutex);
+}
+
+bool ResourceGroupManager::rescanChangedLocations() {
+    bool changed = false;
+    pthread_mutex_lock(&_mutex);
+    std::vector<DirectoryStamp>::iterator itr;
+    for (itr = _stamps.begin(); itr != _stamps.end(); itr++) {
+        if (FileSystem::LastModified(itr->first) != itr->second) {
+            Info("Resource directory changed: " << itr->first);
+            changed = true;
+            break;
+        }
     }
 
-    // Nothing matched. Bail!
-    THROW(ItemNotFoundError, "Could not find resource named '" << name << "'.");
+    pthread_mutex_unlock(&_mutex);
+
+    if (changed) {
+        rescanResourceLocations();
+    }
+
+    return changed;
 }
 
-std::string ResourceGroupManager::findResourceInLocation(const std::string &name, ResourceLocation loc) {
-    std::list<std::string> *listing = FileSystem::GetListing(loc.first, loc.second, false);
+bool ResourceGroupManager::lookup(const std::string &name, std::string &path,
+Archive *&archive) const {
+    pthread_mutex_lock(&_mutex);
+    const IndexEntry *entry = findIndexEntry(name);
+    if (entry) {
+        path = entry->path;
+        archive = _resourceLocs[entry->location].archive;
+    }
+
+    pthread_mutex_unlock(&_mutex);
+    return entry != NULL;
+}
+
+void ResourceGroupManager::indexLocation(int location) {
+    const ResourceLocation &loc = _resourceLocs[location];
+    std::list<std::string> *listing;
     std::list<std::string>::iterator itr;
-    std::string result = "", file;
-
-    if (listing) {
-        for (itr = listing->begin(); itr != listing->end(); itr++) {
-            if (FileSystem::ExtractFilename(*itr, file) == name) {
-                result = *itr;
-                FileSystem::FormatPath(result);
-                break;
+
+    if (loc.archive) {
+        listing = loc.archive->listing("", loc.recurse, false);
+        if (listing) {
+            for (itr = listing->begin(); itr != listing->end(); itr++) {
+                addToIndex(*itr, location);
             }
         }
-        delete listing;
+    } else {
+        // Directories are included so they can be watched for changes. They're the only
+        // entries that end with a '/'.
+        listing = FileSystem::GetListing(loc.path, loc.recurse, true);
+        if (listing) {
+            for (itr = listing->begin(); itr != listing->end(); itr++) {
+                if (*itr->rbegin() == '/') {
+                    _stamps.push_back(DirectoryStamp(*itr, FileSystem::LastModified(*itr)));
+                } else {
+                    std::string path(*itr);
+                    addToIndex(FileSystem::FormatPath(path), location);
+                }
+            }
+        }
+    }
+
+    if (!listing) {
+        Warn("Unable to index resource location: " << loc.path);
+    }
+
+    delete listing;
+}
+
+void ResourceGroupManager::addToIndex(const std::string &path, int location) {
+    IndexEntry entry;
+    std::string::size_type pos = path.rfind('/');
+    entry.name = pos == std::string::npos ? path : path.substr(pos + 1);
+    entry.path = path;
+    entry.hash = Hash(entry.name);
+    entry.location = location;
+
+    const IndexEntry *existing = findIndexEntry(entry.name);
+    if (existing) {
+        Warn("Resource " << path << " is shadowed by " << existing->path);
+        _shadowedCount++;
+        return;
+    }
+
+    // Keep the load factor at or below one half so probe sequences stay short.
+    if ((_index.size() + 1) * 2 > _buckets.size()) {
+        rehash((_index.size() + 1) * 2);
+    }
+
+    unsigned int mask = _buckets.size() - 1;
+    unsigned int bucket = entry.hash & mask;
+    while (_buckets[bucket]) { bucket = (bucket + 1) & mask; }
+    _index.push_back(entry);
+    _buckets[bucket] = _index.size();
+}
+
+const ResourceGroupManager::IndexEntry* ResourceGroupManager::findIndexEntry(const std::string &name) const {
+    unsigned int hash = Hash(name);
+    unsigned int mask = _buckets.size() - 1;
+    for (unsigned int bucket = hash & mask; _buckets[bucket]; bucket = (bucket + 1) & mask) {
+        const IndexEntry &entry = _index[_buckets[bucket] - 1];
+        if (entry.hash == hash && entry.name == name) {
+            return &entry;
+        }
+    }
+
+    return NULL;
+}
+
+void ResourceGroupManager::rehash(unsigned int capacity) {
+    unsigned int size = 16;
+    while (size < capacity) { size <<= 1; }
+    _buckets.assign(size, 0);
+
+    unsigned int mask = size - 1;
+    for (unsigned int i = 0; i < _index.size(); i++) {
+        unsigned int bucket = _index[i].hash & mask;
+        while (_buckets[bucket]) { bucket = (bucket + 1) & mask; }
+        _buckets[bucket] = i + 1;
+    }
+}
+
+unsigned int ResourceGroupManager::Hash(const std::string &str) {
+    unsigned int hash = 2166136261u;
+    for (unsigned int i = 0; i < str.size(); i++) {
+        hash = (hash ^ (unsigned char)str[i]) * 16777619u;
     }
 
-    // Nothing matched. Bail!
-    return result;
+    return hash;
 }
@@ -13,31 +13,132 @@
 #include "IOTarget.h"
 #include "Base.h"
 
+#include <vector>
+#include <ctime>
+#include <pthread.h>
+
+class Archive;
+
+/*! The ResourceGroupManager finds resources by name in a list of resource locations.
+ *  Locations may be directories on disk or ZIP archives. When a location is added, every
+ *  file in it is added to an in memory index keyed by file name, so finding a resource is
+ *  a single hash lookup rather than a walk of the disk. Locations are searched in the
+ *  order they were added, so if two files share a name, the first one found wins and the
+ *  other is reported as shadowed. Resources in ZIP archives can only be read through
+ *  openResource and mapResource; anything that needs a real path must use loose files.
+ *
+ *  Directories can change while the game is running. rescanResourceLocations rebuilds the
+ *  index from scratch, and rescanChangedLocations only does so if a directory in one of
+ *  the locations has been modified since it was last indexed.
+ *
+ *  Lookups and reads are safe to make from any thread, since ResourceLoader prepares
+ *  resources on worker threads. Archives handle concurrent reads themselves. The index
+ *  is guarded by a lock, and a rescan holds it until the new index is complete, so
+ *  lookups made during a rescan wait for it rather than seeing a partial index.
+ *  Locations should only be added and rescanned from the main thread. */
 class ResourceGroupManager {
 public:
     ResourceGroupManager();
     virtual ~ResourceGroupManager();
 
     /*! Adds a resource location to the list of possible resource locations. The set of
-     *  resource locations is used when attempting to load resources from disk. */
+     *  resource locations is used when attempting to load resources from disk. If the
+     *  location is a ZIP file, the files inside of it are used. The location is indexed
+     *  immediately. */
     void addResourceLocation(const std::string &location, bool recurse = false);
 
     /*! Finds a resource in the resource location list based on the given IdType and
-     *  creates an IOTarget representing the resource. */
+     *  creates an IOTarget representing the resource. Throws an InternalError if it is
+     *  in an archive and can't be read. */
     IOTarget* openResource(const std::string &name);
 
+    /*! Makes the whole resource available in memory, pointing data at its contents.
+     *  Loose files and files stored uncompressed in archives are mapped. Anything else is
+     *  read into memory. The returned IOTarget owns the memory and must outlive any use
+     *  of data. Throws an InternalError if the resource can't be read. */
+    IOTarget* mapResource(const std::string &name, const unsigned char *&data, long long &length);
+
     /*! Finds a resource in the resource location list based on the given IdType and
-     *  returns the path to it. */
+     *  returns the path to it. Resources in archives have no path on disk, so this throws
+     *  an InvalidStateError for them. Only use this for consumers that must be handed a
+     *  path, like the FBX importer, and prefer openResource or mapResource otherwise. */
     std::string findResource(const std::string &name);
 
+    /*! Returns true if a resource with the given name is in the index. */
+    bool hasResource(const std::string &name);
+
+    /*! Throws away the index and rebuilds it from every resource location. */
+    void rescanResourceLocations();
+
+    /*! Rebuilds the index if any directory in the resource locations has been modified
+     *  since it was last indexed. Returns true if a rescan happened. */
+    bool rescanChangedLocations();
+
+    /*! Returns the number of resources in the index. */
+    unsigned int getResourceCount() const;
+
+    /*! Fills the given vector with the name of every resource in the index. */
+    void getResourceNames(std::vector<std::string> &names) const;
+
+    /*! Returns the length in bytes of the named resource, or 0 if it can't be found. */
+    long long getResourceLength(const std::string &name);
+
+    /*! Returns the number of files hidden by files with the same name during the last
+     *  scan. Each one is also logged as it is found. */
+    unsigned int getShadowedCount() const;
+
 protected:
-    typedef std::pair<std::string, bool> ResourceLocation;
-    typedef std::list<ResourceLocation> ResourceLocationList;
+    /*! A single resource location. */
+    struct ResourceLocation {
+        ResourceLocation(const std::string &p, bool r): path(p), recurse(r), archive(NULL) {}
+
+        std::string path;  //!< The directory or archive.
+        bool recurse;      //!< Whether or not subdirectories are included.
+        Archive *archive;  //!< The archive at this location, if it is one.
+    };
+
+    /*! A single entry in the resource index. */
+    struct IndexEntry {
+        std::string name;  //!< The file name, without any directories.
+        std::string path;  //!< The full path, or the path in the archive.
+        unsigned int hash; //!< The hash of name.
+        int location;      //!< The index of the location the resource was found in.
+    };
+
+    typedef std::vector<ResourceLocation> ResourceLocationList;
+    typedef std::pair<std::string, time_t> DirectoryStamp;
+
+    /*! Looks up the path to the named resource and the archive it's in, if any. This is
+     *  the only way the public lookups touch the index, and it takes the lock to do so.
+     * \return false if the resource isn't in the index. */
+    bool lookup(const std::string &name, std::string &path, Archive *&archive) const;
 
-    std::string findResourceInLocation(const std::string &name, ResourceLocation loc);
+    /*! Adds every file in the given location to the index. Must be called with the lock
+     *  held. */
+    void indexLocation(int location);
+
+    /*! Adds a single file to the index, unless something with the same name is already in
+     *  it. Must be called with the lock held. */
+    void addToIndex(const std::string &path, int location);
+
+    /*! Returns the index entry with the given name, or NULL if there isn't one. Must be
+     *  called with the lock held, and the entry is only valid for as long as it is. */
+    const IndexEntry* findIndexEntry(const std::string &name) const;
+
+    /*! Rebuilds the hash table to fit the given number of entries. */
+    void rehash(unsigned int capacity);
+
+    /*! FNV-1a hash of the given string. */
+    static unsigned int Hash(const std::string &str);
 
     ResourceLocationList _resourceLocs;
 
+    std::vector<IndexEntry> _index;          //!< Every indexed resource.
+    std::vector<unsigned int> _buckets;      //!< Hash table of _index indices + 1, 0 is empty.
+    std::vector<DirectoryStamp> _stamps;     //!< Modification times of indexed directories.
+    unsigned int _shadowedCount;
+    mutable pthread_mutex_t _mutex;          //!< Guards everything above.
+
 };
 
 #endif
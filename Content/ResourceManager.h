@@ -11,34 +11,96 @@
 #define _RESOURCEMANAGER_H_
 #include "ResourceGroupManager.h"
 #include "ResourceFactory.h"
+#include "ResourceLoader.h"
+#include "ResourceReferences.h"
 #include "Exception.h"
 #include "Logger.h"
 
+/*! A snapshot of what a ResourceManager is holding on to and how its cache is doing.
+ * \seealso ResourceManager::getStats */
+struct ResourceStats {
+    ResourceStats(): loaded(0), unnamed(0), referenced(0), pinned(0), cpuBytes(0),
+        gpuBytes(0), budget(0), hits(0), misses(0), evictions(0) {}
+
+    int loaded;          //!< The number of named resources in the cache.
+    int unnamed;         //!< The number of unnamed resources, which are never evicted.
+    int referenced;      //!< Named resources with outstanding references.
+    int pinned;          //!< Named resources belonging to a pinned group.
+    long long cpuBytes;  //!< System memory used by the named resources.
+    long long gpuBytes;  //!< Video memory used by the named resources.
+    long long budget;    //!< The memory budget, or 0 if there is none.
+    int hits;            //!< getOrLoadResource calls answered from the cache.
+    int misses;          //!< getOrLoadResource calls that had to load.
+    int evictions;       //!< Resources unloaded to stay under the budget.
+};
+
 /*! The ResourceManager gives some basic functionality to aid in resource management. It
  *  gives the user a basic method of caching, accessing, and clearing resources from the
  *  Base. Loading a resource and registering it with the manager is left to the
  *  subclasses.
- * \brief Provides the base functionality for Resource caching and access.
- * \todo Make some way to clear the resource cache
- * \todo Add resource groups (Temp, Level, Always) which can be pre-emptively loaded into
- *  the cache an cleared. */
+ *
+ *  Named resources can be kept under a memory budget. Each resource reports its footprint
+ *  through measureResource, and once the total goes over the budget the least recently
+ *  used resources are unloaded until it fits again. Resources that have been acquired and
+ *  not yet released, or that belong to a pinned group, are never evicted.
+ *
+ *  Groups are named sets of resources (like "Temp", "Level", and "Always") that can be
+ *  pinned, prefetched, and unloaded as a unit. Resources don't need to be loaded to be
+ *  added to a group.
+ * \brief Provides the base functionality for Resource caching and access. */
 template <typename Resource>
-class ResourceManager {
+class ResourceManager : public ResourceReleaser {
+public:
+    /*! An asynchronous load of a single resource, as returned by requestResource. Once
+     *  the request is finished, the resource has been registered with the manager just as
+     *  if it had been loaded with loadResource.
+     * \note Requests are shared, so they must be released rather than deleted. */
+    class Request : public ResourceLoader::Request {
+    public:
+        /*! Gets the loaded resource, or NULL if the request hasn't finished. */
+        Resource* getResource() const { return _resource; }
+
+    protected:
+        Request(ResourceManager *manager, ResourceFactory<Resource> *factory,
+                const std::string &name, int priority);
+
+        virtual ~Request();
+
+        /*! Runs the factory's prepare stage, if it has one. */
+        virtual bool prepare();
+
+        /*! Builds and registers the resource. */
+        virtual bool finish();
+
+        /*! Throws away anything left from prepare and removes the request from the
+         *  manager's pending list. */
+        virtual void retire();
+
+        friend class ResourceManager;
+
+    protected:
+        ResourceManager *_manager;           //!< NULL once the manager is gone.
+        ResourceFactory<Resource> *_factory; //!< NULL if nothing can be prepared.
+        PreparedResource *_prepared;
+        Resource *_resource;
+
+    };
+
 public:
-    ResourceManager();
+    /*! Creates a new manager. The ResourceGroupManager is only needed to answer questions
+     *  about resources on disk, like resourcesAvailable. */
+    ResourceManager(ResourceGroupManager *groupManager = NULL);
     virtual ~ResourceManager();
 
     /*! Reports the number of resources (of type Resource) currently loaded in the system. */
     int resourcesLoaded() const;
 
     /*! Reports the number of resources (of type Resource) that can be found in the set of
-     *  current resource paths.
-     * \todo implement me! */
-    int resourcesAvailable() const { THROW(NotImplementedError, "resourcesAvailable"); }
+     *  current resource paths. */
+    int resourcesAvailable() const;
 
-    /*! Reports how much space (in bytes) the loaded resources are taking up.
-     * \todo implement me! */
-    int bytesTakenOnDisk() const { THROW(NotImplementedError, "bytesTakenOnDisk"); }
+    /*! Reports how much space (in bytes) the loaded resources are taking up on disk. */
+    long long bytesTakenOnDisk() const;
 
     /*! Register a new resource with the system. A name is not necessarily needed, but if
      *  none is given then there will be no way to again retrieve the Resource from here.
@@ -68,23 +130,151 @@ public:
     /*! Attempts to find and load the given resource. */
     Resource* getOrLoadResource(const std::string &name);
 
+    /*! Gets or loads the given resource and adds a reference to it. Referenced resources
+     *  are never evicted, so anything holding on to a resource for a while should acquire
+     *  it and release it when done. */
+    Resource* acquireResource(const std::string &name);
+
+    /*! Removes a reference added by acquireResource. Resources that acquire others, like
+     *  Materials acquiring Textures, record them in a ResourceReferences so they are
+     *  released here when the resource is unloaded. */
+    virtual void releaseResource(const std::string &name);
+
+    /*! Gets the number of outstanding references to the named resource. */
+    int getReferenceCount(const std::string &name) const;
+
+    /*! Starts loading the given resource in the background. Requests for a resource
+     *  that is already being loaded share the same request, which takes on the higher of
+     *  the priorities. Requests for resources that are already cached are returned in
+     *  the Finished state.
+     * \param name The name of the resource to load.
+     * \param priority Higher priority requests are loaded first.
+     * \return The request, which the caller must release when done with it. */
+    Request* requestResource(const std::string &name, int priority = 0);
+
+    /*! Cancels the given request. The resource will not be registered. Since requests
+     *  are shared, this cancels it for everyone holding on to it. */
+    void cancelRequest(Request *request);
+
+    /*! Gets the number of requests that haven't been retired yet. */
+    int getPendingCount() const;
+
+    /*! Sets the loader used for asynchronous requests. */
+    void setResourceLoader(ResourceLoader *loader);
+
+    /*! Gets the loader used for asynchronous requests. */
+    ResourceLoader* getResourceLoader() const;
+
     /*! Registers a new ResourceFactory. */
     void registerFactory(ResourceFactory<Resource> *factory);
 
+    /*! Sets the number of bytes of system and video memory the named resources may use
+     *  before the least recently used ones start getting evicted. 0 means no limit. */
+    void setMemoryBudget(long long bytes);
+
+    /*! Gets the memory budget. 0 means no limit. */
+    long long getMemoryBudget() const;
+
+    /*! Gets the number of bytes of system and video memory the named resources use. */
+    long long getMemoryUsage() const;
+
+    /*! Evicts unreferenced, unpinned resources, least recently used first, until memory
+     *  usage is at or below the given number of bytes.
+     * \return The number of resources evicted. */
+    int evictResources(long long targetBytes);
+
+    /*! Measures the named resource again, evicting other resources if it pushes the
+     *  manager over budget. This should be called after a resource changes size. */
+    void updateResourceSize(const std::string &name);
+
+    /*! Adds the named resource to a group, creating the group if needed. */
+    void addToGroup(const std::string &group, const std::string &name);
+
+    /*! Keeps every resource in the group from being evicted. */
+    void pinGroup(const std::string &group);
+
+    /*! Allows the resources in the group to be evicted again. */
+    void unpinGroup(const std::string &group);
+
+    /*! Returns true if the named resource belongs to a pinned group. */
+    bool isPinned(const std::string &name) const;
+
+    /*! Requests every resource in the group that isn't already loaded. */
+    void prefetchGroup(const std::string &group, int priority = 0);
+
+    /*! Unpins the group and unloads every resource in it that isn't referenced. The
+     *  group itself is kept, so it may be prefetched again later. */
+    void unloadGroup(const std::string &group);
+
+    /*! Gets a snapshot of the manager's current state. */
+    ResourceStats getStats() const;
+
     /*! Searches for the given named resource and returns its name if found. If the given
      *  resource is not registered as a named resource, a blank string will be returned.*/
     std::string getNameOf(const Resource *resource) const;
 
 protected:
+    /*! Everything the manager tracks for a named resource. */
+    struct ResourceInfo {
+        ResourceInfo(): resource(NULL), references(0), cpuBytes(0), gpuBytes(0) {}
+        Resource *resource;
+        int references;
+        long long cpuBytes;
+        long long gpuBytes;
+        std::list<std::string>::iterator lruPosition; //!< Where the resource is in _lru.
+    };
+
+    /*! A named set of resources. */
+    struct ResourceGroup {
+        ResourceGroup(): pinned(false) {}
+        std::set<std::string> members;
+        bool pinned;
+    };
+
     typedef std::list<ResourceFactory<Resource>*> FactoryList;
     typedef typename FactoryList::iterator FactoryIterator;
+    typedef std::map<std::string, ResourceInfo> ResourceMap;
+    typedef std::map<std::string, Request*> PendingMap;
+    typedef std::map<std::string, ResourceGroup> GroupMap;
     friend class TestResourceManager;
+    friend class Request;
 
 protected:
-    std::map<std::string, Resource*> _namedResources;
+    /*! Reports the number of bytes of system and video memory used by the resource.
+     *  Subclasses should override this for anything that takes up a meaningful amount of
+     *  memory. The default reports nothing. */
+    virtual void measureResource(const Resource *resource, long long &cpuBytes,
+                                 long long &gpuBytes) const;
+
+    /*! Marks the named resource as the most recently used. */
+    void touchResource(typename ResourceMap::iterator itr);
+
+    /*! Does the work for evictResources, optionally sparing the most recently used
+     *  resource. */
+    int evict(long long targetBytes, bool keepNewest);
+
+    /*! Evicts resources if the manager is over budget. The most recently used resource
+     *  is always kept, since it's likely just been handed out. */
+    void enforceBudget();
+
+protected:
+    ResourceMap _namedResources;
     std::list<Resource*> _unnamedResources;
     FactoryList _factories;
 
+    ResourceLoader *_loader;
+    PendingMap _pending;           //!< Requests in the loader, keyed by name.
+
+    ResourceGroupManager *_groupManager;
+    GroupMap _groups;
+    std::list<std::string> _lru;   //!< Named resources, most recently used first.
+    long long _budget;
+    long long _cpuBytes;           //!< The total cpuBytes of the named resources.
+    long long _gpuBytes;           //!< The total gpuBytes of the named resources.
+    int _hits;
+    int _misses;
+    int _evictions;
+
 };
 
 #include "ResourceManager.hpp"
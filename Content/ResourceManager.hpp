@@ -14,22 +14,101 @@
 #include "Base.h"
 
 template <typename Resource>
-ResourceManager<Resource>::ResourceManager() {}
+ResourceManager<Resource>::Request::Request(ResourceManager *manager,
+ResourceFactory<Resource> *factory, const std::string &name, int priority):
+ResourceLoader::Request(name, priority), _manager(manager), _factory(factory),
+_prepared(NULL), _resource(NULL) {}
+
+template <typename Resource>
+ResourceManager<Resource>::Request::~Request() {
+    delete _prepared;
+}
+
+template <typename Resource>
+bool ResourceManager<Resource>::Request::prepare() {
+    if (_factory) {
+        _prepared = _factory->prepare(_name);
+        _preparedBytes = _prepared ? _prepared->getBytes() : 0;
+    }
+
+    return true;
+}
+
+template <typename Resource>
+bool ResourceManager<Resource>::Request::finish() {
+    if (!_manager) {
+        return false;
+    }
+
+    // Someone may have loaded the resource the old fashioned way in the mean time.
+    typename ResourceMap::iterator itr = _manager->_namedResources.find(_name);
+    if (itr != _manager->_namedResources.end()) {
+        _resource = itr->second.resource;
+        return true;
+    }
+
+    if (!_factory) {
+        _resource = _manager->loadResource(_name);
+        return _resource != NULL;
+    }
+
+    _resource = _factory->finish(_name, _prepared);
+    if (_resource && _factory->autoRegister()) {
+        _manager->registerResource(_name, _resource);
+    }
+
+    if (_resource) {
+        _manager->updateResourceSize(_name);
+    }
+
+    return _resource != NULL;
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::Request::retire() {
+    delete _prepared;
+    _prepared = NULL;
+
+    if (_manager) {
+        typename PendingMap::iterator itr = _manager->_pending.find(_name);
+        if (itr != _manager->_pending.end() && itr->second == this) {
+            _manager->_pending.erase(itr);
+        }
+    }
+}
+
+template <typename Resource>
+ResourceManager<Resource>::ResourceManager(ResourceGroupManager *groupManager):
+_loader(NULL), _groupManager(groupManager), _budget(0), _cpuBytes(0), _gpuBytes(0),
+_hits(0), _misses(0), _evictions(0) {}
 
 template <typename Resource>
 ResourceManager<Resource>::~ResourceManager() {
+    // Outstanding requests may still be using our factories, so cut them loose first.
+    typename PendingMap::iterator itr;
+    for (itr = _pending.begin(); itr != _pending.end(); itr++) {
+        _loader->cancel(itr->second);
+        _loader->waitForPrepare(itr->second);
+        itr->second->_manager = NULL;
+        itr->second->_factory = NULL;
+    }
+
+    _pending.clear();
     unloadAllResources();
     clear_list(_factories);
 }
 
 template <typename Resource>
 void ResourceManager<Resource>::unloadAllResources() {
-    typename std::map<std::string, Resource*>::iterator itr;
+    typename ResourceMap::iterator itr;
     for (itr = _namedResources.begin(); itr != _namedResources.end(); itr++) {
-        delete itr->second;
+        delete itr->second.resource;
     }
 
     _namedResources.clear();
+    _lru.clear();
+    _cpuBytes = 0;
+    _gpuBytes = 0;
 
     typename std::list<Resource*>::iterator itr2;
     for (itr2 = _unnamedResources.begin(); itr2 != _unnamedResources.end(); itr2++) {
@@ -46,7 +125,7 @@ void ResourceManager<Resource>::registerResource(const std::string &name, Resour
         return;
     }
 
-    typename std::map<std::string, Resource*>::iterator itr = _namedResources.find(name);
+    typename ResourceMap::iterator itr = _namedResources.find(name);
     if (itr != _namedResources.end()) {
         THROW(DuplicateItemError, "Attempting to register a resource that already exists: " << name);
 //        Warn("Resource named " << name << " already exisits. Deleting the old version.");
@@ -54,25 +133,36 @@ void ResourceManager<Resource>::registerResource(const std::string &name, Resour
 //        delete oldResource;
     }
 
-    _namedResources[name] = resource;
+    ResourceInfo &info = _namedResources[name];
+    info.resource = resource;
+    info.lruPosition = _lru.insert(_lru.begin(), name);
+    updateResourceSize(name);
 }
 
 template <typename Resource>
 Resource* ResourceManager<Resource>::getCachedResource(const std::string &name) {
-    typename std::map<std::string, Resource*>::iterator itr = _namedResources.find(name);
+    typename ResourceMap::iterator itr = _namedResources.find(name);
 
     if (itr == _namedResources.end()) {
         THROW(InternalError, "No cached resource named " << name << " exists.");
     }
 
-    return itr->second;
+    touchResource(itr);
+    return itr->second.resource;
 }
 
 template <typename Resource>
 void ResourceManager<Resource>::unloadResource(const std::string &name) {
-    typename std::map<std::string, Resource*>::iterator itr = _namedResources.find(name);
+    typename ResourceMap::iterator itr = _namedResources.find(name);
     if (itr != _namedResources.end()) {
-        delete itr->second;
+        if (itr->second.references > 0) {
+            Warn("Unloading " << name << " with " << itr->second.references << " references.");
+        }
+
+        delete itr->second.resource;
+        _cpuBytes -= itr->second.cpuBytes;
+        _gpuBytes -= itr->second.gpuBytes;
+        _lru.erase(itr->second.lruPosition);
         _namedResources.erase(itr);
     }
 }
@@ -84,9 +174,46 @@ int ResourceManager<Resource>::resourcesLoaded() const {
 
 template <typename Resource>
 Resource* ResourceManager<Resource>::getOrLoadResource(const std::string &name) {
-    typename std::map<std::string, Resource*>::iterator itr = _namedResources.find(name);
-    if (itr != _namedResources.end()) { return itr->second; }
-    return loadResource(name);    
+    typename ResourceMap::iterator itr = _namedResources.find(name);
+    if (itr != _namedResources.end()) {
+        _hits++;
+        touchResource(itr);
+        return itr->second.resource;
+    }
+
+    _misses++;
+    return loadResource(name);
+}
+
+template <typename Resource>
+Resource* ResourceManager<Resource>::acquireResource(const std::string &name) {
+    Resource *resource = getOrLoadResource(name);
+    typename ResourceMap::iterator itr = _namedResources.find(name);
+    if (itr != _namedResources.end()) {
+        itr->second.references++;
+    }
+
+    return resource;
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::releaseResource(const std::string &name) {
+    typename ResourceMap::iterator itr = _namedResources.find(name);
+    if (itr == _namedResources.end() || itr->second.references == 0) {
+        Warn("Releasing a resource that was never acquired: " << name);
+        return;
+    }
+
+    itr->second.references--;
+    if (itr->second.references == 0) {
+        enforceBudget();
+    }
+}
+
+template <typename Resource>
+int ResourceManager<Resource>::getReferenceCount(const std::string &name) const {
+    typename ResourceMap::const_iterator itr = _namedResources.find(name);
+    return itr == _namedResources.end() ? 0 : itr->second.references;
 }
 
 template <typename Resource>
@@ -106,6 +233,9 @@ Resource* ResourceManager<Resource>::loadResource(const std::string &name) {
                 registerResource(name, current);
             }
 
+            // Factories that register themselves tend to do so before the resource is
+            // fully built, so measure it again now that it's done.
+            updateResourceSize(name);
             return current;
         }
     }
@@ -114,6 +244,76 @@ Resource* ResourceManager<Resource>::loadResource(const std::string &name) {
     THROW(InternalError, "This manager doesn't know how to load this resource: " << name);
 }
 
+template <typename Resource>
+typename ResourceManager<Resource>::Request* ResourceManager<Resource>::requestResource(
+const std::string &name, int priority) {
+    Request *request;
+
+    // Already loaded, so there's nothing to wait for.
+    typename ResourceMap::iterator cached = _namedResources.find(name);
+    if (cached != _namedResources.end()) {
+        touchResource(cached);
+        request = new Request(this, NULL, name, priority);
+        request->_resource = cached->second.resource;
+        request->_state = ResourceLoader::Finished;
+        return request;
+    }
+
+    // Already being loaded, so share the existing request.
+    typename PendingMap::iterator itr = _pending.find(name);
+    if (itr != _pending.end()) {
+        request = itr->second;
+        if (priority > request->getPriority()) {
+            _loader->reprioritize(request, priority);
+        }
+
+        request->retain();
+        return request;
+    }
+
+    if (!_loader) {
+        THROW(InternalError, "No loader is available to request resource: " << name);
+    }
+
+    // Pick the factory now, since canPrepare isn't safe to call from the workers. If no
+    // factory can prepare the resource, the whole load happens when finishing.
+    ResourceFactory<Resource> *factory = NULL;
+    FactoryIterator factoryItr;
+    for (factoryItr = _factories.begin(); factoryItr != _factories.end(); factoryItr++) {
+        if ((*factoryItr)->canPrepare(name)) {
+            factory = *factoryItr;
+            break;
+        }
+    }
+
+    request = new Request(this, factory, name, priority);
+    _pending[name] = request;
+    _loader->submit(request);
+    return request;
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::cancelRequest(Request *request) {
+    if (_loader && !request->isDone()) {
+        _loader->cancel(request);
+    }
+}
+
+template <typename Resource>
+int ResourceManager<Resource>::getPendingCount() const {
+    return _pending.size();
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::setResourceLoader(ResourceLoader *loader) {
+    _loader = loader;
+}
+
+template <typename Resource>
+ResourceLoader* ResourceManager<Resource>::getResourceLoader() const {
+    return _loader;
+}
+
 template <typename Resource>
 void ResourceManager<Resource>::registerFactory(ResourceFactory<Resource> *factory) {
     _factories.push_back(factory);
@@ -121,9 +321,9 @@ void ResourceManager<Resource>::registerFactory(ResourceFactory<Resource> *facto
 
 template <typename Resource>
 std::string ResourceManager<Resource>::getNameOf(const Resource *resource) const {
-    typename std::map<std::string, Resource*>::const_iterator itr;
+    typename ResourceMap::const_iterator itr;
     for (itr = _namedResources.begin(); itr != _namedResources.end(); itr++) {
-        if (itr->second == resource) {
+        if (itr->second.resource == resource) {
             return itr->first;
         }
     }
@@ -131,4 +331,207 @@ std::string ResourceManager<Resource>::getNameOf(const Resource *resource) const
     return "";
 }
 
+template <typename Resource>
+int ResourceManager<Resource>::resourcesAvailable() const {
+    if (!_groupManager) { return 0; }
+
+    std::vector<std::string> names;
+    _groupManager->getResourceNames(names);
+
+    // Every factory gets a shot at each resource, but a resource only counts once.
+    int count = 0;
+    for (int i = 0; i < names.size(); i++) {
+        typename FactoryList::const_iterator itr;
+        for (itr = _factories.begin(); itr != _factories.end(); itr++) {
+            if ((*itr)->canLoad(names[i])) {
+                count++;
+                break;
+            }
+        }
+    }
+
+    return count;
+}
+
+template <typename Resource>
+long long ResourceManager<Resource>::bytesTakenOnDisk() const {
+    if (!_groupManager) { return 0; }
+
+    // Resources built at runtime have no file, and simply don't count.
+    long long bytes = 0;
+    typename ResourceMap::const_iterator itr;
+    for (itr = _namedResources.begin(); itr != _namedResources.end(); itr++) {
+        bytes += _groupManager->getResourceLength(itr->first);
+    }
+
+    return bytes;
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::setMemoryBudget(long long bytes) {
+    _budget = bytes;
+    enforceBudget();
+}
+
+template <typename Resource>
+long long ResourceManager<Resource>::getMemoryBudget() const {
+    return _budget;
+}
+
+template <typename Resource>
+long long ResourceManager<Resource>::getMemoryUsage() const {
+    return _cpuBytes + _gpuBytes;
+}
+
+template <typename Resource>
+int ResourceManager<Resource>::evictResources(long long targetBytes) {
+    return evict(targetBytes, false);
+}
+
+template <typename Resource>
+int ResourceManager<Resource>::evict(long long targetBytes, bool keepNewest) {
+    int evicted = 0;
+    std::list<std::string>::iterator itr = _lru.end();
+    while (getMemoryUsage() > targetBytes && itr != _lru.begin()) {
+        --itr;
+        if (keepNewest && itr == _lru.begin()) { break; }
+
+        const ResourceInfo &info = _namedResources.find(*itr)->second;
+        if (info.references > 0 || isPinned(*itr)) { continue; }
+
+        // Unloading erases the current position, so step past it first.
+        std::string name = *itr++;
+        unloadResource(name);
+        evicted++;
+    }
+
+    _evictions += evicted;
+    return evicted;
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::updateResourceSize(const std::string &name) {
+    typename ResourceMap::iterator itr = _namedResources.find(name);
+    if (itr == _namedResources.end()) { return; }
+
+    ResourceInfo &info = itr->second;
+    _cpuBytes -= info.cpuBytes;
+    _gpuBytes -= info.gpuBytes;
+    info.cpuBytes = info.gpuBytes = 0;
+    measureResource(info.resource, info.cpuBytes, info.gpuBytes);
+    _cpuBytes += info.cpuBytes;
+    _gpuBytes += info.gpuBytes;
+
+    enforceBudget();
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::addToGroup(const std::string &group, const std::string &name) {
+    _groups[group].members.insert(name);
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::pinGroup(const std::string &group) {
+    _groups[group].pinned = true;
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::unpinGroup(const std::string &group) {
+    typename GroupMap::iterator itr = _groups.find(group);
+    if (itr != _groups.end()) {
+        itr->second.pinned = false;
+        enforceBudget();
+    }
+}
+
+template <typename Resource>
+bool ResourceManager<Resource>::isPinned(const std::string &name) const {
+    typename GroupMap::const_iterator itr;
+    for (itr = _groups.begin(); itr != _groups.end(); itr++) {
+        if (itr->second.pinned && itr->second.members.count(name)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::prefetchGroup(const std::string &group, int priority) {
+    typename GroupMap::iterator itr = _groups.find(group);
+    if (itr == _groups.end()) {
+        Warn("Prefetching an empty resource group: " << group);
+        return;
+    }
+
+    // The loader keeps the requests alive, so there's no need to hold on to them.
+    std::set<std::string>::iterator member;
+    for (member = itr->second.members.begin(); member != itr->second.members.end(); member++) {
+        if (_namedResources.find(*member) == _namedResources.end()) {
+            requestResource(*member, priority)->release();
+        }
+    }
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::unloadGroup(const std::string &group) {
+    typename GroupMap::iterator itr = _groups.find(group);
+    if (itr == _groups.end()) { return; }
+
+    itr->second.pinned = false;
+
+    std::set<std::string>::iterator member;
+    for (member = itr->second.members.begin(); member != itr->second.members.end(); member++) {
+        typename PendingMap::iterator pending = _pending.find(*member);
+        if (pending != _pending.end()) {
+            cancelRequest(pending->second);
+        }
+
+        if (getReferenceCount(*member) == 0) {
+            unloadResource(*member);
+        }
+    }
+}
+
+template <typename Resource>
+ResourceStats ResourceManager<Resource>::getStats() const {
+    ResourceStats stats;
+    stats.loaded = _namedResources.size();
+    stats.unnamed = _unnamedResources.size();
+    stats.cpuBytes = _cpuBytes;
+    stats.gpuBytes = _gpuBytes;
+    stats.budget = _budget;
+    stats.hits = _hits;
+    stats.misses = _misses;
+    stats.evictions = _evictions;
+
+    typename ResourceMap::const_iterator itr;
+    for (itr = _namedResources.begin(); itr != _namedResources.end(); itr++) {
+        if (itr->second.references > 0) { stats.referenced++; }
+        if (isPinned(itr->first))        { stats.pinned++;     }
+    }
+
+    return stats;
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::measureResource(const Resource *resource, long long &cpuBytes,
+long long &gpuBytes) const {}
+
+template <typename Resource>
+void ResourceManager<Resource>::touchResource(typename ResourceMap::iterator itr) {
+    _lru.splice(_lru.begin(), _lru, itr->second.lruPosition);
+}
+
+template <typename Resource>
+void ResourceManager<Resource>::enforceBudget() {
+    if (_budget <= 0 || getMemoryUsage() <= _budget) { return; }
+
+    int evicted = evict(_budget, true);
+    if (getMemoryUsage() > _budget) {
+        Warn("Unable to get under the memory budget. Using " << getMemoryUsage() <<
+             " of " << _budget << " bytes after evicting " << evicted << " resources.");
+    }
+}
+
 #endif
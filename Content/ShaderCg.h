@@ -31,7 +31,7 @@ public:
     virtual void enable() {}
     virtual void disable() {}
     virtual void bindAttributeToChannel(const std::string &name, int channel) {}
-    virtual void setParameter(const std::string &strVariable, ShaderParameter *param) {}
+    virtual void setParameter(int slot, ShaderParameter *param) {}
 
 };
 
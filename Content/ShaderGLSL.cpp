@@ -7,10 +7,9 @@
  *
  */
 
-#include <Base/FileSystem.h>
-#include <Base/TextStream.h>
 #include "ShaderParameter.h"
 #include "ShaderGLSL.h"
+#include "RenderState.h"
 
 ShaderGLSL::Factory::Factory(ResourceGroupManager *manager): PTreeResourceFactory<Shader>(manager) {
     addRequiredKey("vertex");
@@ -24,13 +23,23 @@ bool ShaderGLSL::Factory::canLoad(const std::string &args) {
     return true;
 }
 
+/*! Copies the source of the given resource, which may be mapped or read from an archive. */
+static void ReadShaderSource(ResourceGroupManager *manager, const std::string &name,
+std::string &result) {
+    if (name.length() == 0) { return; }
+
+    const unsigned char *data;
+    long long length;
+    IOTarget *source = manager->mapResource(name, data, length);
+    result.assign((const char*)data, length);
+    delete source;
+}
+
 Shader* ShaderGLSL::Factory::load(const std::string &args) {
-    std::string vert, vertPath = getPathFromKey("vertex");
-    if (vertPath.length() > 0) { TextStream(FileSystem::GetFile(vertPath)).readAll(vert); }
-    std::string geom, geomPath = getPathFromKey("geometry");
-    if (geomPath.length() > 0) { TextStream(FileSystem::GetFile(geomPath)).readAll(geom); }
-    std::string frag, fragPath = getPathFromKey("fragment");
-    if (fragPath.length() > 0) { TextStream(FileSystem::GetFile(fragPath)).readAll(frag); }
+    std::string vert, geom, frag;
+    ReadShaderSource(_resourceGroupManager, _ptree.get<std::string>("vertex", ""), vert);
+    ReadShaderSource(_resourceGroupManager, _ptree.get<std::string>("geometry", ""), geom);
+    ReadShaderSource(_resourceGroupManager, _ptree.get<std::string>("fragment", ""), frag);
     return new ShaderGLSL(vert, geom, frag);
 }
 
@@ -39,6 +48,7 @@ ShaderGLSL::ShaderGLSL(
     const std::string &geomString,
     const std::string &fragString
 ):
+    _instanceMatrixChannel(-1),
     _vertString(vertString),
     _geomString(geomString),
     _fragString(fragString)
@@ -85,6 +95,43 @@ ShaderGLSL::ShaderGLSL(
         THROW(InternalError, "Error linking shaders to programable object: " << errors);
     }
 
+    reflectUniforms();
+
+    _instanceMatrixChannel = glGetAttribLocation(_programHandle, InstanceMatrixAttribute.c_str());
+}
+
+void ShaderGLSL::reflectUniforms() {
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(_programHandle, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(_programHandle, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<GLchar> buffer(maxLength + 1);
+    for (GLint i = 0; i < count; i++) {
+        GLint size;
+        GLenum type;
+        GLsizei length = 0;
+        glGetActiveUniform(_programHandle, i, buffer.size(), &length, &size, &type, &buffer[0]);
+
+        // Arrays are reported by their first element, but are set by their plain name.
+        std::string name(&buffer[0], length);
+        size_t bracket = name.find('[');
+        if (bracket != std::string::npos) {
+            name.erase(bracket);
+        }
+
+        // Built in uniforms are active, but have no location.
+        GLint location = glGetUniformLocation(_programHandle, name.c_str());
+        if (location == -1) {
+            continue;
+        }
+
+        int slot = ShaderParameter::GetSlot(name);
+        if (slot >= _uniforms.size()) {
+            _uniforms.resize(slot + 1);
+        }
+
+        _uniforms[slot].location = location;
+    }
 }
 
 ShaderGLSL::~ShaderGLSL() {
@@ -149,31 +196,37 @@ void ShaderGLSL::unload() {
     }
     
     if(_programHandle) {
-        glDeleteProgram(_programHandle); _programHandle = NULL;
+        glDeleteProgram(_programHandle);
+        RenderState::Get()->programDeleted(_programHandle);
+        _programHandle = NULL;
     }
 }
 
 void ShaderGLSL::enable() {
-    glUseProgram(_programHandle);
+    RenderState::Get()->useProgram(_programHandle);
 }
 
 void ShaderGLSL::disable() {
     // Loop over bound textures and disable them in one go.
-    TextureChannelBindingMap::iterator itr;
-    for (itr = _textures.begin(); itr != _textures.end(); itr++) {
-        if (itr->second.texture) {
-            itr->second.texture->disable(itr->second.channel);
+    for (int i = 0; i < _textureSlots.size(); i++) {
+        Uniform &uniform = _uniforms[_textureSlots[i]];
+        if (uniform.texture) {
+            uniform.texture->disable(uniform.channel);
         }
     }
 
-    glUseProgram(0);
+    RenderState::Get()->useProgram(0);
+}
+
+int ShaderGLSL::getInstanceMatrixChannel() {
+    return _instanceMatrixChannel;
 }
 
 void ShaderGLSL::bindAttributeToChannel(const std::string &name, int channel) {
     glBindAttribLocation(_programHandle, channel, name.c_str());
 }
 
-void ShaderGLSL::setParameter(const std::string &strVariable, ShaderParameter *param) {
+void ShaderGLSL::setParameter(int slot, ShaderParameter *param) {
 #if DEBUG
     GLint activeProgram = -1;
     glGetIntegerv(GL_CURRENT_PROGRAM, &activeProgram);
@@ -183,7 +236,27 @@ void ShaderGLSL::setParameter(const std::string &strVariable, ShaderParameter *p
     ASSERT_EQ(activeProgram, _programHandle);
 #endif
 
-    int paramID = getVariable(strVariable);
+    if (slot >= _uniforms.size() || _uniforms[slot].location == -1) {
+        THROW(InternalError, "Error getting shader variable '" <<
+            ShaderParameter::GetSlotName(slot) << "': ID == -1");
+    }
+
+    Uniform &uniform = _uniforms[slot];
+    int paramID = uniform.location;
+
+    // Uniforms keep their values as long as the program is around, so don't bother
+    // uploading a value that's already there. Textures are always rebound, since the
+    // binding goes away when the Shader is disabled.
+    if (param->getType() != TextureParam) {
+        int bytes = param->getByteCount();
+        const unsigned char *data = param->getData<unsigned char>();
+        if (uniform.value.size() == bytes && (bytes == 0 || memcmp(&uniform.value[0], data, bytes) == 0)) {
+            return;
+        }
+
+        uniform.value.assign(data, data + bytes);
+    }
+
     switch(param->getType()) {
     case FloatParam:
         switch(param->getSize()) {
@@ -208,20 +281,18 @@ void ShaderGLSL::setParameter(const std::string &strVariable, ShaderParameter *p
         glUniformMatrix4fv(paramID, param->getCount(), false, (param->getData<Matrix>())->getMatrix());
         break;
     case TextureParam: {
-        // Store a reference to the relevant map entry.
-        TextureChannelBinding &binding = _textures[paramID];
-
-        // Initialize the binding if it hasn't already been set. This work should only
+        // Tie the sampler to a channel if it hasn't already been. This work should only
         // need to be done once with the shader active.
-        if (binding.channel == -1) {
-            binding.channel = _textures.size() - 1;
-            glUniform1i(paramID, binding.channel);
+        if (uniform.channel == -1) {
+            uniform.channel = _textureSlots.size();
+            _textureSlots.push_back(slot);
+            glUniform1i(paramID, uniform.channel);
         }
 
         // Enable the texture on the correct channel. Don't need to worry about disabling
         // any old texture as simply enabling a new texture will setup the correct state.
-        binding.texture = param->getData<Texture>();
-        binding.texture->enable(binding.channel);
+        uniform.texture = param->getData<Texture>();
+        uniform.texture->enable(uniform.channel);
 
         break;
     }
@@ -230,15 +301,3 @@ void ShaderGLSL::setParameter(const std::string &strVariable, ShaderParameter *p
     }
 }
 
-GLint ShaderGLSL::getVariable(const std::string &var) const {
-    GLint id = -1;
-    if(_programHandle) {
-        id = glGetUniformLocation(_programHandle, var.c_str());
-    }
-
-    if (id == -1) {
-        THROW(InternalError, "Error getting shader variable '" << var << "': ID == -1");
-    }
-
-    return id;
-}
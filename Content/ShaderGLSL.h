@@ -42,7 +42,9 @@ public:
 
     virtual void bindAttributeToChannel(const std::string &name, int channel);
 
-    virtual void setParameter(const std::string &strVariable, ShaderParameter *param);
+    virtual void setParameter(int slot, ShaderParameter *param);
+
+    virtual int getInstanceMatrixChannel();
 
     bool hasVertexShader();
 
@@ -51,31 +53,34 @@ public:
     bool hasFragmentShader();
 
 private:
-    /*! Maps texture uniform IDs to paired texture channels and textures. When Textures
-     *  are set, they're tied to a texture channel. Then, when we enable the Shader, we
-     *  bind the textures to the proper channel. */
-    struct TextureChannelBinding {
-        TextureChannelBinding(): texture(NULL), channel(-1) {}
-        Texture *texture;
-        GLint channel;
+    /*! Everything known about one of the Shader's active uniforms. These are found once,
+     *  when the program is linked, and stored by slot so setting a parameter never has to
+     *  look anything up by name. */
+    struct Uniform {
+        Uniform(): location(-1), channel(-1), texture(NULL) {}
+        GLint location;                   //!< The uniform's location, or -1 if it isn't active.
+        GLint channel;                    //!< The texture channel a sampler is tied to.
+        Texture *texture;                 //!< The texture last bound to the channel.
+        std::vector<unsigned char> value; //!< The last value uploaded.
     };
 
-    typedef std::map<GLint, TextureChannelBinding> TextureChannelBindingMap;
+    /*! Finds every active uniform in the linked program and fills in _uniforms. */
+    void reflectUniforms();
 
-    TextureChannelBindingMap _textures;
+    std::vector<Uniform> _uniforms; //!< Indexed by ShaderParameter slot.
+    std::vector<int> _textureSlots; //!< The slots of every sampler with a channel.
 
 private:
     GLuint _vertexShader;
     GLuint _geometryShader;
     GLuint _fragmentShader;
     GLuint _programHandle;
+    GLint _instanceMatrixChannel;
 
     const std::string _vertString;
     const std::string _geomString;
     const std::string _fragString;
 
-    GLint getVariable(const std::string &strVariable) const;
-
 };
 
 #endif
@@ -11,7 +11,8 @@
 #include "ShaderGLSL.h"
 #include "ShaderCg.h"
 
-ShaderManager::ShaderManager(ResourceGroupManager *manager) {
+ShaderManager::ShaderManager(ResourceGroupManager *manager):
+ResourceManager<Shader>(manager) {
     registerFactory(new ShaderGLSL::Factory(manager));
     registerFactory(new ShaderCg::Factory(manager));
 }
@@ -0,0 +1,140 @@
+/*
+ *  TextureCache.cpp
+ *  Mountainhome
+ *
+ *  Created by loch on 5/10/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "TextureCache.h"
+#include "ResourceGroupManager.h"
+
+#include <Base/FileSystem.h>
+#include <Base/MappedFile.h>
+#include <Base/Exception.h>
+
+#include <Render/Texture.h>
+#include <Render/PixelData.h>
+
+/*! A mapped and validated cache, waiting to be uploaded. */
+class PreparedTextureCache : public PreparedResource {
+public:
+    PreparedTextureCache(IOTarget *source): source(source) {}
+    virtual ~PreparedTextureCache() { delete source; }
+
+    IOTarget *source;   //!< Owns the memory the cache points into.
+    ImageCache cache;
+
+    void setBytes(long long bytes) { _bytes = bytes; }
+};
+
+/*! Gets the GL layout matching a cache format. */
+static GLenum GetLayout(ImageCache::Format format) {
+    switch (format) {
+    case ImageCache::DXT1: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case ImageCache::DXT5: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    default:               return GL_RGBA;
+    }
+}
+
+#pragma mark TextureCacheFactory static definitions
+
+Texture* TextureCacheFactory::BuildTexture(
+    const std::string &name,
+    const std::vector<ImageCache::LevelView> &views,
+    ImageCache::Format format,
+    TextureManager *tManager
+) {
+    bool expand = ImageCache::IsCompressed(format) && !CanUploadCompressed();
+
+    int count = views.size();
+    std::vector<ImageCache::Level> expanded(expand ? count : 0);
+    PixelData *levels = new PixelData[count];
+    for (int i = 0; i < count; i++) {
+        const ImageCache::LevelView &view = views[i];
+        if (expand) {
+            ImageCache::Level level;
+            level.width = view.width;
+            level.height = view.height;
+            level.data.assign(view.data, view.data + view.size);
+            ImageCache::Decompress(level, format, expanded[i]);
+            levels[i].setPixelData(&expanded[i].data[0], GL_RGBA, view.width, view.height);
+        } else {
+            // The level is only read from, so the const can go.
+            levels[i].setPixelData((unsigned char*)view.data, GetLayout(format), view.width,
+                view.height);
+        }
+    }
+
+    Texture *result = tManager->createTexture(name);
+    result->uploadMipChain(levels, count, GL_RGBA);
+    delete[] levels;
+    return result;
+}
+
+bool TextureCacheFactory::CanUploadCompressed() {
+    static int supported = -1;
+    if (supported < 0) {
+        supported = IsExtensionSupported("GL_EXT_texture_compression_s3tc");
+        if (!supported) {
+            Warn("S3TC isn't supported. Compressed textures will be expanded on load.");
+        }
+    }
+
+    return supported;
+}
+
+#pragma mark TextureCacheFactory definitions
+
+TextureCacheFactory::TextureCacheFactory(ResourceGroupManager *manager, TextureManager *tManager):
+ResourceFactory<Texture>(manager, false), _textureManager(tManager) {}
+
+TextureCacheFactory::~TextureCacheFactory() {}
+
+bool TextureCacheFactory::canLoad(const std::string &name) {
+    std::string ext;
+    FileSystem::ExtractExtension(name, ext, true);
+    return ext == "mht";
+}
+
+Texture* TextureCacheFactory::load(const std::string &name) {
+    PreparedResource *prepared = prepare(name);
+    Texture *result = finish(name, prepared);
+    delete prepared;
+    return result;
+}
+
+bool TextureCacheFactory::canPrepare(const std::string &name) {
+    return canLoad(name);
+}
+
+PreparedResource* TextureCacheFactory::prepare(const std::string &name) {
+    const unsigned char *data = NULL;
+    long long length = 0;
+    PreparedTextureCache *prepared = new PreparedTextureCache(
+        _resourceGroupManager->mapResource(name, data, length));
+
+    if (!prepared->cache.read(data, length)) {
+        delete prepared;
+        THROW(InvalidStateError, "Invalid texture cache: " << name);
+    }
+
+    // Fault the levels in here rather than during the upload on the main thread.
+    MappedFile *file = dynamic_cast<MappedFile*>(prepared->source);
+    if (file) {
+        file->advise(MappedFile::WillNeed);
+    }
+
+    prepared->setBytes(length);
+    return prepared;
+}
+
+Texture* TextureCacheFactory::finish(const std::string &name, PreparedResource *prepared) {
+    if (!prepared) {
+        return load(name);
+    }
+
+    const ImageCache &cache = static_cast<PreparedTextureCache*>(prepared)->cache;
+    return BuildTexture(name, cache.getLevels(), cache.getFormat(), _textureManager);
+}
@@ -0,0 +1,57 @@
+/*
+ *  TextureCache.h
+ *  Mountainhome
+ *
+ *  Created by loch on 5/10/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _TEXTURECACHE_H_
+#define _TEXTURECACHE_H_
+#include "TextureManager.h"
+#include <Base/ImageCache.h>
+
+/*! Loads Textures from the engine's native .mht texture caches. Caches hold every mip
+ *  level already flipped and, usually, already S3TC compressed, so loading one does no
+ *  decoding at all. On the loader threads, the file is mapped, validated, and paged in.
+ *  The main thread only hands each level to the card.
+ *
+ *  Cards without GL_EXT_texture_compression_s3tc get compressed caches expanded back
+ *  into RGBA when they're uploaded, which is slower, but still skips decoding the source
+ *  image and building its mipmaps.
+ *
+ *  This is also where Textures are built from ImageCache levels in general, so atlas
+ *  pages and other generated images can share the upload code.
+ * \brief Builds Textures out of .mht texture caches.
+ * \seealso ImageCache
+ * \seealso TextureSDL::Factory::convert */
+class TextureCacheFactory : public ResourceFactory<Texture> {
+public:
+    /*! Creates a Texture in the given TextureManager from a complete mip chain, in the
+     *  given format, largest level first. */
+    static Texture* BuildTexture(const std::string &name,
+                                 const std::vector<ImageCache::LevelView> &levels,
+                                 ImageCache::Format format, TextureManager *tManager);
+
+    /*! Returns true if compressed levels can be uploaded as is. Only checked once there's
+     *  certain to be a context, the first time it's needed. */
+    static bool CanUploadCompressed();
+
+public:
+    TextureCacheFactory(ResourceGroupManager *manager, TextureManager *tManager);
+    virtual ~TextureCacheFactory();
+
+    bool canLoad(const std::string &args);
+    Texture* load(const std::string &args);
+
+    bool canPrepare(const std::string &args);
+    PreparedResource* prepare(const std::string &args);
+    Texture* finish(const std::string &args, PreparedResource *prepared);
+
+private:
+    TextureManager *_textureManager;
+
+};
+
+#endif
@@ -13,10 +13,13 @@
 #include <Base/File.h>
 
 #include "TextureSDL.h"
+#include "TextureCache.h"
 #include "TextureManager.h"
 #include "Texture.h"
 
-TextureManager::TextureManager(ResourceGroupManager *manager) {
+TextureManager::TextureManager(ResourceGroupManager *manager):
+ResourceManager<Texture>(manager) {
+    registerFactory(new TextureCacheFactory(manager, this));
     registerFactory(new TextureSDL::Factory(manager, this));
 }
 
@@ -39,6 +42,7 @@ Texture *TextureManager::createBlankTexture(const std::string &name, GLenum inte
 
     PixelData data(NULL, format, GL_UNSIGNED_BYTE, w, h, d);
     tex->uploadPixelData(data, internal);
+    updateResourceSize(name);
     return tex;
 }
 
@@ -58,9 +62,15 @@ Texture *TextureManager::createRandomTexture(const std::string &name, int w, int
     // Doesn't have mipmaps, so turn off filtering.
     tex->setFiltering(GL_NEAREST, GL_NEAREST);
 
+    updateResourceSize(name);
     return tex;
 }
 
+void TextureManager::measureResource(const Texture *resource, long long &cpuBytes,
+long long &gpuBytes) const {
+    gpuBytes = resource->getByteCount();
+}
+
 //Texture* TextureManager::initCube(const string &name, int w, int h, int frames) {
 //    Texture *tex = new Texture();
 //    if (!initCube(tex, name, w, h, frames)) {
@@ -23,6 +23,11 @@ public:
     Texture *createBlankTexture(const std::string &name, GLenum internal, int w, int h = 1, int d = 1);
     Texture *createRandomTexture(const std::string &name, int w, int h = 1, int d = 1);
 
+protected:
+    /*! Textures live entirely on the card once uploaded. */
+    virtual void measureResource(const Texture *resource, long long &cpuBytes,
+                                 long long &gpuBytes) const;
+
 };
 
 #endif
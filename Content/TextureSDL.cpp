@@ -19,25 +19,37 @@
 #include <Base/FileSystem.h>
 #include <Base/Assertion.h>
 #include <Base/Logger.h>
+#include <climits>
 
-SDL_Surface *readTextureSDL(const std::string &name, PixelData *data) {
+SDL_Surface *readTextureSDL(ResourceGroupManager *manager, const std::string &name, PixelData *data) {
     SDL_Surface *surface;
-    std::string fullName;
-    if (!FileSystem::GetReadName(name, fullName)) {
-        Error("TextureManager: Could not find the given file.");
-        Error("  Given name : " << name);
-        Error("  Search name: " << fullName);
+    const unsigned char *bytes;
+    long long length;
+
+    // Decode straight out of memory rather than through stdio, so images in archives work
+    // as well as loose files. The extension is passed along since some formats (like TGA)
+    // can't be detected from their contents.
+    IOTarget *source = manager->mapResource(name, bytes, length);
+    if (length > INT_MAX) {
+        Error("TextureManager: Image is too large: " << name);
+        delete source;
         return NULL;
     }
 
-    if (!(surface = IMG_Load(fullName.c_str()))) {
-        Error("TextureManager: Could not open: " << fullName);
+    std::string ext;
+    FileSystem::ExtractExtension(name, ext);
+    SDL_RWops *rw = SDL_RWFromConstMem(bytes, length);
+    surface = IMG_LoadTyped_RW(rw, 1, const_cast<char*>(ext.c_str()));
+    delete source;
+
+    if (!surface) {
+        Error("TextureManager: Could not open: " << name);
         return NULL;
     }
     
     if (surface->format->palette) {
         //TODO add support for loading palette images. It could be neat.
-        Error("TextureManager: " << fullName << " is an indexed image");
+        Error("TextureManager: " << name << " is an indexed image");
         SDL_FreeSurface(surface);
         return NULL;
     }
@@ -59,6 +71,18 @@ SDL_Surface *readTextureSDL(const std::string &name, PixelData *data) {
     return surface;
 }
 
+/*! A decoded image, waiting to be uploaded. */
+class PreparedTextureSDL : public PreparedResource {
+public:
+    PreparedTextureSDL(SDL_Surface *surface): PreparedResource(surface->h * surface->pitch),
+        surface(surface) {}
+
+    virtual ~PreparedTextureSDL() { SDL_FreeSurface(surface); }
+
+    SDL_Surface *surface;
+    PixelData data;
+};
+
 TextureSDL::Factory::Factory(ResourceGroupManager *manager, TextureManager *tManager):
 ResourceFactory<Texture>(manager, false), _textureManager(tManager) {}
 TextureSDL::Factory::~Factory() {}
@@ -72,10 +96,8 @@ bool TextureSDL::Factory::canLoad(const std::string &name) {
 }
 
 Texture *TextureSDL::Factory::load(const std::string &name) {
-    std::string fullName = _resourceGroupManager->findResource(name);
-
     PixelData data;
-    SDL_Surface *surface = readTextureSDL(fullName, &data);
+    SDL_Surface *surface = readTextureSDL(_resourceGroupManager, name, &data);
 
     Texture *result = NULL;
     if (surface) {
@@ -87,6 +109,63 @@ Texture *TextureSDL::Factory::load(const std::string &name) {
     return result;
 }
 
+bool TextureSDL::Factory::canPrepare(const std::string &name) {
+    return canLoad(name);
+}
+
+PreparedResource *TextureSDL::Factory::prepare(const std::string &name) {
+    PixelData data;
+    SDL_Surface *surface = readTextureSDL(_resourceGroupManager, name, &data);
+    if (!surface) {
+        THROW(InternalError, "Could not decode texture: " << name);
+    }
+
+    // The pixel data doesn't own the pixels, so it can just be pointed at them again.
+    PreparedTextureSDL *prepared = new PreparedTextureSDL(surface);
+    prepared->data.setPixelData((unsigned char*)surface->pixels, data.getLayout(),
+        surface->w, surface->h, false);
+    return prepared;
+}
+
+Texture *TextureSDL::Factory::finish(const std::string &name, PreparedResource *prepared) {
+    if (!prepared) {
+        return load(name);
+    }
+
+    PreparedTextureSDL *image = static_cast<PreparedTextureSDL*>(prepared);
+    Texture *result = _textureManager->createTexture(name);
+    result->uploadPixelData(image->data, GL_RGBA);
+    return result;
+}
+
+bool TextureSDL::Factory::convert(const std::string &name, IOTarget *target,
+ImageCache::Format format) {
+    ImageCache::Level image;
+    if (!decode(name, image)) {
+        return false;
+    }
+
+    std::vector<ImageCache::Level> levels;
+    ImageCache::Cook(&image.data[0], image.width, image.height, image.width * 4, 4, false,
+        false, format, levels);
+    return ImageCache::Write(target, format, levels);
+}
+
+bool TextureSDL::Factory::decode(const std::string &name, ImageCache::Level &result) {
+    PixelData data;
+    SDL_Surface *surface = readTextureSDL(_resourceGroupManager, name, &data);
+    if (!surface) {
+        return false;
+    }
+
+    // The surface has already been flipped, and is in the same layout load uploads.
+    ImageCache::Convert((unsigned char*)surface->pixels, surface->w, surface->h,
+        surface->pitch, data.getBytesPerPixel(),
+        data.getLayout() == GL_BGR || data.getLayout() == GL_BGRA, false, result);
+    SDL_FreeSurface(surface);
+    return true;
+}
+
 //Texture* TextureSDL::loadCubeMap(const std::string &name,
 //                                 const std::string files[6]) {
 //    if (!canLoad(name)) {
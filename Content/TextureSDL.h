@@ -12,6 +12,7 @@
 #ifndef _TEXTUREFACTORYSDL_H_
 #define _TEXTUREFACTORYSDL_H_
 #include "TextureManager.h"
+#include <Base/ImageCache.h>
 
 /*! \todo Support cube maps, animated textures, and 3D textures. */
 class TextureSDL : public Texture {
@@ -24,6 +25,24 @@ public:
         bool canLoad(const std::string &args);
         Texture* load(const std::string &args);
 
+        /*! Images are read and decoded on the loader threads. Only the upload is left
+         *  for the main thread. */
+        bool canPrepare(const std::string &args);
+        PreparedResource* prepare(const std::string &args);
+        Texture* finish(const std::string &args, PreparedResource *prepared);
+
+        /*! Decodes the named image and writes it to target as a .mht texture cache, with
+         *  a full mip chain in the given format. TextureCacheFactory loads these without
+         *  decoding, flipping, or building mipmaps.
+         * \return false if the image could not be decoded or written. */
+        bool convert(const std::string &name, IOTarget *target,
+                     ImageCache::Format format = ImageCache::DXT5);
+
+        /*! Decodes the named image into a single RGBA level, bottom row first, the way
+         *  it would be uploaded. Used when building atlases and caches.
+         * \return false if the image could not be decoded. */
+        bool decode(const std::string &name, ImageCache::Level &result);
+
     private:
         TextureManager *_textureManager;
 
@@ -11,6 +11,8 @@
 #include <Render/RenderContext.h>
 #include <Render/SDL_Helper.h>
 #include <Engine/Camera.h>
+#include <Base/Profiler.h>
+#include <Base/Timer.h>
 
 #include "AbstractCore.h"
 #include "EventPump.h"
@@ -43,7 +45,13 @@ void AbstractCore::setPostText() {
     char buffer [64];
     snprintf(buffer, 64, "FPS: %i Geo: %i", (int)_framerate, _renderContext->getPrimitiveCount());
     // snprintf(buffer, 64, "FPS: %i", (int)_framerate);
-    _mainWindow->setPostCaption(buffer);
+
+    // Show the last frame's timings alongside, while profiling.
+    if (Profiler::IsEnabled()) {
+        _mainWindow->setPostCaption(std::string(buffer) + " " + Profiler::GetCaption());
+    } else {
+        _mainWindow->setPostCaption(buffer);
+    }
 }
 
 void AbstractCore::calculateFramerate(int elapsed) {
@@ -61,7 +69,9 @@ void AbstractCore::calculateFramerate(int elapsed) {
 }
 
 int AbstractCore::getTime() {
-    return SDL_GetTicks();
+    // Measured from the first call, so the milliseconds fit comfortably in an int.
+    static uint64_t start = Timer::Now();
+    return (Timer::Now() - start) / 1000000;
 }
 
 Window* AbstractCore::getMainWindow() {
@@ -79,6 +89,7 @@ void AbstractCore::startMainLoop() {
     int elapsedTime;
 
     _running = true;
+    Profiler::SetThreadName("Main");
 
     va_list args;
     setup(args);
@@ -89,10 +100,13 @@ void AbstractCore::startMainLoop() {
         elapsedTime = currentTime - lastTime;
         calculateFramerate(elapsedTime);
 
-        getEventPump()->processEvents();
-        broadcastFrameEvent(elapsedTime);
-
-        innerLoop(elapsedTime);
+        {
+            PROFILE("Frame");
+            getEventPump()->processEvents();
+            { PROFILE("Frame Listeners"); broadcastFrameEvent(elapsedTime); }
+            { PROFILE("Inner Loop"); innerLoop(elapsedTime); }
+        }
+        Profiler::EndFrame();
 
         lastTime = currentTime;
         CheckGLErrors();
@@ -41,11 +41,9 @@ const Matrix & Camera::getViewMatrix() {
     return _view;
 }
 
-bool Camera::updateImplementationValues() {
-    bool ret = SceneNode::updateImplementationValues();
+void Camera::transformationUpdatedNotice() {
     _view = _derivedTransform.getInverse();
     _frustum.setWorldMatrix(_view);
-    return ret;
 }
 
 void Camera::createSelectionFrustum(const Vector2 &one, const Vector2 &two, Frustum &frustum) {
@@ -44,7 +44,7 @@ public:
 protected:
     Camera(const std::string &name, const std::string &type);
 
-    virtual bool updateImplementationValues();
+    virtual void transformationUpdatedNotice();
 
 protected:
     Frustum _frustum;
@@ -74,6 +74,7 @@ const std::string& DefaultCore::getPersonalDir() {
 }
 
 void DefaultCore::innerLoop(int elapsedMilliseconds) {
+    Content::UpdateLoader(LoaderBudget);
     update(elapsedMilliseconds);
 
     _renderContext->resetCounts();
@@ -17,6 +17,9 @@ class RenderTarget;
 
 class DefaultCore : public AbstractCore, public OptionsModule::Listener {
 public:
+    /*! The number of milliseconds each frame may spend finishing background loads. */
+    static const int LoaderBudget = 4;
+
     //\todo Load the particulars from persistent data storage.
     DefaultCore(const std::string &projectName, const std::string &resourceDir = "");
     virtual ~DefaultCore();
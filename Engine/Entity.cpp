@@ -44,13 +44,19 @@ void Entity::addModel(Model *model, Material *mat) {
     }
 }
 
+bool Entity::getLocalAABB(AABB3 &aabb) const {
+    if (_hasLocalAABB) { aabb = _localAABB; }
+    return _hasLocalAABB;
+}
+
 bool Entity::updateImplementationValues() {
     AABB3 oldAABB = _derivedBoundingBox;
 
     SceneNode::updateImplementationValues();
     if (_hasLocalAABB) {
-        _derivedBoundingBox.encompass(_derivedTransform * _localAABB.getMin());
-        _derivedBoundingBox.encompass(_derivedTransform * _localAABB.getMax());
+        AABB3 local;
+        Matrix::TransformBounds(_derivedTransform, &_localAABB, &local, 1);
+        _derivedBoundingBox.encompass(local);
     }
 
     if(oldAABB != _derivedBoundingBox) {
@@ -30,6 +30,8 @@ public:
 
     virtual bool updateImplementationValues();
 
+    virtual bool getLocalAABB(AABB3 &aabb) const;
+
 protected:
     Entity(const std::string &name, const std::string &typeName);
 
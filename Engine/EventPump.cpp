@@ -9,6 +9,7 @@
  
 #include <Render/Render.h>
 #include <Render/SDL_Helper.h>
+#include <Base/Profiler.h>
 
 #include "EventPump.h"
 #include "WindowListener.h"
@@ -44,6 +45,7 @@ void EventPump::addKeyListener(KeyListener *listener) {
 }
 
 void EventPump::processEvents() {
+    PROFILE("Events");
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
         switch(event.type) {
@@ -8,17 +8,30 @@
  */
 
 #include <Render/RenderContext.h>
+#include <Base/AABBTree.h>
+#include <Base/WorkerPool.h>
+#include <Base/Profiler.h>
 
 #include "SceneManager.h"
+#include "SceneStorage.h"
 #include "Light.h"
 
-SceneManager::SceneManager(): _rootNode(NULL), _ambientLight(.6, .6, .6, 1), _frustumCullingEnabled(true), _drawBoundingBoxes(false) {
+SceneManager::SceneManager(): _rootNode(NULL), _storage(NULL), _spatialIndex(NULL), _workers(NULL), _cullBounds(NULL), _cullChunkCount(0), _ambientLight(.6, .6, .6, 1), _frustumCullingEnabled(true), _drawBoundingBoxes(false), _flatStorageEnabled(false), _spatialIndexEnabled(true) {
     _rootNode = new SceneNode("ROOT");
+    _rootNode->_scene = this;
+    _storage = new SceneStorage(_rootNode);
+    _spatialIndex = new AABBTree<SceneNode*>();
 }
 
 SceneManager::~SceneManager() {
     deleteAllNodes();
     deleteAllLights();
+    delete _storage;
+    _storage = NULL;
+    delete _spatialIndex;
+    _spatialIndex = NULL;
+    delete _workers;
+    _workers = NULL;
     delete _rootNode;
     _rootNode = NULL;
 }
@@ -28,30 +41,79 @@ void SceneManager::render(const std::string &camera, RenderContext *context) {
 }
 
 void SceneManager::render(Camera *camera, RenderContext *context) {
-    _rootNode->updateDerivedValues();
+    PROFILE("Scene");
+    { PROFILE("Scene Update"); update(); }
 
-    SceneNodeList visibleNodes;
-    addVisibleObjectsToList(camera->getFrustum(), visibleNodes);
+    _visibleNodes.clear();
+    _visibleRenderables.clear();
+
+    {
+        PROFILE("Scene Cull");
+        if (_frustumCullingEnabled && _workers) {
+            findVisibleRoots(camera->getFrustum());
+
+            // Use a few more pieces than threads, so uneven subtrees balance out.
+            _cullChunkCount = std::min<int>(_visibleRoots.size(), (_workers->getThreadCount() + 1) * 4);
+            if (_cullBuckets.size() < _cullChunkCount) { _cullBuckets.resize(_cullChunkCount); }
+
+            _cullBounds = &camera->getFrustum();
+            _workers->run(CullJob, this, _cullChunkCount);
+
+            // Merge the pieces back together in order.
+            for (int i = 0; i < _cullChunkCount; i++) {
+                CullBucket &bucket = _cullBuckets[i];
+                _visibleNodes.insert(_visibleNodes.end(), bucket.nodes.begin(), bucket.nodes.end());
+                _visibleRenderables.insert(_visibleRenderables.end(), bucket.renderables.begin(), bucket.renderables.end());
+            }
+        } else {
+            addVisibleObjectsToList(camera->getFrustum(), _visibleNodes);
+            SceneNodeList::iterator itr;
+            for (itr = _visibleNodes.begin(); itr != _visibleNodes.end(); itr++) {
+                (*itr)->addRenderablesToList(_visibleRenderables, _drawBoundingBoxes);
+            }
+        }
+    }
 
-    RenderableList visibleRenderables;
     SceneNodeList::iterator itr;
-    for (itr = visibleNodes.begin(); itr != visibleNodes.end(); itr++) {
-        (*itr)->addRenderablesToList(visibleRenderables, _drawBoundingBoxes);
+    for (itr = _visibleNodes.begin(); itr != _visibleNodes.end(); itr++) {
         (*itr)->preRenderNotice();
     }
 
-    LightList lights;
+    _lights.clear();
     LightMap::iterator lightItr = _lightMap.begin();
     for (; lightItr != _lightMap.end(); lightItr++) {
-        lights.push_back(lightItr->second);
+        _lights.push_back(lightItr->second);
     }
 
     context->setGlobalAmbient(_ambientLight);
     context->render(
         camera->getViewMatrix(),
         camera->getProjectionMatrix(),
-        visibleRenderables,
-        lights);
+        _visibleRenderables,
+        _lights);
+}
+
+void SceneManager::CullJob(void *data, int index) {
+    SceneManager *scene = static_cast<SceneManager*>(data);
+    CullBucket &bucket = scene->_cullBuckets[index];
+    bucket.nodes.clear();
+    bucket.renderables.clear();
+
+    int count = scene->_visibleRoots.size();
+    int start = count * index / scene->_cullChunkCount;
+    int end = count * (index + 1) / scene->_cullChunkCount;
+    for (int i = start; i < end; i++) {
+        SceneNode *root = scene->_visibleRoots[i];
+        bucket.nodes.push_back(root);
+        scene->addVisibleChildrenToList(root,
+            scene->_visibleRootsContained[i] ? NULL : scene->_cullBounds,
+            bucket.nodes);
+    }
+
+    SceneNodeList::iterator itr;
+    for (itr = bucket.nodes.begin(); itr != bucket.nodes.end(); itr++) {
+        (*itr)->addRenderablesToList(bucket.renderables, scene->_drawBoundingBoxes);
+    }
 }
 
 void SceneManager::deleteAllNodes() {
@@ -69,10 +131,69 @@ void SceneManager::deleteAllLights() {
 }
 
 void SceneManager::addVisibleObjectsToList(const Frustum &bounds, SceneNodeList &visible) {
-    if(_frustumCullingEnabled) {
-        _rootNode->addVisibleObjectsToList(bounds, visible);
+    if (!_frustumCullingEnabled) {
+        if (_flatStorageEnabled) { _storage->addAllObjectsToList(visible); }
+        else                     { _rootNode->addAllObjectsToList(visible); }
+        return;
+    }
+
+    findVisibleRoots(bounds);
+    for (unsigned int i = 0; i < _visibleRoots.size(); i++) {
+        visible.push_back(_visibleRoots[i]);
+        addVisibleChildrenToList(_visibleRoots[i], _visibleRootsContained[i] ? NULL : &bounds, visible);
+    }
+}
+
+void SceneManager::findVisibleRoots(const Frustum &bounds) {
+    _intersectingNodes.clear();
+    _containedNodes.clear();
+    _visibleRoots.clear();
+    _visibleRootsContained.clear();
+
+    if (_spatialIndexEnabled) {
+        _spatialIndex->query(bounds, _intersectingNodes, _containedNodes);
+    } else {
+        SceneNodeMap::iterator itr = _rootNode->_children.begin();
+        for (; itr != _rootNode->_children.end(); itr++) {
+            _intersectingNodes.push_back(itr->second);
+        }
+    }
+
+    // Top level nodes that straddle the frustum still need to be checked. Do it all in
+    // one batch.
+    unsigned int count = _intersectingNodes.size();
+    _intersectingBoxes.clear();
+    _cullResults.resize(count);
+    for (unsigned int i = 0; i < count; i++) {
+        _intersectingBoxes.add(_intersectingNodes[i]->_derivedBoundingBox);
+    }
+
+    if (count) { bounds.checkAABBs(_intersectingBoxes, 0, count, &_cullResults[0]); }
+
+    for (unsigned int i = 0; i < count; i++) {
+        SceneNode *node = _intersectingNodes[i];
+        if (_cullResults[i] != Frustum::COMPLETE_OUT && node->_visible) {
+            _visibleRoots.push_back(node);
+            _visibleRootsContained.push_back(false);
+        }
+    }
+
+    // Everything else is entirely inside of the frustum, children included.
+    for (unsigned int i = 0; i < _containedNodes.size(); i++) {
+        if (_containedNodes[i]->_visible) {
+            _visibleRoots.push_back(_containedNodes[i]);
+            _visibleRootsContained.push_back(true);
+        }
+    }
+}
+
+void SceneManager::addVisibleChildrenToList(SceneNode *node, const Frustum *bounds, SceneNodeList &visible) {
+    if (_flatStorageEnabled) {
+        _storage->addVisibleObjectsToList(node, bounds, visible);
+    } else if (bounds) {
+        node->addVisibleObjectsToList(*bounds, visible);
     } else {
-        _rootNode->addAllObjectsToList(visible);
+        node->addVisibleObjectsToList(visible);
     }
 }
 
@@ -88,9 +209,71 @@ void SceneManager::setDrawBoundingBoxes(bool value) {
     _drawBoundingBoxes = value;
 }
 
+void SceneManager::setFlatStorage(bool value) {
+    if(value) { Info("Setting flat scene storage ON");  }
+    else {      Info("Setting flat scene storage OFF"); }
+
+    // The storage isn't kept in sync while it's off, so force a full rebuild.
+    if(value && !_flatStorageEnabled) { _storage->invalidate(); }
+    _flatStorageEnabled = value;
+}
+
+void SceneManager::setSpatialIndex(bool value) {
+    if(value) { Info("Setting spatial index ON");  }
+    else {      Info("Setting spatial index OFF"); }
+    _spatialIndexEnabled = value;
+}
+
+void SceneManager::nodeAttached(SceneNode *parent, SceneNode *node) {
+    _storage->invalidate();
+
+    // Only top level nodes go in the spatial index. Everything else is covered by the
+    // AABB of its top level ancestor.
+    if (parent == _rootNode) {
+        node->_spatialProxy = _spatialIndex->insert(node->_derivedBoundingBox, node);
+    }
+}
+
+void SceneManager::nodeDettached(SceneNode *parent, SceneNode *node) {
+    _storage->invalidate();
+
+    if (node->_spatialProxy >= 0) {
+        _spatialIndex->remove(node->_spatialProxy);
+        node->_spatialProxy = -1;
+    }
+}
+
+void SceneManager::nodeDirtied(SceneNode *node) {
+    _storage->enqueue(node);
+}
+
+void SceneManager::nodeVisibilityChanged(SceneNode *node) {
+    _storage->setVisibility(node, node->_visible);
+}
+
+void SceneManager::nodeBoundsChanged(SceneNode *node) {
+    if (node->_spatialProxy >= 0) {
+        _spatialIndex->update(node->_spatialProxy, node->_derivedBoundingBox);
+    }
+}
+
+void SceneManager::setCullingThreads(int count) {
+    Info("Setting culling threads to " << count);
+    delete _workers;
+    _workers = count > 0 ? new WorkerPool(count) : NULL;
+}
+
+int SceneManager::getDirtyNodeCount() const { return _storage->getDirtyCount(); }
+int SceneManager::getTransformUpdateCount() const { return _storage->getTransformUpdateCount(); }
+int SceneManager::getBoundsUpdateCount() const { return _storage->getBoundsUpdateCount(); }
+
 void SceneManager::update() {
     // Update the bounding boxes and derived orientation/positions of everything in the scene.
-    _rootNode->updateDerivedValues();
+    if (_flatStorageEnabled) {
+        _storage->update();
+    } else {
+        _rootNode->updateDerivedValues();
+    }
 }
 
 void SceneManager::setAmbientLight(const Vector4& color) {
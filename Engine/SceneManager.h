@@ -10,16 +10,25 @@
 #define _SCENEMANAGER_H_
 #include <Base/Math3D.h>
 #include <Base/Vector.h>
+#include <Base/AABBArray.h>
+
+#include <Render/Light.h>
 
 #include "SceneNode.h"
 #include "Camera.h"
 #include "Entity.h"
 
+template <typename T> class AABBTree;
+class WorkerPool;
 class RenderContext;
+class SceneStorage;
 class Light;
 class Model;
 
 class SceneManager {
+    friend class SceneNode;
+    friend class SceneStorage;
+
 public:
     SceneManager();
     virtual ~SceneManager();
@@ -73,6 +82,40 @@ public:
     /*! Used to toggle bounding box rendering. */
     void setDrawBoundingBoxes(bool value);
 
+    /*! Used to toggle flat scene storage on and off. When on, derived values are updated
+     *  and visibility is determined by sweeping over a depth first ordered copy of the
+     *  scene rather than by walking the tree of SceneNodes.
+     * \seealso SceneStorage */
+    void setFlatStorage(bool value);
+
+    /*! Used to toggle the spatial index on and off. When on, frustum culling starts by
+     *  querying a bounding volume hierarchy built over the top level nodes in the scene,
+     *  rather than testing each of them in turn. Nodes inside of a region that is
+     *  completely within the frustum are accepted without being tested individually.
+     * \seealso AABBTree */
+    void setSpatialIndex(bool value);
+
+    /*! Sets the number of worker threads used to cull the scene and gather Renderables
+     *  when rendering. Visible top level nodes are split up between the threads and the
+     *  calling thread, and each piece is gathered into its own list before everything is
+     *  merged, in order, for the RenderContext. With no threads, everything is done on
+     *  the calling thread. Since SceneNode::addRenderablesToList may be called from any
+     *  of the threads it must not modify shared state. SceneNode::preRenderNotice is
+     *  always called from the calling thread. */
+    void setCullingThreads(int count);
+
+    /*! Gets the number of nodes that were dirty going into the last update. Only tracked
+     *  when flat storage is enabled. */
+    int getDirtyNodeCount() const;
+
+    /*! Gets the number of derived transforms recalculated during the last update. Only
+     *  tracked when flat storage is enabled. */
+    int getTransformUpdateCount() const;
+
+    /*! Gets the number of AABBs rebuilt during the last update. Only tracked when flat
+     *  storage is enabled. */
+    int getBoundsUpdateCount() const;
+
     /*! Renders the scene to the given RenderContext, based on the named Camera. */
     void render(const std::string &camera, RenderContext *context);
 
@@ -86,12 +129,64 @@ protected:
     SceneNode* genericGetNode(const std::string &name, const std::string &type);
     SceneNode* genericRemoveNode(const std::string &name, const std::string &type);
 
+    /*! Finds the top level nodes that are at least partially inside of the given Frustum
+     *  and stores them in _visibleRoots. Each one is flagged in _visibleRootsContained if
+     *  it is known to be completely inside. */
+    void findVisibleRoots(const Frustum &bounds);
+
+    /*! Culls and gathers Renderables for one chunk of _visibleRoots. Used as a
+     *  WorkerPool job, with the SceneManager as the data. */
+    static void CullJob(void *data, int index);
+
+    /*! Adds all visible objects below the given node to the given list, using whichever
+     *  storage is active. If no Frustum is given, nothing is checked against it. */
+    void addVisibleChildrenToList(SceneNode *node, const Frustum *bounds, SceneNodeList &visible);
+
+    /*! Called by SceneNode when a node is added to the scene. */
+    void nodeAttached(SceneNode *parent, SceneNode *node);
+
+    /*! Called by SceneNode when a node is removed from the scene. */
+    void nodeDettached(SceneNode *parent, SceneNode *node);
+
+    /*! Called by SceneNode when a node in the scene is dirtied. */
+    void nodeDirtied(SceneNode *node);
+
+    /*! Called by SceneNode when a node in the scene changes visibility. */
+    void nodeVisibilityChanged(SceneNode *node);
+
+    /*! Called whenever the derived AABB of a node in the scene changes. */
+    void nodeBoundsChanged(SceneNode *node);
+
 protected:
     bool _frustumCullingEnabled;
     bool _drawBoundingBoxes;
+    bool _flatStorageEnabled;
+    bool _spatialIndexEnabled;
 
     SceneNodeMap _nodeMap;
     SceneNode *_rootNode;
+    SceneStorage *_storage;
+    AABBTree<SceneNode*> *_spatialIndex;
+    std::vector<SceneNode*> _intersectingNodes; //!< Scratch space for spatial index queries.
+    std::vector<SceneNode*> _containedNodes;    //!< Scratch space for spatial index queries.
+    AABBArray _intersectingBoxes;               //!< Scratch space for batch culling.
+    std::vector<unsigned char> _cullResults;    //!< Scratch space for batch culling.
+
+    struct CullBucket {
+        SceneNodeList nodes;
+        RenderableList renderables;
+    };
+
+    WorkerPool *_workers;                       //!< Threads used for culling, if any.
+    const Frustum *_cullBounds;                 //!< The Frustum used by CullJob.
+    int _cullChunkCount;                        //!< The number of pieces CullJob is split into.
+    std::vector<CullBucket> _cullBuckets;       //!< The results of each CullJob piece.
+    SceneNodeList _visibleRoots;                //!< Visible top level nodes.
+    std::vector<unsigned char> _visibleRootsContained; //!< Whether each visible root is completely inside.
+
+    SceneNodeList _visibleNodes;                //!< Reused each frame to avoid allocations.
+    RenderableList _visibleRenderables;         //!< Reused each frame to avoid allocations.
+    LightList _lights;                          //!< Reused each frame to avoid allocations.
     LightMap _lightMap;
 
     Vector4 _ambientLight;
@@ -13,17 +13,18 @@
 
 #include "Renderable.h"
 #include "SceneNode.h"
+#include "SceneManager.h"
 #include "Camera.h"
 
 const std::string SceneNode::TypeName = "SceneNode";
 
 SceneNode::SceneNode(const std::string &name):
 _dirty(true), _fixedYawAxis(true), _yawAxis(0,1,0), _derivedPosition(0.0), _position(0.0),
-_parent(NULL), _type(TypeName), _name(name), _visible(true), _boundingBoxRenderable(NULL) {}
+_parent(NULL), _scene(NULL), _storageIndex(0), _spatialProxy(-1), _type(TypeName), _name(name), _visible(true), _boundingBoxRenderable(NULL) {}
 
 SceneNode::SceneNode(const std::string &name, const std::string &type):
 _dirty(true), _fixedYawAxis(true), _yawAxis(0,1,0), _derivedPosition(0.0), _position(0.0),
-_parent(NULL), _type(type), _name(name), _visible(true), _boundingBoxRenderable(NULL) {}
+_parent(NULL), _scene(NULL), _storageIndex(0), _spatialProxy(-1), _type(type), _name(name), _visible(true), _boundingBoxRenderable(NULL) {}
 
 SceneNode::~SceneNode() {
     clear_list(_renderables);
@@ -33,6 +34,7 @@ SceneNode::~SceneNode() {
 
 void SceneNode::setVisibility(bool state) {
     _visible = state;
+    if (_scene) { _scene->nodeVisibilityChanged(this); }
 }
 
 void SceneNode::addRenderable(Renderable *renderable) {
@@ -58,7 +60,7 @@ void SceneNode::clearRenderables() {
     clear_list(_renderables);
 }
 
-void SceneNode::addVisibleObjectsToList(const Frustum &bounds, std::list<SceneNode*> &visible) {
+void SceneNode::addVisibleObjectsToList(const Frustum &bounds, SceneNodeList &visible) {
     SceneNodeMap::iterator itr = _children.begin();
     for (; itr != _children.end(); itr++) {
         // Only render an entity if some part of it is contained by the frustum.
@@ -69,7 +71,17 @@ void SceneNode::addVisibleObjectsToList(const Frustum &bounds, std::list<SceneNo
     }
 }
 
-void SceneNode::addAllObjectsToList(std::list<SceneNode*> &objects) {
+void SceneNode::addVisibleObjectsToList(SceneNodeList &visible) {
+    SceneNodeMap::iterator itr = _children.begin();
+    for (; itr != _children.end(); itr++) {
+        if (itr->second->_visible) {
+            visible.push_back(itr->second);
+            itr->second->addVisibleObjectsToList(visible);
+        }
+    }
+}
+
+void SceneNode::addAllObjectsToList(SceneNodeList &objects) {
     SceneNodeMap::iterator itr = _children.begin();
     for (; itr != _children.end(); itr++) {
         objects.push_back(itr->second);
@@ -100,6 +112,8 @@ void SceneNode::attach(SceneNode *obj) {
     // Drop it in the _children map and set its new parent.
     _children[obj->getName()] = obj;
     obj->_parent = this;
+    obj->setScene(_scene);
+    if (_scene) { _scene->nodeAttached(this, obj); }
 
     obj->setDirty();
 }
@@ -107,6 +121,9 @@ void SceneNode::attach(SceneNode *obj) {
 void SceneNode::dettach(SceneNode *obj) {
     _children.erase(obj->getName());
     obj->_parent = NULL;
+    if (_scene) { _scene->nodeDettached(this, obj); }
+    obj->setScene(NULL);
+
     obj->setDirty();
     setDirty();
 }
@@ -115,6 +132,8 @@ void SceneNode::dettachAllChildren() {
     SceneNodeMap::iterator itr = _children.begin();
     for (; itr != _children.end(); itr++) {
         itr->second->_parent = NULL;
+        if (_scene) { _scene->nodeDettached(this, itr->second); }
+        itr->second->setScene(NULL);
         itr->second->setDirty();
     }
 
@@ -123,6 +142,14 @@ void SceneNode::dettachAllChildren() {
     setDirty();
 }
 
+void SceneNode::setScene(SceneManager *scene) {
+    _scene = scene;
+    SceneNodeMap::iterator itr = _children.begin();
+    for (; itr != _children.end(); itr++) {
+        itr->second->setScene(scene);
+    }
+}
+
 void SceneNode::updateDerivedValues() {
     if (!isDirty()) { return; }
     if (getParent()) {
@@ -134,7 +161,11 @@ void SceneNode::updateDerivedValues() {
     }
 
     bool updated = updateImplementationValues();
-    if(updated) { updateBoundingBoxRenderable(); }
+    if(updated) {
+        updateBoundingBoxRenderable();
+        if (_scene) { _scene->nodeBoundsChanged(this); }
+    }
+
     setDirty(false);
 } // updateDerivedValues
 
@@ -168,6 +199,7 @@ bool SceneNode::updateImplementationValues() {
 
     updateTransformationMatrices();
     updateRenderableViewMatrices();
+    transformationUpdatedNotice();
 
     return (oldAABB != _derivedBoundingBox);
 }
@@ -197,6 +229,12 @@ const AABB3 & SceneNode::getDerivedAABB() const {
 
 void SceneNode::setDirty(bool value) {
     _dirty = value;
+
+    // Let the flat storage know this node needs to be looked at in the next update.
+    if (_dirty && _scene) {
+        _scene->nodeDirtied(this);
+    }
+
     // Only cascade dirty calls upwards.
     if (_dirty && getParent()) {
         getParent()->setDirty();
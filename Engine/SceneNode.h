@@ -17,16 +17,18 @@
 #include <Render/Renderable.h>
 
 class SceneNode;
-typedef std::list<SceneNode*> SceneNodeList;
+typedef std::vector<SceneNode*> SceneNodeList;
 typedef std::map<std::string, SceneNode*> SceneNodeMap;
 
 class SceneManager;
+class SceneStorage;
 class Frustum;
 
 class SceneNode {
 public:
     static const std::string TypeName;
     friend class SceneManager;
+    friend class SceneStorage;
 
 public:
     SceneNode(const std::string &name);
@@ -35,6 +37,11 @@ public:
     virtual void preRenderNotice() {}
 
     void addVisibleObjectsToList(const Frustum &bounds, SceneNodeList &visible);
+
+    /*! Adds every visible object below this one to the given list without checking
+     *  bounds. Used when this object is known to be entirely inside of the frustum. */
+    void addVisibleObjectsToList(SceneNodeList &visible);
+
     void addAllObjectsToList(SceneNodeList &objects);
 
     /*! Adds any renderables associated with the scene node to the given RenderableList. */
@@ -131,6 +138,19 @@ protected:
     /*! Checks the dirty bit for this object. */
     bool isDirty() const;
 
+    /*! Called whenever the derived transformation of this object changes. Subclasses
+     *  that maintain values based on the derived transformation (like a Camera's view
+     *  matrix) should override this. */
+    virtual void transformationUpdatedNotice() {}
+
+    /*! Gets the bounds of any geometry owned directly by this object, in its local
+     *  space. Returns false if there is none. These bounds are included in the object's
+     *  derived AABB. */
+    virtual bool getLocalAABB(AABB3 &aabb) const { return false; }
+
+    /*! Sets the SceneManager this object and all of its children belong to. */
+    void setScene(SceneManager *scene);
+
     void updateRenderableViewMatrices();
     void updateTransformationMatrices();
     void updateBoundingBoxRenderable();
@@ -154,6 +174,10 @@ protected:
     SceneNodeMap _children; //!< This object's children.
     SceneNode *_parent;     //!< This object's parent.
 
+    SceneManager *_scene;        //!< The scene this object belongs to, if any.
+    unsigned int _storageIndex;  //!< This object's index in the scene's flat storage.
+    int _spatialProxy;           //!< This object's proxy in the scene's spatial index, or -1.
+
     std::string _type; //!< The object's type name.
     std::string _name; //!< The object's name.
 
@@ -0,0 +1,280 @@
+/*
+ *  SceneStorage.cpp
+ *  Mountainhome
+ *
+ *  Created by loch on 4/2/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include <Base/Assertion.h>
+#include <Base/Frustum.h>
+#include <algorithm>
+
+#include "SceneStorage.h"
+#include "SceneManager.h"
+
+SceneStorage::SceneStorage(SceneNode *root): _root(root), _needsRebuild(true),
+_dirtyCount(0), _transformCount(0), _boundsCount(0) {
+    ASSERT(_root);
+}
+
+SceneStorage::~SceneStorage() {}
+
+void SceneStorage::invalidate() {
+    _needsRebuild = true;
+}
+
+unsigned int SceneStorage::getNodeCount() const { return _nodes.size(); }
+unsigned int SceneStorage::getDirtyCount() const { return _dirtyCount; }
+unsigned int SceneStorage::getTransformUpdateCount() const { return _transformCount; }
+unsigned int SceneStorage::getBoundsUpdateCount() const { return _boundsCount; }
+
+void SceneStorage::setVisibility(SceneNode *node, bool visible) {
+    unsigned int index = node->_storageIndex;
+    if (index < _nodes.size() && _nodes[index] == node) {
+        _visible[index] = visible;
+    }
+}
+
+void SceneStorage::enqueue(SceneNode *node) {
+    unsigned int index = node->_storageIndex;
+    if (index < _nodes.size() && _nodes[index] == node && !(_flags[index] & Queued)) {
+        _flags[index] |= Queued;
+        _dirtyList.push_back(index);
+    }
+}
+
+void SceneStorage::queueAABB(unsigned int index) {
+    if (!(_flags[index] & AABBQueued)) {
+        _flags[index] |= AABBQueued;
+        _aabbHeap.push_back(index);
+        std::push_heap(_aabbHeap.begin(), _aabbHeap.end());
+    }
+}
+
+void SceneStorage::rebuild() {
+    _nodes.clear();
+    _parents.clear();
+    _subtreeEnds.clear();
+    _flags.clear();
+    _visible.clear();
+    _positions.clear();
+    _orientations.clear();
+    _transforms.clear();
+    _derivedPositions.clear();
+    _derivedOrientations.clear();
+    _derivedTransforms.clear();
+    _localAABBs.clear();
+    _hasLocalAABB.clear();
+    _derivedAABBs.clear();
+    _cullBoxes.clear();
+    _dirtyList.clear();
+    _aabbHeap.clear();
+
+    addSubtree(_root, -1);
+    _cullResults.resize(_nodes.size());
+    _planeCache.assign(_nodes.size(), 0);
+
+    for (unsigned int i = 0; i < _nodes.size(); i++) {
+        pullLocalValues(i);
+    }
+
+    // Everything needs to be recalculated after a rebuild, which is exactly what happens
+    // when the root is dirtied.
+    _flags[0] = Queued | DerivedChanged;
+    _dirtyList.push_back(0);
+
+    _needsRebuild = false;
+}
+
+void SceneStorage::addSubtree(SceneNode *node, int parent) {
+    unsigned int index = _nodes.size();
+    node->_storageIndex = index;
+
+    _nodes.push_back(node);
+    _parents.push_back(parent);
+    _subtreeEnds.push_back(index + 1);
+    _flags.push_back(0);
+    _visible.push_back(node->_visible);
+
+    _positions.push_back(node->_position);
+    _orientations.push_back(node->_orientation);
+    _transforms.push_back(Matrix::Affine(node->_orientation, node->_position));
+
+    _derivedPositions.push_back(node->_derivedPosition);
+    _derivedOrientations.push_back(node->_derivedOrientation);
+    _derivedTransforms.push_back(node->_derivedTransform);
+
+    _localAABBs.push_back(AABB3());
+    _hasLocalAABB.push_back(false);
+    _derivedAABBs.push_back(node->_derivedBoundingBox);
+    _cullBoxes.add(node->_derivedBoundingBox);
+
+    // Iterate over the map so the ordering matches the tree walk exactly.
+    SceneNodeMap::iterator itr = node->_children.begin();
+    for (; itr != node->_children.end(); itr++) {
+        addSubtree(itr->second, index);
+    }
+
+    _subtreeEnds[index] = _nodes.size();
+}
+
+bool SceneStorage::pullLocalValues(unsigned int index) {
+    SceneNode *node = _nodes[index];
+    _hasLocalAABB[index] = node->getLocalAABB(_localAABBs[index]);
+
+    if (node->_position == _positions[index] && node->_orientation == _orientations[index]) {
+        return false;
+    }
+
+    _positions[index] = node->_position;
+    _orientations[index] = node->_orientation;
+    _transforms[index] = Matrix::Affine(_orientations[index], _positions[index]);
+    return true;
+}
+
+void SceneStorage::update() {
+    if (_needsRebuild) { rebuild(); }
+
+    _dirtyCount = _dirtyList.size();
+    _transformCount = 0;
+    _boundsCount = 0;
+
+    if (_dirtyList.empty()) { return; }
+
+    // Sorting the dirty list puts parents before their children.
+    std::sort(_dirtyList.begin(), _dirtyList.end());
+
+    std::vector<unsigned int>::iterator itr;
+    for (itr = _dirtyList.begin(); itr != _dirtyList.end(); itr++) {
+        if (pullLocalValues(*itr)) { _flags[*itr] |= LocalChanged | DerivedChanged; }
+        queueAABB(*itr);
+    }
+
+    // A change to a node's derived transform changes the derived transform of everything
+    // below it, so recalculate whole subtrees. Once a subtree has been handled, any dirty
+    // nodes inside of it can be skipped.
+    unsigned int handledEnd = 0;
+    for (itr = _dirtyList.begin(); itr != _dirtyList.end(); itr++) {
+        unsigned int index = *itr;
+        if (index < handledEnd || !(_flags[index] & DerivedChanged)) { continue; }
+
+        for (unsigned int i = index; i < _subtreeEnds[index]; i++) {
+            int parent = _parents[i];
+            if (parent >= 0) {
+                _derivedOrientations[i] = _derivedOrientations[parent] * _orientations[i];
+                _derivedPositions[i] = _derivedPositions[parent] + _positions[i];
+            } else {
+                _derivedOrientations[i] = _orientations[i];
+                _derivedPositions[i] = _positions[i];
+            }
+
+            _derivedTransforms[i] = Matrix::Affine(_derivedOrientations[i], _derivedPositions[i]);
+            _flags[i] |= DerivedChanged;
+            queueAABB(i);
+            _transformCount++;
+        }
+
+        handledEnd = _subtreeEnds[index];
+    }
+
+    // Rebuild AABBs from the highest index down, so children are always finished before
+    // their parents. Parents are only added if one of their children actually changed.
+    while (!_aabbHeap.empty()) {
+        std::pop_heap(_aabbHeap.begin(), _aabbHeap.end());
+        unsigned int index = _aabbHeap.back();
+        _aabbHeap.pop_back();
+
+        bool aabbChanged = rebuildAABB(index);
+        _boundsCount++;
+
+        if (aabbChanged && _parents[index] >= 0) {
+            queueAABB(_parents[index]);
+        }
+
+        if (aabbChanged || (_flags[index] & DerivedChanged)) {
+            pushDerivedValues(index, aabbChanged);
+        }
+
+        _nodes[index]->setDirty(false);
+        _flags[index] = 0;
+    }
+
+    _dirtyList.clear();
+}
+
+bool SceneStorage::rebuildAABB(unsigned int index) {
+    AABB3 oldAABB = _derivedAABBs[index];
+    AABB3 &aabb = _derivedAABBs[index];
+
+    unsigned int child = index + 1;
+    if (child == _subtreeEnds[index]) {
+        aabb.setCenter(_derivedPositions[index]);
+        aabb.setRadius(Vector3(0, 0, 0));
+    } else {
+        aabb = _derivedAABBs[child];
+        for (child = _subtreeEnds[child]; child < _subtreeEnds[index]; child = _subtreeEnds[child]) {
+            aabb.encompass(_derivedAABBs[child]);
+        }
+    }
+
+    if (_hasLocalAABB[index]) {
+        AABB3 local;
+        Matrix::TransformBounds(_derivedTransforms[index], &_localAABBs[index], &local, 1);
+        aabb.encompass(local);
+    }
+
+    if (oldAABB == aabb) { return false; }
+
+    _cullBoxes.set(index, aabb);
+    return true;
+}
+
+void SceneStorage::pushDerivedValues(unsigned int index, bool aabbChanged) {
+    SceneNode *node = _nodes[index];
+    node->_derivedPosition = _derivedPositions[index];
+    node->_derivedOrientation = _derivedOrientations[index];
+    node->_derivedTransform = _derivedTransforms[index];
+    node->_transform = _transforms[index];
+    node->_derivedBoundingBox = _derivedAABBs[index];
+
+    node->updateRenderableViewMatrices();
+    node->transformationUpdatedNotice();
+    if (aabbChanged) {
+        node->updateBoundingBoxRenderable();
+        if (node->_scene) { node->_scene->nodeBoundsChanged(node); }
+    }
+}
+
+void SceneStorage::addVisibleObjectsToList(const Frustum &bounds, SceneNodeList &visible) {
+    addVisibleObjectsToList(_root, &bounds, visible);
+}
+
+void SceneStorage::addVisibleObjectsToList(SceneNode *node, const Frustum *bounds, SceneNodeList &visible) {
+    unsigned int index = node->_storageIndex;
+    ASSERT(index < _nodes.size() && _nodes[index] == node);
+
+    // Skip the node itself, just like SceneNode::addVisibleObjectsToList does. A node that
+    // fails the test takes its entire subtree with it.
+    unsigned int end = _subtreeEnds[index];
+    if (bounds) {
+        bounds->checkAABBs(_cullBoxes, index + 1, end - index - 1,
+            &_cullResults[index + 1], &_planeCache[index + 1]);
+    }
+
+    for (unsigned int i = index + 1; i < end;) {
+        if (_visible[i] && (!bounds || _cullResults[i] != Frustum::COMPLETE_OUT)) {
+            visible.push_back(_nodes[i]);
+            i++;
+        } else {
+            i = _subtreeEnds[i];
+        }
+    }
+}
+
+void SceneStorage::addAllObjectsToList(SceneNodeList &objects) {
+    for (unsigned int i = 1; i < _nodes.size(); i++) {
+        objects.push_back(_nodes[i]);
+    }
+}
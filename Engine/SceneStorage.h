@@ -0,0 +1,153 @@
+/*
+ *  SceneStorage.h
+ *  Mountainhome
+ *
+ *  Created by loch on 4/2/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _SCENESTORAGE_H_
+#define _SCENESTORAGE_H_
+#include <Base/Quaternion.h>
+#include <Base/Vector.h>
+#include <Base/Matrix.h>
+#include <Base/AABB.h>
+#include <Base/AABBArray.h>
+
+#include "SceneNode.h"
+
+class Frustum;
+
+/*! SceneStorage is a flattened copy of a SceneNode hierarchy. Rather than walking the
+ *  tree of SceneNodes (each of which keeps its children in a string keyed map), every
+ *  node in the scene is given an index in a set of parallel arrays, laid out in depth
+ *  first order. Local transforms, derived transforms, bounding boxes and visibility are
+ *  each kept in their own array, and the hierarchy is described by parent indices and
+ *  the index one past the end of each node's subtree.
+ *
+ *  Because parents always come before their children, derived transforms can be built
+ *  by sweeping forward, and bounding boxes can be built by sweeping backward. Culling
+ *  is also a forward sweep, where rejecting a node simply jumps to the end of its
+ *  subtree.
+ *
+ *  The SceneNodes are still the authoritative copy of the scene. SceneStorage pulls local
+ *  values out of nodes that have been dirtied and pushes derived values back into any
+ *  nodes that have changed, so everything else (Renderables, Cameras) sees the same
+ *  results it would with a standard tree walk. The arrays are rebuilt from the tree
+ *  whenever the structure of the scene changes.
+ *
+ *  Updates are incremental. Dirtying a node adds it to a dirty list, and an update only
+ *  visits the subtrees of nodes on that list (in parent before child order) followed by
+ *  the ancestors whose AABBs actually changed. Nodes that haven't moved aren't touched.
+ * \brief A flat, cache friendly representation of a scene graph.
+ * \seealso SceneManager::setFlatStorage */
+class SceneStorage {
+public:
+    SceneStorage(SceneNode *root);
+    virtual ~SceneStorage();
+
+    /*! Marks the storage as needing to be rebuilt from the SceneNode tree. This is called
+     *  any time a node is attached or detached. */
+    void invalidate();
+
+    /*! Updates the visibility bit of the given node. Nodes that are not currently in the
+     *  storage are ignored. */
+    void setVisibility(SceneNode *node, bool visible);
+
+    /*! Adds the given node to the dirty list, so its values will be recalculated on the
+     *  next update. Nodes that are not currently in the storage are ignored. */
+    void enqueue(SceneNode *node);
+
+    /*! Updates the derived values of every dirty node in the scene, rebuilding the arrays
+     *  first if the structure of the scene has changed. */
+    void update();
+
+    /*! Finds all visible objects in the scene, based on the given Frustum, and adds them
+     *  to the given list. The order matches SceneNode::addVisibleObjectsToList. */
+    void addVisibleObjectsToList(const Frustum &bounds, SceneNodeList &visible);
+
+    /*! Finds all visible objects below the given node and adds them to the given list.
+     *  If no Frustum is given, every visible object is added without checking bounds.
+     *  Otherwise, the whole subtree is checked in a single batch before it is swept. */
+    void addVisibleObjectsToList(SceneNode *node, const Frustum *bounds, SceneNodeList &visible);
+
+    /*! Adds every node in the scene (except the root) to the given list. */
+    void addAllObjectsToList(SceneNodeList &objects);
+
+    /*! Returns the number of nodes in the storage, including the root. */
+    unsigned int getNodeCount() const;
+
+    /*! Gets the number of nodes that were on the dirty list during the last update. */
+    unsigned int getDirtyCount() const;
+
+    /*! Gets the number of derived transforms recalculated during the last update. */
+    unsigned int getTransformUpdateCount() const;
+
+    /*! Gets the number of AABBs rebuilt during the last update. */
+    unsigned int getBoundsUpdateCount() const;
+
+protected:
+    enum Flags {
+        LocalChanged   = 1 << 0, //!< The local transform was changed since the last update.
+        DerivedChanged = 1 << 1, //!< The derived transform needs to be pushed to the node.
+        Queued         = 1 << 2, //!< The node is on the dirty list.
+        AABBQueued     = 1 << 3  //!< The node is waiting on an AABB rebuild.
+    };
+
+    /*! Throws away the current arrays and rebuilds them from the tree. */
+    void rebuild();
+
+    /*! Adds the given index to the AABB rebuild heap if it isn't already there. */
+    void queueAABB(unsigned int index);
+
+    /*! Recursively adds the given node and all of its children to the arrays. */
+    void addSubtree(SceneNode *node, int parent);
+
+    /*! Pulls the local values out of the node at the given index. Returns true if the
+     *  local transform actually changed. */
+    bool pullLocalValues(unsigned int index);
+
+    /*! Pushes the derived values at the given index back into the node. */
+    void pushDerivedValues(unsigned int index, bool aabbChanged);
+
+    /*! Rebuilds the AABB of the node at the given index from its children. Returns true
+     *  if the AABB changed. */
+    bool rebuildAABB(unsigned int index);
+
+protected:
+    SceneNode *_root;
+    bool _needsRebuild;
+
+    std::vector<unsigned int> _dirtyList;     //!< Indices of nodes dirtied since the last update.
+    std::vector<unsigned int> _aabbHeap;      //!< Max heap of indices waiting on AABB rebuilds.
+
+    unsigned int _dirtyCount;                 //!< Nodes on the dirty list in the last update.
+    unsigned int _transformCount;             //!< Transforms recalculated in the last update.
+    unsigned int _boundsCount;                //!< AABBs rebuilt in the last update.
+
+    std::vector<SceneNode*> _nodes;           //!< The node each index represents.
+    std::vector<int> _parents;                //!< The parent index of each node (-1 for root).
+    std::vector<unsigned int> _subtreeEnds;   //!< One past the last index in each subtree.
+    std::vector<unsigned char> _flags;        //!< Per node update flags.
+    std::vector<unsigned char> _visible;      //!< Per node visibility bits.
+
+    std::vector<Vector3> _positions;          //!< Local positions.
+    std::vector<Quaternion> _orientations;    //!< Local orientations.
+    std::vector<Matrix> _transforms;          //!< Local transformation matrices.
+
+    std::vector<Vector3> _derivedPositions;       //!< Derived positions.
+    std::vector<Quaternion> _derivedOrientations; //!< Derived orientations.
+    std::vector<Matrix> _derivedTransforms;       //!< Derived transformation matrices.
+
+    std::vector<AABB3> _localAABBs;           //!< Bounds of any geometry owned by the node.
+    std::vector<unsigned char> _hasLocalAABB; //!< Whether or not each node has local bounds.
+    std::vector<AABB3> _derivedAABBs;         //!< Derived bounding boxes.
+
+    AABBArray _cullBoxes;                     //!< Derived bounding boxes, laid out for batch culling.
+    std::vector<unsigned char> _cullResults;  //!< Per node results of the last batch cull.
+    std::vector<unsigned char> _planeCache;   //!< Per node frustum plane that last culled it.
+
+};
+
+#endif
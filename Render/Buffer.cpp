@@ -8,10 +8,62 @@
  */
 
 #include "Buffer.h"
+#include "RenderState.h"
 
 #include <Base/Assertion.h>
 #include <Base/Math3D.h>
 
+#pragma mark Buffer helpers
+
+// Ring allocations start on this boundary, which satisfies any attribute or index type.
+static const unsigned int StreamAlignment = 64;
+
+/*! The optional GL features buffers take advantage of. Checked once, the first time a
+ *  buffer needs to know, since there is always a context by then. */
+struct BufferFeatures {
+    bool copy;          //!< GL_ARB_copy_buffer
+    bool mapRange;      //!< GL_ARB_map_buffer_range
+    bool sync;          //!< GL_ARB_sync
+    bool storage;       //!< GL_ARB_buffer_storage
+};
+
+static const BufferFeatures &GetBufferFeatures() {
+    static BufferFeatures features;
+    static bool initialized = false;
+    if (!initialized) {
+        memset(&features, 0, sizeof(features));
+#ifdef GL_ARB_copy_buffer
+        features.copy = IsExtensionSupported("GL_ARB_copy_buffer");
+#endif
+#ifdef GL_ARB_map_buffer_range
+        features.mapRange = IsExtensionSupported("GL_ARB_map_buffer_range");
+#endif
+#ifdef GL_ARB_sync
+        features.sync = IsExtensionSupported("GL_ARB_sync");
+#endif
+#ifdef GL_ARB_buffer_storage
+        features.storage = IsExtensionSupported("GL_ARB_buffer_storage");
+#endif
+        initialized = true;
+    }
+
+    return features;
+}
+
+/*! Returns true if the ring can be fenced, which is what streaming needs to be useful. */
+static bool CanStream() {
+    const BufferFeatures &features = GetBufferFeatures();
+    return features.sync && (features.mapRange || features.storage);
+}
+
+/*! STREAM and DYNAMIC buffers get rewritten often enough to be worth orphaning. */
+static bool ShouldOrphan(GLenum accessType) {
+    return accessType != GL_STATIC_DRAW && accessType != GL_STATIC_READ &&
+           accessType != GL_STATIC_COPY;
+}
+
+#pragma mark Buffer definitions
+
 Buffer::Buffer(
     GLenum bufferType,
     GLenum accessType,
@@ -28,7 +80,11 @@ Buffer::Buffer(
     _elementCapacity(0),
     _bytesPerComponent(0),
     _handle(0),
-    _byteCount(0)
+    _byteCount(0),
+    _byteOffset(0),
+    _streaming(false),
+    _ringHead(0),
+    _persistentData(NULL)
 {
     calculateComponentSize();
     allocate(_elementCount, data);
@@ -48,20 +104,22 @@ Buffer::Buffer(
     _elementCapacity(0),
     _bytesPerComponent(0),
     _handle(0),
-    _byteCount(0)
+    _byteCount(0),
+    _byteOffset(0),
+    _streaming(false),
+    _ringHead(0),
+    _persistentData(NULL)
 {
     calculateComponentSize();
 }
 
 Buffer::~Buffer() {
-    if (_handle) {
-        glDeleteBuffers(1, &_handle);
-    }
+    release();
 }
 
 void *Buffer::mapBufferData(GLenum accessType) {
     if (_handle) {
-        glBindBuffer(_bufferType, _handle);
+        RenderState::Get()->bindBuffer(_bufferType, _handle);
         return glMapBuffer(_bufferType, accessType);
     }
 
@@ -73,7 +131,7 @@ bool Buffer::unmapBufferData() {
 
     if (_handle) {
         retVal = glUnmapBuffer(_bufferType);
-        glBindBuffer(_bufferType, 0);
+        RenderState::Get()->bindBuffer(_bufferType, 0);
     }
 
     return retVal;
@@ -87,46 +145,190 @@ void Buffer::setData(void *data, int elementCount) {
 
     ASSERT(_handle);
 
-    glBindBuffer(_bufferType, _handle);
-    glBufferSubData(_bufferType, 0, _byteCount, data);
-    glBindBuffer(_bufferType, 0);
+    // Only copy the elements in use. The allocation may be larger than the given data.
+    unsigned int bytes = _bytesPerComponent * _componentsPerElement * _elementCount;
+    if (_streaming && CanStream()) {
+        stream(data, bytes);
+        return;
+    }
+
+    RenderState::Get()->bindBuffer(_bufferType, _handle);
+    if (ShouldOrphan(_accessType) || _streaming) {
+        glBufferData(_bufferType, _byteCount, NULL, _accessType);
+    }
+
+    glBufferSubData(_bufferType, 0, bytes, data);
+    RenderState::Get()->bindBuffer(_bufferType, 0);
 }
 
 void Buffer::resize(int elementCount, bool saveData) {
+    // Grow geometrically, so a buffer that is grown a little at a time only reallocates
+    // a logarithmic number of times.
     if (elementCount > _elementCapacity) {
-        reserve(elementCount, saveData);
+        reserve(Math::Max(elementCount, _elementCapacity * 2), saveData);
     }
     _elementCount = elementCount;
 }
 
 void Buffer::reserve(int elementCapacity, bool saveData) {
-    if (!_handle) {
+    if (!_handle || !_elementCount) {
         saveData = false;
     }
 
-    unsigned char *data = NULL;
+    unsigned int copySize = _bytesPerComponent * _componentsPerElement *
+        Math::Min(_elementCount, elementCapacity);
+    unsigned int sourceOffset = _byteOffset;
+
+    if (saveData && GetBufferFeatures().copy) {
+#ifdef GL_ARB_copy_buffer
+        // Build the new buffer next to the old one and copy between them on the GPU. The
+        // old buffer is detached first so allocate creates a new one, and its fences go
+        // with it, since nothing pending reads from the new buffer.
+        GLuint old = _handle;
+        clearFences();
+        _handle = 0;
+        _persistentData = NULL;
+
+        allocate(elementCapacity, NULL);
+
+        glBindBuffer(GL_COPY_READ_BUFFER, old);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _handle);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, 0, copySize);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        // Deleting the old buffer is safe even if draws are pending. GL holds on to it
+        // until they're done, and unmaps it if needed.
+        glDeleteBuffers(1, &old);
+        RenderState::Get()->bufferDeleted(old);
+#endif
+    } else {
+        unsigned char *data = NULL;
+
+        if (saveData) {
+            // We need to create a heap allocation the size of the actual buffer allocation,
+            // but we only want to copy up to the size that is actually used.
+            unsigned int allocSize = _bytesPerComponent * _componentsPerElement * elementCapacity;
+            data = new unsigned char[allocSize];
+
+            RenderState::Get()->bindBuffer(_bufferType, _handle);
+            unsigned char *source = (unsigned char*)glMapBuffer(_bufferType, GL_READ_ONLY);
+            memcpy(data, source + sourceOffset, copySize);
+            ASSERT(glUnmapBuffer(_bufferType));
+            RenderState::Get()->bindBuffer(_bufferType, 0);
+        }
+
+        allocate(elementCapacity, data);
+        delete[] data;
+    }
 
+    // Whatever was kept now sits at the start of the buffer.
     if (saveData) {
-        // We need to create a heap allocation the size of the actual buffer allocation,
-        // but we only want to copy up to the size that is actually used.
-        unsigned int allocSize = _bytesPerComponent * _componentsPerElement * elementCapacity;
-        unsigned int copySize = _bytesPerComponent * _componentsPerElement * _elementCount;
-        data = new unsigned char[allocSize];
+        _ringHead = copySize;
+    }
+
+    CheckGLErrors();
+}
 
-        glBindBuffer(_bufferType, _handle);
-        memcpy(data, glMapBuffer(_bufferType, GL_READ_ONLY), Math::Min(allocSize, copySize));
-        ASSERT(glUnmapBuffer(_bufferType));
-        glBindBuffer(_bufferType, 0);
+void Buffer::orphan() {
+    if (!_handle) { return; }
+
+    // Streaming buffers need their fences dropped too, and may not be able to respecify
+    // their storage, so they just start over.
+    if (_streaming) {
+        allocate(_elementCapacity, NULL);
+        return;
     }
 
-    allocate(elementCapacity, data);
+    RenderState::Get()->bindBuffer(_bufferType, _handle);
+    glBufferData(_bufferType, _byteCount, NULL, _accessType);
+    RenderState::Get()->bindBuffer(_bufferType, 0);
+}
 
-    if (saveData) {
-        delete[] data;
-        data = NULL;
+void Buffer::setStreaming(unsigned int ringCapacity) {
+    _streaming = true;
+    _elementCount = 0;
+    release();
+    allocate(ringCapacity, NULL);
+}
+
+bool Buffer::isStreaming() const {
+    return _streaming;
+}
+
+unsigned int Buffer::getByteOffset() const {
+    return _byteOffset;
+}
+
+const GLvoid *Buffer::getOffsetPointer(unsigned int extra) const {
+    return (const char*)0 + _byteOffset + extra;
+}
+
+void Buffer::stream(const void *data, unsigned int bytes) {
+#if defined(GL_ARB_sync) && defined(GL_ARB_map_buffer_range)
+    // Everything drawn from the last write has been issued by now, so one fence covers it.
+    if (_ringHead > _byteOffset) {
+        StreamFence fence = { glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), _byteOffset, _ringHead };
+        _fences.push_back(fence);
     }
 
-    CheckGLErrors();
+    unsigned int start = (_ringHead + StreamAlignment - 1) / StreamAlignment * StreamAlignment;
+    if (start + bytes > _byteCount) {
+        start = 0;
+    }
+
+    // The oldest fences are the ones just ahead of the write, so only the front needs to
+    // be checked. Anything done is dropped. Anything still in flight means the ring is too
+    // small to cover the frames the GPU is behind by, so grow it rather than wait.
+    while (!_fences.empty() && _fences.front().start < start + bytes && start < _fences.front().end) {
+        GLsync sync = (GLsync)_fences.front().sync;
+        GLenum status = glClientWaitSync(sync, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            allocate(_elementCapacity * 2, NULL);
+            start = 0;
+            break;
+        }
+
+        glDeleteSync(sync);
+        _fences.pop_front();
+    }
+
+    if (_persistentData) {
+        memcpy(_persistentData + start, data, bytes);
+    } else {
+        RenderState::Get()->bindBuffer(_bufferType, _handle);
+        void *target = glMapBufferRange(_bufferType, start, bytes,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        memcpy(target, data, bytes);
+        glUnmapBuffer(_bufferType);
+        RenderState::Get()->bindBuffer(_bufferType, 0);
+    }
+
+    _byteOffset = start;
+    _ringHead = start + bytes;
+#endif
+}
+
+void Buffer::clearFences() {
+#ifdef GL_ARB_sync
+    for (int i = 0; i < _fences.size(); i++) {
+        glDeleteSync((GLsync)_fences[i].sync);
+    }
+#endif
+    _fences.clear();
+}
+
+void Buffer::release() {
+    clearFences();
+    _persistentData = NULL;
+    _byteOffset = 0;
+    _ringHead = 0;
+
+    if (_handle) {
+        glDeleteBuffers(1, &_handle);
+        RenderState::Get()->bufferDeleted(_handle);
+        _handle = 0;
+    }
 }
 
 void Buffer::allocate(int elementCapacity, void *data) {
@@ -138,13 +340,32 @@ void Buffer::allocate(int elementCapacity, void *data) {
 
     _byteCount = _bytesPerComponent * _componentsPerElement * _elementCapacity;
 
+    // Immutable storage can't be respecified, so persistent rings always start over with
+    // a new buffer. Old fences only describe the old storage.
+    if (_persistentData) {
+        release();
+    }
+
+    clearFences();
+    _byteOffset = 0;
+    _ringHead = 0;
+
     if (!_handle) {
         glGenBuffers(1, &_handle);
     }
 
-    glBindBuffer(_bufferType, _handle);
-    glBufferData(_bufferType, _byteCount, data, _accessType);
-    glBindBuffer(_bufferType, 0);
+    RenderState::Get()->bindBuffer(_bufferType, _handle);
+#ifdef GL_ARB_buffer_storage
+    if (_streaming && CanStream() && GetBufferFeatures().storage && _byteCount) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(_bufferType, _byteCount, data, flags);
+        _persistentData = (unsigned char*)glMapBufferRange(_bufferType, 0, _byteCount, flags);
+    } else
+#endif
+    {
+        glBufferData(_bufferType, _byteCount, data, _accessType);
+    }
+    RenderState::Get()->bindBuffer(_bufferType, 0);
 
     CheckGLErrors();
 }
@@ -199,3 +420,7 @@ unsigned int Buffer::getElementCount() {
 unsigned int Buffer::getElementCapacity() {
     return _elementCapacity;
 }
+
+unsigned int Buffer::getByteCount() const {
+    return _byteCount;
+}
@@ -10,10 +10,20 @@
 #ifndef _BUFFER_H_
 #define _BUFFER_H_
 #include "GL_Helper.h"
+#include <deque>
 
 /*! A generic graphics hardware buffer. This class is absolutely not meant to be used by
  *  itself. it JUST provides a place to put shared interface logic between the IndexBuffer
  *  class and the GenericAttributeBuffer class.
+ *
+ *  Buffers grow like std::vector: resize and setData at least double the capacity when
+ *  they run out of room, and any data being kept is copied on the GPU when
+ *  GL_ARB_copy_buffer is available, rather than being read back through a mapping.
+ *
+ *  Buffers that are rewritten often (any STREAM or DYNAMIC access type) are orphaned by
+ *  setData, so the driver can hand out fresh storage instead of waiting for the GPU to
+ *  finish with the old contents. Buffers rewritten many times a frame can go further and
+ *  turn on streaming, which is described in setStreaming.
  * \seealso GenericAttributeBuffer
  * \seealso IndexBuffer */
 class Buffer {
@@ -36,16 +46,47 @@ public:
 
     virtual ~Buffer();
 
+    /*! Replaces the contents of the buffer, optionally changing the number of elements.
+     *  Buffers that aren't STATIC are orphaned first, and streaming buffers write to the
+     *  next free part of their ring instead. */
     void setData(void *data, int elementCount = 0);
 
+    /*! Maps the whole buffer. Keep in mind that a streaming buffer's current data starts
+     *  at getByteOffset, not at the start of the mapping. */
     void *mapBufferData(GLenum accessType);
 
     bool unmapBufferData();
 
+    /*! Changes the number of elements in use, growing the capacity geometrically if it
+     *  is too small. */
     void resize(int elementCount, bool saveData);
 
+    /*! Reallocates the buffer to hold exactly the given number of elements. */
     void reserve(int elementCapacity, bool saveData);
 
+    /*! Detaches the buffer from its current storage, which GL frees once any pending
+     *  draws are done with it. The contents are lost. */
+    void orphan();
+
+    /*! Turns the buffer into a ring of the given number of elements, for data that is
+     *  rewritten many times a frame. Each setData writes to the next free part of the
+     *  ring and draws read from there, so writes never touch anything a pending draw
+     *  might still need. Every write fences the one before it, and if the ring wraps
+     *  around onto a region the GPU hasn't finished with, the ring moves to new storage
+     *  twice the size instead of waiting. The ring should hold a few frames worth of data.
+     *
+     *  With GL_ARB_buffer_storage the ring is mapped once and written directly. Otherwise
+     *  each write maps its part of the ring unsynchronized. Without GL_ARB_sync and
+     *  GL_ARB_map_buffer_range there is no way to fence the ring, so streaming buffers
+     *  fall back to orphaning on every write. The current contents are lost. */
+    void setStreaming(unsigned int ringCapacity);
+
+    bool isStreaming() const;
+
+    /*! Gets the offset of the current data within the buffer. This is always 0 unless
+     *  the buffer is streaming. */
+    unsigned int getByteOffset() const;
+
     GLenum getAccessType();
 
     GLenum getDataType();
@@ -54,6 +95,9 @@ public:
 
     unsigned int getElementCapacity();
 
+    /*! Gets the number of bytes allocated for the buffer. */
+    unsigned int getByteCount() const;
+
 protected:
     /*! Specifies the type of the buffer. */
     GLenum _bufferType;
@@ -83,10 +127,38 @@ protected:
     /*! The number of bytes in the buffer. */
     unsigned int _byteCount;
 
+    /*! Where the current data starts in the buffer. */
+    unsigned int _byteOffset;
+
+protected:
+    /*! Returns the current data's offset as the pointer GL expects for buffer offsets. */
+    const GLvoid *getOffsetPointer(unsigned int extra = 0) const;
+
 private:
+    /*! A region of the ring that pending draws may still read from. */
+    struct StreamFence {
+        void *sync;             //!< The GLsync, untyped so this header doesn't need ARB_sync.
+        unsigned int start;
+        unsigned int end;
+    };
+
     void allocate(int elementCapacity, void *data);
     void calculateComponentSize();
 
+    /*! Deletes the buffer and anything tied to it, leaving _handle 0. */
+    void release();
+
+    /*! Copies the given bytes to the next free part of the ring. */
+    void stream(const void *data, unsigned int bytes);
+
+    void clearFences();
+
+private:
+    bool _streaming;
+    unsigned int _ringHead;               //!< The end of the most recent write.
+    std::deque<StreamFence> _fences;      //!< Oldest first, in ring order.
+    unsigned char *_persistentData;       //!< The persistent mapping, if there is one.
+
 };
 
 // Provide a single include point for these files:
@@ -32,7 +32,13 @@ Font::Font(Material *mat):
     _lineSkip(0)
 {}
 
-Font::~Font() {}
+Font::~Font() {
+    _references.releaseAll();
+}
+
+void Font::holdReference(ResourceReleaser *manager, const std::string &name) {
+    _references.add(manager, name);
+}
 
 void Font::setDefaultColor(const Color4 &color) {
     _defaultColor = color;
@@ -10,6 +10,7 @@
 #ifndef _FONT_H_
 #define _FONT_H_
 #include <Base/Vector.h>
+#include <Base/ResourceReferences.h>
 #include "Renderable.h"
 
 /*! A special renderer containing addition data specific to dealing with fonts. */
@@ -73,6 +74,10 @@ public:
 
     FontRenderable * print(const Color4 &color, const char *format, ...);
 
+    /*! Keeps a reference the Font's loader acquired for it, like the one on its
+     *  Material, until the Font is deleted. */
+    void holdReference(ResourceReleaser *manager, const std::string &name);
+
 protected:
     template <typename Resource> friend class ResourceManager;
 
@@ -102,6 +107,8 @@ protected:
     int _fontAscent;
     int _lineSkip;
 
+    ResourceReferences _references; //!< Released when the Font is deleted.
+
 };
 
 #endif
@@ -10,6 +10,7 @@
 #include "Framebuffer.h"
 #include "TextureManager.h"
 #include "Texture.h"
+#include "RenderState.h"
 
 Framebuffer::Framebuffer(
     Texture *target,
@@ -31,7 +32,7 @@ Framebuffer::Framebuffer(
 
 Framebuffer::~Framebuffer() {
     glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    RenderState::Get()->bindTexture(GL_TEXTURE_2D, 0);
 
     glDeleteFramebuffersEXT(1, &_fb);
     glDeleteRenderbuffersEXT(1, &_depthRb);
@@ -88,7 +89,7 @@ bool Framebuffer::isColorBuffer() {
 }
 
 void Framebuffer::enable(){
-    glBindTexture(GL_TEXTURE_2D, 0);
+    RenderState::Get()->bindTexture(GL_TEXTURE_2D, 0);
     glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, _fb);
     if (isDepthBuffer()) {
         glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
@@ -9,6 +9,7 @@
 
 #include <Base/Assertion.h>
 #include "GenericAttributeBuffer.h"
+#include "RenderState.h"
 
 GenericAttributeBuffer::GenericAttributeBuffer(
     GLenum accessType,
@@ -25,7 +26,9 @@ GenericAttributeBuffer::GenericAttributeBuffer(
         elementCount,
         data
     ),
-    _activeChannel(-1)
+    _activeChannel(-1),
+    _activeColumns(1),
+    _instanced(false)
 {}
 
 void GenericAttributeBuffer::enable(int channel) {
@@ -35,17 +38,45 @@ void GenericAttributeBuffer::enable(int channel) {
 
     glEnableVertexAttribArray(_activeChannel);
 
-    glBindBuffer(_bufferType, _handle);
+    RenderState::Get()->bindBuffer(_bufferType, _handle);
 
-    glVertexAttribPointer(_activeChannel, _componentsPerElement, _dataType, GL_FALSE, 0, 0);
+    glVertexAttribPointer(_activeChannel, _componentsPerElement, _dataType, GL_FALSE, 0, getOffsetPointer());
+}
+
+void GenericAttributeBuffer::enableInstanced(int channel, int columns) {
+    ASSERT(_activeChannel == -1);
+
+    _activeChannel = channel;
+    _activeColumns = columns;
+    _instanced = true;
+
+    RenderState::Get()->bindBuffer(_bufferType, _handle);
+
+    int stride = _bytesPerComponent * _componentsPerElement * columns;
+    for (int i = 0; i < columns; i++) {
+        const GLvoid *offset = getOffsetPointer(_bytesPerComponent * _componentsPerElement * i);
+        glEnableVertexAttribArray(_activeChannel + i);
+        glVertexAttribPointer(_activeChannel + i, _componentsPerElement, _dataType, GL_FALSE, stride, offset);
+        glVertexAttribDivisorARB(_activeChannel + i, 1);
+    }
+
+    RenderState::Get()->bindBuffer(_bufferType, 0);
 }
 
 void GenericAttributeBuffer::disable() {
     ASSERT(_activeChannel != -1);
 
-    glDisableVertexAttribArray(_activeChannel);
+    for (int i = 0; i < _activeColumns; i++) {
+        if (_instanced) {
+            glVertexAttribDivisorARB(_activeChannel + i, 0);
+        }
+
+        glDisableVertexAttribArray(_activeChannel + i);
 
-    glVertexAttribPointer(_activeChannel, 4, GL_FLOAT, GL_FALSE, 0, 0);
+        glVertexAttribPointer(_activeChannel + i, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    }
 
     _activeChannel = -1;
+    _activeColumns = 1;
+    _instanced = false;
 }
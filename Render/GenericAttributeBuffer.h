@@ -57,10 +57,19 @@ public:
 
     void enable(int channel);
 
+    /*! Enables the buffer as a per instance attribute, advancing once per instance rather
+     *  than once per vertex. Each instance reads 'columns' consecutive elements, which are
+     *  bound to consecutive channels starting at the given one. This is how matrix
+     *  attributes are laid out (a mat4 is 4 columns of 4 floats).
+     * \note Requires GL_ARB_instanced_arrays. */
+    void enableInstanced(int channel, int columns);
+
     void disable();
 
 private:
     int _activeChannel;
+    int _activeColumns;
+    bool _instanced;
 
 };
 
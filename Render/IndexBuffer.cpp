@@ -8,6 +8,7 @@
  */
 
 #include "IndexBuffer.h"
+#include "RenderState.h"
 
 IndexBuffer::IndexBuffer(
     GLenum accessType,
@@ -37,15 +38,25 @@ IndexBuffer::IndexBuffer(
     )
 {}
 
-void IndexBuffer::render(PrimitiveType type) {
-    glBindBuffer(_bufferType, _handle);
+void IndexBuffer::render(PrimitiveType type, int instances) {
+    RenderState::Get()->bindBuffer(_bufferType, _handle);
 
-    glDrawElements(
-        TranslatePrimitiveType(type),
-        getElementCount(),
-        getDataType(),
-        0
-    );
+    if (instances > 1) {
+        glDrawElementsInstancedARB(
+            TranslatePrimitiveType(type),
+            getElementCount(),
+            getDataType(),
+            getOffsetPointer(),
+            instances
+        );
+    } else {
+        glDrawElements(
+            TranslatePrimitiveType(type),
+            getElementCount(),
+            getDataType(),
+            getOffsetPointer()
+        );
+    }
 
-    glBindBuffer(_bufferType, 0);
+    RenderState::Get()->bindBuffer(_bufferType, 0);
 }
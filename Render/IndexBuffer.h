@@ -60,7 +60,7 @@ public:
 
 private:
     friend class RenderOperation;
-    void render(PrimitiveType type);
+    void render(PrimitiveType type, int instances = 1);
 
 };
 
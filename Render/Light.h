@@ -43,6 +43,6 @@ private:
 	Vector4 _specular;
 };
 
-typedef std::list<Light*> LightList;
+typedef std::vector<Light*> LightList;
 
 #endif
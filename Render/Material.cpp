@@ -10,6 +10,7 @@
 #include <Base/FileSystem.h>
 #include "Material.h"
 #include "Shader.h"
+#include "RenderState.h"
 
 #if DEBUG
 // Ensures that pre/post render calls are not made inappropriately. This ensures
@@ -17,17 +18,31 @@
 static bool SafetyCheck_BetweenCalls = false;
 #endif
 
+unsigned int Material::NextSortID = 1;
+
 Material::Material():
     _name(""),
-    _shader(NULL)
+    _shader(NULL),
+    _sortID(NextSortID++),
+    _textureSortID(0),
+    _textureSortIDDirty(true)
 {}
 
 Material::Material(const std::string &name):
     _name(name),
-    _shader(NULL)
+    _shader(NULL),
+    _sortID(NextSortID++),
+    _textureSortID(0),
+    _textureSortIDDirty(true)
 {}
 
-Material::~Material() {}
+Material::~Material() {
+    _references.releaseAll();
+}
+
+void Material::holdReference(ResourceReleaser *manager, const std::string &name) {
+    _references.add(manager, name);
+}
 
 const std::string & Material::getName() {
     return _name;
@@ -37,7 +52,7 @@ void Material::setName(const std::string &name) {
     _name = name;
 }
 
-void Material::enable() {
+void Material::enable(bool enableShader) {
 #if DEBUG
     if (SafetyCheck_BetweenCalls) {
         THROW(InternalError, "Nested calls to Material::enable!!!");
@@ -47,16 +62,18 @@ void Material::enable() {
 #endif // DEBUG
 
     // This needs to happen before we push parameters to the shader.
-    if (_shader) {
-        _shader->enable();
-    } else {
-        glUseProgram(0);
+    if (enableShader) {
+        if (_shader) {
+            _shader->enable();
+        } else {
+            RenderState::Get()->useProgram(0);
+        }
     }
 
     pushParameters(_shader);
 }
 
-void Material::disable() {
+void Material::disable(bool disableShader) {
 #if DEBUG
     if (!SafetyCheck_BetweenCalls) {
         THROW(InternalError, "Out of order call to Material::disable!!!");
@@ -68,7 +85,7 @@ void Material::disable() {
     popParameters();
 
     // Make sure to disable the shader to cleanup certain parameter state!
-    if(_shader) {
+    if(_shader && disableShader) {
         _shader->disable();
     }
 }
@@ -80,3 +97,29 @@ void Material::setShader(Shader *shader) {
 Shader * Material::getShader() {
     return _shader;
 }
+
+unsigned int Material::getSortID() const {
+    return _sortID;
+}
+
+unsigned int Material::getTextureSortID() {
+    if (_textureSortIDDirty) {
+        _textureSortID = 0;
+        const ShaderParameterList &params = getShaderParameters();
+        ShaderParameterList::const_iterator itr;
+        for (itr = params.begin(); itr != params.end(); itr++) {
+            if (itr->second->getType() == TextureParam && itr->second->getData<Texture>()) {
+                _textureSortID = itr->second->getData<Texture>()->getID();
+                break;
+            }
+        }
+
+        _textureSortIDDirty = false;
+    }
+
+    return _textureSortID;
+}
+
+void Material::shaderParametersChanged() {
+    _textureSortIDDirty = true;
+}
@@ -11,6 +11,7 @@
 #define _MATERIAL_H_
 #include <Base/Math3D.h>
 #include <Base/Vector.h>
+#include <Base/ResourceReferences.h>
 #include <Render/Texture.h>
 
 #include "RenderParameterContainer.h"
@@ -63,9 +64,14 @@ public:
 
     virtual ~Material();
 
-    void enable();
+    /*! Enables the Material for rendering.
+     * \param enableShader If false, the Shader is assumed to already be enabled. This is
+     *  used to avoid program switches between Materials that share a Shader. */
+    void enable(bool enableShader = true);
 
-    void disable();
+    /*! Disables the Material.
+     * \param disableShader If false, the Shader is left enabled for the next Material. */
+    void disable(bool disableShader = true);
 
     void setShader(Shader *shader);
 
@@ -75,10 +81,34 @@ public:
 
     void setName(const std::string &name);
 
+    /*! Returns a small number unique to this Material, used when sorting.
+     * \seealso RenderQueue */
+    unsigned int getSortID() const;
+
+    /*! Returns a number identifying the first Texture this Material sets, or 0 if it has
+     *  no textures. Used to group Renderables by Texture when sorting.
+     * \seealso RenderQueue */
+    unsigned int getTextureSortID();
+
+    /*! Keeps a reference the Material's loader acquired for it, like one on a Texture
+     *  or Shader it uses, until the Material is deleted. */
+    void holdReference(ResourceReleaser *manager, const std::string &name);
+
+protected:
+    virtual void shaderParametersChanged();
+
 private:
+    static unsigned int NextSortID;
+
     std::string _name;
     Shader *_shader;
 
+    unsigned int _sortID;
+    unsigned int _textureSortID;
+    bool _textureSortIDDirty;
+
+    ResourceReferences _references; //!< Released when the Material is deleted.
+
 };
 
 #endif
@@ -9,6 +9,7 @@
  */
 
 #include <Base/Plane.h>
+#include <Base/Skeleton.h>
 
 #include "RenderOperation.h"
 #include "RenderContext.h"
@@ -73,6 +74,11 @@ Model::Model():
 Model::~Model() {
     clear_list(_meshes);
     clear_list(_bones);
+    _references.releaseAll();
+}
+
+void Model::holdReference(ResourceReleaser *manager, const std::string &name) {
+    _references.add(manager, name);
 }
 
 void Model::calculateBoundsFromMeshes() {
@@ -93,6 +99,19 @@ ModelMesh * Model::getMesh(int index) {
     return _meshes[index];
 }
 
+long long Model::getByteCount() const {
+    long long bytes = 0;
+    for (int i = 0; i < _meshes.size(); i++) {
+        bytes += _meshes[i]->getRenderOperation()->getByteCount();
+    }
+
+    return bytes;
+}
+
+long long Model::getSystemByteCount() const {
+    return sizeof(Model) + _meshes.size() * sizeof(ModelMesh) + _bones.size() * sizeof(ModelBone);
+}
+
 unsigned int Model::getMeshCount() {
     return _meshes.size();
 }
@@ -109,6 +128,46 @@ ModelBone * Model::getRootBone() {
     return _rootBone;
 }
 
+Skeleton * Model::createSkeleton(std::vector<int> *boneMap) {
+    bool ordered = true;
+    for (int i = 0; i < _bones.size() && ordered; i++) {
+        ModelBone *parent = _bones[i]->getParent();
+        ordered = !parent || parent->getBoneArrayIndex() < i;
+    }
+
+    std::vector<ModelBone *> order;
+    if (ordered) {
+        order = _bones;
+    } else {
+        std::vector<ModelBone *> stack;
+        for (int i = _bones.size() - 1; i >= 0; i--) {
+            if (!_bones[i]->getParent()) { stack.push_back(_bones[i]); }
+        }
+
+        while (stack.size() > 0) {
+            ModelBone *bone = stack.back();
+            stack.pop_back();
+            order.push_back(bone);
+            for (int i = bone->getChildCount() - 1; i >= 0; i--) {
+                stack.push_back(bone->getChild(i));
+            }
+        }
+    }
+
+    std::vector<int> indices(_bones.size(), -1);
+    Skeleton *skeleton = new Skeleton();
+    for (int i = 0; i < order.size(); i++) {
+        ModelBone *parent = order[i]->getParent();
+        indices[order[i]->getBoneArrayIndex()] = i;
+        skeleton->addBone(order[i]->getName(),
+            parent ? indices[parent->getBoneArrayIndex()] : -1,
+            order[i]->getTransform());
+    }
+
+    if (boneMap) { boneMap->swap(indices); }
+    return skeleton;
+}
+
 const std::string & Model::getName() {
     return _name;
 }
@@ -12,10 +12,12 @@
 #define _MODEL_H
 #include <Base/Vector.h>
 #include <Base/AABB.h>
+#include <Base/ResourceReferences.h>
 #include "ModelMesh.h"
 #include "ModelBone.h"
 
 class RenderContext;
+class Skeleton;
 
 class Model {
 public:
@@ -52,9 +54,25 @@ public:
     /*! Get the central bone of the model. */
     ModelBone * getRootBone();
 
+    /*! Builds a flattened copy of the model's bones for animation. Bones keep their
+     *  indices as long as every parent comes before its children, which is always true
+     *  for cached models. Otherwise they are reordered depth first, and if boneMap is
+     *  given, it is filled with the skeleton index of each of the model's bones. */
+    Skeleton * createSkeleton(std::vector<int> *boneMap = NULL);
+
     /*! Returns the name of the model. */
     const std::string & getName();
 
+    /*! Gets the number of bytes of video memory used by the model's geometry. */
+    long long getByteCount() const;
+
+    /*! Estimates the number of bytes of system memory used by the model. */
+    long long getSystemByteCount() const;
+
+    /*! Keeps a reference the Model's loader acquired for it, like one on a Texture its
+     *  materials use, until the Model is deleted. */
+    void holdReference(ResourceReleaser *manager, const std::string &name);
+
 protected:
     Model();
 
@@ -72,6 +90,8 @@ private:
 
     AABB3 _bounds;                    //!< Bounding box for the model in its local space.
 
+    ResourceReferences _references;   //!< Released when the model is deleted.
+
 };
 
 #endif
@@ -54,6 +54,10 @@ ModelBone * ModelBone::getChild(int index) {
     return _children[index];
 }
 
+void ModelBone::addChild(ModelBone *child) {
+    _children.push_back(child);
+}
+
 unsigned int ModelBone::getBoneArrayIndex() {
     return _index;
 }
@@ -28,6 +28,9 @@ public:
 
     ModelBone * getChild(int index);
 
+    /*! Adds a child to the bone. Only the parent's list of children is changed. */
+    void addChild(ModelBone *child);
+
     unsigned int getBoneArrayIndex();
 
 private:
@@ -51,6 +51,10 @@ Material * ModelMesh::getDefaultMaterial() {
     return _defaultMaterial;
 }
 
+void ModelMesh::setDefaultMaterial(Material *mat) {
+    _defaultMaterial = mat;
+}
+
 ModelBone * ModelMesh::getRootBone() {
     return _rootBone;
 }
@@ -27,6 +27,9 @@ public:
 
     Material * getDefaultMaterial();
 
+    /*! Changes the Material new Entities draw the mesh with. The mesh doesn't own it. */
+    void setDefaultMaterial(Material *mat);
+
     ModelBone * getRootBone();
 
     const AABB3 & getBoundingBox();
@@ -9,6 +9,7 @@
 
 #include <Base/Assertion.h>
 #include "NormalBuffer.h"
+#include "RenderState.h"
 
 NormalBuffer::NormalBuffer(
     GLenum accessType,
@@ -42,11 +43,11 @@ void NormalBuffer::enable() {
     ASSERT(_handle);
 
     glEnableClientState(GL_NORMAL_ARRAY);
-    glBindBuffer(_bufferType, _handle);
+    RenderState::Get()->bindBuffer(_bufferType, _handle);
 
-    glNormalPointer(_dataType, 0, 0);
+    glNormalPointer(_dataType, 0, getOffsetPointer());
 
-    glBindBuffer(_bufferType, 0);
+    RenderState::Get()->bindBuffer(_bufferType, 0);
 }
 
 void NormalBuffer::disable() {
@@ -9,6 +9,7 @@
 
 #include "PixelData.h"
 #include <Base/Logger.h>
+#include <Base/Math3D.h>
 #include <png.h>
 
 PixelData::PixelData():
@@ -54,6 +55,22 @@ unsigned int PixelData::getHeight()        const { return _height; }
 unsigned int PixelData::getDepth()         const { return _depth; }
 unsigned int PixelData::getBytesPerPixel() const { return _bytesPP; }
 
+bool PixelData::isCompressed() const {
+    return _layout == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ||
+           _layout == GL_COMPRESSED_RGBA_S3TC_DXT3_EXT ||
+           _layout == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+unsigned int PixelData::getByteCount() const {
+    if (isCompressed()) {
+        unsigned int blockSize = _layout == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ? 8 : 16;
+        return ((_width + 3) / 4) * ((Math::Max(_height, 1u) + 3) / 4) * Math::Max(_depth, 1u) *
+            blockSize;
+    }
+
+    return _width * Math::Max(_height, 1u) * Math::Max(_depth, 1u) * _bytesPP;
+}
+
 void PixelData::deleteOldPixelData() {
     if (_cleanup && _pixels) {
         switch(_type) {
@@ -73,6 +90,12 @@ void PixelData::deleteOldPixelData() {
 }
 
 void PixelData::calcBytesPerPixel() {
+    // Compressed data is sized by the block, in getByteCount.
+    if (isCompressed()) {
+        _bytesPP = 0;
+        return;
+    }
+
     int components;
     switch(_layout) {
     case GL_LUMINANCE:
@@ -53,9 +53,16 @@ public:
     GLenum getDataType() const;
 
     /*! Gets the number of bytes in a single pixel. This is a function of the DataType and
-     *  pixel layout. */
+     *  pixel layout. Block compressed layouts don't have a size per pixel, and return 0. */
     unsigned int getBytesPerPixel() const;
 
+    /*! Gets the total size of the image data in bytes, including compressed layouts, which
+     *  are stored in 4x4 blocks of 8 or 16 bytes. */
+    unsigned int getByteCount() const;
+
+    /*! Returns true if the layout is one of the S3TC block compressed formats. */
+    bool isCompressed() const;
+
     /*! Returns the width of the image data. */
     unsigned int getWidth() const;
 
@@ -9,6 +9,7 @@
 
 #include <Base/Assertion.h>
 #include "PositionBuffer.h"
+#include "RenderState.h"
 
 PositionBuffer::PositionBuffer(
     GLenum accessType,
@@ -44,11 +45,11 @@ void PositionBuffer::enable() {
     ASSERT(_handle);
 
     glEnableClientState(GL_VERTEX_ARRAY);
-    glBindBuffer(_bufferType, _handle);
+    RenderState::Get()->bindBuffer(_bufferType, _handle);
 
-    glVertexPointer(_componentsPerElement, _dataType, 0, 0);
+    glVertexPointer(_componentsPerElement, _dataType, 0, getOffsetPointer());
 
-    glBindBuffer(_bufferType, 0);
+    RenderState::Get()->bindBuffer(_bufferType, 0);
 }
 
 void PositionBuffer::disable() {
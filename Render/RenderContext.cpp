@@ -12,13 +12,26 @@
 #include "Viewport.h"
 #include "Texture.h"
 #include "Shader.h"
+#include "GenericAttributeBuffer.h"
+
+#include <Base/Profiler.h>
 
 RenderContext::RenderContext():
     _viewport(0, 0, 0, 0),
+    _instancingSupported(false),
+    _instancingEnabled(true),
+    _instanceBuffer(NULL),
     _renderableCount(0),
     _primitiveCount(0),
-    _vertexCount(0)
+    _vertexCount(0),
+    _drawCount(0),
+    _instancedDrawCount(0),
+    _instanceCount(0),
+    _materialChangeCount(0),
+    _shaderChangeCount(0)
 {
+    _state.makeCurrent();
+
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
     glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST);
@@ -29,7 +42,7 @@ RenderContext::RenderContext():
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // The default values are fucked. Set them to avoid issues in Get/SetpolygonMode.
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    _state.setWireframe(false);
 
     setCullMode(BACK);
     setTransparency(false);
@@ -63,9 +76,30 @@ RenderContext::RenderContext():
     }
     Info("Renderer: " << renderer);
 
+    _instancingSupported =
+        IsExtensionSupported("GL_ARB_draw_instanced") &&
+        IsExtensionSupported("GL_ARB_instanced_arrays");
+
+    if (!_instancingSupported) {
+        Info("Instanced rendering is not supported.");
+    }
+
 }
 
-RenderContext::~RenderContext() {}
+RenderContext::~RenderContext() {
+    delete _instanceBuffer;
+    _instanceBuffer = NULL;
+}
+
+void RenderContext::setInstancing(bool enabled) {
+    if(enabled) { Info("Setting instanced rendering ON");  }
+    else {        Info("Setting instanced rendering OFF"); }
+    _instancingEnabled = enabled;
+}
+
+bool RenderContext::getInstancing() const {
+    return _instancingEnabled;
+}
 
 void RenderContext::setViewport(const Viewport &viewport) {
     glViewport(viewport.xPos, viewport.yPos, viewport.width, viewport.height);
@@ -128,6 +162,8 @@ void RenderContext::render2D(int width, int height, RenderableList &list) {
 }
 
 void RenderContext::render(const Matrix &view, const Matrix &projection, RenderableList &list, LightList &lights) {
+    PROFILE("Render");
+
     // Assume the correct render target is enabled and has been cleared if it needs to be.
 
     // Set the projection and view matrices, to give our Shaders access to a
@@ -150,48 +186,70 @@ void RenderContext::render(const Matrix &view, const Matrix &projection, Rendera
     // Ignore any ShaderParameters people may have set. Who knows why they set them here?
     pushParameters(NULL);
 
-    // The Renderable operator< defines how sorting happens. Here, we assume it's based on
-    // Material. A system that can just intelligently track ALL current state and just not
-    // change things unless required would be ideal, but this works for now. Also, only
-    // sort if we're doing depth testing, otherwise order matters.
-    if (getDepthTest()) {
-        list.sort();
+    // Build sort keys for everything, then sort to minimize state changes. Only sort if
+    // we're doing depth testing, otherwise order matters.
+    _queue.clear();
+    RenderableList::iterator itr;
+    for (itr = list.begin(); itr != list.end(); itr++) {
+        _queue.add(*itr, view);
+    }
+
+    // Instancing reorders things, so it also only happens when sorting.
+    bool sorted = getDepthTest();
+    if (sorted) {
+        _queue.sort();
     }
 
     CheckGLErrors();
 
     bool newlyActive = false;
     Material *active = NULL;
-    RenderableList::iterator itr;
-    for (itr = list.begin(); itr != list.end(); itr++) {
+    for (unsigned int i = 0; i < _queue.size(); i++) {
+        Renderable *renderable = _queue[i];
+
         // Update the material, if we need to. Be sure to do this BEFORE calling
         // preRenderNotice on the Renderable, to avoid RenderParameterContainer push/pop
-        // issues.
-        if ((*itr)->getMaterial() != active) {
+        // issues. Since the queue is sorted by shader first, back to back materials will
+        // often share a shader, in which case the program is left bound.
+        if (renderable->getMaterial() != active) {
+            Material *next = renderable->getMaterial();
+            bool sameShader = active && next->getShader() && active->getShader() == next->getShader();
+
             if (active) {
-                active->disable();
+                active->disable(!sameShader);
             }
 
-            active = (*itr)->getMaterial();
-
-            active->enable();
+            active = next;
+            active->enable(!sameShader);
 
             newlyActive = true;
+            _materialChangeCount += 1;
+            if (!sameShader) { _shaderChangeCount += 1; }
+        }
+
+        // Draw everything sharing this Renderable's geometry and Material in one go, if
+        // possible. The queue places these right next to each other.
+        unsigned int end = sorted ? findInstanceRun(i) : i + 1;
+        if (end - i >= MinInstanceCount) {
+            renderInstances(view, i, end, newlyActive);
+            newlyActive = false;
+            i = end - 1;
+            continue;
         }
 
         // Call this right now, as preRenderNotice may result in changes to the
         // Renderable's internal RenderOperation.
-        (*itr)->preRenderNotice();
+        renderable->preRenderNotice();
 
         _renderableCount += 1;
 
         // Only do this work if there is a vertex array and we have vertices in that array.
-        if ((*itr)->getRenderOperation() &&
-            (*itr)->getRenderOperation()->getVertexArray() &&
-            (*itr)->getRenderOperation()->getVertexCount())
+        if (renderable->getRenderOperation() &&
+            renderable->getRenderOperation()->getVertexArray() &&
+            renderable->getRenderOperation()->getVertexCount())
         {
-            _primitiveCount += (*itr)->getRenderOperation()->getPrimitiveCount();
-            _vertexCount += (*itr)->getRenderOperation()->getVertexCount();
+            _primitiveCount += renderable->getRenderOperation()->getPrimitiveCount();
+            _vertexCount += renderable->getRenderOperation()->getVertexCount();
 
             // This relies on the RenderOperation, so it should be done *after* the
             // preRenderNotice, but it also should only be done when a new material is set,
@@ -200,18 +258,19 @@ void RenderContext::render(const Matrix &view, const Matrix &projection, Rendera
                 ///\todo I feel pretty strongly that this should be handled differently...
                 /// I'd like to do it once, and forget about it. This requires more research
                 /// into how XNA and others handle it.
-                (*itr)->getMaterial()->getShader()->bindAttributesToChannel(
-                    (*itr)->getRenderOperation()->getVertexArray()->getVertexArrayLayout());
+                renderable->getMaterial()->getShader()->bindAttributesToChannel(
+                    renderable->getRenderOperation()->getVertexArray()->getVertexArrayLayout());
                 newlyActive = false;
             }
 
             // Render the Renderable. Don't use its render method because it sets the Material.
-            setModelViewMatrix(view * (*itr)->getModelMatrix());
+            setModelViewMatrix(view * renderable->getModelMatrix());
 
-            (*itr)->getRenderOperation()->render();
+            renderable->getRenderOperation()->render();
+            _drawCount += 1;
         }
 
-        (*itr)->postRenderNotice();
+        renderable->postRenderNotice();
     }
 
     if (active) {
@@ -232,6 +291,72 @@ void RenderContext::render(const Matrix &view, const Matrix &projection, Rendera
     CheckGLErrors();
 }
 
+unsigned int RenderContext::findInstanceRun(unsigned int first) {
+    if (!_instancingEnabled || !_instancingSupported) { return first + 1; }
+
+    // Translucent things need to be drawn in strict back to front order.
+    if (RenderQueue::IsTranslucent(_queue.getKey(first))) { return first + 1; }
+
+    Renderable *renderable = _queue[first];
+    Material *material = renderable->getMaterial();
+    RenderOperation *op = renderable->getRenderOperation();
+    if (!material->getShader() || material->getShader()->getInstanceMatrixChannel() < 0 ||
+        !op || !op->getVertexArray() || !op->getVertexCount() || !renderable->canInstance())
+    {
+        return first + 1;
+    }
+
+    unsigned int end = first + 1;
+    while (end < _queue.size() &&
+           _queue[end]->getRenderOperation() == op &&
+           _queue[end]->getMaterial() == material &&
+           _queue[end]->canInstance())
+    {
+        end++;
+    }
+
+    return end;
+}
+
+void RenderContext::renderInstances(const Matrix &view, unsigned int first, unsigned int end, bool bindAttributes) {
+    Renderable *renderable = _queue[first];
+    RenderOperation *op = renderable->getRenderOperation();
+    Shader *shader = renderable->getMaterial()->getShader();
+    unsigned int count = end - first;
+
+    // Stream the model matrices out. Each one is four columns of four floats, which is
+    // exactly how a mat4 attribute is laid out.
+    _instanceMatrices.resize(count);
+    for (unsigned int i = 0; i < count; i++) {
+        _instanceMatrices[i] = _queue[first + i]->getModelMatrix();
+    }
+
+    if (!_instanceBuffer) {
+        _instanceBuffer = new GenericAttributeBuffer(GL_STREAM_DRAW, GL_FLOAT, 4, 0, NULL);
+        _instanceBuffer->setStreaming(InstanceRingSize * 4);
+    }
+
+    _instanceBuffer->setData(&_instanceMatrices[0], count * 4);
+
+    if (bindAttributes) {
+        shader->bindAttributesToChannel(op->getVertexArray()->getVertexArrayLayout());
+    }
+
+    // The shader applies each model matrix itself, so only the view goes in modelview.
+    setModelViewMatrix(view);
+
+    _instanceBuffer->enableInstanced(shader->getInstanceMatrixChannel(), 4);
+    op->render(count);
+    _instanceBuffer->disable();
+
+    _renderableCount += count;
+    _primitiveCount += count * op->getPrimitiveCount();
+    _vertexCount += count * op->getVertexCount();
+    _drawCount += 1;
+    _instancedDrawCount += 1;
+    _instanceCount += count;
+}
+
 void RenderContext::renderTexture(Texture *src) {
     // Get the scene ready.
     clear(Color4(1, 1, 1, 1));
@@ -268,11 +393,25 @@ void RenderContext::renderTexture(Texture *src) {
 int RenderContext::getRenderableCount() const { return _renderableCount; }
 int RenderContext::getPrimitiveCount() const { return _primitiveCount; }
 int RenderContext::getVertexCount() const { return _vertexCount; }
+int RenderContext::getDrawCount() const { return _drawCount; }
+int RenderContext::getInstancedDrawCount() const { return _instancedDrawCount; }
+int RenderContext::getInstanceCount() const { return _instanceCount; }
+int RenderContext::getMaterialChangeCount() const { return _materialChangeCount; }
+int RenderContext::getShaderChangeCount() const { return _shaderChangeCount; }
+int RenderContext::getStateChangeCount() const { return _state.getIssuedCount(); }
+int RenderContext::getElidedStateChangeCount() const { return _state.getElidedCount(); }
+RenderState *RenderContext::getRenderState() { return &_state; }
 
 void RenderContext::resetCounts() {
     _renderableCount = 0;
     _primitiveCount = 0;
     _vertexCount = 0;
+    _drawCount = 0;
+    _instancedDrawCount = 0;
+    _instanceCount = 0;
+    _materialChangeCount = 0;
+    _shaderChangeCount = 0;
+    _state.resetCounts();
 }
 
 
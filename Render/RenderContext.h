@@ -14,12 +14,15 @@
 #include <Base/AABB.h>
 
 #include "RenderParameterContainer.h"
+#include "RenderQueue.h"
+#include "RenderState.h"
 #include "Renderable.h"
 #include "Viewport.h"
 #include "Light.h"
 
 class Texture;
 class Material;
+class GenericAttributeBuffer;
 
 /*! \brief The render context acts as a wrapper around a system's native rendering API
     \author Brent Wilson
@@ -43,6 +46,17 @@ public:
 
     void setViewport(const Viewport &viewport);
 
+    /*! Turns instanced rendering on or off. When on, runs of opaque Renderables that share
+     *  a RenderOperation and a Material are drawn with a single instanced draw call, as
+     *  long as the Material's Shader accepts a per instance model matrix and none of the
+     *  Renderables have local parameters. This is on by default, but only takes effect if
+     *  the hardware supports it.
+     * \seealso Shader::getInstanceMatrixChannel
+     * \seealso Renderable::canInstance */
+    void setInstancing(bool enabled);
+
+    bool getInstancing() const;
+
     const Viewport& getViewport() const;
 
     /*! Gets the number of Renderables handled since the last resetCounts call. */
@@ -54,19 +68,70 @@ public:
     /*! Gets the number of primitives handled since the last resetCounts call. */
     int getVertexCount() const;
 
-    /*! Resets the Renderable, Primitive, and Vertex counts to zero. */
+    /*! Gets the number of draw calls issued since the last resetCounts call. */
+    int getDrawCount() const;
+
+    /*! Gets the number of instanced draw calls issued since the last resetCounts call. */
+    int getInstancedDrawCount() const;
+
+    /*! Gets the number of Renderables drawn by instanced draw calls since the last
+     *  resetCounts call. */
+    int getInstanceCount() const;
+
+    /*! Gets the number of Material switches since the last resetCounts call. */
+    int getMaterialChangeCount() const;
+
+    /*! Gets the number of Shader switches since the last resetCounts call. Materials
+     *  that share a Shader don't cause a switch when drawn back to back. */
+    int getShaderChangeCount() const;
+
+    /*! Gets the number of GL state changes issued since the last resetCounts call. */
+    int getStateChangeCount() const;
+
+    /*! Gets the number of redundant GL state changes that were skipped since the last
+     *  resetCounts call. */
+    int getElidedStateChangeCount() const;
+
+    /*! Returns the shadow of the GL state this context tracks. */
+    RenderState *getRenderState();
+
+    /*! Resets all of the counts to zero. */
     void resetCounts();
 
 private:
+    enum {
+        MinInstanceCount = 2,    //!< The shortest run worth an instanced draw.
+        InstanceRingSize = 16384 //!< The matrices _instanceBuffer's ring starts out holding.
+    };
+
     void setProjectionMatrix(const Matrix &mat);
     void setModelViewMatrix(const Matrix &mat);
 
+    /*! Returns one past the last entry in the queue that can be instanced along with the
+     *  given one. If the given entry can't be instanced, this is just first + 1. */
+    unsigned int findInstanceRun(unsigned int first);
+
+    /*! Draws the given range of the queue with a single instanced draw call. */
+    void renderInstances(const Matrix &view, unsigned int first, unsigned int end, bool bindAttributes);
+
 private:
     Viewport _viewport;
+    RenderQueue _queue;
+    RenderState _state;
+
+    bool _instancingSupported;
+    bool _instancingEnabled;
+    GenericAttributeBuffer *_instanceBuffer;  //!< Streams per instance model matrices.
+    std::vector<Matrix> _instanceMatrices;    //!< Reused staging for _instanceBuffer.
 
     mutable int _renderableCount;
     mutable int _primitiveCount;
     mutable int _vertexCount;
+    mutable int _drawCount;
+    mutable int _instancedDrawCount;
+    mutable int _instanceCount;
+    mutable int _materialChangeCount;
+    mutable int _shaderChangeCount;
 
 };
 
@@ -13,6 +13,10 @@
 #include "VertexArray.h"
 #include "IndexBuffer.h"
 
+#include <Base/MeshOptimizer.h>
+
+unsigned int RenderOperation::NextSortID = 1;
+
 RenderOperation * RenderOperation::CreateNoOp() {
     return new RenderOperation(TRIANGLES, NULL);
 }
@@ -199,6 +203,20 @@ RenderOperation * RenderOperation::CreateSphereOp(int strips, int panels, Real r
 
     GenerateSphereGeometry(strips, panels, radius, wire, indices, positions, normals);
 
+    // Spheres are drawn constantly, so give the solid ones the same treatment as imported
+    // meshes. The optimizer never adds vertices, so the indices still fit in 16 bits.
+    if (!wire) {
+        MeshCache::Mesh mesh;
+        mesh.positions.swap(positions);
+        mesh.normals.swap(normals);
+        mesh.indices.assign(indices.begin(), indices.end());
+        MeshOptimizer::Optimize(mesh);
+
+        positions.swap(mesh.positions);
+        normals.swap(mesh.normals);
+        indices.assign(mesh.indices.begin(), mesh.indices.end());
+    }
+
     VertexArray *vertexArray = new VertexArray();
     vertexArray->setPositionBuffer(new PositionBuffer(
         GL_STATIC_DRAW, GL_FLOAT, 3, positions.size(), &positions[0]));
@@ -341,7 +359,8 @@ RenderOperation::RenderOperation(
 ):
     _type(type),
     _vertices(vertices),
-    _indices(indices)
+    _indices(indices),
+    _sortID(NextSortID++)
 {}
 
 RenderOperation::~RenderOperation() {
@@ -376,10 +395,19 @@ unsigned int RenderOperation::getVertexCount() {
     return 0;
 }
 
+unsigned int RenderOperation::getSortID() const {
+    return _sortID;
+}
+
 PrimitiveType RenderOperation::getPrimitiveType() { 
     return _type;
 }
 
+long long RenderOperation::getByteCount() const {
+    return (_vertices ? _vertices->getByteCount() : 0) +
+           (_indices  ? _indices->getByteCount()  : 0);
+}
+
 VertexArray * RenderOperation::getVertexArray() {
     return _vertices;
 }
@@ -388,14 +416,20 @@ IndexBuffer * RenderOperation::getIndexBuffer() {
     return _indices;
 }
 
-void RenderOperation::render() {
+void RenderOperation::render(int instances) {
     // If there are no vertices, this is a NULL operation.
     if (!_vertices) { return; }
 
     _vertices->enable();
 
     if (_indices) {
-        _indices->render(_type);
+        _indices->render(_type, instances);
+    } else if (instances > 1) {
+        glDrawArraysInstancedARB(
+            TranslatePrimitiveType(_type),
+            0, // offset
+            _vertices->getElementCount(),
+            instances);
     } else {
         glDrawArrays(
             TranslatePrimitiveType(_type),
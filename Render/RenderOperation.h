@@ -57,14 +57,28 @@ public:
     unsigned int getPrimitiveCount();
     unsigned int getVertexCount();
 
+    /*! Gets the number of bytes allocated for the vertices and indices. */
+    long long getByteCount() const;
+
+    /*! Returns a small number unique to this RenderOperation, used to group Renderables
+     *  that share geometry when sorting.
+     * \seealso RenderQueue */
+    unsigned int getSortID() const;
+
 private:
     friend class RenderContext;
-    void render();
+
+    /*! Draws the geometry. If more than one instance is requested, a single instanced
+     *  draw is issued, and any per instance attributes must already be enabled. */
+    void render(int instances = 1);
 
 private:
+    static unsigned int NextSortID;
+
     PrimitiveType _type;
     VertexArray *_vertices;
     IndexBuffer *_indices;
+    unsigned int _sortID;
 
 };
 
@@ -8,8 +8,9 @@
  */
 
 #include "RenderParameterContainer.h"
-#include "GL_Helper.h"
+#include "RenderState.h"
 #include "Shader.h"
+#include <algorithm>
 
 #if DEBUG
 #include <stack>
@@ -33,37 +34,87 @@ RenderParameterContainer::RenderParameterContainer():
 {}
 
 RenderParameterContainer::~RenderParameterContainer() {
-    clear_map(_params);
+    ShaderParameterList::iterator itr;
+    for (itr = _params.begin(); itr != _params.end(); itr++) {
+        delete itr->second;
+    }
+}
+
+static bool SlotLess(const std::pair<int, ShaderParameter*> &lhs, int rhs) {
+    return lhs.first < rhs;
+}
+
+ShaderParameterList::iterator RenderParameterContainer::lowerBound(int slot) {
+    return std::lower_bound(_params.begin(), _params.end(), slot, SlotLess);
+}
+
+ShaderParameter *RenderParameterContainer::findParameter(const std::string &name) {
+    int slot = ShaderParameter::GetSlot(name);
+    ShaderParameterList::iterator itr = lowerBound(slot);
+    return itr != _params.end() && itr->first == slot ? itr->second : NULL;
+}
+
+ShaderParameter *RenderParameterContainer::findOrCreateParameter(const std::string &name) {
+    int slot = ShaderParameter::GetSlot(name);
+    ShaderParameterList::iterator itr = lowerBound(slot);
+    if (itr == _params.end() || itr->first != slot) {
+        itr = _params.insert(itr, std::make_pair(slot, new ShaderParameter()));
+    }
+
+    return itr->second;
 }
 
 void RenderParameterContainer::clearShaderParameter(const std::string &name) {
-    ShaderParameterMap::iterator itr = _params.find(name);
-    if (itr != _params.end()) {
+    int slot = ShaderParameter::GetSlot(name);
+    ShaderParameterList::iterator itr = lowerBound(slot);
+    if (itr != _params.end() && itr->first == slot) {
         delete itr->second;
         _params.erase(itr);
+        shaderParametersChanged();
     }
 }
 
 void RenderParameterContainer::setShaderParameter(const std::string &name, ShaderParameter *data) {
-    clearShaderParameter(name);
-    _params[name] = data;
+    int slot = ShaderParameter::GetSlot(name);
+    ShaderParameterList::iterator itr = lowerBound(slot);
+    if (itr != _params.end() && itr->first == slot) {
+        delete itr->second;
+        itr->second = data;
+    } else {
+        _params.insert(itr, std::make_pair(slot, data));
+    }
+
+    shaderParametersChanged();
+}
+
+void RenderParameterContainer::shaderParametersChanged() {}
+
+bool RenderParameterContainer::hasParameters() const {
+    return !_params.empty() || _cullMode.set || _transparency.set || _depthTest.set || _wireframe.set;
+}
+
+const ShaderParameterList & RenderParameterContainer::getShaderParameters() const {
+    return _params;
 }
 
 void RenderParameterContainer::setOldValues() {
+    // The RenderState shadows GL, so none of this needs to query the driver.
+    RenderState *state = RenderState::Get();
+
     if (_cullMode.set) {
-        _cullMode.old = GetCullMode();
+        _cullMode.old = state->getCullMode();
     }
     
     if (_wireframe.set) {
-        _wireframe.old = GetWireframe();
+        _wireframe.old = state->getWireframe();
     }
 
     if (_transparency.set) {
-        glGetBooleanv(GL_BLEND, (GLboolean*)&_transparency.old);
+        _transparency.old = state->getBlend();
     }
 
     if (_depthTest.set) {
-        glGetBooleanv(GL_DEPTH_TEST, (GLboolean*)&_depthTest.old);
+        _depthTest.old = state->getDepthTest();
     }
 }
 
@@ -82,28 +133,22 @@ void RenderParameterContainer::pushParameters(Shader *shaderTarget) {
     // Update the old values before we set the new ones.
     setOldValues();
 
+    RenderState *state = RenderState::Get();
+
     if (_cullMode.set) {
-        SetCullMode(_cullMode.set ? _cullMode.current : _cullMode.old);
+        state->setCullMode(_cullMode.current);
     }
 
     if (_wireframe.set) {
-        SetWireframe(_wireframe.set ? _wireframe.current : _wireframe.old);
+        state->setWireframe(_wireframe.current);
     }
 
     if (_transparency.set) {
-        if (_transparency.current) {
-            glEnable(GL_BLEND);
-        } else {
-            glDisable(GL_BLEND);
-        }
+        state->setBlend(_transparency.current);
     }
 
     if (_depthTest.set) {
-        if (_depthTest.current) {
-            glEnable(GL_DEPTH_TEST);
-        } else {
-            glDisable(GL_DEPTH_TEST);
-        }
+        state->setDepthTest(_depthTest.current);
     }
 }
 
@@ -117,28 +162,22 @@ void RenderParameterContainer::popParameters() {
     SafetyCheck_PushPopStack.pop();
 #endif //DEBUG
 
+    RenderState *state = RenderState::Get();
+
     if (_cullMode.set) {
-        SetCullMode(_cullMode.set ? _cullMode.old : GetCullMode());
+        state->setCullMode(_cullMode.old);
     }
     
     if (_wireframe.set) {
-        SetWireframe(_wireframe.set ? _wireframe.old : GetWireframe());
+        state->setWireframe(_wireframe.old);
     }
 
     if (_transparency.set) {
-        if (_transparency.old) {
-            glEnable(GL_BLEND);
-        } else {
-            glDisable(GL_BLEND);
-        }
+        state->setBlend(_transparency.old);
     }
 
     if (_depthTest.set) {
-        if (_depthTest.old) {
-            glEnable(GL_DEPTH_TEST);
-        } else {
-            glDisable(GL_DEPTH_TEST);
-        }
+        state->setDepthTest(_depthTest.old);
     }
 }
 
@@ -36,18 +36,15 @@ public:
         if (data == NULL) {
             clearShaderParameter(name);
         } else {
-            ShaderParameterMap::iterator itr = _params.find(name);
-            if (itr == _params.end()) {
-                itr = _params.insert(itr, std::pair<std::string, ShaderParameter*>(name, new ShaderParameter()));
-            }
-
-            itr->second->setData(data, count, cleanUp);
+            findOrCreateParameter(name)->setData(data, count, cleanUp);
+            shaderParametersChanged();
         }
     }
 
     template <typename T>
     T* getShaderParameter(const std::string &name) {
-        return _params[name]->getData<T>();
+        ShaderParameter *param = findParameter(name);
+        return param ? param->getData<T>() : NULL;
     }
 
     void setCullMode(CullMode mode);
@@ -76,9 +73,28 @@ public:
      *  unintented side effects may occur. */
     void popParameters();
 
+protected:
+    /*! Called whenever a ShaderParameter is set or cleared. */
+    virtual void shaderParametersChanged();
+
+    /*! Returns true if any ShaderParameters or render settings have been set. */
+    bool hasParameters() const;
+
+    /*! Returns every ShaderParameter set on this container, keyed by slot. */
+    const ShaderParameterList & getShaderParameters() const;
+
+    /*! Returns the ShaderParameter with the given name, or NULL if it isn't set. */
+    ShaderParameter *findParameter(const std::string &name);
+
+    /*! Returns the ShaderParameter with the given name, creating it if needed. */
+    ShaderParameter *findOrCreateParameter(const std::string &name);
+
 private:
     void setOldValues();
 
+    /*! Returns the position of the given slot in _params, or where it should go. */
+    ShaderParameterList::iterator lowerBound(int slot);
+
 private:
     template <typename T>
     struct RenderParameter {
@@ -90,7 +106,7 @@ private:
     };
 
 private:
-    ShaderParameterMap _params;
+    ShaderParameterList _params; //!< Sorted by slot, so pushing needs no name lookups.
 
     RenderParameter<CullMode> _cullMode;
     RenderParameter<bool> _transparency;
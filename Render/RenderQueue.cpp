@@ -0,0 +1,104 @@
+/*
+ *  RenderQueue.cpp
+ *  Mountainhome
+ *
+ *  Created by loch on 4/14/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include <Base/RadixSort.h>
+#include "RenderQueue.h"
+#include "Material.h"
+#include "Shader.h"
+
+#define FIELD(value, bits) ((uint64_t)(value) & ((1ull << (bits)) - 1))
+
+RenderQueue::RenderQueue() {}
+RenderQueue::~RenderQueue() {}
+
+void RenderQueue::clear() {
+    _entries.clear();
+}
+
+void RenderQueue::add(Renderable *renderable, const Matrix &view) {
+    add(renderable, ViewDepth(renderable, view));
+}
+
+void RenderQueue::add(Renderable *renderable, Real depth) {
+    Material *material = renderable->getMaterial();
+    Shader *shader = material->getShader();
+
+    Entry entry;
+    entry.renderable = renderable;
+    entry.key = MakeKey(
+        renderable->getLayer(),
+        material->getTransparency() || renderable->getTransparency(),
+        shader ? shader->getSortID() : 0,
+        material->getTextureSortID(),
+        material->getSortID(),
+        renderable->getRenderOperation() ? renderable->getRenderOperation()->getSortID() : 0,
+        depth);
+
+    _entries.push_back(entry);
+}
+
+void RenderQueue::sort() {
+    RadixSort(_entries, _scratch);
+}
+
+unsigned int RenderQueue::size() const {
+    return _entries.size();
+}
+
+Renderable *RenderQueue::operator[](unsigned int index) const {
+    return _entries[index].renderable;
+}
+
+uint64_t RenderQueue::getKey(unsigned int index) const {
+    return _entries[index].key;
+}
+
+uint64_t RenderQueue::MakeKey(unsigned int layer, bool translucent, unsigned int shader,
+    unsigned int texture, unsigned int material, unsigned int operation, Real depth)
+{
+    uint64_t key = FIELD(layer, LayerBits) << 61;
+    uint64_t state =
+        (FIELD(shader, ShaderBits) << (TextureBits + MaterialBits)) |
+        (FIELD(texture, TextureBits) << MaterialBits) |
+        FIELD(material, MaterialBits);
+
+    if (translucent) {
+        // Farthest first, so invert the depth.
+        key |= 1ull << 60;
+        key |= (FIELD(~QuantizeDepth(depth), DepthBits) << 36) | state;
+    } else {
+        key |= state << (OperationBits + OpaqueDepthBits);
+        key |= FIELD(operation, OperationBits) << OpaqueDepthBits;
+        key |= QuantizeDepth(depth, OpaqueDepthBits);
+    }
+
+    return key;
+}
+
+unsigned int RenderQueue::QuantizeDepth(Real depth, int bits) {
+    if (!(depth > 0)) { return 0; }
+
+    // Positive IEEE floats sort the same as their bit patterns. Drop the sign bit and the
+    // lowest mantissa bits to fit what's left into the requested number of bits.
+    union { float f; uint32_t i; } pattern;
+    pattern.f = depth;
+    return (pattern.i >> (31 - bits)) & ((1 << bits) - 1);
+}
+
+bool RenderQueue::IsTranslucent(uint64_t key) {
+    return (key >> 60) & 1;
+}
+
+Real RenderQueue::ViewDepth(Renderable *renderable, const Matrix &view) {
+    // Only the z component of the view space position is needed. The camera looks down
+    // the negative z axis, so flip it to get a distance.
+    const Real *v = view.getMatrix();
+    const Real *m = renderable->getModelMatrix().getMatrix();
+    return -(v[2] * m[12] + v[6] * m[13] + v[10] * m[14] + v[14]);
+}
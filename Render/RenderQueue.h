@@ -0,0 +1,99 @@
+/*
+ *  RenderQueue.h
+ *  Mountainhome
+ *
+ *  Created by loch on 4/14/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _RENDERQUEUE_H_
+#define _RENDERQUEUE_H_
+#include <Base/Matrix.h>
+#include "Renderable.h"
+
+/*! The RenderQueue orders a frame's Renderables to minimize state changes. Each
+ *  Renderable is given a single 64 bit key, and the queue is radix sorted on that key.
+ *  From the most significant bit down, the key is laid out as:
+ *
+ *    Opaque:      layer (3) | 0 | shader (10) | texture (10) | material (16) | operation (8) | depth (16)
+ *    Translucent: layer (3) | 1 | inverted depth (24) | shader (10) | texture (10) | material (16)
+ *
+ *  Layers always draw in order, and opaque objects always draw before translucent ones
+ *  within a layer. Opaque objects are grouped by shader, then texture, then material, so
+ *  expensive state only changes when a prefix of the key changes. Within a material they
+ *  are grouped by RenderOperation, which lines up runs that can be instanced, and are
+ *  then drawn front to back to help out early depth rejection. Translucent objects must
+ *  be blended back to front, so depth is moved ahead of all state.
+ *
+ *  Depth is the view space distance to the Renderable's origin, quantized by taking the
+ *  upper bits of its IEEE representation (which sort the same as the floats themselves,
+ *  as long as they're positive). Opaque objects only need a rough ordering, so they get
+ *  fewer bits than translucent ones.
+ * \seealso Renderable::setLayer
+ * \seealso RenderContext::render */
+class RenderQueue {
+public:
+    struct Entry {
+        uint64_t key;
+        Renderable *renderable;
+    };
+
+    /*! The number of bits available for each field of the key. */
+    enum {
+        LayerBits       = 3,
+        ShaderBits      = 10,
+        TextureBits     = 10,
+        MaterialBits    = 16,
+        OperationBits   = 8,
+        OpaqueDepthBits = 16,
+        DepthBits       = 24
+    };
+
+public:
+    RenderQueue();
+    ~RenderQueue();
+
+    /*! Removes everything from the queue. Memory is kept around for the next frame. */
+    void clear();
+
+    /*! Adds a Renderable to the queue, using the given view matrix to find its depth. */
+    void add(Renderable *renderable, const Matrix &view);
+
+    /*! Adds a Renderable with a precalculated view space depth. */
+    void add(Renderable *renderable, Real depth);
+
+    /*! Sorts the queue by key. The sort is stable. */
+    void sort();
+
+    /*! Returns the number of Renderables in the queue. */
+    unsigned int size() const;
+
+    /*! Returns the Renderable at the given position. */
+    Renderable *operator[](unsigned int index) const;
+
+    /*! Returns the key of the entry at the given position. */
+    uint64_t getKey(unsigned int index) const;
+
+    /*! Builds a sort key from its individual parts. Values that are too large for their
+     *  field are wrapped. */
+    static uint64_t MakeKey(unsigned int layer, bool translucent, unsigned int shader,
+        unsigned int texture, unsigned int material, unsigned int operation, Real depth);
+
+    /*! Quantizes a view space depth to the given number of bits. Depths at or behind the
+     *  eye are 0. */
+    static unsigned int QuantizeDepth(Real depth, int bits = DepthBits);
+
+    /*! Returns true if the given key belongs to a translucent Renderable. */
+    static bool IsTranslucent(uint64_t key);
+
+    /*! Returns the view space depth of the given Renderable, based on its model matrix. */
+    static Real ViewDepth(Renderable *renderable, const Matrix &view);
+
+protected:
+    std::vector<Entry> _entries;
+    std::vector<Entry> _scratch;
+
+};
+
+#endif
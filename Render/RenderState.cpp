@@ -0,0 +1,221 @@
+/*
+ *  RenderState.cpp
+ *  Mountainhome
+ *
+ *  Created by loch on 4/15/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#include "RenderState.h"
+
+RenderState *RenderState::Current = NULL;
+
+static RenderState *Fallback() {
+    static RenderState fallback;
+    return &fallback;
+}
+
+RenderState *RenderState::Get() {
+    return Current ? Current : Fallback();
+}
+
+RenderState::RenderState(): _issuedCount(0), _elidedCount(0) {
+    invalidate();
+}
+
+RenderState::~RenderState() {
+    if (Current == this) {
+        Current = NULL;
+        Fallback()->invalidate();
+    }
+}
+
+void RenderState::makeCurrent() {
+    Current = this;
+    Fallback()->invalidate();
+}
+
+void RenderState::invalidate() {
+    _cullMode.known = false;
+    _wireframe.known = false;
+    _blend.known = false;
+    _depthTest.known = false;
+    _program.known = false;
+    _activeTexture.known = false;
+    _arrayBuffer.known = false;
+    _elementBuffer.known = false;
+
+    for (int unit = 0; unit < MaxTextureUnits; unit++) {
+        for (int slot = 0; slot < TextureTargets; slot++) {
+            _textures[unit][slot].known = false;
+            _textureEnabled[unit][slot].known = false;
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Fixed function state
+//////////////////////////////////////////////////////////////////////////////////////////
+void RenderState::setCullMode(CullMode mode) {
+    if (change(_cullMode, mode)) {
+        SetCullMode(mode);
+    }
+}
+
+CullMode RenderState::getCullMode() {
+    if (!_cullMode.known) {
+        _cullMode.value = GetCullMode();
+        _cullMode.known = true;
+    }
+
+    return _cullMode.value;
+}
+
+void RenderState::setWireframe(bool wireframe) {
+    if (change(_wireframe, wireframe)) {
+        SetWireframe(wireframe);
+    }
+}
+
+bool RenderState::getWireframe() {
+    if (!_wireframe.known) {
+        _wireframe.value = GetWireframe();
+        _wireframe.known = true;
+    }
+
+    return _wireframe.value;
+}
+
+void RenderState::setBlend(bool enable) {
+    setCapability(_blend, GL_BLEND, enable);
+}
+
+bool RenderState::getBlend() {
+    return getCapability(_blend, GL_BLEND);
+}
+
+void RenderState::setDepthTest(bool enable) {
+    setCapability(_depthTest, GL_DEPTH_TEST, enable);
+}
+
+bool RenderState::getDepthTest() {
+    return getCapability(_depthTest, GL_DEPTH_TEST);
+}
+
+void RenderState::setCapability(Value<bool> &shadow, GLenum capability, bool enable) {
+    if (change(shadow, enable)) {
+        if (enable) {
+            glEnable(capability);
+        } else {
+            glDisable(capability);
+        }
+    }
+}
+
+bool RenderState::getCapability(Value<bool> &shadow, GLenum capability) {
+    if (!shadow.known) {
+        shadow.value = glIsEnabled(capability);
+        shadow.known = true;
+    }
+
+    return shadow.value;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Object bindings
+//////////////////////////////////////////////////////////////////////////////////////////
+void RenderState::useProgram(GLuint program) {
+    if (change(_program, program)) {
+        glUseProgram(program);
+    }
+}
+
+void RenderState::setActiveTexture(int unit) {
+    if (change(_activeTexture, unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+}
+
+void RenderState::bindTexture(GLenum target, GLuint texture) {
+    int slot = TextureSlot(target);
+    if (slot < 0 || !_activeTexture.known || _activeTexture.value >= MaxTextureUnits) {
+        _issuedCount++;
+        glBindTexture(target, texture);
+    } else if (change(_textures[_activeTexture.value][slot], texture)) {
+        glBindTexture(target, texture);
+    }
+}
+
+void RenderState::setTextureEnabled(GLenum target, bool enable) {
+    int slot = TextureSlot(target);
+    if (slot < 0 || !_activeTexture.known || _activeTexture.value >= MaxTextureUnits) {
+        _issuedCount++;
+        if (enable) { glEnable(target); } else { glDisable(target); }
+    } else {
+        setCapability(_textureEnabled[_activeTexture.value][slot], target, enable);
+    }
+}
+
+void RenderState::bindBuffer(GLenum target, GLuint buffer) {
+    Value<GLuint> *shadow = bufferShadow(target);
+    if (!shadow) {
+        _issuedCount++;
+        glBindBuffer(target, buffer);
+    } else if (change(*shadow, buffer)) {
+        glBindBuffer(target, buffer);
+    }
+}
+
+void RenderState::programDeleted(GLuint program) {
+    // GL keeps a deleted program around until it's no longer in use, so the binding is
+    // unknown rather than 0.
+    if (_program.known && _program.value == program) {
+        _program.known = false;
+    }
+}
+
+void RenderState::texturesDeleted(int count, const GLuint *textures) {
+    for (int unit = 0; unit < MaxTextureUnits; unit++) {
+        for (int slot = 0; slot < TextureTargets; slot++) {
+            Value<GLuint> &shadow = _textures[unit][slot];
+            for (int i = 0; shadow.known && i < count; i++) {
+                if (shadow.value == textures[i]) { shadow.value = 0; }
+            }
+        }
+    }
+}
+
+void RenderState::bufferDeleted(GLuint buffer) {
+    if (_arrayBuffer.known && _arrayBuffer.value == buffer) { _arrayBuffer.value = 0; }
+    if (_elementBuffer.known && _elementBuffer.value == buffer) { _elementBuffer.value = 0; }
+}
+
+int RenderState::TextureSlot(GLenum target) {
+    switch (target) {
+        case GL_TEXTURE_1D:       return 0;
+        case GL_TEXTURE_2D:       return 1;
+        case GL_TEXTURE_3D:       return 2;
+        case GL_TEXTURE_CUBE_MAP: return 3;
+        default:                  return -1;
+    }
+}
+
+RenderState::Value<GLuint> *RenderState::bufferShadow(GLenum target) {
+    switch (target) {
+        case GL_ARRAY_BUFFER:         return &_arrayBuffer;
+        case GL_ELEMENT_ARRAY_BUFFER: return &_elementBuffer;
+        default:                      return NULL;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+#pragma mark Statistics
+//////////////////////////////////////////////////////////////////////////////////////////
+int RenderState::getIssuedCount() const { return _issuedCount; }
+int RenderState::getElidedCount() const { return _elidedCount; }
+
+void RenderState::resetCounts() {
+    _issuedCount = 0;
+    _elidedCount = 0;
+}
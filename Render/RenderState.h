@@ -0,0 +1,149 @@
+/*
+ *  RenderState.h
+ *  Mountainhome
+ *
+ *  Created by loch on 4/15/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ */
+
+#ifndef _RENDERSTATE_H_
+#define _RENDERSTATE_H_
+#include "GL_Helper.h"
+
+/*! RenderState is a CPU side shadow of the GL state the engine changes most often: cull
+ *  mode, polygon mode, blending, depth testing, the bound program, the textures bound to
+ *  each texture unit and the bound array and element buffers. Every change goes through
+ *  here, so a change to a value that is already set is dropped without touching GL, and
+ *  the current value of anything can be read back without a glGet (which forces the
+ *  driver to sync with the GPU).
+ *
+ *  Values start out unknown. The first time an unknown value is read it is queried from
+ *  GL once, and the first time it is set the call is always issued. Anything that changes
+ *  GL state behind the tracker's back (other libraries, context recreation) must call
+ *  invalidate afterwards.
+ *
+ *  Each RenderContext owns a RenderState and makes it current. Code without access to the
+ *  RenderContext (Textures, Buffers, Shaders) uses RenderState::Get. If there is no
+ *  RenderContext, Get returns a fallback instance that is invalidated whenever the
+ *  current state changes.
+ * \seealso RenderContext::getStateChangeCount */
+class RenderState {
+public:
+    /*! Returns the current RenderState. This is never NULL. */
+    static RenderState *Get();
+
+    RenderState();
+    ~RenderState();
+
+    /*! Makes this the RenderState returned by Get. */
+    void makeCurrent();
+
+    /*! Forgets everything, forcing the next read to query GL and the next set to be
+     *  issued. */
+    void invalidate();
+
+#pragma mark Fixed function state
+    void setCullMode(CullMode mode);
+    CullMode getCullMode();
+
+    void setWireframe(bool wireframe);
+    bool getWireframe();
+
+    void setBlend(bool enable);
+    bool getBlend();
+
+    void setDepthTest(bool enable);
+    bool getDepthTest();
+
+#pragma mark Object bindings
+    void useProgram(GLuint program);
+
+    /*! Makes the given unit the target of bindTexture and setTextureEnabled. */
+    void setActiveTexture(int unit);
+
+    /*! Binds a texture to the active texture unit. */
+    void bindTexture(GLenum target, GLuint texture);
+
+    /*! Enables or disables a texture target on the active texture unit. */
+    void setTextureEnabled(GLenum target, bool enable);
+
+    void bindBuffer(GLenum target, GLuint buffer);
+
+    /*! Must be called when a program is deleted, so a new program given the same name
+     *  isn't mistaken for it. */
+    void programDeleted(GLuint program);
+
+    /*! Must be called when textures are deleted, since GL implicitly unbinds them. */
+    void texturesDeleted(int count, const GLuint *textures);
+
+    /*! Must be called when a buffer is deleted, since GL implicitly unbinds it. */
+    void bufferDeleted(GLuint buffer);
+
+#pragma mark Statistics
+    /*! Gets the number of state changes sent to GL since the last resetCounts call. */
+    int getIssuedCount() const;
+
+    /*! Gets the number of redundant state changes dropped since the last resetCounts. */
+    int getElidedCount() const;
+
+    void resetCounts();
+
+protected:
+    enum {
+        MaxTextureUnits = 16,
+        TextureTargets = 4
+    };
+
+    template <typename T>
+    struct Value {
+        T value;
+        bool known;
+    };
+
+    /*! Returns true (and counts an issued change) if the value needs to be sent to GL,
+     *  updating the shadowed value. Otherwise counts an elided change. */
+    template <typename T>
+    bool change(Value<T> &shadow, const T &value) {
+        if (shadow.known && shadow.value == value) {
+            _elidedCount++;
+            return false;
+        }
+
+        shadow.value = value;
+        shadow.known = true;
+        _issuedCount++;
+        return true;
+    }
+
+    /*! Maps a texture target to its slot, or -1 if it isn't tracked. */
+    static int TextureSlot(GLenum target);
+
+    void setCapability(Value<bool> &shadow, GLenum capability, bool enable);
+    bool getCapability(Value<bool> &shadow, GLenum capability);
+
+    /*! Returns the shadow of the given buffer target, or NULL if it isn't tracked. */
+    Value<GLuint> *bufferShadow(GLenum target);
+
+protected:
+    static RenderState *Current;
+
+    Value<CullMode> _cullMode;
+    Value<bool> _wireframe;
+    Value<bool> _blend;
+    Value<bool> _depthTest;
+
+    Value<GLuint> _program;
+    Value<int> _activeTexture;
+    Value<GLuint> _textures[MaxTextureUnits][TextureTargets];
+    Value<bool> _textureEnabled[MaxTextureUnits][TextureTargets];
+
+    Value<GLuint> _arrayBuffer;
+    Value<GLuint> _elementBuffer;
+
+    int _issuedCount;
+    int _elidedCount;
+
+};
+
+#endif
@@ -18,7 +18,8 @@ static bool SafetyCheck_BetweenCalls = false;
 Renderable::Renderable():
     _renderOp(NULL),
     _material(NULL),
-    _modelMatrix(Matrix::Identity())
+    _modelMatrix(Matrix::Identity()),
+    _layer(0)
 #if DEBUG
     , Parent(NULL)
 #endif
@@ -27,7 +28,8 @@ Renderable::Renderable():
 Renderable::Renderable(RenderOperation *op, Material *mat):
     _renderOp(op),
     _material(mat),
-    _modelMatrix(Matrix::Identity())
+    _modelMatrix(Matrix::Identity()),
+    _layer(0)
 #if DEBUG
     , Parent(NULL)
 #endif
@@ -81,6 +83,18 @@ void Renderable::postRenderNotice() {
     popParameters();
 }
 
+bool Renderable::canInstance() {
+    return !hasParameters();
+}
+
+void Renderable::setLayer(unsigned int layer) {
+    _layer = layer;
+}
+
+unsigned int Renderable::getLayer() const {
+    return _layer;
+}
+
 bool Renderable::operator<(const Renderable& rhs) {
     // Sort based on material. Just compare pointers for speed purposes. Comparing names would work, too.
     return _material < rhs._material;
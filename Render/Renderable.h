@@ -17,7 +17,7 @@
 #include "Material.h"
 
 class Renderable;
-typedef std::list<Renderable*> RenderableList;
+typedef std::vector<Renderable*> RenderableList;
 
 class Material;
 class RenderContext;
@@ -167,18 +167,31 @@ public:
     /*! Called after this Renderable is rendered. */
     virtual void postRenderNotice();
 
+    /*! Returns true if this Renderable can be drawn as one instance of many, in which case
+     *  its pre and post render notices are skipped. By default, this is only true if no
+     *  local parameters have been set. Subclasses that do work in preRenderNotice or
+     *  postRenderNotice should return false.
+     * \seealso RenderContext::setInstancing */
+    virtual bool canInstance();
+
+    /*! Sets the layer this Renderable draws in. Lower layers are always drawn first,
+     *  regardless of Material or depth. Only the lowest 3 bits are used. */
+    void setLayer(unsigned int layer);
+
+    unsigned int getLayer() const;
+
     /*! Used for sorting lists of renderables for rendering speed.
-     * \todo Needs to be setup to consider alpha blending. */
+     * \seealso RenderQueue */
     bool operator < (const Renderable& rhs);
 
 protected:
     Renderable();
 
 protected:
-    ShaderParameterMap _params;
     RenderOperation *_renderOp;
     Material *_material;
     Matrix _modelMatrix;
+    unsigned int _layer;
 
 
 #if DEBUG
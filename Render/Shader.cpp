@@ -9,17 +9,32 @@
 
 #include "Shader.h"
 
-Shader::Shader() {}
+const std::string Shader::InstanceMatrixAttribute = "instanceMatrix";
+unsigned int Shader::NextSortID = 1;
+
+Shader::Shader(): _sortID(NextSortID++) {}
 Shader::~Shader() {}
 
+int Shader::getInstanceMatrixChannel() {
+    return -1;
+}
+
+unsigned int Shader::getSortID() const {
+    return _sortID;
+}
+
 void Shader::bindAttributesToChannel(const std::vector<std::string> &names) {
     for (int i = 0; i < names.size(); i++) {
         bindAttributeToChannel(names[i], i);
     }
 }
 
-void Shader::setParameters(const ShaderParameterMap &params) {
-    ShaderParameterMap::const_iterator itr;
+void Shader::setParameter(const std::string &name, ShaderParameter *param) {
+    setParameter(ShaderParameter::GetSlot(name), param);
+}
+
+void Shader::setParameters(const ShaderParameterList &params) {
+    ShaderParameterList::const_iterator itr;
     for (itr = params.begin(); itr != params.end(); itr++) {
         setParameter(itr->first, itr->second);
     }
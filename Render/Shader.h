@@ -55,12 +55,37 @@ public:
 
     /*! Sets a single parameter for the named uniform in the shader.
      * \seealso ShaderParameter */
-    virtual void setParameter(const std::string &name, ShaderParameter *param) = 0;
+    void setParameter(const std::string &name, ShaderParameter *param);
 
-    /*! Sets each parameter in the map. The key is the name of the Shader uniform to set.
+    /*! Sets a single parameter for the uniform assigned to the given slot.
+     * \seealso ShaderParameter::GetSlot */
+    virtual void setParameter(int slot, ShaderParameter *param) = 0;
+
+    /*! Sets each parameter in the list. The key is the slot of the Shader uniform to set.
      *  The value is the ShaderParameter that contains the value to set the uniform to.
      * \seealso ShaderParameter */
-    void setParameters(const ShaderParameterMap &params);
+    void setParameters(const ShaderParameterList &params);
+
+    /*! Returns the first attribute channel of the per instance model matrix, or -1 if
+     *  the Shader can't be used for instanced rendering. Shaders opt in by declaring a
+     *  mat4 attribute named InstanceMatrixAttribute and using it in place of the model
+     *  part of the modelview matrix, which only holds the view matrix when instancing.
+     * \seealso RenderContext::setInstancing */
+    virtual int getInstanceMatrixChannel();
+
+    /*! Returns a small number unique to this Shader, used to group Renderables by Shader
+     *  when sorting.
+     * \seealso RenderQueue */
+    unsigned int getSortID() const;
+
+public:
+    /*! The name of the per instance model matrix attribute. */
+    static const std::string InstanceMatrixAttribute;
+
+private:
+    static unsigned int NextSortID;
+
+    unsigned int _sortID;
 
 };
 
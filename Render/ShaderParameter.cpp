@@ -38,6 +38,43 @@ ShaderParameterType ShaderParameter::getType()  { return _type;  }
 int                 ShaderParameter::getCount() { return _count; }
 int                 ShaderParameter::getSize()  { return _size;  }
 
+int ShaderParameter::getByteCount() {
+    switch (_type) {
+        case FloatParam:   return _count * _size * sizeof(GLfloat);
+        case IntParam:     return _count * _size * sizeof(GLint);
+        case Matrix4Param: return _count * 16 * sizeof(Real);
+        default:           return 0;
+    }
+}
+
+typedef std::map<std::string, int> SlotMap;
+
+static SlotMap & Slots() {
+    static SlotMap slots;
+    return slots;
+}
+
+static std::vector<std::string> & SlotNames() {
+    static std::vector<std::string> names;
+    return names;
+}
+
+int ShaderParameter::GetSlot(const std::string &name) {
+    SlotMap::iterator itr = Slots().find(name);
+    if (itr != Slots().end()) {
+        return itr->second;
+    }
+
+    int slot = SlotNames().size();
+    Slots()[name] = slot;
+    SlotNames().push_back(name);
+    return slot;
+}
+
+const std::string & ShaderParameter::GetSlotName(int slot) {
+    return SlotNames()[slot];
+}
+
 template <>
 void ShaderParameter::setData(float *data, int count, bool free) {
     setData(data, FloatParam, 1, count, free);
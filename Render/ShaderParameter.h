@@ -15,7 +15,9 @@
 
 class ShaderParameter;
 
-typedef std::map<std::string, ShaderParameter*> ShaderParameterMap;
+/*! ShaderParameters keyed by slot, kept sorted by slot.
+ * \seealso ShaderParameter::GetSlot */
+typedef std::vector<std::pair<int, ShaderParameter*> > ShaderParameterList;
 
 enum ShaderParameterType {
     FloatParam,
@@ -54,6 +56,18 @@ public:
     int getCount();
     int getSize();
 
+    /*! Returns the number of bytes the parameter's value takes up. Textures take no
+     *  space, as they are compared by binding rather than by value. */
+    int getByteCount();
+
+    /*! Returns the slot for the given uniform name, assigning a new one the first time a
+     *  name is seen. Slots are small, dense integers shared by every Shader, so parameters
+     *  can be stored and looked up without strings once they've been set. */
+    static int GetSlot(const std::string &name);
+
+    /*! Returns the name the given slot was assigned to. */
+    static const std::string & GetSlotName(int slot);
+
 private:
     ShaderParameter(const ShaderParameter &other);
 
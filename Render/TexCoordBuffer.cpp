@@ -8,6 +8,7 @@
  */
 
 #include "TexCoordBuffer.h"
+#include "RenderState.h"
 #include <Base/Assertion.h>
 
 TexCoordBuffer::TexCoordBuffer(
@@ -51,11 +52,11 @@ void TexCoordBuffer::enable(int channel) {
     glClientActiveTexture(GL_TEXTURE0 + _activeChannel);
 
     glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-    glBindBuffer(_bufferType, _handle);
+    RenderState::Get()->bindBuffer(_bufferType, _handle);
 
-    glTexCoordPointer(_componentsPerElement, _dataType, 0, 0);
+    glTexCoordPointer(_componentsPerElement, _dataType, 0, getOffsetPointer());
 
-    glBindBuffer(_bufferType, 0);
+    RenderState::Get()->bindBuffer(_bufferType, 0);
 }
 
 void TexCoordBuffer::disable() {
@@ -70,3 +71,23 @@ void TexCoordBuffer::disable() {
 
     _activeChannel = -1;
 }
+
+bool TexCoordBuffer::remap(const TextureAtlas::Region &region) {
+    if (_dataType != GL_FLOAT || _componentsPerElement < 2 || !_elementCount) {
+        return false;
+    }
+
+    unsigned char *data = (unsigned char*)mapBufferData(GL_READ_WRITE);
+    if (!data) {
+        return false;
+    }
+
+    float *coords = (float*)(data + getByteOffset());
+    bool inRange = TextureAtlas::IsInUnitRange(coords, _elementCount, _componentsPerElement);
+    if (inRange) {
+        TextureAtlas::RemapTexCoords(region, coords, _elementCount, _componentsPerElement);
+    }
+
+    unmapBufferData();
+    return inRange;
+}
@@ -10,6 +10,7 @@
 #ifndef _TEXCOORDBUFFER_H_
 #define _TEXCOORDBUFFER_H_
 #include "Buffer.h"
+#include <Base/TextureAtlas.h>
 
 class TexCoordBuffer : public Buffer {
 public:
@@ -31,6 +32,14 @@ public:
 
     void disable();
 
+    /*! Moves the coordinates in channels 0 and 1 into the given atlas region, so the
+     *  buffer can be drawn with the atlas page instead of the original texture. Only
+     *  float coordinates in [0, 1] can be remapped, since anything outside would sample
+     *  the image's neighbors.
+     * \return false if the coordinates couldn't be remapped, in which case they're left
+     *  untouched. */
+    bool remap(const TextureAtlas::Region &region);
+
 private:
     int _activeChannel;
 
@@ -9,6 +9,7 @@
 
 #include "Texture.h"
 #include "TextureManager.h"
+#include "RenderState.h"
 #include <Base/Assertion.h>
 #include <Base/Math3D.h>
 #include "PixelData.h"
@@ -36,6 +37,7 @@ Texture::Texture(int frames):
     _internalFormat(0),
     _textureId(NULL),
     _numFrames(frames),
+    _mipmapped(false),
     _name("No name")
 {
     initEnvironment();
@@ -49,6 +51,7 @@ Texture::Texture(const std::string &name, int frames):
     _internalFormat(0),
     _textureId(NULL),
     _numFrames(frames),
+    _mipmapped(false),
     _name(name)
 {
     initEnvironment();
@@ -57,6 +60,7 @@ Texture::Texture(const std::string &name, int frames):
 Texture::~Texture() {
     if (_textureId) {
         glDeleteTextures(_numFrames, _textureId);
+        RenderState::Get()->texturesDeleted(_numFrames, _textureId);
         delete[] _textureId;
     }
 }
@@ -82,6 +86,35 @@ GLenum Texture::getFormat() {
     return _internalFormat;
 }
 
+/*! Estimates the number of bytes a single texel takes up on the card. */
+static double BytesPerTexel(GLenum format) {
+    switch (format) {
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        return 0.5;
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_ALPHA:
+    case GL_LUMINANCE:
+        return 1;
+    case GL_LUMINANCE_ALPHA:
+    case GL_DEPTH_COMPONENT16:
+        return 2;
+    default:
+        // Drivers pad RGB out to RGBA and depth out to 32 bits, so assume 4.
+        return 4;
+    }
+}
+
+long long Texture::getByteCount() const {
+    double bytes = (double)_width * Math::Max(_height, 1u) * Math::Max(_depth, 1u) *
+        BytesPerTexel(_internalFormat);
+
+    // A full mip chain adds a third again to a 2D texture.
+    if (_mipmapped) { bytes *= 4.0 / 3.0; }
+
+    return (long long)(bytes * _numFrames);
+}
+
 int Texture::dimensions() {
     if (getDepth()  > 1) { return 3; }
     if (getHeight() > 1) { return 2; }
@@ -89,20 +122,22 @@ int Texture::dimensions() {
 }
 
 void Texture::enable(int level, int frame) {
-    glActiveTexture(GL_TEXTURE0 + level);
-    glBindTexture(_target, _textureId[frame]);
-    glEnable(_target);
+    RenderState *state = RenderState::Get();
+    state->setActiveTexture(level);
+    state->bindTexture(_target, _textureId[frame]);
+    state->setTextureEnabled(_target, true);
 }
 
 void Texture::disable(int level) {
-    glActiveTexture(GL_TEXTURE0 + level);
-    glBindTexture(_target, 0);
-    glDisable(_target);
+    RenderState *state = RenderState::Get();
+    state->setActiveTexture(level);
+    state->bindTexture(_target, 0);
+    state->setTextureEnabled(_target, false);
 }
 
 void Texture::setFiltering(GLenum minFilter, GLenum magFilter) {
     for (int i = 0; i < _numFrames; i++) {
-        glBindTexture(_target, _textureId[i]);
+        RenderState::Get()->bindTexture(_target, _textureId[i]);
         glTexParameterf(_target, GL_TEXTURE_MIN_FILTER, minFilter);
         glTexParameterf(_target, GL_TEXTURE_MAG_FILTER, magFilter);
     }
@@ -110,7 +145,7 @@ void Texture::setFiltering(GLenum minFilter, GLenum magFilter) {
 
 void Texture::setTexCoordHandling(GLenum sCoord, GLenum tCoord, GLenum rCoord) {
     for (int i = 0; i < _numFrames; i++) {
-        glBindTexture(_target, _textureId[i]);
+        RenderState::Get()->bindTexture(_target, _textureId[i]);
         glTexParameterf(_target, GL_TEXTURE_WRAP_S, sCoord);
         glTexParameterf(_target, GL_TEXTURE_WRAP_T, tCoord);
         glTexParameterf(_target, GL_TEXTURE_WRAP_R, rCoord);
@@ -129,7 +164,7 @@ void Texture::setAnisoLevel(int level) {
 
     // Set the aniso level.
     for (int i = 0; i < _numFrames; i++) {
-        glBindTexture(_target, _textureId[i]);
+        RenderState::Get()->bindTexture(_target, _textureId[i]);
         glTexParameterf(_target, GL_TEXTURE_MAX_ANISOTROPY_EXT, level);
     }
 }
@@ -165,23 +200,24 @@ void Texture::uploadPixelData(
 
     enable(0, frame);
 
-    if (data.getLayout() == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ||
-        data.getLayout() == GL_COMPRESSED_RGBA_S3TC_DXT3_EXT ||
-        data.getLayout() == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) {
+    if (data.isCompressed()) {
         _internalFormat = data.getLayout();
+        _mipmapped = false;
 
         if (level < 0) {
-            Error("No mipmaps on precompressed textures");
+            Error("No mipmaps on precompressed textures. Use uploadMipChain instead.");
+            disable();
             return;
         } else {
             switch (dimensions()) {
-            case 1: glCompressedTexImage1D(getTarget(), level, _internalFormat, getWidth(), 0, data.getDataType() * ceil(getWidth() / 4.0), data.getPixelData<void>()); break;
-            case 2: glCompressedTexImage2D(getTarget(), level, _internalFormat, getWidth(), getHeight(), 0, data.getDataType() * ceil(getWidth() / 4.0) * ceil(getHeight() / 4.0), data.getPixelData<void>()); break;
-            case 3: glCompressedTexImage3D(getTarget(), level, _internalFormat, getWidth(), getHeight(), getDepth(), 0, data.getDataType() * ceil(getWidth() / 4.0) * ceil(getHeight() / 4.0) * ceil(getDepth() / 4.0), data.getPixelData<void>()); break;
+            case 1: glCompressedTexImage1D(getTarget(), level, _internalFormat, getWidth(), 0, data.getByteCount(), data.getPixelData<void>()); break;
+            case 2: glCompressedTexImage2D(getTarget(), level, _internalFormat, getWidth(), getHeight(), 0, data.getByteCount(), data.getPixelData<void>()); break;
+            case 3: glCompressedTexImage3D(getTarget(), level, _internalFormat, getWidth(), getHeight(), getDepth(), 0, data.getByteCount(), data.getPixelData<void>()); break;
             }
         }
     } else {
         _internalFormat = internal ?: data.getLayout();
+        _mipmapped = level < 0;
 
         if (level < 0) {
             switch (dimensions()) {
@@ -273,3 +309,36 @@ GLenum getGLEnum(GLenum old) {
     return 0;
 }*/
 
+void Texture::uploadMipChain(
+    const PixelData *levels,
+    int count,
+    GLenum internal,
+    int frame)
+{
+    ASSERT(count > 0);
+    _width = levels[0].getWidth();
+    _height = levels[0].getHeight();
+    _depth = 1;
+
+    bool compressed = levels[0].isCompressed();
+    _internalFormat = compressed ? levels[0].getLayout() : (internal ?: levels[0].getLayout());
+    _mipmapped = count > 1;
+
+    enable(0, frame);
+
+    for (int i = 0; i < count; i++) {
+        const PixelData &level = levels[i];
+        if (compressed) {
+            glCompressedTexImage2D(getTarget(), i, _internalFormat, level.getWidth(),
+                level.getHeight(), 0, level.getByteCount(), level.getPixelData<void>());
+        } else {
+            glTexImage2D(getTarget(), i, _internalFormat, level.getWidth(), level.getHeight(),
+                0, level.getLayout(), level.getDataType(), level.getPixelData<void>());
+        }
+    }
+
+    // Without this, a chain that stops short of 1x1 leaves the texture incomplete.
+    glTexParameteri(getTarget(), GL_TEXTURE_MAX_LEVEL, count - 1);
+
+    disable();
+}
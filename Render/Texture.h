@@ -37,6 +37,10 @@ public:
     unsigned int getDepth();
 
     int dimensions();
+
+    /*! Estimates the number of bytes of video memory used by every frame of the texture,
+     *  including mipmaps. */
+    long long getByteCount() const;
     
     GLuint getID(int frame = 0);
     GLuint getTarget();
@@ -55,6 +59,15 @@ public:
         bool genMipmaps = true,
         int frame = 0);
 
+    /*! Uploads a complete, prebuilt mip chain for a 2D texture, starting with the full
+     *  size image. The levels may be uncompressed or all in one S3TC format, in which case
+     *  they go straight to the card without being decoded or recompressed. */
+    void uploadMipChain(
+        const PixelData *levels,
+        int count,
+        GLenum format = 0,
+        int frame = 0);
+
 protected:
     void initEnvironment();
 
@@ -67,6 +80,7 @@ protected:
     GLenum _internalFormat;
     GLuint *_textureId;
     int _numFrames;
+    bool _mipmapped;
 
     std::string _name;
 };
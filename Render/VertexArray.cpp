@@ -77,6 +77,22 @@ unsigned int VertexArray::getAttributeCount() const {
     return _buffers.size() + _texCoords.size() + (_positions ? 1 : 0) + (_normals ? 1 : 0);
 }
 
+long long VertexArray::getByteCount() const {
+    long long bytes = 0;
+    if (_positions) { bytes += _positions->getByteCount(); }
+    if (_normals)   { bytes += _normals->getByteCount();   }
+
+    for (int i = 0; i < _texCoords.size(); i++) {
+        if (_texCoords[i]) { bytes += _texCoords[i]->getByteCount(); }
+    }
+
+    for (int i = 0; i < _buffers.size(); i++) {
+        bytes += _buffers[i]->getByteCount();
+    }
+
+    return bytes;
+}
+
 void VertexArray::resize(int elementCount, bool saveData) {
     if (_positions) { _positions->resize(elementCount, saveData); }
     if (_normals) { _normals->resize(elementCount, saveData); }
@@ -59,6 +59,9 @@ public:
     /*! Get the number of GenericAttributeBuffers in the VertexArray */
     unsigned int getAttributeCount() const;
 
+    /*! Gets the number of bytes allocated across all of the underlying buffers. */
+    long long getByteCount() const;
+
     /*! Resizes all internal buffers. This may or may not result in reallocation and will
      *  destroy all old data unless saveData is set to true. */
     void resize(int elementCount, bool saveData);
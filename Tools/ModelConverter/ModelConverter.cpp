@@ -0,0 +1,122 @@
+/*
+ *  ModelConverter.cpp
+ *  ModelConverter
+ *
+ *  Created by loch on 4/28/11.
+ *  Copyright 2011 Mountainhome Project. All rights reserved.
+ *
+ *  Converts FBX models into .mhm mesh caches, and optionally compares how long each
+ *  takes to load. Usage:
+ *      ModelConverter [-benchmark passes] input.fbx output.mhm
+ *
+ */
+
+#include <Base/FileSystem.h>
+#include <Base/MappedFile.h>
+#include <Base/MeshCache.h>
+#include <Base/Timer.h>
+#include <Base/File.h>
+#include <Base/Math3D.h>
+
+#include <Content/ResourceGroupManager.h>
+#include <Content/ModelFBX.h>
+
+#include <cstdlib>
+
+static int Usage() {
+    std::cerr << "usage: ModelConverter [-benchmark passes] input.fbx output.mhm" << std::endl;
+    return 1;
+}
+
+static bool Convert(ModelFBXFactory &factory, const std::string &name, const std::string &output) {
+    File *file = FileSystem::GetFile(output, IOTarget::Write);
+    if (!file->isOpen()) {
+        Error("Unable to open " << output << " for writing.");
+        delete file;
+        return false;
+    }
+
+    bool success = factory.convert(name, file);
+    delete file;
+    return success;
+}
+
+/*! Copies the given stream into scratch, to make sure every page of it is read. */
+static void Touch(const void *stream, long long bytes, std::vector<char> &scratch) {
+    if (!stream || !bytes) { return; }
+    scratch.resize(Math::Max((long long)scratch.size(), bytes));
+    memcpy(&scratch[0], stream, bytes);
+}
+
+/*! Maps and reads the cache, then reads every stream the way an upload would. */
+static bool ReadCache(const std::string &output, std::vector<char> &scratch) {
+    MappedFile *file = FileSystem::GetMappedFile(output);
+    MeshCache cache;
+    bool success = file && file->isOpen() && cache.read(file->getData(), file->length());
+
+    for (int i = 0; success && i < cache.getMeshCount(); i++) {
+        const MeshCache::MeshView &mesh = cache.getMesh(i);
+        Touch(mesh.positions, mesh.vertexCount * sizeof(float) * 3, scratch);
+        Touch(mesh.normals,   mesh.vertexCount * sizeof(float) * 3, scratch);
+        Touch(mesh.texCoords, mesh.vertexCount * sizeof(float) * 2, scratch);
+        Touch(mesh.indices,   mesh.indexCount * mesh.indexSize,     scratch);
+    }
+
+    delete file;
+    return success;
+}
+
+int main(int argc, char * const argv[]) {
+    int passes = 0;
+    int arg = 1;
+    if (argc > arg && std::string(argv[arg]) == "-benchmark") {
+        if (argc <= arg + 1) { return Usage(); }
+        passes = atoi(argv[arg + 1]);
+        arg += 2;
+    }
+
+    if (argc != arg + 2) { return Usage(); }
+
+    std::string input = argv[arg], output = argv[arg + 1], directory, name;
+    FileSystem::ExtractDirectory(input, directory);
+    FileSystem::ExtractFilename(input, name);
+
+    ResourceGroupManager manager;
+    manager.addResourceLocation(directory.empty() ? "." : directory);
+
+    // Textures are only referenced by name in the cache, so no TextureManager is needed.
+    ModelFBXFactory factory(&manager, NULL);
+    if (!Convert(factory, name, output)) {
+        Error("Failed to convert " << input);
+        return 1;
+    }
+
+    Info("Wrote " << output << " (" << FileSystem::Length(output) << " bytes)");
+
+    if (passes > 0) {
+        Timer timer;
+        timer.start();
+        for (int i = 0; i < passes; i++) {
+            Convert(factory, name, output);
+        }
+        timer.stop();
+        double fbxTime = timer.mseconds() / passes;
+
+        std::vector<char> scratch;
+        timer.start();
+        for (int i = 0; i < passes; i++) {
+            ReadCache(output, scratch);
+        }
+        timer.stop();
+        double cacheTime = timer.mseconds() / passes;
+
+        // Both paths end with identical buffer uploads, so only the CPU side is timed. The
+        // FBX time includes writing the cache, which is small next to the import itself.
+        Info("Average load time over " << passes << " passes, excluding GL uploads:");
+        Info("  FBX import:  " << fbxTime << "ms");
+        Info("  Mesh cache:  " << cacheTime << "ms");
+        Info("  Speedup:     " << (cacheTime > 0 ? fbxTime / cacheTime : 0) << "x");
+    }
+
+    return 0;
+}